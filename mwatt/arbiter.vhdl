@@ -167,9 +167,11 @@ begin
     end if;
 
     -- Output assignment
-    lsdo <= (data   => (others => '0'), others => '0');
+    lsdo <= (data   => (others => '0'), data2 => (others => '0'),
+             real_addr => (others => '0'), others => '0');
     lsds <= '1';
-    qdo  <= (data   => (others => '0'), others => '0');
+    qdo  <= (data   => (others => '0'), data2 => (others => '0'),
+             real_addr => (others => '0'), others => '0');
     qds  <= '1';
     do   <= (addr   => (others => '0'), data => (others => '0'), byte_sel => (others => '0'), others => '0');
     lmo  <= (sprval => (others => '0'), others => '0');
@@ -192,6 +192,8 @@ architecture sim of arbiter_tb is
 
   constant dcache_to_loadstore1_type_init : DcacheToLoadstore1Type := (
     data   => (others => '0'),
+    data2  => (others => '0'),
+    real_addr => (others => '0'),
     others => '0'
   );
 
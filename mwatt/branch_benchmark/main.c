@@ -0,0 +1,168 @@
+#include "console.h"
+#include "io.h"
+#include "microwatt_soc.h"
+
+#include "pmu.h"
+#include "time.h"
+
+/*
+ * Branchy code benchmark for the fetch1/decode1 branch predictors.
+ *
+ * Runs a small bytecode interpreter (switch dispatch plus data dependent
+ * conditional branches, much like MicroPython's VM loop) and a recursive
+ * call-heavy kernel, and reports timebase ticks, completed instructions,
+ * conditional branch mispredicts and blr mispredicts for each.  Compare
+ * a build with HAS_GSHARE/HAS_RAS against one without.
+ */
+
+#define ITERATIONS 8
+
+enum {
+  OP_PUSH,      // push immediate
+  OP_ADD,
+  OP_SUB,
+  OP_DUP,
+  OP_OVER,
+  OP_SWAP,
+  OP_JNZ,       // pop, jump if non-zero
+  OP_MOD2,      // replace top with top & 1
+  OP_DROP,
+  OP_HALT,
+};
+
+/*
+ * sum = 0; for (i = 200; i != 0; i--) if (i & 1) sum += i; else sum -= 3;
+ * stack layout: [sum, i]
+ */
+static const unsigned char program[] = {
+  OP_PUSH, 0,           // sum
+  OP_PUSH, 200,         // i
+  /* 4: loop */
+  OP_DUP,
+  OP_MOD2,
+  OP_JNZ, 17,           // odd -> 17
+  OP_SWAP,              // [i, sum]
+  OP_PUSH, 3,
+  OP_SUB,
+  OP_SWAP,              // [sum, i]
+  OP_PUSH, 1,
+  OP_JNZ, 21,           // always -> 21
+  /* 17: odd */
+  OP_SWAP,              // [i, sum]
+  OP_OVER,              // [i, sum, i]
+  OP_ADD,
+  OP_SWAP,              // [sum, i]
+  /* 21: next */
+  OP_PUSH, 1,
+  OP_SUB,
+  OP_DUP,
+  OP_JNZ, 4,
+  OP_DROP,
+  OP_HALT,
+};
+
+static long interp(const unsigned char *pc0)
+{
+  long stack[16];
+  long *sp = stack;
+  const unsigned char *pc = pc0;
+  long a, b;
+
+  for (;;) {
+    switch (*pc++) {
+    case OP_PUSH:
+      *sp++ = *pc++;
+      break;
+    case OP_ADD:
+      b = *--sp; a = *--sp;
+      *sp++ = a + b;
+      break;
+    case OP_SUB:
+      b = *--sp; a = *--sp;
+      *sp++ = a - b;
+      break;
+    case OP_DUP:
+      a = sp[-1];
+      *sp++ = a;
+      break;
+    case OP_OVER:
+      a = sp[-2];
+      *sp++ = a;
+      break;
+    case OP_SWAP:
+      a = sp[-1]; sp[-1] = sp[-2]; sp[-2] = a;
+      break;
+    case OP_JNZ:
+      a = *--sp;
+      if (a)
+        pc = pc0 + *pc;
+      else
+        pc++;
+      break;
+    case OP_MOD2:
+      sp[-1] &= 1;
+      break;
+    case OP_DROP:
+      --sp;
+      break;
+    case OP_HALT:
+    default:
+      return sp > stack ? sp[-1] : 0;
+    }
+  }
+}
+
+static __attribute__((noinline)) long fib(long n)
+{
+  if (n < 2)
+    return n;
+  return fib(n - 1) + fib(n - 2);
+}
+
+static void report(const char *name, uint64_t ticks, long result)
+{
+  puts(name);
+  puts(": result ");
+  print_uint64(result);
+  puts(" tb ");
+  print_uint64(ticks);
+  puts(" insns ");
+  print_uint64(pmu_read(1));
+  puts(" br_mispredict ");
+  print_uint64(pmu_read(4));
+  puts(" blr_mispredict ");
+  print_uint64(pmu_read(3));
+  puts("\n");
+}
+
+int main(void)
+{
+  uint64_t t0, t1;
+  long r = 0;
+  int i;
+
+  console_init();
+
+  pmu_start(PMU_MMCR1(PMU_EV1_INSN_COMPLETE, PMU_EV2_BR_TAKEN,
+                      PMU_EV3_BR_RET_MISPREDICT, PMU_EV4_BR_MISPREDICT));
+  t0 = get_tb();
+  for (i = 0; i < ITERATIONS; i++)
+    r += interp(program);
+  t1 = get_tb();
+  pmu_stop();
+  report("interp", t1 - t0, r);
+
+  pmu_start(PMU_MMCR1(PMU_EV1_INSN_COMPLETE, PMU_EV2_BR_TAKEN,
+                      PMU_EV3_BR_RET_MISPREDICT, PMU_EV4_BR_MISPREDICT));
+  t0 = get_tb();
+  r = fib(16);
+  t1 = get_tb();
+  pmu_stop();
+  report("fib", t1 - t0, r);
+
+  return 0;
+}
+
+void secondary_main(void)
+{
+}
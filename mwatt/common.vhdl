@@ -269,18 +269,25 @@ package common is
 
     subtype intr_vector_t is integer range 0 to 16#fff#;
 
-    -- For now, fixed 16 sources, make this either a parametric
-    -- package of some sort or an unconstrainted array.
     -- We don't know NCPUS or SRC_NUM here, so make this
-    -- large enough for 4 cpus and 16 interrupt sources for now.
+    -- large enough for 4 cpus and 256 interrupt sources.
     type ics_to_icp_t is record
         -- Level interrupts only, ICS just keeps prsenting the
         -- highest priority interrupt. Once handling edge, something
         -- smarter involving handshake & reject support will be needed
-        src : std_ulogic_vector(15 downto 0);  -- 4 bits each for 4 cpus
+        src : std_ulogic_vector(31 downto 0);  -- 8 bits each for 4 cpus
         pri : std_ulogic_vector(31 downto 0);  -- 8 bits each for 4 cpus
     end record;
 
+    -- MFRR write taken straight off the IO bus by the SoC, so that an
+    -- IPI doesn't have to go through the 32-bit IO bus to the ICP.
+    type icp_ipi_t is record
+        valid : std_ulogic;
+        cpu   : std_ulogic_vector(3 downto 0);
+        mfrr  : std_ulogic_vector(7 downto 0);
+    end record;
+    constant icp_ipi_init : icp_ipi_t := (valid => '0', others => (others => '0'));
+
     -- Bits in each half of DEXCR and HDEXCR
     subtype aspect_bits_t is std_ulogic_vector(4 downto 0);
     constant aspect_bits_init : aspect_bits_t := (others => '1');
@@ -353,6 +360,8 @@ package common is
         stop_mark   : std_ulogic;
         predicted   : std_ulogic;
         pred_ntaken : std_ulogic;
+        pred_slot   : std_ulogic;  -- prediction is for the second word of a dual fetch
+        dual        : std_ulogic;  -- fetch both words of the doubleword at nia
         nia         : std_ulogic_vector(63 downto 0);
         next_nia    : std_ulogic_vector(63 downto 0);
         rpn         : std_ulogic_vector(REAL_ADDR_BITS - MIN_LG_PGSZ - 1 downto 0);
@@ -369,11 +378,18 @@ package common is
         big_endian: std_ulogic;
         next_predicted: std_ulogic;
         next_pred_ntaken: std_ulogic;
+        pred_slot: std_ulogic;
+        -- second word of the doubleword, valid if dual = 1
+        dual: std_ulogic;
+        insn2: std_ulogic_vector(31 downto 0);
+        icode2: insn_code_t;
     end record;
     constant IcacheToDecode1Init : IcacheToDecode1Type := (
         nia    => (others => '0'),
         insn   => (others => '0'),
         icode  => INSN_illegal,
+        insn2  => (others => '0'),
+        icode2 => INSN_illegal,
         others => '0'
     );
 
@@ -382,6 +398,18 @@ package common is
         itlb_miss_resolved : std_ulogic;
     end record;
 
+    -- Events from the shared L2 in the SoC, for this core's requests
+    type L2cacheEventType is record
+        hit  : std_ulogic;
+        miss : std_ulogic;
+    end record;
+    constant L2cacheEventInit : L2cacheEventType := (others => '0');
+
+    type LoopBufferEventType is record
+        hit : std_ulogic;           -- decode1 took an entry replayed from the loop buffer
+    end record;
+    constant LoopBufferEventInit : LoopBufferEventType := (others => '0');
+
     type Decode1ToDecode2Type is record
         valid             : std_ulogic;
         stop_mark         : std_ulogic;
@@ -391,15 +419,23 @@ package common is
         prefix            : std_ulogic_vector(25 downto 0);
         illegal_suffix    : std_ulogic;
         misaligned_prefix : std_ulogic;
+        fused             : std_ulogic;  -- addis pair fused into a prefixed-form op
         insn              : std_ulogic_vector(31 downto 0);
         decode            : decode_rom_t;
         br_pred           : std_ulogic;  -- Branch was predicted to be taken
+        br_target         : std_ulogic_vector(63 downto 0);  -- Predicted target of bclr
         big_endian        : std_ulogic;
         spr_info          : spr_id;
         ram_spr           : ram_spr_info;
         reg_a             : gspr_index_t;
         reg_b             : gspr_index_t;
         reg_c             : gspr_index_t;
+        -- Simple ALU instruction dual-issued with this one
+        dual              : std_ulogic;
+        insn2             : std_ulogic_vector(31 downto 0);
+        decode2           : decode_rom_t;
+        reg_d             : gspr_index_t;
+        reg_e             : gspr_index_t;
     end record;
     constant Decode1ToDecode2Init : Decode1ToDecode2Type := (
         valid             => '0',
@@ -411,14 +447,21 @@ package common is
         insn              => (others => '0'),
         illegal_suffix    => '0',
         misaligned_prefix => '0',
+        fused             => '0',
         decode            => decode_rom_init,
         br_pred           => '0',
+        br_target         => (others => '0'),
         big_endian        => '0',
         spr_info          => spr_id_init,
         ram_spr           => ram_spr_info_init,
         reg_a             => (others => '0'),
         reg_b             => (others => '0'),
-        reg_c             => (others => '0')
+        reg_c             => (others => '0'),
+        dual              => '0',
+        insn2             => (others => '0'),
+        decode2           => decode_rom_init,
+        reg_d             => (others => '0'),
+        reg_e             => (others => '0')
     );
 
     type Decode1ToFetch1Type is record
@@ -433,13 +476,51 @@ package common is
         read_1_enable : std_ulogic;
         read_2_enable : std_ulogic;
         read_3_enable : std_ulogic;
+        -- operands of a dual-issued instruction
+        reg_4_addr    : gspr_index_t;
+        reg_5_addr    : gspr_index_t;
     end record;
 
+    -- tag2 and data2 are for the result of a dual-issued instruction,
+    -- which has the same tag as the instruction it was issued with.
     type bypass_data_t is record
-        tag  : instr_tag_t;
-        data : std_ulogic_vector(63 downto 0);
+        tag   : instr_tag_t;
+        data  : std_ulogic_vector(63 downto 0);
+        tag2  : instr_tag_t;
+        data2 : std_ulogic_vector(63 downto 0);
     end record;
-    constant bypass_data_init : bypass_data_t := (tag => instr_tag_init, data => (others => '0'));
+    constant bypass_data_init : bypass_data_t := (tag => instr_tag_init, data => (others => '0'),
+                                                  tag2 => instr_tag_init, data2 => (others => '0'));
+
+    -- A simple ALU instruction (add, logical, rotate or extend, with no
+    -- Rc, OE or carry, or a compare) issued alongside another instruction
+    -- (DUAL_ISSUE).  read_data1 is RA, zero or RS and read_data2 is RB or
+    -- an immediate.  A compare (output_cr = 1) writes no GPR.
+    type SimpleOpType is record
+        valid      : std_ulogic;
+        insn_type  : insn_type_t;
+        insn       : std_ulogic_vector(31 downto 0);
+        write_reg  : gspr_index_t;
+        read_data1 : std_ulogic_vector(63 downto 0);
+        read_data2 : std_ulogic_vector(63 downto 0);
+        invert_a   : std_ulogic;
+        invert_out : std_ulogic;
+        is_signed  : std_ulogic;
+        is_32bit   : std_ulogic;
+        carry_in   : std_ulogic;
+        output_cr  : std_ulogic;
+        data_len   : std_ulogic_vector(3 downto 0);
+    end record;
+    constant SimpleOpInit : SimpleOpType := (
+        valid      => '0',
+        insn_type  => OP_ILLEGAL,
+        insn       => (others => '0'),
+        write_reg  => (others => '0'),
+        read_data1 => (others => '0'),
+        read_data2 => (others => '0'),
+        data_len   => (others => '0'),
+        others     => '0'
+    );
 
     type cr_bypass_data_t is record
         tag  : instr_tag_t;
@@ -487,6 +568,7 @@ package common is
         update             : std_ulogic;  -- is this an update instruction?
         reserve            : std_ulogic;  -- set for larx/stcx
         br_pred            : std_ulogic;
+        br_target          : std_ulogic_vector(63 downto 0);  -- predicted target of bclr
         result_sel         : std_ulogic_vector(2 downto 0);  -- select source of result
         sub_select         : std_ulogic_vector(2 downto 0);  -- sub-result selection
         repeat             : std_ulogic;  -- set if instruction is cracked into two ops
@@ -507,6 +589,7 @@ package common is
         prefix             : std_ulogic_vector(25 downto 0);
         illegal_suffix     : std_ulogic;
         misaligned_prefix  : std_ulogic;
+        fused              : std_ulogic;
         illegal_form       : std_ulogic;
         uses_tar           : std_ulogic;
         uses_dscr          : std_ulogic;
@@ -515,6 +598,8 @@ package common is
         rot_clear_right    : std_ulogic;
         rot_sign_ext       : std_ulogic;
         do_popcnt          : std_ulogic;
+        mul64              : std_ulogic;  -- 64-bit multiply with OE=0, may issue behind another
+        dual               : SimpleOpType;
     end record;
     constant Decode2ToExecute1Init : Decode2ToExecute1Type := (
         valid              => '0',
@@ -539,6 +624,7 @@ package common is
         xerc               => xerc_init,
         reserve            => '0',
         br_pred            => '0',
+        br_target          => (others => '0'),
         byte_reverse       => '0',
         sign_extend        => '0',
         update             => '0',
@@ -572,6 +658,7 @@ package common is
         prefix             => (others => '0'),
         illegal_suffix     => '0',
         misaligned_prefix  => '0',
+        fused              => '0',
         illegal_form       => '0',
         uses_tar           => '0',
         uses_dscr          => '0',
@@ -580,6 +667,8 @@ package common is
         rot_clear_right    => '0',
         rot_sign_ext       => '0',
         do_popcnt          => '0',
+        mul64              => '0',
+        dual               => SimpleOpInit,
         others             => (others => '0'));
 
     type MultiplyInputType is record
@@ -608,6 +697,31 @@ package common is
         others   => (others => '0')
     );
 
+    type FPUFastInputType is record
+        valid : std_ulogic;
+        op    : std_ulogic_vector(4 downto 0);  -- instruction bits 5..1
+        fra   : std_ulogic_vector(63 downto 0);
+        frb   : std_ulogic_vector(63 downto 0);
+        frc   : std_ulogic_vector(63 downto 0);
+    end record;
+    constant FPUFastInputInit : FPUFastInputType := (
+        valid => '0',
+        op    => "00000",
+        others => 64x"0"
+    );
+
+    type FPUFastOutputType is record
+        valid  : std_ulogic;
+        ok     : std_ulogic;  -- 0 => result is zero, tiny or huge; redo it the slow way
+        result : std_ulogic_vector(63 downto 0);
+        fr     : std_ulogic;
+        fi     : std_ulogic;
+    end record;
+    constant FPUFastOutputInit : FPUFastOutputType := (
+        result => 64x"0",
+        others => '0'
+    );
+
     type Execute1ToDividerType is record
         valid       : std_ulogic;
         flush       : std_ulogic;
@@ -630,11 +744,13 @@ package common is
         dispatch            : std_ulogic;
         ext_interrupt       : std_ulogic;
         instr_complete      : std_ulogic;
+        instr_complete2     : std_ulogic;   -- completion was a fused or dual-issued pair
         fp_complete         : std_ulogic;
         ld_complete         : std_ulogic;
         st_complete         : std_ulogic;
         br_taken_complete   : std_ulogic;
         br_mispredict       : std_ulogic;
+        br_ret_mispredict   : std_ulogic;
         ipref_discard       : std_ulogic;
         itlb_miss           : std_ulogic;
         itlb_miss_resolved  : std_ulogic;
@@ -647,6 +763,11 @@ package common is
         dtlb_miss_resolved  : std_ulogic;
         ld_miss_nocache     : std_ulogic;
         ld_fill_nocache     : std_ulogic;
+        l2_hit              : std_ulogic;
+        l2_miss             : std_ulogic;
+        fused_op            : std_ulogic;
+        dual_op             : std_ulogic;
+        lb_hit              : std_ulogic;
     end record;
     constant PMUEventInit : PMUEventType := (others => '0');
 
@@ -675,12 +796,16 @@ package common is
         read1_enable : std_ulogic;
         read2_enable : std_ulogic;
         read3_enable : std_ulogic;
+        read4_enable : std_ulogic;
+        read5_enable : std_ulogic;
     end record;
 
     type RegisterFileToDecode2Type is record
         read1_data : std_ulogic_vector(63 downto 0);
         read2_data : std_ulogic_vector(63 downto 0);
         read3_data : std_ulogic_vector(63 downto 0);
+        read4_data : std_ulogic_vector(63 downto 0);
+        read5_data : std_ulogic_vector(63 downto 0);
     end record;
 
     type Decode2ToCrFileType is record
@@ -721,6 +846,7 @@ package common is
         msr          : std_ulogic_vector(63 downto 0);
         hashkey      : std_ulogic_vector(63 downto 0);
         hash_enable  : std_ulogic;
+        fused        : std_ulogic;      -- addis pair fused into a prefixed load
     end record;
     constant Execute1ToLoadstore1Init : Execute1ToLoadstore1Type := (
         valid        => '0',
@@ -750,7 +876,8 @@ package common is
         e2stall      => '0',
         msr          => (others => '0'),
         hashkey      => (others => '0'),
-        hash_enable  => '0'
+        hash_enable  => '0',
+        fused        => '0'
     );
 
     type Loadstore1ToExecute1Type is record
@@ -779,6 +906,7 @@ package common is
         data         : std_ulogic_vector(63 downto 0);  -- valid the cycle after .valid = 1
         byte_sel     : std_ulogic_vector(7 downto 0);
         dawr_match   : std_ulogic;      -- valid the cycle after .valid = 1
+        dual         : std_ulogic;      -- load crossing a doubleword, return both
     end record;
     constant Loadstore1ToDcacheInit : Loadstore1ToDcacheType := (
         addr     => (others => '0'),
@@ -790,10 +918,12 @@ package common is
     type DcacheToLoadstore1Type is record
         valid         : std_ulogic;
         data          : std_ulogic_vector(63 downto 0);
+        data2         : std_ulogic_vector(63 downto 0);  -- next doubleword, for dual
         store_done    : std_ulogic;
         error         : std_ulogic;
         cache_paradox : std_ulogic;
         reserve_nc    : std_ulogic;
+        real_addr     : real_addr_t;  -- of the access completing, for the cosim store trace
     end record;
 
     type DcacheEventType is record
@@ -835,6 +965,8 @@ package common is
         tlbie : std_ulogic;
         doall : std_ulogic;
         tlbld : std_ulogic;
+        large : std_ulogic;  -- with tlbld, PTE maps a 2MB page
+        huge  : std_ulogic;  -- with tlbld, PTE maps a 1GB page
         addr  : std_ulogic_vector(63 downto 0);
         pte   : std_ulogic_vector(63 downto 0);
     end record;
@@ -850,6 +982,8 @@ package common is
         tlbld : std_ulogic;
         tlbie : std_ulogic;
         doall : std_ulogic;
+        large : std_ulogic;  -- with tlbld, PTE maps a 2MB page
+        huge  : std_ulogic;  -- with tlbld, PTE maps a 1GB page
         addr  : std_ulogic_vector(63 downto 0);
         pte   : std_ulogic_vector(63 downto 0);
     end record;
@@ -866,6 +1000,7 @@ package common is
         interrupt    : std_ulogic;
         intr_vec     : intr_vector_t;
         srr1         : std_ulogic_vector(15 downto 0);
+        fused        : std_ulogic;
     end record;
     constant Loadstore1ToWritebackInit : Loadstore1ToWritebackType := (
         valid        => '0',
@@ -878,13 +1013,16 @@ package common is
         store_done   => '0',
         interrupt    => '0',
         intr_vec     => 0,
-        srr1         => (others => '0')
+        srr1         => (others => '0'),
+        fused        => '0'
     );
 
     type Loadstore1EventType is record
-        load_complete  : std_ulogic;
-        store_complete : std_ulogic;
-        itlb_miss      : std_ulogic;
+        load_complete    : std_ulogic;
+        store_complete   : std_ulogic;
+        itlb_miss        : std_ulogic;
+        queue_empty_wait : std_ulogic;  -- lfdxq/lfsxq waiting for data
+        queue_full_wait  : std_ulogic;  -- queue store waiting for space
     end record;
 
     type Execute1ToWritebackType is record
@@ -912,6 +1050,14 @@ package common is
         abs_br            : std_ulogic;
         srr1              : std_ulogic_vector(15 downto 0);
         msr               : std_ulogic_vector(63 downto 0);
+        -- result of a dual-issued instruction
+        write_enable2     : std_ulogic;
+        write_reg2        : gspr_index_t;
+        write_data2       : std_ulogic_vector(63 downto 0);
+        -- instruction was an addis pair fused into one
+        fused             : std_ulogic;
+        -- a second instruction was dual-issued with it
+        dual              : std_ulogic;
     end record;
     constant Execute1ToWritebackInit : Execute1ToWritebackType := (
         valid             => '0',
@@ -937,7 +1083,12 @@ package common is
         br_taken          => '0',
         abs_br            => '0',
         srr1              => (others => '0'),
-        msr               => (others => '0')
+        msr               => (others => '0'),
+        write_enable2     => '0',
+        fused             => '0',
+        dual              => '0',
+        write_reg2        => (others => '0'),
+        write_data2       => (others => '0')
     );
 
     type Execute1ToFPUType is record
@@ -1064,14 +1215,20 @@ package common is
     );
 
     type WritebackToRegisterFileType is record
-        write_reg    : gspr_index_t;
-        write_data   : std_ulogic_vector(63 downto 0);
-        write_enable : std_ulogic;
+        write_reg     : gspr_index_t;
+        write_data    : std_ulogic_vector(63 downto 0);
+        write_enable  : std_ulogic;
+        -- second write port, for dual-issued instructions
+        write_reg2    : gspr_index_t;
+        write_data2   : std_ulogic_vector(63 downto 0);
+        write_enable2 : std_ulogic;
     end record;
     constant WritebackToRegisterFileInit : WritebackToRegisterFileType := (
-        write_enable => '0',
-        write_data   => (others => '0'),
-        others       => (others => '0')
+        write_enable  => '0',
+        write_data    => (others => '0'),
+        write_enable2 => '0',
+        write_data2   => (others => '0'),
+        others        => (others => '0')
     );
 
     type WritebackToCrFileType is record
@@ -1097,8 +1254,9 @@ package common is
     end record;
 
     type WritebackEventType is record
-        instr_complete : std_ulogic;
-        fp_complete    : std_ulogic;
+        instr_complete  : std_ulogic;
+        instr_complete2 : std_ulogic;   -- completion was a fused or dual-issued pair
+        fp_complete     : std_ulogic;
     end record;
 
     ------------------------------------------------------------
@@ -0,0 +1,83 @@
+#include "console.h"
+#include "io.h"
+#include "microwatt_soc.h"
+
+#include "pmu.h"
+#include "time.h"
+
+/*
+ * Console output cost benchmark.
+ *
+ * Runs the same small compute loop, printing a progress line every
+ * iteration, first with the polled puts()/print_uint64() and then with
+ * the buffered, interrupt driven console_printf(), and reports the
+ * average number of PMU run cycles per iteration for each. With the
+ * polled console each line costs the time for the UART to send it;
+ * with the buffered one it only costs formatting it into the TX ring.
+ */
+
+#define ITERS 64
+#define WORK  256
+
+static uint64_t __attribute__((noinline)) work(uint64_t x)
+{
+  int i;
+
+  for (i = 0; i < WORK; i++)
+    x = x * 6364136223846793005ul + 1442695040888963407ul;
+  return x;
+}
+
+static uint64_t run_polled(void)
+{
+  volatile uint64_t sink = 1;
+  int i;
+
+  pmu_start(PMU_MMCR1(PMU_EV1_CYCLES, 0, 0, 0));
+  for (i = 0; i < ITERS; i++) {
+    sink = work(sink);
+    puts("iter ");
+    print_uint64(i);
+    puts(" done\n");
+  }
+  pmu_stop();
+  return pmu_read(1);
+}
+
+static uint64_t run_buffered(void)
+{
+  volatile uint64_t sink = 1;
+  int i;
+
+  pmu_start(PMU_MMCR1(PMU_EV1_CYCLES, 0, 0, 0));
+  for (i = 0; i < ITERS; i++) {
+    sink = work(sink);
+    console_printf("iter %d done\n", i);
+  }
+  pmu_stop();
+  return pmu_read(1);
+}
+
+int main(void)
+{
+  uint64_t polled, buffered;
+
+  console_init();
+
+  polled = run_polled();
+
+  console_buffered_init();
+  buffered = run_buffered();
+  console_flush();
+
+  console_printf("polled:   cycles/iter %lu\n", polled / ITERS);
+  console_printf("buffered: cycles/iter %lu\n", buffered / ITERS);
+  console_printf("dropped:  %lu\n", console_dropped());
+  console_flush();
+
+  return 0;
+}
+
+void secondary_main(void)
+{
+}
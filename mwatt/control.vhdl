@@ -23,6 +23,10 @@ entity control is
         gpr_write_valid_in  : in std_ulogic;
         gpr_write_in        : in gspr_index_t;
 
+        -- destination of a dual-issued instruction
+        gpr_write2_valid_in : in std_ulogic;
+        gpr_write2_in       : in gspr_index_t;
+
         gpr_a_read_valid_in : in std_ulogic;
         gpr_a_read_in       : in gspr_index_t;
 
@@ -32,6 +36,13 @@ entity control is
         gpr_c_read_valid_in : in std_ulogic;
         gpr_c_read_in       : in gspr_index_t;
 
+        -- operands of a dual-issued instruction
+        gpr_d_read_valid_in : in std_ulogic;
+        gpr_d_read_in       : in gspr_index_t;
+
+        gpr_e_read_valid_in : in std_ulogic;
+        gpr_e_read_in       : in gspr_index_t;
+
         execute_next_tag    : in instr_tag_t;
         execute_next_cr_tag : in instr_tag_t;
         execute2_next_tag    : in instr_tag_t;
@@ -45,13 +56,17 @@ entity control is
         valid_out           : out std_ulogic;
         stopped_out         : out std_ulogic;
 
-        -- Note on gpr_bypass_*: bits 1 to 3 are a 1-hot encoding of which
-        -- bypass source we may possibly need to use; bit 0 is 1 if the bypass
-        -- value should be used (i.e. any of bits 1-3 are 1 and the
-        -- corresponding gpr_x_read_valid_in is also 1).
-        gpr_bypass_a        : out std_ulogic_vector(3 downto 0);
-        gpr_bypass_b        : out std_ulogic_vector(3 downto 0);
-        gpr_bypass_c        : out std_ulogic_vector(3 downto 0);
+        -- Note on gpr_bypass_*: bits 1 to 6 are a 1-hot encoding of which
+        -- bypass source we may possibly need to use, bits 1 to 3 being the
+        -- execute1, execute2 and writeback results and bits 4 to 6 the
+        -- results of a dual-issued instruction at the same stages; bit 0
+        -- is 1 if the bypass value should be used (i.e. any of bits 1-6
+        -- are 1 and the corresponding gpr_x_read_valid_in is also 1).
+        gpr_bypass_a        : out std_ulogic_vector(6 downto 0);
+        gpr_bypass_b        : out std_ulogic_vector(6 downto 0);
+        gpr_bypass_c        : out std_ulogic_vector(6 downto 0);
+        gpr_bypass_d        : out std_ulogic_vector(6 downto 0);
+        gpr_bypass_e        : out std_ulogic_vector(6 downto 0);
         cr_bypass           : out std_ulogic_vector(1 downto 0);
 
         instr_tag_out       : out instr_tag_t
@@ -60,21 +75,79 @@ end entity control;
 
 architecture rtl of control is
     signal gpr_write_valid : std_ulogic;
+    signal gpr_write2_valid : std_ulogic;
     signal cr_write_valid  : std_ulogic;
     signal ov_write_valid  : std_ulogic;
 
+    -- wr_gpr2, reg2 and recent2 are for the GPR written by a
+    -- dual-issued instruction, which shares the tag.
     type tag_register is record
-        wr_gpr : std_ulogic;
-        reg    : gspr_index_t;
-        recent : std_ulogic;
-        wr_cr  : std_ulogic;
-        wr_ov  : std_ulogic;
-        valid  : std_ulogic;
+        wr_gpr  : std_ulogic;
+        reg     : gspr_index_t;
+        recent  : std_ulogic;
+        wr_gpr2 : std_ulogic;
+        reg2    : gspr_index_t;
+        recent2 : std_ulogic;
+        wr_cr   : std_ulogic;
+        wr_ov   : std_ulogic;
+        valid   : std_ulogic;
     end record;
 
     type tag_regs_array is array(tag_number_t) of tag_register;
     signal tag_regs : tag_regs_array;
 
+    -- The in-flight instruction that most recently wrote a GPR, and
+    -- whether it was the dual-issued one of its pair (lane = 1).
+    type gpr_tag_t is record
+        tag  : instr_tag_t;
+        lane : std_ulogic;
+    end record;
+
+    function gpr_tag(regs : tag_regs_array; reg : gspr_index_t) return gpr_tag_t is
+        variable t : gpr_tag_t;
+    begin
+        t := (tag => instr_tag_init, lane => '0');
+        for i in tag_number_t loop
+            if regs(i).wr_gpr = '1' and regs(i).recent = '1' and regs(i).reg = reg then
+                t.tag.valid := '1';
+                t.tag.tag := i;
+                t.lane := '0';
+            end if;
+            if regs(i).wr_gpr2 = '1' and regs(i).recent2 = '1' and regs(i).reg2 = reg then
+                t.tag.valid := '1';
+                t.tag.tag := i;
+                t.lane := '1';
+            end if;
+        end loop;
+        return t;
+    end;
+
+    function gpr_bypass(t : gpr_tag_t; read_valid : std_ulogic;
+                        ex_tag : instr_tag_t; ex2_tag : instr_tag_t;
+                        wb_tag : instr_tag_t) return std_ulogic_vector is
+        variable byp : std_ulogic_vector(6 downto 0);
+        variable sel : std_ulogic_vector(2 downto 0);
+    begin
+        sel := "000";
+        if EX1_BYPASS and tag_match(ex_tag, t.tag) then
+            sel(0) := '1';
+        end if;
+        if EX1_BYPASS and tag_match(ex2_tag, t.tag) then
+            sel(1) := '1';
+        end if;
+        if tag_match(wb_tag, t.tag) then
+            sel(2) := '1';
+        end if;
+        byp := (others => '0');
+        if t.lane = '0' then
+            byp(3 downto 1) := sel;
+        else
+            byp(6 downto 4) := sel;
+        end if;
+        byp(0) := read_valid and (sel(0) or sel(1) or sel(2));
+        return byp;
+    end;
+
     signal instr_tag  : instr_tag_t;
 
     signal gpr_tag_stall : std_ulogic;
@@ -96,6 +169,7 @@ begin
             for i in tag_number_t loop
                 if rst = '1' or flush_in = '1' then
                     tag_regs(i).wr_gpr <= '0';
+                    tag_regs(i).wr_gpr2 <= '0';
                     tag_regs(i).wr_cr <= '0';
                     tag_regs(i).wr_ov <= '0';
                     tag_regs(i).valid <= '0';
@@ -103,22 +177,32 @@ begin
                     if complete_in.valid = '1' and i = complete_in.tag then
                         assert tag_regs(i).valid = '1' report "spurious completion" severity failure;
                         tag_regs(i).wr_gpr <= '0';
+                        tag_regs(i).wr_gpr2 <= '0';
                         tag_regs(i).wr_cr <= '0';
                         tag_regs(i).wr_ov <= '0';
                         tag_regs(i).valid <= '0';
                         report "tag " & integer'image(i) & " not valid";
                     end if;
-                    if instr_tag.valid = '1' and gpr_write_valid = '1' and
-                        tag_regs(i).reg = gpr_write_in then
+                    if instr_tag.valid = '1' and
+                        ((gpr_write_valid = '1' and tag_regs(i).reg = gpr_write_in) or
+                         (gpr_write2_valid = '1' and tag_regs(i).reg = gpr_write2_in)) then
                         tag_regs(i).recent <= '0';
                         if tag_regs(i).recent = '1' and tag_regs(i).wr_gpr = '1' then
                             report "tag " & integer'image(i) & " not recent";
                         end if;
                     end if;
+                    if instr_tag.valid = '1' and
+                        ((gpr_write_valid = '1' and tag_regs(i).reg2 = gpr_write_in) or
+                         (gpr_write2_valid = '1' and tag_regs(i).reg2 = gpr_write2_in)) then
+                        tag_regs(i).recent2 <= '0';
+                    end if;
                     if instr_tag.valid = '1' and i = instr_tag.tag then
                         tag_regs(i).wr_gpr <= gpr_write_valid;
                         tag_regs(i).reg <= gpr_write_in;
                         tag_regs(i).recent <= gpr_write_valid;
+                        tag_regs(i).wr_gpr2 <= gpr_write2_valid;
+                        tag_regs(i).reg2 <= gpr_write2_in;
+                        tag_regs(i).recent2 <= gpr_write2_valid;
                         tag_regs(i).wr_cr <= cr_write_valid;
                         tag_regs(i).wr_ov <= ov_write_valid;
                         tag_regs(i).valid <= '1';
@@ -150,83 +234,45 @@ begin
 
     control_hazards : process(all)
         variable gpr_stall : std_ulogic;
-        variable tag_a : instr_tag_t;
-        variable tag_b : instr_tag_t;
-        variable tag_c : instr_tag_t;
-        variable tag_s : instr_tag_t;
-        variable tag_t : instr_tag_t;
+        variable tag_a : gpr_tag_t;
+        variable tag_b : gpr_tag_t;
+        variable tag_c : gpr_tag_t;
+        variable tag_d : gpr_tag_t;
+        variable tag_e : gpr_tag_t;
         variable incr_tag : tag_number_t;
-        variable byp_a : std_ulogic_vector(3 downto 0);
-        variable byp_b : std_ulogic_vector(3 downto 0);
-        variable byp_c : std_ulogic_vector(3 downto 0);
+        variable byp_a : std_ulogic_vector(6 downto 0);
+        variable byp_b : std_ulogic_vector(6 downto 0);
+        variable byp_c : std_ulogic_vector(6 downto 0);
+        variable byp_d : std_ulogic_vector(6 downto 0);
+        variable byp_e : std_ulogic_vector(6 downto 0);
         variable tag_cr : instr_tag_t;
         variable byp_cr : std_ulogic_vector(1 downto 0);
         variable tag_ov : instr_tag_t;
         variable tag_prev : instr_tag_t;
     begin
-        tag_a := instr_tag_init;
-        for i in tag_number_t loop
-            if tag_regs(i).wr_gpr = '1' and tag_regs(i).recent = '1' and tag_regs(i).reg = gpr_a_read_in then
-                tag_a.valid := '1';
-                tag_a.tag := i;
-            end if;
-        end loop;
-        tag_b := instr_tag_init;
-        for i in tag_number_t loop
-            if tag_regs(i).wr_gpr = '1' and tag_regs(i).recent = '1' and tag_regs(i).reg = gpr_b_read_in then
-                tag_b.valid := '1';
-                tag_b.tag := i;
-            end if;
-        end loop;
-        tag_c := instr_tag_init;
-        for i in tag_number_t loop
-            if tag_regs(i).wr_gpr = '1' and tag_regs(i).recent = '1' and tag_regs(i).reg = gpr_c_read_in then
-                tag_c.valid := '1';
-                tag_c.tag := i;
-            end if;
-        end loop;
-
-        byp_a := "0000";
-        if EX1_BYPASS and tag_match(execute_next_tag, tag_a) then
-            byp_a(1) := '1';
-        end if;
-        if EX1_BYPASS and tag_match(execute2_next_tag, tag_a) then
-            byp_a(2) := '1';
-        end if;
-        if tag_match(complete_in, tag_a) then
-            byp_a(3) := '1';
-        end if;
-        byp_a(0) := gpr_a_read_valid_in and (byp_a(1) or byp_a(2) or byp_a(3));
-        byp_b := "0000";
-        if EX1_BYPASS and tag_match(execute_next_tag, tag_b) then
-            byp_b(1) := '1';
-        end if;
-        if EX1_BYPASS and tag_match(execute2_next_tag, tag_b) then
-            byp_b(2) := '1';
-        end if;
-        if tag_match(complete_in, tag_b) then
-            byp_b(3) := '1';
-        end if;
-        byp_b(0) := gpr_b_read_valid_in and (byp_b(1) or byp_b(2) or byp_b(3));
-        byp_c := "0000";
-        if EX1_BYPASS and tag_match(execute_next_tag, tag_c) then
-            byp_c(1) := '1';
-        end if;
-        if EX1_BYPASS and tag_match(execute2_next_tag, tag_c) then
-            byp_c(2) := '1';
-        end if;
-        if tag_match(complete_in, tag_c) then
-            byp_c(3) := '1';
-        end if;
-        byp_c(0) := gpr_c_read_valid_in and (byp_c(1) or byp_c(2) or byp_c(3));
+        tag_a := gpr_tag(tag_regs, gpr_a_read_in);
+        tag_b := gpr_tag(tag_regs, gpr_b_read_in);
+        tag_c := gpr_tag(tag_regs, gpr_c_read_in);
+        tag_d := gpr_tag(tag_regs, gpr_d_read_in);
+        tag_e := gpr_tag(tag_regs, gpr_e_read_in);
+
+        byp_a := gpr_bypass(tag_a, gpr_a_read_valid_in, execute_next_tag, execute2_next_tag, complete_in);
+        byp_b := gpr_bypass(tag_b, gpr_b_read_valid_in, execute_next_tag, execute2_next_tag, complete_in);
+        byp_c := gpr_bypass(tag_c, gpr_c_read_valid_in, execute_next_tag, execute2_next_tag, complete_in);
+        byp_d := gpr_bypass(tag_d, gpr_d_read_valid_in, execute_next_tag, execute2_next_tag, complete_in);
+        byp_e := gpr_bypass(tag_e, gpr_e_read_valid_in, execute_next_tag, execute2_next_tag, complete_in);
 
         gpr_bypass_a <= byp_a;
         gpr_bypass_b <= byp_b;
         gpr_bypass_c <= byp_c;
+        gpr_bypass_d <= byp_d;
+        gpr_bypass_e <= byp_e;
 
-        gpr_tag_stall <= (tag_a.valid and gpr_a_read_valid_in and not byp_a(0)) or
-                         (tag_b.valid and gpr_b_read_valid_in and not byp_b(0)) or
-                         (tag_c.valid and gpr_c_read_valid_in and not byp_c(0));
+        gpr_tag_stall <= (tag_a.tag.valid and gpr_a_read_valid_in and not byp_a(0)) or
+                         (tag_b.tag.valid and gpr_b_read_valid_in and not byp_b(0)) or
+                         (tag_c.tag.valid and gpr_c_read_valid_in and not byp_c(0)) or
+                         (tag_d.tag.valid and gpr_d_read_valid_in and not byp_d(0)) or
+                         (tag_e.tag.valid and gpr_e_read_valid_in and not byp_e(0));
 
         incr_tag := curr_tag;
         instr_tag.tag <= curr_tag;
@@ -277,6 +323,7 @@ begin
 
         if rst = '1' then
             gpr_write_valid <= '0';
+            gpr_write2_valid <= '0';
             cr_write_valid <= '0';
             valid_tmp := '0';
         end if;
@@ -292,6 +339,7 @@ begin
         end if;
 
         gpr_write_valid <= gpr_write_valid_in and valid_tmp;
+        gpr_write2_valid <= gpr_write2_valid_in and valid_tmp;
         cr_write_valid <= cr_write_in and valid_tmp;
         ov_write_valid <= ov_write_in and valid_tmp;
 
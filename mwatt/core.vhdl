@@ -13,7 +13,19 @@ entity core is
         DISABLE_FLATTEN     : boolean                        := false;
         EX1_BYPASS          : boolean                        := true;
         HAS_FPU             : boolean                        := true;
+        HAS_FPU_FAST_PATH   : boolean                        := false;
+        DIV_RADIX_BITS      : positive                       := 1;
+        MUL_PIPELINE_DEPTH  : positive                       := 3;
         HAS_BTC             : boolean                        := true;
+        BTC_ADDR_BITS       : positive                       := 10;
+        HAS_GSHARE          : boolean                        := false;
+        GSHARE_BITS         : positive                       := 10;
+        HAS_RAS             : boolean                        := false;
+        RAS_DEPTH           : positive                       := 8;
+        HAS_FUSION          : boolean                        := false;
+        DUAL_ISSUE          : boolean                        := false;
+        HAS_LOOP_BUFFER     : boolean                        := false;
+        LOOP_BUFFER_SIZE    : positive                       := 16;
         ALT_RESET_ADDRESS   : std_ulogic_vector(63 downto 0) := (others => '0');
         LOG_LENGTH          : natural                        := 512;
         ICACHE_NUM_LINES    : natural                        := 64;
@@ -23,7 +35,13 @@ entity core is
         DCACHE_NUM_WAYS     : natural                        := 2;
         DCACHE_TLB_SET_SIZE : natural                        := 64;
         DCACHE_TLB_NUM_WAYS : natural                        := 2;
-        QUEUE_DEPTH         : natural                        := 4
+        MMU_L2TLB_SIZE      : natural                        := 64;
+        MMU_L2TLB_LARGE_SIZE : natural                       := 8;
+        MMU_PWC_SIZE        : natural                        := 4;
+        QUEUE_DEPTH         : natural                        := 4;
+        STORE_BUFFER_DEPTH  : natural                        := 0;
+        START_STOPPED       : boolean                        := false;
+        COSIM               : boolean                        := false
     );
     port (
         clk : in std_ulogic;
@@ -42,7 +60,12 @@ entity core is
         wishbone_data_in  : in  wishbone_slave_out;
         wishbone_data_out : out wishbone_master_out;
 
-        wb_snoop_in : in wishbone_master_out;
+        wb_snoop_in  : in wishbone_master_out;
+        -- The current snooped write came from our own dcache
+        wb_snoop_own : in std_ulogic := '0';
+
+        -- Shared L2 events for this core's requests
+        l2_events : in L2cacheEventType := L2cacheEventInit;
 
         dmi_addr : in  std_ulogic_vector(3 downto 0);
         dmi_din  : in  std_ulogic_vector(63 downto 0);
@@ -66,26 +89,33 @@ entity core is
         write_type_i   : in  std_ulogic;
         write_data_i   : in  std_ulogic_vector(63 downto 0);
         full_o         : out std_ulogic;
+        write_wait_i   : in  std_ulogic := '0';
 
         -- This core loadstore to other core queue
         write_enable_o : out std_ulogic;
         write_type_o   : out std_ulogic;
         write_data_o   : out std_ulogic_vector(63 downto 0);
-        full_i         : in  std_ulogic
+        full_i         : in  std_ulogic;
+        write_wait_o   : out std_ulogic
 
     );
 end core;
 
 architecture behave of core is
+    constant DCACHE_LINE_SIZE : positive := 64;
+
     -- icache signals
     signal fetch1_to_icache    : Fetch1ToIcacheType;
     signal writeback_to_fetch1 : WritebackToFetch1Type;
+    signal fetch1_w_in : WritebackToFetch1Type;
     signal icache_to_decode1   : IcacheToDecode1Type;
+    signal lbuf_to_decode1     : IcacheToDecode1Type;
     signal mmu_to_itlb         : MmuToITLBType;
 
     -- decode signals
     signal decode1_to_decode2       : Decode1ToDecode2Type;
     signal decode1_to_fetch1        : Decode1ToFetch1Type;
+    signal lbuf_to_fetch1           : Decode1ToFetch1Type;
     signal decode1_to_register_file : Decode1ToRegisterFileType;
     signal decode2_to_execute1      : Decode2ToExecute1Type;
 
@@ -166,6 +196,8 @@ architecture behave of core is
     signal flush         : std_ulogic;
     signal decode1_flush : std_ulogic;
     signal fetch1_flush  : std_ulogic;
+    signal lbuf_flush    : std_ulogic;
+    signal lbuf_busy     : std_ulogic;
 
     signal complete  : instr_tag_t;
     signal terminate : std_ulogic;
@@ -205,11 +237,20 @@ architecture behave of core is
     signal dbg_ls_spr_ack  : std_ulogic;
     signal dbg_ls_spr_addr : std_ulogic_vector(1 downto 0);
     signal dbg_ls_spr_data : std_ulogic_vector(63 downto 0);
+    signal dbg_gpr_wr      : std_ulogic;
+    signal dbg_spr_wr      : std_ulogic;
+    signal dbg_cr_wr       : std_ulogic;
+    signal dbg_xer_wr      : std_ulogic;
+    signal dbg_msr_wr      : std_ulogic;
+    signal dbg_nia_wr      : std_ulogic;
+    signal dbg_wr_data     : std_ulogic_vector(63 downto 0);
+    signal dbg_cr_data     : std_ulogic_vector(31 downto 0);
 
     signal ctrl_debug : ctrl_t;
 
     -- PMU event bus
     signal icache_events    : IcacheEventType;
+    signal lbuf_events      : LoopBufferEventType;
     signal loadstore_events : Loadstore1EventType;
     signal dcache_events    : DcacheEventType;
     signal writeback_events : WritebackEventType;
@@ -271,7 +312,9 @@ begin
             RESET_ADDRESS     => (others => '0'),
             ALT_RESET_ADDRESS => ALT_RESET_ADDRESS,
             TLB_SIZE          => ICACHE_TLB_SIZE,
-            HAS_BTC           => HAS_BTC
+            HAS_BTC           => HAS_BTC,
+            BTC_ADDR_BITS     => BTC_ADDR_BITS,
+            DUAL_ISSUE        => DUAL_ISSUE
         )
         port map (
             clk          => clk,
@@ -282,14 +325,28 @@ begin
             inval_btc    => ex1_icache_inval or mmu_to_itlb.tlbie,
             stop_in      => dbg_core_stop,
             m_in         => mmu_to_itlb,
-            d_in         => decode1_to_fetch1,
-            w_in         => writeback_to_fetch1,
+            d_in         => lbuf_to_fetch1,
+            w_in         => fetch1_w_in,
             i_out        => fetch1_to_icache,
             log_out      => log_data(42 downto 0)
         );
 
-    fetch1_stall_in <= icache_stall_out or decode1_busy;
-    fetch1_flush    <= flush or decode1_flush;
+    fetch1_stall_in <= icache_stall_out or decode1_busy or lbuf_busy;
+
+    -- A debug write to NIA redirects fetch in the mode given by the MSR
+    fetch1_debug_redirect: process(all)
+    begin
+        fetch1_w_in <= writeback_to_fetch1;
+        if dbg_nia_wr = '1' then
+            fetch1_w_in.redirect <= '1';
+            fetch1_w_in.redirect_nia <= dbg_wr_data;
+            fetch1_w_in.virt_mode <= ctrl_debug.msr(MSR_IR);
+            fetch1_w_in.priv_mode <= not ctrl_debug.msr(MSR_PR);
+            fetch1_w_in.big_endian <= not ctrl_debug.msr(MSR_LE);
+            fetch1_w_in.mode_32bit <= not ctrl_debug.msr(MSR_SF);
+        end if;
+    end process;
+    fetch1_flush    <= flush or decode1_flush or lbuf_flush;
 
     icache_0 : entity work.icache
         generic map(
@@ -316,21 +373,61 @@ begin
             log_out      => log_data(100 downto 43)
         );
 
-    icache_stall_in <= decode1_busy;
+    icache_stall_in <= decode1_busy or lbuf_busy;
+
+    with_loop_buffer : if HAS_LOOP_BUFFER generate
+    begin
+        loop_buffer_0 : entity work.loop_buffer
+            generic map (
+                SIZE => LOOP_BUFFER_SIZE
+                )
+            port map (
+                clk         => clk,
+                rst         => rst_dec1,
+                flush_in    => flush,
+                redirect_in => decode1_flush,
+                busy_in     => decode1_busy,
+                stop_in     => dbg_core_stop,
+                i_in        => icache_to_decode1,
+                i_out       => lbuf_to_decode1,
+                d_in        => decode1_to_fetch1,
+                f_out       => lbuf_to_fetch1,
+                busy_out    => lbuf_busy,
+                flush_out   => lbuf_flush,
+                events      => lbuf_events
+                );
+    end generate;
+
+    no_loop_buffer : if not HAS_LOOP_BUFFER generate
+    begin
+        lbuf_to_decode1 <= icache_to_decode1;
+        lbuf_to_fetch1  <= decode1_to_fetch1;
+        lbuf_busy       <= '0';
+        lbuf_flush      <= '0';
+        lbuf_events     <= LoopBufferEventInit;
+    end generate;
 
     decode1_0 : entity work.decode1
         generic map(
-            HAS_FPU    => HAS_FPU,
-            LOG_LENGTH => LOG_LENGTH
+            HAS_FPU     => HAS_FPU,
+            HAS_GSHARE  => HAS_GSHARE,
+            GSHARE_BITS => GSHARE_BITS,
+            HAS_RAS     => HAS_RAS,
+            RAS_DEPTH   => RAS_DEPTH,
+            HAS_FUSION  => HAS_FUSION,
+            DUAL_ISSUE  => DUAL_ISSUE,
+            LOG_LENGTH  => LOG_LENGTH
         )
         port map (
             clk       => clk,
             rst       => rst_dec1,
             stall_in  => decode1_stall_in,
             flush_in  => flush,
+            trace_in  => ctrl_debug.msr(MSR_SE),
             flush_out => decode1_flush,
             busy_out  => decode1_busy,
-            f_in      => icache_to_decode1,
+            f_in      => lbuf_to_decode1,
+            w_in      => writeback_to_fetch1,
             d_out     => decode1_to_decode2,
             f_out     => decode1_to_fetch1,
             r_out     => decode1_to_register_file,
@@ -375,6 +472,7 @@ begin
         generic map (
             SIM        => SIM,
             HAS_FPU    => HAS_FPU,
+            DUAL_ISSUE => DUAL_ISSUE,
             LOG_LENGTH => LOG_LENGTH
         )
         port map (
@@ -388,6 +486,8 @@ begin
             dbg_gpr_ack   => dbg_gpr_ack,
             dbg_gpr_addr  => dbg_gpr_addr,
             dbg_gpr_data  => dbg_gpr_data,
+            dbg_gpr_wr    => dbg_gpr_wr,
+            dbg_gpr_wdata => dbg_wr_data,
             sim_dump      => terminate,
             sim_dump_done => sim_ex_dump,
             log_out       => log_data(255 downto 184)
@@ -405,6 +505,10 @@ begin
             w_in     => writeback_to_cr_file,
             sim_dump => sim_cr_dump,
             ctrl     => ctrl_debug,
+            dbg_cr_wr   => dbg_cr_wr,
+            dbg_xer_wr  => dbg_xer_wr,
+            dbg_wr_data => dbg_wr_data,
+            dbg_cr_data => dbg_cr_data,
             log_out  => log_data(183 downto 171)
         );
 
@@ -414,6 +518,10 @@ begin
             CPU_INDEX  => CPU_INDEX,
             EX1_BYPASS => EX1_BYPASS,
             HAS_FPU    => HAS_FPU,
+            DIV_RADIX_BITS => DIV_RADIX_BITS,
+            MUL_PIPELINE_DEPTH => MUL_PIPELINE_DEPTH,
+            DUAL_ISSUE => DUAL_ISSUE,
+            COSIM      => COSIM,
             LOG_LENGTH => LOG_LENGTH
         )
         port map (
@@ -440,12 +548,17 @@ begin
             ls_events       => loadstore_events,
             dc_events       => dcache_events,
             ic_events       => icache_events,
+            l2_events       => l2_events,
+            lb_events       => lbuf_events,
             run_out         => run_out,
             terminate_out   => terminate,
             dbg_spr_req     => dbg_spr_req,
             dbg_spr_ack     => dbg_spr_ack,
             dbg_spr_addr    => dbg_spr_addr,
             dbg_spr_data    => dbg_spr_data,
+            dbg_spr_wr      => dbg_spr_wr,
+            dbg_msr_wr      => dbg_msr_wr,
+            dbg_wr_data     => dbg_wr_data,
             sim_dump        => sim_ex_dump,
             sim_dump_done   => sim_cr_dump,
             log_out         => log_data(135 downto 124),
@@ -457,6 +570,9 @@ begin
     with_fpu : if HAS_FPU generate
     begin
         fpu_0 : entity work.fpu
+            generic map (
+                HAS_FAST_PATH => HAS_FPU_FAST_PATH
+                )
             port map (
                 clk      => clk,
                 rst      => rst_fpu,
@@ -516,6 +632,8 @@ begin
     -- Queue Instantiation
     queue : entity work.queue
         generic map (
+            SIM         => SIM,
+            CPU_INDEX   => CPU_INDEX,
             QUEUE_DEPTH => QUEUE_DEPTH
         )
         port map (
@@ -534,13 +652,21 @@ begin
             d_out          => queue_to_dcache,
             d_stall        => q_stall,
             m_in           => mmu_to_queue,
-            m_out          => queue_to_mmu
+            m_out          => queue_to_mmu,
+            read_wait_i    => loadstore_events.queue_empty_wait,
+            write_wait_i   => write_wait_i
         );
 
+    write_wait_o <= loadstore_events.queue_full_wait;
+
     loadstore1_0 : entity work.loadstore1
         generic map (
-            HAS_FPU    => HAS_FPU,
-            LOG_LENGTH => LOG_LENGTH
+            HAS_FPU            => HAS_FPU,
+            STORE_BUFFER_DEPTH => STORE_BUFFER_DEPTH,
+            DCACHE_LINE_SIZE   => DCACHE_LINE_SIZE,
+            CPU_INDEX          => CPU_INDEX,
+            COSIM              => COSIM,
+            LOG_LENGTH         => LOG_LENGTH
         )
         port map (
             clk           => clk,
@@ -574,6 +700,11 @@ begin
         );
 
     mmu_0 : entity work.mmu
+        generic map (
+            L2TLB_SIZE       => MMU_L2TLB_SIZE,
+            L2TLB_LARGE_SIZE => MMU_L2TLB_LARGE_SIZE,
+            PWC_SIZE         => MMU_PWC_SIZE
+            )
         port map (
             clk   => clk,
             rst   => core_rst,
@@ -586,7 +717,7 @@ begin
 
     dcache_0 : entity work.dcache
         generic map (
-            LINE_SIZE    => 64,
+            LINE_SIZE    => DCACHE_LINE_SIZE,
             NUM_LINES    => DCACHE_NUM_LINES,
             NUM_WAYS     => DCACHE_NUM_WAYS,
             TLB_SET_SIZE => DCACHE_TLB_SET_SIZE,
@@ -604,11 +735,16 @@ begin
             wishbone_in  => wishbone_data_in,
             wishbone_out => wishbone_data_out,
             snoop_in     => wb_snoop_in,
+            snoop_own    => wb_snoop_own,
             events       => dcache_events,
             log_out      => log_data(170 downto 151)
         );
 
     writeback_0 : entity work.writeback
+        generic map (
+            CPU_INDEX => CPU_INDEX,
+            COSIM     => COSIM
+            )
         port map (
             clk           => clk,
             rst           => rst_wback,
@@ -630,7 +766,8 @@ begin
 
     debug_0 : entity work.core_debug
         generic map (
-            LOG_LENGTH => LOG_LENGTH
+            LOG_LENGTH    => LOG_LENGTH,
+            START_STOPPED => START_STOPPED
         )
         port map (
             clk             => clk,
@@ -661,6 +798,14 @@ begin
             dbg_ls_spr_ack  => dbg_ls_spr_ack,
             dbg_ls_spr_addr => dbg_ls_spr_addr,
             dbg_ls_spr_data => dbg_ls_spr_data,
+            cr              => dbg_cr_data,
+            dbg_gpr_wr      => dbg_gpr_wr,
+            dbg_spr_wr      => dbg_spr_wr,
+            dbg_cr_wr       => dbg_cr_wr,
+            dbg_xer_wr      => dbg_xer_wr,
+            dbg_msr_wr      => dbg_msr_wr,
+            dbg_nia_wr      => dbg_nia_wr,
+            dbg_wr_data     => dbg_wr_data,
             log_data        => log_data,
             log_read_addr   => log_rd_addr,
             log_read_data   => log_rd_data,
@@ -10,7 +10,9 @@ use work.wishbone_types.all;
 entity core_debug is
     generic (
         -- Length of log buffer
-        LOG_LENGTH : natural := 512
+        LOG_LENGTH : natural := 512;
+        -- Come out of reset stopped, waiting for a debug start
+        START_STOPPED : boolean := false
         );
     port (
         clk             : in std_logic;
@@ -35,14 +37,16 @@ entity core_debug is
         msr             : in std_ulogic_vector(63 downto 0);
         wb_snoop_in     : in wishbone_master_out := wishbone_master_out_init;
 
-        -- GPR/FPR register read port
+        -- GPR/FPR register read/write port
         dbg_gpr_req     : out std_ulogic;
+        dbg_gpr_wr      : out std_ulogic;
         dbg_gpr_ack     : in std_ulogic;
         dbg_gpr_addr    : out gspr_index_t;
         dbg_gpr_data    : in std_ulogic_vector(63 downto 0);
 
-        -- SPR register read port for SPRs in execute1
+        -- SPR register read/write port for SPRs in execute1
         dbg_spr_req     : out std_ulogic;
+        dbg_spr_wr      : out std_ulogic;
         dbg_spr_ack     : in std_ulogic;
         dbg_spr_addr    : out std_ulogic_vector(7 downto 0);
         dbg_spr_data    : in std_ulogic_vector(63 downto 0);
@@ -53,6 +57,16 @@ entity core_debug is
         dbg_ls_spr_addr : out std_ulogic_vector(1 downto 0);
         dbg_ls_spr_data : in std_ulogic_vector(63 downto 0);
 
+        -- CR read, and one-cycle write strobes for CR, XER, MSR and NIA
+        cr              : in std_ulogic_vector(31 downto 0);
+        dbg_cr_wr       : out std_ulogic;
+        dbg_xer_wr      : out std_ulogic;
+        dbg_msr_wr      : out std_ulogic;
+        dbg_nia_wr      : out std_ulogic;
+
+        -- Write data for all of the above, and for GPR/FPR/SPR writes
+        dbg_wr_data     : out std_ulogic_vector(63 downto 0);
+
         -- Core logging data
         log_data        : in std_ulogic_vector(255 downto 0);
         log_read_addr   : in std_ulogic_vector(31 downto 0);
@@ -90,16 +104,20 @@ architecture behave of core_debug is
     constant DBG_CORE_STAT_STOPPED   : integer := 1;
     constant DBG_CORE_STAT_TERM      : integer := 2;
 
-    -- NIA register (read only for now)
+    -- NIA register.  Writing it (with the core stopped) redirects
+    -- fetch to the new address, in the mode given by the current MSR,
+    -- so write MSR first.
     constant DBG_CORE_NIA             : std_ulogic_vector(3 downto 0) := "0010";
 
-    -- MSR (read only)
+    -- MSR (write with the core stopped)
     constant DBG_CORE_MSR            : std_ulogic_vector(3 downto 0) := "0011";
 
     -- GSPR register index
     constant DBG_CORE_GSPR_INDEX     : std_ulogic_vector(3 downto 0) := "0100";
 
-    -- GSPR register data
+    -- GSPR register data.  Writes (with the core stopped) go to GPRs,
+    -- FPRs and the execute1 SPRs; writes to the loadstore1/MMU SPRs
+    -- are ignored.
     constant DBG_CORE_GSPR_DATA      : std_ulogic_vector(3 downto 0) := "0101";
 
     -- Log buffer address and data registers
@@ -108,6 +126,12 @@ architecture behave of core_debug is
     constant DBG_CORE_LOG_TRIGGER    : std_ulogic_vector(3 downto 0) := "1000";
     constant DBG_CORE_LOG_MTRIGGER   : std_ulogic_vector(3 downto 0) := "1001";
 
+    -- CR (write with the core stopped)
+    constant DBG_CORE_CR             : std_ulogic_vector(3 downto 0) := "1010";
+
+    -- GSPR index of XER, whose SO/OV/CA bits live in the CR file
+    constant GSPR_XER                : std_ulogic_vector(7 downto 0) := x"2c";
+
     constant LOG_INDEX_BITS : natural := log2(LOG_LENGTH);
 
     -- Some internal wires
@@ -118,7 +142,12 @@ architecture behave of core_debug is
     signal do_step      : std_ulogic;
     signal do_reset     : std_ulogic;
     signal do_icreset   : std_ulogic;
+    signal do_cr_wr     : std_ulogic;
+    signal do_xer_wr    : std_ulogic;
+    signal do_msr_wr    : std_ulogic;
+    signal do_nia_wr    : std_ulogic;
     signal terminated   : std_ulogic;
+    signal wr_ok        : std_ulogic;
     signal do_gspr_rd   : std_ulogic;
     signal gspr_index   : std_ulogic_vector(7 downto 0);
     signal gspr_data    : std_ulogic_vector(63 downto 0);
@@ -143,6 +172,11 @@ begin
     dmi_ack <= dmi_req when dmi_addr /= DBG_CORE_GSPR_DATA
                else dbg_gpr_ack or dbg_spr_ack or dbg_ls_spr_ack;
 
+    -- Register writes only take effect with the core stopped (which it
+    -- also is once terminated); while it runs they are dropped, and a
+    -- GSPR data write is done as a read so that DMI still gets an ack.
+    wr_ok <= stopping and core_stopped;
+
     -- Status register read composition
     stat_reg <= (2 => terminated,
                  1 => core_stopped,
@@ -160,6 +194,7 @@ begin
         nia             when DBG_CORE_NIA,
         msr             when DBG_CORE_MSR,
         gspr_data       when DBG_CORE_GSPR_DATA,
+        32x"0" & cr     when DBG_CORE_CR,
         log_write_addr & log_dmi_addr when DBG_CORE_LOG_ADDR,
         log_dmi_data    when DBG_CORE_LOG_DATA,
         log_dmi_trigger when DBG_CORE_LOG_TRIGGER,
@@ -174,10 +209,18 @@ begin
             do_step <= '0';
             do_reset <= '0';
             do_icreset <= '0';
+            do_cr_wr <= '0';
+            do_xer_wr <= '0';
+            do_msr_wr <= '0';
+            do_nia_wr <= '0';
             do_dmi_log_rd <= '0';
 
             if (rst) then
-                stopping <= '0';
+                if START_STOPPED then
+                    stopping <= '1';
+                else
+                    stopping <= '0';
+                end if;
                 terminated <= '0';
                 log_trigger_delay <= 0;
                 gspr_index <= (others => '0');
@@ -229,6 +272,14 @@ begin
                                 stopping <= '0';
                                 terminated <= '0';
                             end if;
+                        elsif dmi_addr = DBG_CORE_NIA then
+                            do_nia_wr <= wr_ok;
+                        elsif dmi_addr = DBG_CORE_MSR then
+                            do_msr_wr <= wr_ok;
+                        elsif dmi_addr = DBG_CORE_CR then
+                            do_cr_wr <= wr_ok;
+                        elsif dmi_addr = DBG_CORE_GSPR_DATA and gspr_index = GSPR_XER then
+                            do_xer_wr <= wr_ok;
                         elsif dmi_addr = DBG_CORE_GSPR_INDEX then
                             gspr_index <= dmi_din(7 downto 0);
                         elsif dmi_addr = DBG_CORE_LOG_ADDR then
@@ -239,6 +290,10 @@ begin
                         elsif dmi_addr = DBG_CORE_LOG_MTRIGGER then
                             log_mem_trigger <= dmi_din;
                         end if;
+                        if wr_ok = '0' and (dmi_addr = DBG_CORE_NIA or dmi_addr = DBG_CORE_MSR or
+                                            dmi_addr = DBG_CORE_CR or dmi_addr = DBG_CORE_GSPR_DATA) then
+                            report "DMI write ignored, core not stopped" severity warning;
+                        end if;
                     else
                         report("DMI read from " & to_string(dmi_addr));
                     end if;
@@ -278,6 +333,9 @@ begin
             dbg_gpr_req <= '0';
             dbg_spr_req <= '0';
             dbg_ls_spr_req <= '0';
+            dbg_gpr_wr <= dmi_wr and wr_ok;
+            dbg_spr_wr <= dmi_wr and wr_ok;
+            dbg_wr_data <= dmi_din;
             if rst = '0' and dmi_req = '1' and dmi_addr = DBG_CORE_GSPR_DATA then
                 if gspr_index(5) = '0' then
                     dbg_gpr_req <= '1';
@@ -352,6 +410,10 @@ begin
     core_stop <= stopping and not do_step;
     core_rst <= do_reset;
     icache_rst <= do_icreset;
+    dbg_cr_wr <= do_cr_wr;
+    dbg_xer_wr <= do_xer_wr;
+    dbg_msr_wr <= do_msr_wr;
+    dbg_nia_wr <= do_nia_wr;
     terminated_out <= terminated;
 
     -- Logging RAM
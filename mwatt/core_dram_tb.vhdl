@@ -14,7 +14,9 @@ entity core_dram_tb is
         DRAM_INIT_FILE : string  := "";
         DRAM_INIT_SIZE : natural := 16#c000#;
         L2_TRACE : boolean := false;
-        LITEDRAM_TRACE : boolean := false
+        LITEDRAM_TRACE : boolean := false;
+        NCPUS : positive := 1;
+        HAS_SHARED_L2 : boolean := false
         );
 end core_dram_tb;
 
@@ -60,6 +62,8 @@ begin
     soc0: entity work.soc
         generic map(
             SIM => true,
+            NCPUS => NCPUS,
+            HAS_SHARED_L2 => HAS_SHARED_L2,
             MEMORY_SIZE => MEMORY_SIZE,
             RAM_INIT_FILE => MAIN_RAM_FILE,
             HAS_DRAM => true,
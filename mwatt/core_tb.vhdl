@@ -7,6 +7,18 @@ use work.common.all;
 use work.wishbone_types.all;
 
 entity core_tb is
+    generic (
+        -- Run this many instructions, or up to this PC, in the
+        -- sim_isa_model reference model before starting the cores
+        FFWD_INSNS : natural := 0;
+        FFWD_PC    : integer := -1;
+        -- Check every completed instruction against the reference model
+        COSIM      : boolean := false;
+        DUAL_ISSUE : boolean := false;
+        HAS_FUSION : boolean := false;
+        HAS_LOOP_BUFFER : boolean := false;
+        STORE_BUFFER_DEPTH : natural := 4
+        );
 end core_tb;
 
 architecture behave of core_tb is
@@ -21,7 +33,13 @@ begin
             SIM => true,
             MEMORY_SIZE => (384*1024),
             RAM_INIT_FILE => "main_ram.bin",
-            CLK_FREQ => 100000000
+            CLK_FREQ => 100000000,
+            START_STOPPED => FFWD_INSNS /= 0 or FFWD_PC /= -1,
+            COSIM => COSIM,
+            DUAL_ISSUE => DUAL_ISSUE,
+            HAS_FUSION => HAS_FUSION,
+            HAS_LOOP_BUFFER => HAS_LOOP_BUFFER,
+            STORE_BUFFER_DEPTH => STORE_BUFFER_DEPTH
             )
         port map(
             rst => rst,
@@ -44,6 +62,10 @@ begin
         wait;
     end process;
 
-    jtag: entity work.sim_jtag;
+    jtag: entity work.sim_jtag
+        generic map(
+            FFWD_INSNS => FFWD_INSNS,
+            FFWD_PC => FFWD_PC
+            );
 
 end;
@@ -20,6 +20,12 @@ entity cr_file is
         w_in  : in WritebackToCrFileType;
         ctrl  : in ctrl_t;
 
+        -- debug access, only used with the core stopped
+        dbg_cr_wr   : in std_ulogic := '0';
+        dbg_xer_wr  : in std_ulogic := '0';
+        dbg_wr_data : in std_ulogic_vector(63 downto 0) := (others => '0');
+        dbg_cr_data : out std_ulogic_vector(31 downto 0);
+
         -- debug
         sim_dump : in std_ulogic;
 
@@ -73,9 +79,22 @@ begin
                     " CA32=" & std_ulogic'image(xerc_updated.ca32);
                 xerc <= xerc_updated;
             end if;
+            if dbg_cr_wr = '1' then
+                report "Debug writing CR " & to_hstring(dbg_wr_data(31 downto 0));
+                crs <= dbg_wr_data(31 downto 0);
+            end if;
+            if dbg_xer_wr = '1' then
+                xerc.so <= dbg_wr_data(31);
+                xerc.ov <= dbg_wr_data(30);
+                xerc.ca <= dbg_wr_data(29);
+                xerc.ov32 <= dbg_wr_data(19);
+                xerc.ca32 <= dbg_wr_data(18);
+            end if;
         end if;
     end process;
 
+    dbg_cr_data <= crs;
+
     -- asynchronous reads
     cr_read_0: process(all)
     begin
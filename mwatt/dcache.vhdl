@@ -26,6 +26,8 @@ entity dcache is
         TLB_NUM_WAYS : positive := 2;
         -- L1 DTLB log_2(page_size)
         TLB_LG_PGSZ  : positive := 12;
+        -- L1 DTLB entries for 2MB/1GB pages (fully associative)
+        TLB_LARGE_SIZE : natural := 4;
         -- Non-zero to enable log data collection
         LOG_LENGTH   : natural  := 0
     );
@@ -39,7 +41,8 @@ entity dcache is
         m_in  : in  MmuToDcacheType;
         m_out : out DcacheToMmuType;
 
-        snoop_in : in wishbone_master_out := wishbone_master_out_init;
+        snoop_in  : in wishbone_master_out := wishbone_master_out_init;
+        snoop_own : in std_ulogic := '0';
 
         stall_out : out std_ulogic;
 
@@ -55,7 +58,9 @@ end entity dcache;
 architecture rtl of dcache is
     -- BRAM organisation: We never access more than wishbone_data_bits at
     -- a time so to save resources we make the array only that wide, and
-    -- use consecutive indices to make a cache "line"
+    -- use consecutive indices to make a cache "line". Each way is split
+    -- into even and odd rows so that a load crossing a doubleword can read
+    -- both of its rows in one cycle.
     --
     -- ROW_SIZE is the width in bytes of the BRAM (based on WB, so 64-bits)
     constant ROW_SIZE     : natural := wishbone_data_bits / 8;
@@ -157,6 +162,19 @@ architecture rtl of dcache is
     attribute ram_style of dtlb_tags : signal is "distributed";
     attribute ram_style of dtlb_ptes : signal is "distributed";
 
+    -- Large page TLB.  A hit here is substituted for way 0 of the set
+    -- read from the main TLB, so the rest of the pipeline just sees an
+    -- ordinary TLB hit.
+    type ltlb_entry_t is record
+        valid : std_ulogic;
+        huge  : std_ulogic;
+        tag   : std_ulogic_vector(63 downto 21);
+        pte   : tlb_pte_t;
+    end record;
+    type ltlb_t is array(0 to maximum(TLB_LARGE_SIZE, 1) - 1) of ltlb_entry_t;
+    signal dtlb_large : ltlb_t;
+    signal ltlb_repl  : integer range 0 to maximum(TLB_LARGE_SIZE, 1) - 1;
+
     -- Record for storing permission, attribute, etc. bits from a PTE
     type perm_attr_t is record
         reference : std_ulogic;
@@ -288,6 +306,8 @@ architecture rtl of dcache is
         tlbie   : std_ulogic;           -- indicates a tlbie request (from MMU)
         doall   : std_ulogic;  -- with tlbie, indicates flush whole TLB
         tlbld   : std_ulogic;  -- indicates a TLB load request (from MMU)
+        large   : std_ulogic;  -- with tlbld, 2MB page
+        huge    : std_ulogic;  -- with tlbld, 1GB page
         mmu_req : std_ulogic;           -- indicates source of request
         d_valid : std_ulogic;           -- indicates req.data is valid now
     end record;
@@ -317,6 +337,7 @@ architecture rtl of dcache is
         same_tag  : std_ulogic;
         mmu_req   : std_ulogic;
         dawr_m    : std_ulogic;
+        dual      : std_ulogic;
     end record;
 
     -- First stage register, contains state for stage 1 of load hits
@@ -351,6 +372,12 @@ architecture rtl of dcache is
         forward_valid : std_ulogic;
         forward_row   : row_t;
         data_out      : std_ulogic_vector(63 downto 0);
+        data_out2     : std_ulogic_vector(63 downto 0);
+
+        -- first row of a dual load that missed, and whether an NC
+        -- dual load is reading its second row
+        dual_data     : std_ulogic_vector(63 downto 0);
+        dual_second   : std_ulogic;
 
         -- Cache miss state (reload state machine)
         state         : state_t;
@@ -419,17 +446,21 @@ architecture rtl of dcache is
     signal early_req_row  : row_t;
     signal early_rd_valid : std_ulogic;
 
-    signal r0_valid : std_ulogic;
-    signal r0_stall : std_ulogic;
+    signal r0_valid  : std_ulogic;
+    signal r0_stall  : std_ulogic;
+    signal dual_wait : std_ulogic;
 
-    signal fwd_same_tag   : std_ulogic;
-    signal use_forward_st : std_ulogic;
-    signal use_forward_rl : std_ulogic;
-    signal use_forward2   : std_ulogic;
+    signal fwd_same_tag      : std_ulogic;
+    signal use_forward_st    : std_ulogic;
+    signal use_forward_rl    : std_ulogic;
+    signal use_forward2      : std_ulogic;
+    signal use_forward_st_r2 : std_ulogic;
+    signal use_forward2_r2   : std_ulogic;
 
     -- Cache RAM interface
     type cache_ram_out_t is array(0 to NUM_WAYS-1) of cache_row_t;
     signal cache_out     : cache_ram_out_t;
+    signal cache_out2    : cache_ram_out_t;
     signal ram_wr_data   : cache_row_t;
     signal ram_wr_select : std_ulogic_vector(ROW_SIZE - 1 downto 0);
 
@@ -592,6 +623,7 @@ begin
     assert (64 = wishbone_data_bits)
         report "Can't yet handle a wishbone width that isn't 64-bits" severity failure;
     assert SET_SIZE_BITS <= TLB_LG_PGSZ report "Set indexed by virtual address" severity failure;
+    assert TLB_LARGE_SIZE = 0 or TLB_LG_PGSZ = 12 report "Large page TLB needs 4kB base pages" severity failure;
 
     -- Latch the request in r0.req as long as we're not stalling
     stage_0 : process(clk)
@@ -611,6 +643,8 @@ begin
                 r.tlbie         := m_in.tlbie;
                 r.doall         := m_in.doall;
                 r.tlbld         := m_in.tlbld;
+                r.large         := m_in.large;
+                r.huge          := m_in.huge;
                 r.mmu_req       := '1';
                 r.d_valid       := '1';
             else
@@ -619,6 +653,8 @@ begin
                 r.tlbie    := '0';
                 r.doall    := '0';
                 r.tlbld    := '0';
+                r.large    := '0';
+                r.huge     := '0';
                 r.mmu_req  := '0';
                 r.d_valid  := '0';
             end if;
@@ -627,7 +663,7 @@ begin
             end if;
             if rst = '1' then
                 r0_full <= '0';
-            elsif r1.full = '0' and d_in.hold = '0' then
+            elsif r1.full = '0' and d_in.hold = '0' and dual_wait = '0' then
                 r0      <= r;
                 r0_full <= r.req.valid;
             elsif r0.d_valid = '0' then
@@ -645,10 +681,28 @@ begin
     -- we don't yet handle collisions between loadstore1 requests and MMU requests
     m_out.stall <= '0';
 
+    -- A dual load can only complete as a hit once both of its rows are
+    -- in the cache, so if its line is being reloaded, keep it in r0 until
+    -- they have both arrived. This only looks at the index, not the tag,
+    -- so that it doesn't depend on the TLB and tag compare.
+    dual_check : process(all)
+        variable row : row_t;
+    begin
+        row := get_row(r0.req.addr);
+        dual_wait <= '0';
+        if r0_full = '1' and r0.req.dual = '1' and r1.state = RELOAD_WAIT_ACK and
+            get_index(r0.req.addr) = r1.store_index then
+            if r1.rows_valid(to_integer(get_row_of_line(row))) = '0' or
+                r1.rows_valid(to_integer(get_row_of_line(next_row(row)))) = '0' then
+                dual_wait <= '1';
+            end if;
+        end if;
+    end process;
+
     -- Hold off the request in r0 when r1 has an uncompleted request
-    r0_stall  <= r1.full or d_in.hold;
-    r0_valid  <= r0_full and not r1.full and not d_in.hold;
-    stall_out <= r1.full;
+    r0_stall  <= r1.full or d_in.hold or dual_wait;
+    r0_valid  <= r0_full and not r1.full and not d_in.hold and not dual_wait;
+    stall_out <= r1.full or dual_wait;
 
     events <= ev;
 
@@ -659,6 +713,10 @@ begin
         variable index    : tlb_index_t;
         variable addrbits : std_ulogic_vector(TLB_SET_BITS - 1 downto 0);
         variable valid    : std_ulogic;
+        variable lhit     : std_ulogic;
+        variable lpte     : tlb_pte_t;
+        variable tagset   : tlb_way_tags_t;
+        variable pteset   : tlb_way_ptes_t;
     begin
         if rising_edge(clk) then
             if m_in.valid = '1' then
@@ -681,6 +739,34 @@ begin
                     tlb_valid_way <= dtlb_valids(index);
                     tlb_tag_way   <= dtlb_tags(index);
                     tlb_pte_way   <= dtlb_ptes(index);
+
+                    -- Look up loadstore1 requests in the large page TLB
+                    lhit := '0';
+                    lpte := (others => '0');
+                    if TLB_LARGE_SIZE > 0 and m_in.valid = '0' then
+                        for i in 0 to TLB_LARGE_SIZE - 1 loop
+                            if dtlb_large(i).valid = '1' and
+                                dtlb_large(i).tag(63 downto 30) = d_in.addr(63 downto 30) and
+                                (dtlb_large(i).huge = '1' or
+                                 dtlb_large(i).tag(29 downto 21) = d_in.addr(29 downto 21)) then
+                                lhit := '1';
+                                lpte := dtlb_large(i).pte;
+                                if dtlb_large(i).huge = '1' then
+                                    lpte(29 downto 21) := d_in.addr(29 downto 21);
+                                end if;
+                                lpte(20 downto 12) := d_in.addr(20 downto 12);
+                            end if;
+                        end loop;
+                    end if;
+                    if lhit = '1' then
+                        tagset := dtlb_tags(index);
+                        write_tlb_tag(0, tagset, d_in.addr(63 downto TLB_LG_PGSZ + TLB_SET_BITS));
+                        pteset := dtlb_ptes(index);
+                        write_tlb_pte(0, pteset, lpte);
+                        tlb_valid_way(0) <= '1';
+                        tlb_tag_way      <= tagset;
+                        tlb_pte_way      <= pteset;
+                    end if;
                 end if;
             end if;
             if rst = '1' then
@@ -787,6 +873,23 @@ begin
             tlbie                 := r0_valid and r0.tlbie;
             tlbwe                 := r0_valid and r0.tlbld;
             ev.dtlb_miss_resolved <= tlbwe;
+            if rst = '1' or tlbie = '1' then
+                -- any tlbie flushes the whole large page TLB
+                for i in 0 to TLB_LARGE_SIZE - 1 loop
+                    dtlb_large(i).valid <= '0';
+                end loop;
+                ltlb_repl <= 0;
+            elsif tlbwe = '1' and (r0.large or r0.huge) = '1' and TLB_LARGE_SIZE > 0 then
+                dtlb_large(ltlb_repl).valid <= '1';
+                dtlb_large(ltlb_repl).huge  <= r0.huge;
+                dtlb_large(ltlb_repl).tag   <= r0.req.addr(63 downto 21);
+                dtlb_large(ltlb_repl).pte   <= r0.req.data;
+                if ltlb_repl = TLB_LARGE_SIZE - 1 then
+                    ltlb_repl <= 0;
+                else
+                    ltlb_repl <= ltlb_repl + 1;
+                end if;
+            end if;
             if rst = '1' or (tlbie = '1' and r0.doall = '1') then
                 -- clear all valid bits at once
                 for i in tlb_index_t loop
@@ -798,7 +901,7 @@ begin
                     assert not is_X(tlb_hit_way);
                     dtlb_valids(to_integer(tlb_req_index))(to_integer(tlb_hit_way)) <= '0';
                 end if;
-            elsif tlbwe = '1' then
+            elsif tlbwe = '1' and not ((r0.large or r0.huge) = '1' and TLB_LARGE_SIZE > 0) then
                 assert not is_X(tlb_req_index);
                 repl_way := to_unsigned(0, TLB_WAY_BITS);
                 if TLB_NUM_WAYS > 1 then
@@ -897,10 +1000,10 @@ begin
     end process;
 
     -- Snoop logic
-    -- Don't snoop our own cycles
+    -- Don't snoop our own cycles; the SoC tells us which ones they are
+    -- since with a crossbar other masters can write while we are.
     snoop_addr   <= addr_to_real(wb_to_addr(snoop_in.adr));
-    snoop_active <= snoop_in.cyc and snoop_in.stb and snoop_in.we and
-                    not (r1.wb.cyc and not wishbone_in.stall);
+    snoop_active <= snoop_in.cyc and snoop_in.stb and snoop_in.we and not snoop_own;
     kill_rsrv <= '1' when (snoop_active = '1' and reservation.valid = '1' and
                            snoop_addr(REAL_ADDR_BITS - 1 downto LINE_OFF_BITS) = reservation.addr)
                  else '0';
@@ -938,6 +1041,7 @@ begin
     -- Cache request parsing and hit detection
     dcache_request : process(all)
         variable req_row     : row_t;
+        variable req_row2    : row_t;
         variable rindex      : index_t;
         variable is_hit      : std_ulogic;
         variable hit_way     : way_t;
@@ -962,6 +1066,7 @@ begin
         rindex    := get_index(r0.req.addr);
         req_index <= rindex;
         req_row   := get_row(r0.req.addr);
+        req_row2  := next_row(req_row);
         req_tag   <= get_tag(ra);
         if r0.d_valid = '0' then
             dawr_match := d_in.dawr_match;
@@ -975,6 +1080,8 @@ begin
         end if;
         if go = '1' then
             assert not is_X(r1.forward_tag);
+            assert not (r0.req.dual = '1' and get_row_of_line(req_row2) = 0)
+                report "dual load crosses a cache line" severity failure;
         end if;
 
         -- Test if pending request is a hit on any way
@@ -1085,6 +1192,18 @@ begin
             use_forward2 <= r1.forward_valid;
         end if;
 
+        -- Same for the second row of a dual load. It can't be arriving
+        -- from a reload this cycle since dual_wait holds the load in r0
+        -- until both rows are valid.
+        use_forward_st_r2 <= '0';
+        if rel_match = '1' and r1.store_row = req_row2 then
+            use_forward_st_r2 <= r1.write_bram;
+        end if;
+        use_forward2_r2 <= '0';
+        if fwd_match = '1' and r1.forward_row = req_row2 then
+            use_forward2_r2 <= r1.forward_valid;
+        end if;
+
         -- The way to replace on a miss
         replace_way <= to_unsigned(0, WAY_BITS);
         if NUM_WAYS > 1 then
@@ -1216,10 +1335,12 @@ begin
     begin
         d_out.valid         <= r1.ls_valid;
         d_out.data          <= r1.data_out;
+        d_out.data2         <= r1.data_out2;
         d_out.store_done    <= not r1.stcx_fail;
         d_out.error         <= r1.ls_error;
         d_out.cache_paradox <= r1.cache_paradox;
         d_out.reserve_nc    <= r1.reserve_nc;
+        d_out.real_addr     <= r1.req.real_addr;
 
         -- Outputs to MMU
         m_out.done <= r1.mmu_done;
@@ -1297,36 +1418,71 @@ begin
     --       icache. The writeback logic needs to take that into
     --       account by using 1-cycle delayed signals for load hits.
     --
+    -- Each way is made of two RAMs, one for the even rows and one for the
+    -- odd rows. Reads always fetch the requested row and the one after
+    -- it in the same line, which come out as cache_out and cache_out2.
+    --
     rams : for i in 0 to NUM_WAYS-1 generate
         signal do_read  : std_ulogic;
-        signal rd_addr  : std_ulogic_vector(ROW_BITS-1 downto 0);
-        signal wr_addr  : std_ulogic_vector(ROW_BITS-1 downto 0);
-        signal wr_data  : std_ulogic_vector(wishbone_data_bits-1 downto 0);
-        signal wr_sel   : std_ulogic_vector(ROW_SIZE-1 downto 0);
-        signal wr_sel_m : std_ulogic_vector(ROW_SIZE-1 downto 0);
-        signal dout     : cache_row_t;
+        signal rd_addr0 : std_ulogic_vector(ROW_BITS-2 downto 0);
+        signal rd_addr1 : std_ulogic_vector(ROW_BITS-2 downto 0);
+        signal wr_addr  : std_ulogic_vector(ROW_BITS-2 downto 0);
+        signal wr_sel0  : std_ulogic_vector(ROW_SIZE-1 downto 0);
+        signal wr_sel1  : std_ulogic_vector(ROW_SIZE-1 downto 0);
+        signal dout0    : cache_row_t;
+        signal dout1    : cache_row_t;
     begin
-        way : entity work.cache_ram
+        even : entity work.cache_ram
             generic map (
-                ROW_BITS => ROW_BITS,
+                ROW_BITS => ROW_BITS - 1,
                 WIDTH    => wishbone_data_bits,
                 ADD_BUF  => false
             )
             port map (
                 clk     => clk,
                 rd_en   => do_read,
-                rd_addr => rd_addr,
-                rd_data => dout,
-                wr_sel  => wr_sel_m,
+                rd_addr => rd_addr0,
+                rd_data => dout0,
+                wr_sel  => wr_sel0,
+                wr_addr => wr_addr,
+                wr_data => ram_wr_data
+            );
+        odd : entity work.cache_ram
+            generic map (
+                ROW_BITS => ROW_BITS - 1,
+                WIDTH    => wishbone_data_bits,
+                ADD_BUF  => false
+            )
+            port map (
+                clk     => clk,
+                rd_en   => do_read,
+                rd_addr => rd_addr1,
+                rd_data => dout1,
+                wr_sel  => wr_sel1,
                 wr_addr => wr_addr,
                 wr_data => ram_wr_data
             );
         process(all)
+            variable row      : row_t;
+            variable wr_sel_m : std_ulogic_vector(ROW_SIZE-1 downto 0);
         begin
-            -- Cache hit reads
-            do_read      <= early_rd_valid;
-            rd_addr      <= std_ulogic_vector(early_req_row);
-            cache_out(i) <= dout;
+            -- Cache hit reads. The odd row is in the same pair as the
+            -- requested row, the even row is in the next pair if the
+            -- requested row is odd.
+            do_read  <= early_rd_valid;
+            row      := early_req_row;
+            rd_addr1 <= std_ulogic_vector(row(ROW_BITS-1 downto 1));
+            if row(0) = '1' then
+                row := next_row(row);
+            end if;
+            rd_addr0 <= std_ulogic_vector(row(ROW_BITS-1 downto 1));
+            if r0.req.addr(ROW_OFF_BITS) = '0' then
+                cache_out(i)  <= dout0;
+                cache_out2(i) <= dout1;
+            else
+                cache_out(i)  <= dout1;
+                cache_out2(i) <= dout0;
+            end if;
 
             -- Write mux:
             --
@@ -1335,16 +1491,23 @@ begin
             -- For timing, the mux on wr_data/sel/addr is not dependent on anything
             -- other than the current state.
             --
-            wr_addr <= std_ulogic_vector(r1.store_row);
+            wr_addr <= std_ulogic_vector(r1.store_row(ROW_BITS-1 downto 1));
 
-            wr_sel_m <= (others => '0');
+            wr_sel_m := (others => '0');
             if r1.write_bram = '1' or
                 (r1.state = RELOAD_WAIT_ACK and wishbone_in.ack = '1') then
                 assert not is_X(replace_way);
                 if to_unsigned(i, WAY_BITS) = replace_way then
-                    wr_sel_m <= ram_wr_select;
+                    wr_sel_m := ram_wr_select;
                 end if;
             end if;
+            if r1.store_row(0) = '0' then
+                wr_sel0 <= wr_sel_m;
+                wr_sel1 <= (others => '0');
+            else
+                wr_sel0 <= (others => '0');
+                wr_sel1 <= wr_sel_m;
+            end if;
 
         end process;
     end generate;
@@ -1355,8 +1518,9 @@ begin
     --
     dcache_fast_hit : process(clk)
         variable j        : integer;
-        variable sel      : std_ulogic_vector(1 downto 0);
-        variable data_out : std_ulogic_vector(63 downto 0);
+        variable sel       : std_ulogic_vector(1 downto 0);
+        variable data_out  : std_ulogic_vector(63 downto 0);
+        variable data_out2 : std_ulogic_vector(63 downto 0);
     begin
         if rising_edge(clk) then
             if r0_valid = '1' then
@@ -1393,7 +1557,41 @@ begin
                         end if;
                 end case;
             end loop;
-            r1.data_out <= data_out;
+
+            -- The same for the second row of a dual load. A dual load that
+            -- missed completes when its second row arrives, with the first
+            -- row saved in r1.dual_data.
+            for i in 0 to 7 loop
+                if r1.full = '1' then
+                    sel := "00";
+                elsif use_forward_st_r2 = '1' and r1.req.byte_sel(i) = '1' then
+                    sel := "01";
+                elsif use_forward2_r2 = '1' and r1.forward_sel(i) = '1' then
+                    sel := "10";
+                else
+                    sel := "11";
+                end if;
+                j := i * 8;
+                case sel is
+                    when "00" =>
+                        data_out2(j + 7 downto j) := wishbone_in.dat(j + 7 downto j);
+                    when "01" =>
+                        data_out2(j + 7 downto j) := r1.req.data(j + 7 downto j);
+                    when "10" =>
+                        data_out2(j + 7 downto j) := r1.forward_data(j + 7 downto j);
+                    when others =>
+                        if is_X(req_hit_way) then
+                            data_out2(j + 7 downto j) := (others => 'X');
+                        else
+                            data_out2(j + 7 downto j) := cache_out2(to_integer(req_hit_way))(j + 7 downto j);
+                        end if;
+                end case;
+            end loop;
+            if r1.full = '1' and r1.req.dual = '1' then
+                data_out := r1.dual_data;
+            end if;
+            r1.data_out  <= data_out;
+            r1.data_out2 <= data_out2;
 
             r1.forward_data  <= ram_wr_data;
             r1.forward_tag   <= r1.reload_tag;
@@ -1446,6 +1644,7 @@ begin
         variable stbs_done : boolean;
         variable req       : mem_access_request_t;
         variable acks      : unsigned(2 downto 0);
+        variable last_row  : row_t;
     begin
         if rising_edge(clk) then
             ev.dcache_refill <= '0';
@@ -1471,6 +1670,7 @@ begin
                 r1.dec_acks        <= '0';
                 r1.prev_hit        <= '0';
                 r1.prev_hit_reload <= '0';
+                r1.dual_second     <= '0';
                 reservation.valid  <= '0';
                 reservation.addr   <= (others => '0');
 
@@ -1544,6 +1744,7 @@ begin
                     req.first_dw  := not r0.req.atomic_qw or r0.req.atomic_first;
                     req.last_dw   := not r0.req.atomic_qw or r0.req.atomic_last;
                     req.real_addr := ra;
+                    req.dual      := r0.req.dual;
                     -- Force data to 0 for dcbz
                     if r0.req.dcbz = '1' then
                         req.data := (others => '0');
@@ -1727,9 +1928,19 @@ begin
                                 assert not is_X(r1.store_row);
                                 assert not is_X(r1.req.real_addr);
                             end if;
+                            -- A dual load keeps its first row and completes when
+                            -- the next row arrives.
+                            last_row := get_row(r1.req.real_addr);
+                            if r1.req.dual = '1' then
+                                last_row := next_row(last_row);
+                            end if;
+                            if r1.full = '1' and r1.req.same_tag = '1' and r1.req.dual = '1' and
+                                r1.store_row = get_row(r1.req.real_addr) then
+                                r1.dual_data <= wishbone_in.dat;
+                            end if;
                             if r1.full = '1' and r1.req.same_tag = '1' and
                                 ((r1.dcbz = '1' and r1.req.dcbz = '1') or r1.req.op_lmiss = '1') and
-                                r1.store_row = get_row(r1.req.real_addr) then
+                                r1.store_row = last_row then
                                 r1.full       <= '0';
                                 r1.slow_valid <= '1';
                                 if r1.mmu_req = '0' then
@@ -1823,8 +2034,18 @@ begin
                             r1.wb.stb <= '0';
                         end if;
 
-                        -- Got ack ? complete.
-                        if wishbone_in.ack = '1' then
+                        -- Got ack ? complete, unless this is the first half
+                        -- of a dual load. Its second doubleword is read in
+                        -- full since we don't know how many bytes of it the
+                        -- load wants.
+                        if wishbone_in.ack = '1' and r1.req.dual = '1' and r1.dual_second = '0' then
+                            r1.dual_data   <= wishbone_in.dat;
+                            r1.dual_second <= '1';
+                            r1.wb.adr      <= next_row_wb_addr(r1.wb.adr);
+                            r1.wb.sel      <= (others => '1');
+                            r1.wb.stb      <= '1';
+                        elsif wishbone_in.ack = '1' then
+                            r1.dual_second <= '0';
                             r1.state      <= IDLE;
                             r1.full       <= '0';
                             r1.slow_valid <= '1';
@@ -54,6 +54,7 @@ architecture behave of dcache_tb is
         d_in_o.dawr_match   <= '0';
         d_in_o.virt_mode    <= '0';
         d_in_o.priv_mode    <= '1';
+        d_in_o.dual         <= '0';
         d_in_o.addr         <= (others => '0');
         d_in_o.data         <= (others => '0');
         d_in_o.byte_sel     <= (others => '1');
@@ -64,6 +65,8 @@ architecture behave of dcache_tb is
         m_in_o.tlbie  <= '0';
         m_in_o.doall  <= '0';
         m_in_o.tlbld  <= '0';
+        m_in_o.large  <= '0';
+        m_in_o.huge   <= '0';
 
         -- Wait for signals to settle
         wait for 4 * clk_period;
@@ -126,6 +129,37 @@ architecture behave of dcache_tb is
             severity failure;
     end procedure do_nc_read;
 
+
+    procedure do_dual_read(
+        signal clk_i             : in  std_ulogic;
+        signal stall_i           : in  std_ulogic;
+        signal d_in_o            : out Loadstore1ToDcacheType;
+        signal d_out_i           : in  DcacheToLoadstore1Type;
+        constant address       : in  std_ulogic_vector(63 downto 0);
+        constant nc            : in  std_ulogic;
+        constant expected_data : in  std_ulogic_vector(63 downto 0);
+        constant expected_data2 : in std_ulogic_vector(63 downto 0)
+    ) is
+    begin
+        report "Dual read of address " & to_hstring(address) & "...";
+        d_in_o.load  <= '1';
+        d_in_o.nc    <= nc;
+        d_in_o.dual  <= '1';
+        d_in_o.addr  <= address;
+        d_in_o.valid <= '1';
+
+        wait until rising_edge(clk_i) and stall_i = '0';
+        d_in_o.valid <= '0';
+
+        wait until rising_edge(clk_i) and d_out_i.valid = '1';
+        d_in_o.dual  <= '0';
+        assert d_out_i.data = expected_data and d_out_i.data2 = expected_data2
+            report "data @" & to_hstring(address) &
+                   " = " & to_hstring(d_out_i.data) & " " & to_hstring(d_out_i.data2) &
+                   " expected " & to_hstring(expected_data) & " " & to_hstring(expected_data2)
+            severity failure;
+    end procedure do_dual_read;
+
 begin
 
     ----------------------------------------------------------------------------
@@ -222,6 +256,22 @@ begin
         -- Non-cacheable read of address 200
         do_nc_read(clk, stall, d_in, d_out, x"0000000000000200", x"0000008100000080");
 
+        -- Dual read of address 134, hitting in the line read above
+        do_dual_read(clk, stall, d_in, d_out, x"0000000000000134", '0',
+                     x"0000004D0000004C", x"0000004F0000004E");
+
+        -- Dual read of address 184, a miss
+        do_dual_read(clk, stall, d_in, d_out, x"0000000000000184", '0',
+                     x"0000006100000060", x"0000006300000062");
+
+        -- Ensure reload completes
+        wait for 100 * clk_period;
+        wait until rising_edge(clk);
+
+        -- Non-cacheable dual read of address 204
+        do_dual_read(clk, stall, d_in, d_out, x"0000000000000204", '1',
+                     x"0000008100000080", x"0000008300000082");
+
         -- Wait a few extra cycles
         wait for 4 * clk_period;
         wait until rising_edge(clk);
@@ -45,22 +45,16 @@ int main(void)
   puts("[Core0]: "); print_hex(addr2); puts(" -> "); print_hex(*(unsigned long*)&val2); puts("\n");
   puts("[Core0]: "); print_hex(addr3); puts(" -> "); print_hex(*(unsigned long*)&val3); puts("\n");
   puts("[Core0]: "); print_hex(addr4); puts(" -> "); print_hex(*(unsigned long*)&val4); puts("\n");
-  __asm__ volatile("ld 14, %0" : : "m"(addr1));
-  __asm__ volatile("ld 15, %0" : : "m"(addr2));
-  __asm__ volatile("ld 16, %0" : : "m"(addr3));
-  __asm__ volatile("ld 17, %0" : : "m"(addr4));
 
-  // Send addresses in GPRs to queue
-  stafdxq(14);
-  stafdxq(15);
-  stafdxq(16);
-  stafdxq(17);
+  // Send addresses to queue
+  queue_push_addr(&val1);
+  queue_push_addr(&val2);
+  queue_push_addr(&val3);
+  queue_push_addr(&val4);
 
   // Reading result from the queue
-  lfdxq(1);
+  double result = queue_pop_f64();
   puts("[Core0]: Got the following value from the queue \n");
-  double result;
-  __asm__ volatile("stfd 1, %0" : "=m"(result));
   puts("[Core0]: "); print_hex(*(unsigned long*)&result); puts("\n");
 
   return 0;
@@ -71,22 +65,16 @@ void secondary_main(void)
   // Enable FPU
   enable_fpu();
 
-  // Read values in queue and store in FPRs
-  lfdxq(1);
-  lfdxq(2);
-  lfdxq(3);
-  lfdxq(4);
+  // Read values from the queue
+  double res1 = queue_pop_f64();
+  double res2 = queue_pop_f64();
+  double res3 = queue_pop_f64();
+  double res4 = queue_pop_f64();
 
   // Enable UART
   console_init();
 
-  // Read values from FPRs
   puts("[Core1]: Got the following values from the queue \n");
-  double res1, res2, res3, res4;
-  __asm__ volatile("stfd 1, %0" : "=m"(res1));
-  __asm__ volatile("stfd 2, %0" : "=m"(res2));
-  __asm__ volatile("stfd 3, %0" : "=m"(res3));
-  __asm__ volatile("stfd 4, %0" : "=m"(res4));
   puts("[Core1]: "); print_hex(*(unsigned long*)&res1); puts("\n");
   puts("[Core1]: "); print_hex(*(unsigned long*)&res2); puts("\n");
   puts("[Core1]: "); print_hex(*(unsigned long*)&res3); puts("\n");
@@ -95,10 +83,9 @@ void secondary_main(void)
   // Compute sum and send it to the queue
   puts("[Core1]: Computing the sum...\n");
   double sum = res1 + res2 + res3 + res4;
-  __asm__ volatile("lfd 5, %0" : : "m"(sum));
   puts("[Core1]: Sending the following value to the queue \n");
   puts("[Core1]: "); print_hex(*(unsigned long*)&sum); puts("\n");
-  stfdxq(5);
+  queue_push_f64(sum);
 
   while(1) {
     /* Stall */
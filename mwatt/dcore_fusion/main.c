@@ -0,0 +1,235 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "console.h"
+#include "pmu.h"
+
+/*
+ * Directed tests for addis fusion in decode1.  Run with the core
+ * built with HAS_FUSION (core_tb -gHAS_FUSION=true); with fusion off
+ * the same results are expected, only the fused op count is zero.
+ */
+
+extern long test_trace(long base, long *res);
+
+static uint64_t table[4] = {
+	0x0123456789abcdef,
+	0xfedcba9876548001,
+	0x1122334455667788,
+	0x8877665544332211,
+};
+
+void print_string(const char *str)
+{
+	for (; *str; ++str)
+		putchar(*str);
+}
+
+void print_hex(unsigned long val)
+{
+	int i, x;
+
+	for (i = 60; i >= 0; i -= 4) {
+		x = (val >> i) & 0xf;
+		if (x >= 10)
+			putchar(x + 'a' - 10);
+		else
+			putchar(x + '0');
+	}
+}
+
+// i < 100
+void print_test_number(int i)
+{
+	print_string("test ");
+	putchar(48 + i/10);
+	putchar(48 + i%10);
+	putchar(':');
+}
+
+/* addis+addi, including lis+addi and a negative displacement */
+int fusion_test_1(void)
+{
+	long a, b, base = 0x10000000;
+
+	__asm__ volatile("lis %0,0x1234\n\t"
+			 "addi %0,%0,0x5678"
+			 : "=&b" (a));
+	if (a != 0x12345678)
+		return 1;
+	__asm__ volatile("addis %0,%1,1\n\t"
+			 "addi %0,%0,-1"
+			 : "=&b" (b) : "b" (base));
+	if (b != base + 0xffff)
+		return 2;
+	__asm__ volatile("addis %0,%1,-1\n\t"
+			 "addi %0,%0,-0x8000"
+			 : "=&b" (b) : "b" (base));
+	if (b != base - 0x18000)
+		return 3;
+	return 0;
+}
+
+/* addis+load of each size, with the addis part of the offset */
+int fusion_test_2(void)
+{
+	unsigned long lo = (unsigned long)table - 0x10000;
+	unsigned long hi = (unsigned long)table + 0x10000;
+	unsigned long v;
+
+	__asm__ volatile("addis %0,%1,1\n\t"
+			 "ld %0,8(%0)"
+			 : "=&b" (v) : "b" (lo) : "memory");
+	if (v != table[1])
+		return 1;
+	__asm__ volatile("addis %0,%1,-1\n\t"
+			 "ld %0,16(%0)"
+			 : "=&b" (v) : "b" (hi) : "memory");
+	if (v != table[2])
+		return 2;
+	__asm__ volatile("addis %0,%1,1\n\t"
+			 "lwz %0,4(%0)"
+			 : "=&b" (v) : "b" (lo) : "memory");
+	if (v != table[0] >> 32)
+		return 3;
+	__asm__ volatile("addis %0,%1,1\n\t"
+			 "lhz %0,8(%0)"
+			 : "=&b" (v) : "b" (lo) : "memory");
+	if (v != 0x8001)
+		return 4;
+	__asm__ volatile("addis %0,%1,1\n\t"
+			 "lha %0,8(%0)"
+			 : "=&b" (v) : "b" (lo) : "memory");
+	if (v != 0xffffffffffff8001ul)
+		return 5;
+	__asm__ volatile("addis %0,%1,1\n\t"
+			 "lbz %0,31(%0)"
+			 : "=&b" (v) : "b" (lo) : "memory");
+	if (v != 0x88)
+		return 6;
+	return 0;
+}
+
+/* A load into a different register isn't fused; the addis result stays visible */
+int fusion_test_3(void)
+{
+	unsigned long lo = (unsigned long)table - 0x10000;
+	unsigned long t, v;
+
+	__asm__ volatile("addis %0,%2,1\n\t"
+			 "ld %1,24(%0)"
+			 : "=&b" (t), "=&r" (v) : "b" (lo) : "memory");
+	if (t != (unsigned long)table)
+		return 1;
+	if (v != table[3])
+		return 2;
+	return 0;
+}
+
+/* Single-stepping takes a trace interrupt for each half of a pair */
+int fusion_test_4(void)
+{
+	long res[2];
+	long base = 0x20000000;
+	long n;
+
+	n = test_trace(base, res);
+	if (res[0] != base + 0x10002)
+		return 1;
+	if (res[1] != base + 0x30000 - 4)
+		return 2;
+	/* two pairs plus the mtmsrd that clears MSR[SE] */
+	if (n != 5)
+		return 3;
+	return 0;
+}
+
+#define PAIRS	4
+
+static uint64_t __attribute__((noinline)) fused_block(uint64_t *fused)
+{
+	uint64_t a, b, c, d, n;
+
+	pmu_start(PMU_MMCR1(0, PMU_EV2_FUSED_OP, PMU_EV3_INSN_COMPLETE, 0));
+	__asm__ volatile("addis %0,%4,1\n\t"
+			 "addi %0,%0,1\n\t"
+			 "addis %1,%4,2\n\t"
+			 "addi %1,%1,2\n\t"
+			 "addis %2,%4,3\n\t"
+			 "addi %2,%2,3\n\t"
+			 "addis %3,%4,4\n\t"
+			 "addi %3,%3,4"
+			 : "=&b" (a), "=&b" (b), "=&b" (c), "=&b" (d) : "b" (0ul));
+	pmu_stop();
+	n = pmu_read(3);
+	*fused = pmu_read(2);
+	return n;
+}
+
+static uint64_t __attribute__((noinline)) split_block(uint64_t *fused)
+{
+	uint64_t a, b, c, d, n;
+
+	pmu_start(PMU_MMCR1(0, PMU_EV2_FUSED_OP, PMU_EV3_INSN_COMPLETE, 0));
+	__asm__ volatile("addis %0,%4,1\n\t"
+			 "addi %1,%0,1\n\t"
+			 "addis %2,%4,2\n\t"
+			 "addi %3,%2,2\n\t"
+			 "addis %0,%4,3\n\t"
+			 "addi %1,%0,3\n\t"
+			 "addis %2,%4,4\n\t"
+			 "addi %3,%2,4"
+			 : "=&b" (a), "=&b" (b), "=&b" (c), "=&b" (d) : "b" (0ul));
+	pmu_stop();
+	n = pmu_read(3);
+	*fused = pmu_read(2);
+	return n;
+}
+
+/* The PMU counts a fused pair as two completed instructions */
+int fusion_test_5(void)
+{
+	uint64_t nf, ns, ff, fs;
+
+	nf = fused_block(&ff);
+	ns = split_block(&fs);
+	if (fs != 0)
+		return 1;
+	if (ff != 0 && ff != PAIRS)
+		return 2;
+	if (nf != ns)
+		return 3;
+	return 0;
+}
+
+int fail = 0;
+
+void do_test(int num, int (*test)(void))
+{
+	int ret;
+
+	print_test_number(num);
+	ret = test();
+	if (ret == 0) {
+		print_string("PASS\r\n");
+	} else {
+		fail = 1;
+		print_string("FAIL ");
+		putchar(ret + '0');
+		print_string("\r\n");
+	}
+}
+
+int main(void)
+{
+	console_init();
+
+	do_test(1, fusion_test_1);
+	do_test(2, fusion_test_2);
+	do_test(3, fusion_test_3);
+	do_test(4, fusion_test_4);
+	do_test(5, fusion_test_5);
+
+	return fail;
+}
@@ -0,0 +1,177 @@
+#include "console.h"
+#include "io.h"
+#include "microwatt_soc.h"
+
+#include "runtime.h"
+
+/*
+ * Shared L2 snoop filter test.
+ *
+ * Run on core_dram_tb with -gNCPUS=2 -gHAS_SHARED_L2=true and the
+ * default L2 geometry (256 sets of 4 ways, 64 byte lines). Core 0 keeps
+ * lines in its dcache while core 1 evicts them from the L2, reinstalls
+ * them and writes to them, and core 0 checks it sees every write:
+ *
+ *  1. core 1 thrashes the L2 set while core 0 is refilling the line,
+ *     then writes it;
+ *  2. core 0 allocates the line with dcbz while it isn't in the L2,
+ *     core 1 reads it into the L2 and then writes it;
+ *  3. core 0 allocates the line with dcbz while it isn't in the L2 and
+ *     core 1 writes it without reading it (a write miss in the L2).
+ */
+
+#define L2_SET_STRIDE	(256 * 64)
+#define L2_WAYS		4
+#define ITERS		32
+
+#define TEST_BASE	(DRAM_BASE + 0x100000ul)
+
+static rt_barrier_t barrier;
+static volatile long fails[4];
+
+static inline volatile uint64_t *line(int test, int i, int k)
+{
+  /* Each iteration uses its own line; k selects another line in its set */
+  return (volatile uint64_t *)(TEST_BASE + test * 0x40000 + i * 64 +
+                               k * L2_SET_STRIDE);
+}
+
+static void evict_set(int test, int i)
+{
+  volatile uint64_t sink;
+  int k;
+
+  for (k = 1; k <= 2 * L2_WAYS; k++)
+    sink = *line(test, i, k);
+  (void)sink;
+}
+
+static inline void dcbz(volatile void *p)
+{
+  __asm__ volatile("dcbz 0,%0" : : "r"(p) : "memory");
+}
+
+static void sync_point(void)
+{
+  rt_sync();
+  rt_barrier_wait(&barrier);
+}
+
+static void eviction_during_refill(long cpu, int i)
+{
+  volatile uint64_t *p = line(1, i, 0);
+
+  if (cpu == 1)
+    *p = i;
+  sync_point();
+  /* Race core 0's refill of the line against core 1 evicting it */
+  if (cpu == 0 && *p != i)
+    fails[1]++;
+  if (cpu == 1)
+    evict_set(1, i);
+  sync_point();
+  if (cpu == 1)
+    *p = i + 1000;
+  sync_point();
+  if (cpu == 0 && *p != i + 1000)
+    fails[1]++;
+}
+
+static void dcbz_then_install(long cpu, int i)
+{
+  volatile uint64_t *p = line(2, i, 0);
+  volatile uint64_t sink;
+
+  if (cpu == 1)
+    evict_set(2, i);
+  sync_point();
+  if (cpu == 0)
+    dcbz(p);
+  sync_point();
+  if (cpu == 1) {
+    sink = *p;
+    (void)sink;
+    *p = i + 2000;
+  }
+  sync_point();
+  if (cpu == 0 && *p != i + 2000)
+    fails[2]++;
+}
+
+static void dcbz_then_write_miss(long cpu, int i)
+{
+  volatile uint64_t *p = line(3, i, 0);
+
+  if (cpu == 1)
+    evict_set(3, i);
+  sync_point();
+  if (cpu == 0)
+    dcbz(p);
+  sync_point();
+  if (cpu == 1)
+    *p = i + 3000;
+  sync_point();
+  if (cpu == 0 && *p != i + 3000)
+    fails[3]++;
+}
+
+static void run_tests(void *arg, long cpu, long ncpus)
+{
+  int i;
+
+  if (cpu > 1) {
+    /* Spare cores just keep the barrier count right */
+    for (i = 0; i < ITERS * 9; i++)
+      rt_barrier_wait(&barrier);
+    return;
+  }
+  for (i = 0; i < ITERS; i++) {
+    eviction_during_refill(cpu, i);
+    dcbz_then_install(cpu, i);
+    dcbz_then_write_miss(cpu, i);
+  }
+}
+
+static void report(int test, const char *name)
+{
+  puts("test ");
+  print_uint64(test);
+  puts(" ");
+  puts(name);
+  if (fails[test] == 0) {
+    puts(": PASS\n");
+  } else {
+    puts(": FAIL ");
+    print_uint64(fails[test]);
+    puts("\n");
+  }
+}
+
+int main(void)
+{
+  console_init();
+  rt_init();
+
+  if (rt_ncpus() < 2) {
+    puts("needs at least 2 cores\n");
+    return 1;
+  }
+  if (!(readq(SYSCON_BASE + SYS_REG_INFO) & SYS_REG_INFO_HAS_DRAM)) {
+    puts("needs DRAM\n");
+    return 1;
+  }
+
+  rt_barrier_init(&barrier, rt_ncpus());
+  rt_run_on_all(run_tests, NULL);
+
+  report(1, "eviction during refill");
+  report(2, "dcbz, then install by another core");
+  report(3, "dcbz, then write miss by another core");
+
+  return fails[1] + fails[2] + fails[3] != 0;
+}
+
+void secondary_main(void)
+{
+  rt_worker();
+}
@@ -0,0 +1,266 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "console.h"
+
+/*
+ * Directed tests for the loadstore1 store buffer.  Run on core_tb both
+ * with the default STORE_BUFFER_DEPTH of 4 and with -gSTORE_BUFFER_DEPTH=0;
+ * the results must be the same, only the timing differs.
+ *
+ * Everything here runs in real mode, so the stores are buffered and the
+ * loads can bypass or forward from the buffer.
+ */
+
+static uint64_t buf[64] __attribute__((aligned(128)));
+static uint64_t other[32] __attribute__((aligned(128)));
+
+void print_string(const char *str)
+{
+	for (; *str; ++str)
+		putchar(*str);
+}
+
+// i < 100
+void print_test_number(int i)
+{
+	print_string("test ");
+	putchar(48 + i/10);
+	putchar(48 + i%10);
+	putchar(':');
+}
+
+static inline void st64(volatile void *p, uint64_t v)
+{
+	__asm__ volatile("std %0,0(%1)" : : "r" (v), "b" (p) : "memory");
+}
+
+static inline uint64_t ld64(volatile void *p)
+{
+	uint64_t v;
+
+	__asm__ volatile("ld %0,0(%1)" : "=r" (v) : "b" (p) : "memory");
+	return v;
+}
+
+static inline uint64_t ldcix(volatile void *p)
+{
+	uint64_t v;
+
+	__asm__ volatile("ldcix %0,0,%1" : "=r" (v) : "r" (p) : "memory");
+	return v;
+}
+
+/* Load after store to the same doubleword, forwarded from the buffer */
+int sb_test_1(void)
+{
+	volatile uint64_t *p = &buf[0];
+	volatile uint32_t *w = (volatile uint32_t *)&buf[1];
+	volatile uint8_t *b = (volatile uint8_t *)&buf[2];
+	uint64_t v;
+
+	st64(p, 0x0123456789abcdef);
+	v = ld64(p);
+	if (v != 0x0123456789abcdef)
+		return 1;
+
+	/* the youngest of two matching entries is forwarded */
+	st64(p, 0x1111111111111111);
+	st64(p, 0x2222222222222222);
+	v = ld64(p);
+	if (v != 0x2222222222222222)
+		return 2;
+
+	/* a smaller load inside a buffered store */
+	st64(&buf[1], 0xfedcba9876543210);
+	if (w[1] != 0xfedcba98 || w[0] != 0x76543210)
+		return 3;
+	st64(&buf[2], 0x8877665544332211);
+	if (b[0] != 0x11 || b[5] != 0x66 || b[7] != 0x88)
+		return 4;
+	return 0;
+}
+
+/* Load after store to overlapping bytes the buffer can't supply */
+int sb_test_2(void)
+{
+	volatile uint8_t *b = (volatile uint8_t *)&buf[4];
+	volatile uint32_t *w = (volatile uint32_t *)&buf[4];
+	volatile uint16_t *h = (volatile uint16_t *)((uintptr_t)&buf[4] + 3);
+	uint64_t v;
+
+	/* a byte store, then a doubleword load around it */
+	st64(&buf[4], 0);
+	b[3] = 0x5a;
+	v = ld64(&buf[4]);
+	if (v != 0x5a000000)
+		return 1;
+
+	/* a word store, then a word load half inside it */
+	w[1] = 0xa5a5a5a5;
+	v = *(volatile uint32_t *)((uintptr_t)&buf[4] + 2);
+	if (v != 0xa5a55a00)
+		return 2;
+
+	/* a store to one doubleword, then a load crossing into the next */
+	st64(&buf[5], 0x0706050403020100);
+	v = *(volatile uint32_t *)((uintptr_t)&buf[4] + 6);
+	if (v != 0x0100a5a5)
+		return 3;
+
+	/* two byte stores merged into one unaligned halfword load */
+	b[3] = 0x12;
+	b[4] = 0x34;
+	if (*h != 0x3412)
+		return 4;
+	return 0;
+}
+
+/*
+ * A burst of stores to separate doublewords, each followed straight away
+ * by loads elsewhere, so that loads arrive while drained stores are still
+ * in flight to the dcache.
+ */
+int sb_test_3(void)
+{
+	uint64_t sum = 0;
+	int i, j;
+
+	for (i = 0; i < 32; i++)
+		other[i] = i;
+	for (j = 0; j < 4; j++) {
+		for (i = 0; i < 8; i++) {
+			st64(&buf[8 + i], j * 100 + i);
+			sum += ld64(&other[i + j]);
+		}
+		for (i = 0; i < 8; i++)
+			if (ld64(&buf[8 + i]) != j * 100 + i)
+				return 1;
+	}
+	if (sum != 4 * 28 + 8 * (0 + 1 + 2 + 3))
+		return 2;
+	/* and the dcache has them once the buffer has drained */
+	__asm__ volatile("sync" : : : "memory");
+	for (i = 0; i < 8; i++)
+		if (ldcix(&buf[8 + i]) != 300 + i)
+			return 3;
+	return 0;
+}
+
+/*
+ * One store followed by a long stream of loads to other doublewords,
+ * none of which would leave the buffer a free cycle to drain in if the
+ * age counter didn't hold them back.
+ */
+int sb_test_4(void)
+{
+	uint64_t a, b, c, d;
+	int i;
+
+	for (i = 0; i < 8; i++)
+		other[i] = i;
+	__asm__ volatile("sync" : : : "memory");
+	st64(&buf[16], 0x4444444444444444);
+	__asm__ volatile("ld %0,0(%4)\n\t"
+			 "ld %1,8(%4)\n\t"
+			 "ld %2,16(%4)\n\t"
+			 "ld %3,24(%4)\n\t"
+			 "ld %0,32(%4)\n\t"
+			 "ld %1,40(%4)\n\t"
+			 "ld %2,48(%4)\n\t"
+			 "ld %3,56(%4)\n\t"
+			 "ld %0,0(%4)\n\t"
+			 "ld %1,8(%4)\n\t"
+			 "ld %2,16(%4)\n\t"
+			 "ld %3,24(%4)\n\t"
+			 "ld %0,32(%4)\n\t"
+			 "ld %1,40(%4)\n\t"
+			 "ld %2,48(%4)\n\t"
+			 "ld %3,56(%4)"
+			 : "=&r" (a), "=&r" (b), "=&r" (c), "=&r" (d)
+			 : "b" (&other[0]) : "memory");
+	if (a != 4 || b != 5 || c != 6 || d != 7)
+		return 1;
+	if (ldcix(&buf[16]) != 0x4444444444444444)
+		return 2;
+	return 0;
+}
+
+/*
+ * Accesses the buffer doesn't take wait for it to drain: each of these
+ * would see a stale value, or be overwritten by the older store, if it
+ * went ahead of a buffered store to the same doubleword.
+ */
+int sb_test_5(void)
+{
+	uint64_t v, x, y;
+	int i;
+
+	/* larx after a buffered store; stcx. before a later load */
+	st64(&buf[24], 0x5555);
+	__asm__ volatile("1: ldarx %0,0,%1\n\t"
+			 "addi %0,%0,1\n\t"
+			 "stdcx. %0,0,%1\n\t"
+			 "bne 1b"
+			 : "=&r" (v) : "r" (&buf[24]) : "cr0", "memory");
+	if (v != 0x5556 || ld64(&buf[24]) != 0x5556)
+		return 1;
+
+	/* cache-inhibited load after a buffered store */
+	st64(&buf[25], 0x6666);
+	if (ldcix(&buf[25]) != 0x6666)
+		return 2;
+
+	/* dcbz after buffered stores to the line */
+	for (i = 32; i < 40; i++)
+		st64(&buf[i], ~0ul);
+	__asm__ volatile("dcbz 0,%0" : : "r" (&buf[32]) : "memory");
+	for (i = 32; i < 40; i++)
+		if (ld64(&buf[i]) != 0)
+			return 3;
+
+	/* stq after buffered stores to both of its doublewords */
+	st64(&buf[40], 0x7777);
+	st64(&buf[41], 0x8888);
+	__asm__ volatile("li %%r10,0x1234\n\t"
+			 "li %%r11,0x5678\n\t"
+			 "stq %%r10,0(%0)"
+			 : : "b" (&buf[40]) : "r10", "r11", "memory");
+	x = ld64(&buf[40]);
+	y = ld64(&buf[41]);
+	if (!((x == 0x1234 && y == 0x5678) || (x == 0x5678 && y == 0x1234)))
+		return 4;
+	return 0;
+}
+
+int fail = 0;
+
+void do_test(int num, int (*test)(void))
+{
+	int ret;
+
+	print_test_number(num);
+	ret = test();
+	if (ret == 0) {
+		print_string("PASS\r\n");
+	} else {
+		fail = 1;
+		print_string("FAIL ");
+		putchar(ret + '0');
+		print_string("\r\n");
+	}
+}
+
+int main(void)
+{
+	console_init();
+
+	do_test(1, sb_test_1);
+	do_test(2, sb_test_2);
+	do_test(3, sb_test_3);
+	do_test(4, sb_test_4);
+	do_test(5, sb_test_5);
+
+	return fail;
+}
@@ -7,6 +7,12 @@ use work.common.all;
 use work.wishbone_types.all;
 
 entity dcore_tb is
+    generic (
+        -- Run this many instructions, or up to this PC, in the
+        -- sim_isa_model reference model before starting the cores
+        FFWD_INSNS : natural := 0;
+        FFWD_PC    : integer := -1
+        );
 end dcore_tb;
 
 architecture behave of dcore_tb is
@@ -20,7 +26,8 @@ begin
             NCPUS => 2,
             MEMORY_SIZE => (384*1024),
             RAM_INIT_FILE => "main_ram.bin",
-            CLK_FREQ => 100000000
+            CLK_FREQ => 100000000,
+            START_STOPPED => FFWD_INSNS /= 0 or FFWD_PC /= -1
             )
         port map(
             rst => rst,
@@ -43,6 +50,11 @@ begin
         wait;
     end process;
 
-    jtag: entity work.sim_jtag;
+    jtag: entity work.sim_jtag
+        generic map(
+            NCPUS => 2,
+            FFWD_INSNS => FFWD_INSNS,
+            FFWD_PC => FFWD_PC
+            );
 
 end;
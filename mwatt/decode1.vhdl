@@ -3,15 +3,27 @@ use ieee.std_logic_1164.all;
 use ieee.numeric_std.all;
 
 library work;
+use work.utils.all;
 use work.common.all;
 use work.decode_types.all;
 use work.insn_helpers.all;
 
 entity decode1 is
     generic (
-        HAS_FPU    : boolean := true;
+        HAS_FPU     : boolean := true;
+        -- gshare direction predictor for conditional relative branches
+        HAS_GSHARE  : boolean := false;
+        GSHARE_BITS : positive := 10;
+        -- Return address stack for predicting blr
+        HAS_RAS     : boolean := false;
+        RAS_DEPTH   : positive := 8;
+        -- Fuse addis with a following addi or D-form load into one op
+        HAS_FUSION  : boolean := false;
+        -- Issue a simple ALU op together with the instruction before it
+        -- when both come from one doubleword fetch
+        DUAL_ISSUE  : boolean := false;
         -- Non-zero to enable log data collection
-        LOG_LENGTH : natural := 0
+        LOG_LENGTH  : natural := 0
     );
     port (
         clk : in std_ulogic;
@@ -19,10 +31,12 @@ entity decode1 is
 
         stall_in  : in  std_ulogic;
         flush_in  : in  std_ulogic;
+        trace_in  : in  std_ulogic;     -- MSR[SE], don't fuse while set
         busy_out  : out std_ulogic;
         flush_out : out std_ulogic;
 
         f_in    : in  IcacheToDecode1Type;
+        w_in    : in  WritebackToFetch1Type;
         f_out   : out Decode1ToFetch1Type;
         d_out   : out Decode1ToDecode2Type;
         r_out   : out Decode1ToRegisterFileType;
@@ -41,11 +55,71 @@ architecture behaviour of decode1 is
 
     signal br, br_in : br_predictor_t;
 
+    -- Direction predicted by the gshare table for the instruction in f_in
+    signal gs_taken : std_ulogic;
+
+    -- Return address stack
+    constant RAS_BITS : natural := log2(RAS_DEPTH);
+    type ras_t is array(0 to RAS_DEPTH - 1) of std_ulogic_vector(61 downto 0);
+    signal ras       : ras_t := (others => (others => '0'));
+    signal ras_top   : unsigned(RAS_BITS - 1 downto 0);
+    signal ras_push  : std_ulogic;
+    signal ras_pop   : std_ulogic;
+    signal ras_entry : std_ulogic_vector(61 downto 0);
+
     signal decode_rom_addr : insn_code_t;
     signal decode : decode_rom_t;
+    signal decode_b : decode_rom_t := decode_rom_init;
 
     signal double : std_ulogic;
 
+    -- The instruction being decoded.  This is f_in, except that after a
+    -- dual fetch whose two words couldn't be issued together, it is the
+    -- second word of the doubleword on the following cycle.
+    signal cur         : IcacheToDecode1Type;
+    signal second_word : std_ulogic;
+    signal split       : std_ulogic;
+
+    -- Classes of instructions that can be dual-issued.  Any of them can
+    -- be first in a pair; the second must be one of the classes up to
+    -- DUAL_RS and have Rc = 0 and OE = 0, or a DUAL_CMP after an op
+    -- that doesn't write CR or XER.
+    type dual_class_t is (DUAL_NONE,
+                          DUAL_ADD,     -- RT <- RA, RB (XO-form)
+                          DUAL_NEG,     -- RT <- RA (XO-form)
+                          DUAL_ADDI,    -- RT <- RA|0, SI (D-form)
+                          DUAL_LOG,     -- RA <- RS, RB (X-form)
+                          DUAL_LOGI,    -- RA <- RS, UI (D-form)
+                          DUAL_RS,      -- RA <- RS (X, M or MD-form)
+                          DUAL_CR,      -- RA, CR0 <- RS, UI (andi., andis.)
+                          DUAL_CMP);    -- CR <- RA, RB or SI/UI
+
+    function dual_class(icode : insn_code_t) return dual_class_t is
+    begin
+        case icode is
+            when INSN_add | INSN_subf =>
+                return DUAL_ADD;
+            when INSN_neg =>
+                return DUAL_NEG;
+            when INSN_addi | INSN_addis =>
+                return DUAL_ADDI;
+            when INSN_and | INSN_andc | INSN_or | INSN_orc | INSN_nand | INSN_nor |
+                INSN_xor | INSN_eqv =>
+                return DUAL_LOG;
+            when INSN_ori | INSN_oris | INSN_xori | INSN_xoris =>
+                return DUAL_LOGI;
+            when INSN_extsb | INSN_extsh | INSN_extsw |
+                INSN_rlwinm | INSN_rldicl | INSN_rldicr | INSN_rldic =>
+                return DUAL_RS;
+            when INSN_andi_dot | INSN_andis_dot =>
+                return DUAL_CR;
+            when INSN_cmp | INSN_cmpi | INSN_cmpl | INSN_cmpli =>
+                return DUAL_CMP;
+            when others =>
+                return DUAL_NONE;
+        end case;
+    end;
+
     type prefix_state_t is record
         prefixed : std_ulogic;
         prefix   : std_ulogic_vector(25 downto 0);
@@ -401,6 +475,9 @@ architecture behaviour of decode1 is
         to_integer(unsigned(INSN_lfsxq))       =>  (LDST, FPU,  OP_LDQ,       RA_OR_ZERO, RB,  NONE,        NONE, FRT,  '0', '0', '0', '0', ZERO, '0', is4B, '0', '0', '0', '0', '1', '0', NONE, '0', '0', '0', NONE),
         to_integer(unsigned(INSN_stafsxq))     =>  (LDST, NONE, OP_STAQ,      RA_OR_ZERO, RB,  NONE,        RS,   NONE, '0', '0', '0', '0', ZERO, '0', is4B, '0', '0', '0', '0', '1', '0', NONE, '0', '0', '0', NONE),
         to_integer(unsigned(INSN_stfsxq))      =>  (LDST, FPU,  OP_STQ,       RA_OR_ZERO, RB,  NONE,        FRS,  NONE, '0', '0', '0', '0', ZERO, '0', is4B, '0', '0', '0', '0', '1', '0', NONE, '0', '0', '0', NONE),
+        to_integer(unsigned(INSN_lfdpxq))      =>  (LDST, FPU,  OP_LDQ,       RA_OR_ZERO, RB,  NONE,        NONE, FRT,  '0', '0', '0', '0', ZERO, '0', is8B, '0', '0', '0', '0', '0', '0', NONE, '0', '0', '0', DQP),
+        to_integer(unsigned(INSN_stafdpxq))    =>  (LDST, NONE, OP_STAQ,      RA_OR_ZERO, RB,  NONE,        NONE, NONE, '0', '0', '0', '0', ZERO, '0', is8B, '0', '0', '0', '0', '0', '0', NONE, '0', '0', '0', DQP),
+        to_integer(unsigned(INSN_stfdpxq))     =>  (LDST, FPU,  OP_STQ,       RA_OR_ZERO, RB,  NONE,        FRS,  NONE, '0', '0', '0', '0', ZERO, '0', is8B, '0', '0', '0', '0', '0', '0', NONE, '0', '0', '0', DQP),
         --
         others                                 =>  (ALU,  NONE, OP_ILLEGAL,   NONE,       IMM, NONE,        NONE, NONE, '0', '0', '0', '0', ZERO, '0', NONE, '0', '0', '0', '0', '0', '0', NONE, '0', '0', '0', NONE)
     );
@@ -532,6 +609,24 @@ architecture behaviour of decode1 is
 begin
     double <= not r.second when (r.valid = '1' and decode.repeat /= NONE) else '0';
 
+    decode1_cur : process(all)
+        variable c : IcacheToDecode1Type;
+    begin
+        c := f_in;
+        if DUAL_ISSUE and second_word = '1' then
+            c.nia   := f_in.nia(63 downto 3) & "100";
+            c.insn  := f_in.insn2;
+            c.icode := f_in.icode2;
+            c.dual  := '0';
+        end if;
+        -- A BTC prediction applies only to the word it was made for
+        if DUAL_ISSUE and f_in.dual = '1' and f_in.pred_slot /= second_word then
+            c.next_predicted   := '0';
+            c.next_pred_ntaken := '0';
+        end if;
+        cur <= c;
+    end process;
+
     decode1_0 : process(clk)
     begin
         if rising_edge(clk) then
@@ -539,10 +634,12 @@ begin
                 r            <= Decode1ToDecode2Init;
                 fetch_failed <= '0';
                 pr           <= prefix_state_init;
+                second_word  <= '0';
             elsif flush_in = '1' then
                 r.valid      <= '0';
                 fetch_failed <= '0';
                 pr           <= prefix_state_init;
+                second_word  <= '0';
             elsif stall_in = '0' then
                 if double = '0' then
                     r            <= rin;
@@ -550,6 +647,7 @@ begin
                     if f_in.valid = '1' then
                         pr <= pr_in;
                     end if;
+                    second_word  <= split;
                 else
                     r.second <= '1';
                     r.reg_c  <= rin.reg_c;
@@ -563,13 +661,88 @@ begin
         end if;
     end process;
 
-    busy_out <= stall_in or double;
+    -- gshare predictor: a table of 2-bit saturating counters indexed by
+    -- the branch address XORed with the global history.  The history is
+    -- that of resolved branches as reported by writeback, and the same
+    -- register is used both for prediction and for training, so the
+    -- index used at training time can differ from the one used to
+    -- predict while there are other branches in flight.
+    gshare : if HAS_GSHARE generate
+        constant PHT_SIZE : positive := 2 ** GSHARE_BITS;
+        type pht_t is array(0 to PHT_SIZE - 1) of std_ulogic_vector(1 downto 0);
+        signal pht : pht_t := (others => "01");
+        signal ghr : std_ulogic_vector(GSHARE_BITS - 1 downto 0);
+    begin
+        gshare_read : process(all)
+            variable idx : std_ulogic_vector(GSHARE_BITS - 1 downto 0);
+        begin
+            idx := cur.nia(GSHARE_BITS + 1 downto 2) xor ghr;
+            if is_X(idx) then
+                gs_taken <= '0';
+            else
+                gs_taken <= pht(to_integer(unsigned(idx)))(1);
+            end if;
+        end process;
+
+        gshare_update : process(clk)
+            variable idx : std_ulogic_vector(GSHARE_BITS - 1 downto 0);
+            variable ctr : unsigned(1 downto 0);
+        begin
+            if rising_edge(clk) then
+                if rst = '1' then
+                    ghr <= (others => '0');
+                elsif w_in.br_last = '1' then
+                    idx := w_in.br_nia(GSHARE_BITS + 1 downto 2) xor ghr;
+                    assert not is_X(idx) report "gshare index invalid on update" severity FAILURE;
+                    ctr := unsigned(pht(to_integer(unsigned(idx))));
+                    if w_in.br_taken = '1' and ctr /= "11" then
+                        ctr := ctr + 1;
+                    elsif w_in.br_taken = '0' and ctr /= "00" then
+                        ctr := ctr - 1;
+                    end if;
+                    pht(to_integer(unsigned(idx))) <= std_ulogic_vector(ctr);
+                    ghr <= ghr(GSHARE_BITS - 2 downto 0) & w_in.br_taken;
+                end if;
+            end if;
+        end process;
+    end generate;
+
+    no_gshare : if not HAS_GSHARE generate
+        gs_taken <= '0';
+    end generate;
+
+    -- Return address stack.  Pushed with the return address when a
+    -- branch with LK=1 is decoded and popped by blr, speculatively and
+    -- without any repair on a flush; a wrong prediction is caught by
+    -- execute1 comparing the predicted target against LR.
+    assert not HAS_RAS or (ispow2(RAS_DEPTH) and RAS_DEPTH > 1)
+        report "RAS_DEPTH not a power of 2" severity FAILURE;
+
+    ras_sync : process(clk)
+    begin
+        if rising_edge(clk) then
+            if rst = '1' then
+                ras_top <= (others => '0');
+            elsif ras_push = '1' then
+                ras(to_integer(ras_top + 1)) <= std_ulogic_vector(unsigned(cur.nia(63 downto 2)) + 1);
+                ras_top <= ras_top + 1;
+            elsif ras_pop = '1' then
+                ras_top <= ras_top - 1;
+            end if;
+        end if;
+    end process;
+    ras_entry <= ras(to_integer(ras_top));
+
+    busy_out <= stall_in or double or split;
 
     decode1_rom : process(clk)
     begin
         if rising_edge(clk) then
             if stall_in = '0' and double = '0' then
                 decode <= decode_rom(to_integer(unsigned(decode_rom_addr)));
+                if DUAL_ISSUE then
+                    decode_b <= decode_rom(to_integer(unsigned(f_in.icode2)));
+                end if;
             end if;
         end if;
     end process;
@@ -586,31 +759,38 @@ begin
         variable pv : prefix_state_t;
         variable icode_bits : std_ulogic_vector(9 downto 0);
         variable valid_suffix : std_ulogic;
+        variable fuse : std_ulogic;
+        variable fuse_8ls : std_ulogic;
+        variable fuse_hi : signed(17 downto 0);
+        variable pair : std_ulogic;
+        variable ca, cb : dual_class_t;
+        variable dest_a, dest_b : gpr_index_t;
+        variable src_b : gpr_index_t;
     begin
         v  := Decode1ToDecode2Init;
         pv := pr;
 
-        v.valid      := f_in.valid;
-        v.nia        := f_in.nia;
-        v.insn       := f_in.insn;
+        v.valid      := cur.valid;
+        v.nia        := cur.nia;
+        v.insn       := cur.insn;
         v.prefix     := pr.prefix;
         v.prefixed   := pr.prefixed;
-        v.stop_mark  := f_in.stop_mark;
-        v.big_endian := f_in.big_endian;
+        v.stop_mark  := cur.stop_mark;
+        v.big_endian := cur.big_endian;
 
-        if is_X(f_in.insn) then
+        if is_X(cur.insn) then
             v.spr_info := (sel   => "XXXX", others => 'X');
             v.ram_spr  := (index => (others => 'X'), others => 'X');
         else
-            sprn       := decode_spr_num(f_in.insn);
+            sprn       := decode_spr_num(cur.insn);
             v.spr_info := map_spr(sprn);
             v.ram_spr  := decode_ram_spr(sprn);
         end if;
 
-        icode := f_in.icode;
+        icode := cur.icode;
         icode_bits := icode;
 
-        if f_in.fetch_failed = '1' then
+        if cur.fetch_failed = '1' then
             icode_bits := INSN_fetch_fail;
             -- Only send down a single OP_FETCH_FAILED
             v.valid    := not fetch_failed;
@@ -651,58 +831,194 @@ begin
 
         elsif icode = INSN_prefix then
             pv.prefixed := '1';
-            pv.pref_ia  := f_in.nia(5 downto 2);
-            pv.prefix   := f_in.insn(25 downto 0);
+            pv.pref_ia  := cur.nia(5 downto 2);
+            pv.prefix   := cur.insn(25 downto 0);
             -- Check if the address of the prefix mod 64 is 60;
             -- if so we need to arrange to generate an alignment interrupt
-            if f_in.nia(5 downto 2) = "1111" then
+            if cur.nia(5 downto 2) = "1111" then
                 v.misaligned_prefix := '1';
             else
                 v.valid := '0';
             end if;
 
         end if;
+
+        -- Instruction fusion.  If r holds addis rT,rA,SI and f_in is an
+        -- addi or D-form load whose RT and RA are both rT, the pair is
+        -- turned into the paddi or prefixed load with RA = rA and a
+        -- displacement of (SI << 16) + D, at the address of the addis,
+        -- and the addis is dropped from d_out.  The intermediate rT is
+        -- never visible, so an interrupt on the load restarts at the
+        -- addis.  No fusion is done while single-stepping (MSR[SE] = 1)
+        -- so that each instruction takes its own trace interrupt; CIABR
+        -- still sees the pair as a single instruction.
+        fuse := '0';
+        fuse_8ls := '0';
+        if HAS_FUSION and trace_in = '0' and r.valid = '1' and r.prefixed = '0' and r.second = '0' and
+            r.stop_mark = '0' and r.dual = '0' and r.insn(31 downto 26) = "001111" and
+            insn_rt(r.insn) /= "00000" and pr.prefixed = '0' and
+            cur.valid = '1' and cur.fetch_failed = '0' and cur.stop_mark = '0' and
+            insn_rt(cur.insn) = insn_rt(r.insn) and insn_ra(cur.insn) = insn_rt(r.insn) then
+            case icode is
+                when INSN_addi | INSN_lbz | INSN_lha | INSN_lhz | INSN_lwz =>
+                    fuse := '1';
+                when INSN_ld =>
+                    -- DS-form, XO = 0 so insn(15 downto 0) is the displacement
+                    fuse := '1';
+                    fuse_8ls := '1';
+                when others =>
+            end case;
+        end if;
+        if fuse = '1' then
+            -- High 18 bits of the 34-bit displacement; D is sign-extended
+            fuse_hi := resize(signed(r.insn(15 downto 0)), 18);
+            if cur.insn(15) = '1' then
+                fuse_hi := fuse_hi - 1;
+            end if;
+            if fuse_8ls = '1' then
+                icode_bits := INSN_pld;
+            else
+                icode_bits(0) := '1';
+            end if;
+            v.nia                 := r.nia;
+            v.insn(20 downto 16)  := insn_ra(r.insn);
+            v.prefix              := (others => '0');
+            v.prefix(25)          := not fuse_8ls;     -- MLS or 8LS form, R = 0
+            v.prefix(17 downto 0) := std_ulogic_vector(fuse_hi);
+            v.fused               := '1';
+        end if;
         decode_rom_addr <= icode_bits;
 
-        if f_in.valid = '1' then
+        if cur.valid = '1' then
             report "Decode " & decode_insn_name(icode_bits) & " " &
-                to_hstring(f_in.insn) & " at " & to_hstring(f_in.nia);
+                to_hstring(cur.insn) & " at " & to_hstring(cur.nia);
         end if;
 
         -- Branch predictor
-        -- Note bclr, bcctr and bctar not predicted as we have no
-        -- count cache or link stack.
-        br_offset := f_in.insn(25 downto 2);
+        -- Note bcctr and bctar not predicted as we have no count cache,
+        -- and bclr is only predicted (using the return address stack)
+        -- for a plain blr.
+        br_offset := cur.insn(25 downto 2);
+        ras_push <= '0';
+        ras_pop <= '0';
         case icode is
             when INSN_brel | INSN_babs =>
                 -- Unconditional branches are always taken
                 v.br_pred := '1';
             when INSN_bcrel =>
-                -- Predict backward relative branches as taken, others as untaken
-                v.br_pred               := f_in.insn(15);
+                if HAS_GSHARE then
+                    -- BO = 1z1zz is branch always
+                    v.br_pred := gs_taken or (cur.insn(25) and cur.insn(23));
+                else
+                    -- Predict backward relative branches as taken, others as untaken
+                    v.br_pred := cur.insn(15);
+                end if;
                 br_offset(23 downto 14) := (others => '1');
+            when INSN_bclr =>
+                -- blr: BO = 1z1zz, BH = 00, LK = 0
+                if HAS_RAS and cur.insn(25) = '1' and cur.insn(23) = '1' and
+                    cur.insn(12 downto 11) = "00" and cur.insn(0) = '0' then
+                    v.br_pred := '1';
+                    ras_pop <= cur.valid and not flush_in and not (stall_in or double);
+                end if;
             when others =>
         end case;
-        br_nia := f_in.nia(63 downto 2);
-        if f_in.insn(1) = '1' then
+        -- bcl 20,31,$+4 is used to read the PC, not to call anything,
+        -- so it doesn't get a return address pushed
+        if HAS_RAS and cur.insn(0) = '1' and cur.insn /= x"429f0005" and
+            (icode = INSN_brel or icode = INSN_babs or icode = INSN_bcrel or
+             icode = INSN_bclr or icode = INSN_bcctr) then
+            ras_push <= cur.valid and not flush_in and not (stall_in or double);
+        end if;
+        br_nia := cur.nia(63 downto 2);
+        if cur.insn(1) = '1' then
             br_nia := (others => '0');
         end if;
         bv.br_target := signed(br_nia) + signed(br_offset);
-        if f_in.next_predicted = '1' then
+        if HAS_RAS and icode = INSN_bclr then
+            bv.br_target := signed(ras_entry);
+        end if;
+        v.br_target := std_ulogic_vector(bv.br_target) & "00";
+        if cur.next_predicted = '1' then
             v.br_pred := '1';
-        elsif f_in.next_pred_ntaken = '1' then
+        elsif cur.next_pred_ntaken = '1' and not (HAS_GSHARE and icode = INSN_bcrel) then
+            -- With gshare, a conditional branch that the BTC predicted
+            -- untaken can still be redirected here.
             v.br_pred := '0';
         end if;
-        bv.predict := v.br_pred and f_in.valid and not flush_in and not busy_out and not f_in.next_predicted;
+        bv.predict := v.br_pred and cur.valid and not flush_in and not (stall_in or double) and
+                      not cur.next_predicted;
+
+        -- Dual issue.  If cur holds both words of a doubleword, and the
+        -- second is a simple ALU op which doesn't use or overwrite the
+        -- result of the first, itself a simple ALU op, the second goes
+        -- down in the same Decode1ToDecode2Type entry and gets the same
+        -- tag.  Otherwise, unless the first is a taken branch, the
+        -- second word is decoded on the next cycle.
+        pair := '0';
+        dest_a := (others => '0');
+        ca := dual_class(cur.icode);
+        cb := dual_class(f_in.icode2);
+        if ca = DUAL_ADD or ca = DUAL_NEG or ca = DUAL_ADDI then
+            dest_a := insn_rt(cur.insn);
+        else
+            dest_a := insn_ra(cur.insn);
+        end if;
+        if cb = DUAL_ADD or cb = DUAL_NEG or cb = DUAL_ADDI or cb = DUAL_CMP then
+            src_b := insn_ra(f_in.insn2);
+            dest_b := insn_rt(f_in.insn2);
+        else
+            src_b := insn_rs(f_in.insn2);
+            dest_b := insn_ra(f_in.insn2);
+        end if;
+        if DUAL_ISSUE and cur.dual = '1' and cur.valid = '1' and cur.fetch_failed = '0' and
+            cur.stop_mark = '0' and pr.prefixed = '0' and fuse = '0' and
+            f_in.next_predicted = '0' and ca /= DUAL_NONE then
+            case cb is
+                when DUAL_ADD | DUAL_NEG =>
+                    pair := not f_in.insn2(10) and not f_in.insn2(0);
+                when DUAL_LOG | DUAL_RS =>
+                    pair := not f_in.insn2(0);
+                when DUAL_ADDI | DUAL_LOGI =>
+                    pair := '1';
+                when DUAL_CMP =>
+                    -- the compare goes through the CR write path of the
+                    -- pair and reads XER[SO], so the first op can't use them
+                    case ca is
+                        when DUAL_ADD | DUAL_NEG =>
+                            pair := not cur.insn(10) and not cur.insn(0);
+                        when DUAL_LOG | DUAL_RS =>
+                            pair := not cur.insn(0);
+                        when DUAL_ADDI | DUAL_LOGI =>
+                            pair := '1';
+                        when others =>
+                    end case;
+                when others =>
+            end case;
+            if cb = DUAL_CMP then
+                -- BF is where RT would be, and there is no GPR result
+                if src_b = dest_a or
+                    (f_in.insn2(31 downto 26) = "011111" and insn_rb(f_in.insn2) = dest_a) then
+                    pair := '0';
+                end if;
+            elsif ca /= DUAL_CMP and
+                (src_b = dest_a or dest_b = dest_a or
+                 ((cb = DUAL_ADD or cb = DUAL_LOG) and insn_rb(f_in.insn2) = dest_a)) then
+                pair := '0';
+            end if;
+        end if;
+        v.dual    := pair;
+        v.insn2   := f_in.insn2;
+        split <= cur.valid and cur.dual and not cur.fetch_failed and not pair and not v.br_pred;
 
         -- Work out GPR/FPR read addresses
         -- Note that for prefixed instructions we are working this out based
         -- only on the suffix.
         if double = '0' then
             maybe_rb      := '0';
-            vr.reg_1_addr := '0' & insn_ra(f_in.insn);
-            vr.reg_2_addr := '0' & insn_rb(f_in.insn);
-            vr.reg_3_addr := '0' & insn_rs(f_in.insn);
+            vr.reg_1_addr := '0' & insn_ra(cur.insn);
+            vr.reg_2_addr := '0' & insn_rb(cur.insn);
+            vr.reg_3_addr := '0' & insn_rs(cur.insn);
 
             -- report "[if double = '0'] Debug registers "
             --     & insn_code'image(insn_code'val(to_integer(unsigned(icode_bits))))
@@ -715,7 +1031,7 @@ begin
                 maybe_rb := '1';
                 if icode < INSN_first_frs then
                     if icode >= INSN_first_rc then
-                        vr.reg_3_addr := '0' & insn_rcreg(f_in.insn);
+                        vr.reg_3_addr := '0' & insn_rcreg(cur.insn);
                     end if;
                 else
                     -- report "[icode < INSN_first_frs else 1] Debug registers "
@@ -739,7 +1055,7 @@ begin
 
                     if icode >= INSN_first_frabc then
                         -- access FRC operand
-                        vr.reg_3_addr := '1' & insn_rcreg(f_in.insn);
+                        vr.reg_3_addr := '1' & insn_rcreg(cur.insn);
                     end if;
                     -- report "[icode < INSN_first_frs else 3] Debug registers "
                     --     & insn_code'image(insn_code'val(to_integer(unsigned(icode_bits))))
@@ -751,18 +1067,25 @@ begin
             -- See if this is an instruction where repeat_t = DRSP and we need
             -- to read RS|1 followed by RS, i.e. stq or stqcx. in LE mode
             -- (note we don't have access to the decode for the current instruction)
-            if (icode = INSN_stq or icode = INSN_stqcx) and f_in.big_endian = '0' then
+            if (icode = INSN_stq or icode = INSN_stqcx) and cur.big_endian = '0' then
                 vr.reg_3_addr(0) := '1';
             end if;
             -- See if this is an instruction where we need to use the RS/RC
             -- read port to read the RB operand, because we want to get an
             -- immediate operand to execute1 via read_data2.
             if (icode = INSN_hashst or icode = INSN_hashchk or icode = INSN_hashstp or icode = INSN_hashchkp) then
-                vr.reg_3_addr := '0' & insn_rb(f_in.insn);
+                vr.reg_3_addr := '0' & insn_rb(cur.insn);
+            end if;
+            -- A fused op reads RA of the addis
+            if fuse = '1' then
+                vr.reg_1_addr := '0' & insn_ra(r.insn);
             end if;
-            vr.read_1_enable := f_in.valid;
-            vr.read_2_enable := f_in.valid and maybe_rb;
-            vr.read_3_enable := f_in.valid;
+            vr.read_1_enable := cur.valid;
+            vr.read_2_enable := cur.valid and maybe_rb;
+            vr.read_3_enable := cur.valid;
+            -- Operands of the second instruction of a pair
+            vr.reg_4_addr := '0' & src_b;
+            vr.reg_5_addr := '0' & insn_rb(f_in.insn2);
         else
             -- second instance of a doubled instruction
             vr.reg_1_addr    := r.reg_a;
@@ -771,11 +1094,17 @@ begin
             vr.read_1_enable := '0';    -- (not actually used)
             vr.read_2_enable := '0';
             vr.read_3_enable := '1';    -- (not actually used)
+            vr.reg_4_addr    := r.reg_d;
+            vr.reg_5_addr    := r.reg_e;
             -- For pstq, and for stq and stqcx in BE mode,
             -- we need to read register RS|1 in the cycle after we read RS;
             -- stq and stqcx in LE mode read RS.
             if decode.repeat = DRSP then
-                vr.reg_3_addr(0) := r.prefixed or f_in.big_endian;
+                vr.reg_3_addr(0) := r.prefixed or cur.big_endian;
+            end if;
+            -- Queue pairs always do FRS then FRS|1.
+            if decode.repeat = DQP then
+                vr.reg_3_addr(0) := '1';
             end if;
         end if;
 
@@ -783,6 +1112,8 @@ begin
         v.reg_a := vr.reg_1_addr;
         v.reg_b := vr.reg_2_addr;
         v.reg_c := vr.reg_3_addr;
+        v.reg_d := vr.reg_4_addr;
+        v.reg_e := vr.reg_5_addr;
 
         -- report "[END] Debug registers "
         --     & insn_code'image(insn_code'val(to_integer(unsigned(icode_bits))))
@@ -797,7 +1128,9 @@ begin
 
         -- Update outputs
         d_out              <= r;
+        d_out.valid        <= r.valid and not fuse;
         d_out.decode       <= decode;
+        d_out.decode2      <= decode_b;
         r_out              <= vr;
         f_out.redirect     <= br.predict;
         f_out.redirect_nia <= std_ulogic_vector(br.br_target) & "00";
@@ -63,9 +63,15 @@ architecture behaviour of decode2 is
         input_ov  : std_ulogic;
         output_ov : std_ulogic;
         read_rspr : std_ulogic;
+        -- operands of the dual-issued instruction in e.dual
+        reg_valid4 : std_ulogic;
+        read_reg4  : gspr_index_t;
+        reg_valid5 : std_ulogic;
+        read_reg5  : gspr_index_t;
     end record;
     constant reg_type_init : reg_type :=
-        (e => Decode2ToExecute1Init, repeat => NONE, others => '0');
+        (e => Decode2ToExecute1Init, repeat => NONE,
+         read_reg4 => (others => '0'), read_reg5 => (others => '0'), others => '0');
 
     signal dc2, dc2in : reg_type;
 
@@ -226,23 +232,49 @@ architecture behaviour of decode2 is
         end case;
     end;
 
-    function andor (mask_a : std_ulogic; val_a : std_ulogic_vector(63 downto 0);
-                    mask_b : std_ulogic; val_b : std_ulogic_vector(63 downto 0);
-                    mask_c : std_ulogic; val_c : std_ulogic_vector(63 downto 0)) return std_ulogic_vector is
+    -- Select a bypass value according to a gpr_bypass_* vector from control
+    function bypass_mux (sel : std_ulogic_vector(6 downto 0);
+                         ex : bypass_data_t; ex2 : bypass_data_t; wb : bypass_data_t)
+        return std_ulogic_vector is
         variable t : std_ulogic_vector(63 downto 0) := (others => '0');
     begin
-        if mask_a = '1' then
-            t := val_a;
+        if sel(1) = '1' then
+            t := ex.data;
+        end if;
+        if sel(2) = '1' then
+            t := t or ex2.data;
+        end if;
+        if sel(3) = '1' then
+            t := t or wb.data;
         end if;
-        if mask_b = '1' then
-            t := t or val_b;
+        if sel(4) = '1' then
+            t := t or ex.data2;
         end if;
-        if mask_c = '1' then
-            t := t or val_c;
+        if sel(5) = '1' then
+            t := t or ex2.data2;
+        end if;
+        if sel(6) = '1' then
+            t := t or wb.data2;
         end if;
         return t;
     end;
 
+    function decode_length (t : length_t) return std_ulogic_vector is
+    begin
+        case t is
+            when is1B =>
+                return "0001";
+            when is2B =>
+                return "0010";
+            when is4B =>
+                return "0100";
+            when is8B =>
+                return "1000";
+            when NONE =>
+                return "0000";
+        end case;
+    end;
+
     -- control signals that are derived from insn_type
     type mux_select_array_t is array(insn_type_t) of std_ulogic_vector(2 downto 0);
 
@@ -300,6 +332,9 @@ architecture behaviour of decode2 is
     signal decoded_reg_b : decode_input_reg_t;
     signal decoded_reg_c : decode_input_reg_t;
     signal decoded_reg_o : decode_output_reg_t;
+    signal decoded_reg_d : decode_input_reg_t;
+    signal decoded_reg_e : decode_input_reg_t;
+    signal decoded_reg_o2 : decode_output_reg_t;
 
     -- issue control signals
     signal control_valid_in : std_ulogic;
@@ -309,17 +344,28 @@ architecture behaviour of decode2 is
     signal gpr_write_valid : std_ulogic;
     signal gpr_write : gspr_index_t;
 
+    signal gpr_write2_valid : std_ulogic;
+    signal gpr_write2 : gspr_index_t;
+
     signal gpr_a_read_valid : std_ulogic;
     signal gpr_a_read       : gspr_index_t;
-    signal gpr_a_bypass     : std_ulogic_vector(3 downto 0);
+    signal gpr_a_bypass     : std_ulogic_vector(6 downto 0);
 
     signal gpr_b_read_valid : std_ulogic;
     signal gpr_b_read       : gspr_index_t;
-    signal gpr_b_bypass     : std_ulogic_vector(3 downto 0);
+    signal gpr_b_bypass     : std_ulogic_vector(6 downto 0);
 
     signal gpr_c_read_valid : std_ulogic;
     signal gpr_c_read       : gspr_index_t;
-    signal gpr_c_bypass     : std_ulogic_vector(3 downto 0);
+    signal gpr_c_bypass     : std_ulogic_vector(6 downto 0);
+
+    signal gpr_d_read_valid : std_ulogic;
+    signal gpr_d_read       : gspr_index_t;
+    signal gpr_d_bypass     : std_ulogic_vector(6 downto 0);
+
+    signal gpr_e_read_valid : std_ulogic;
+    signal gpr_e_read       : gspr_index_t;
+    signal gpr_e_bypass     : std_ulogic_vector(6 downto 0);
 
     signal cr_read_valid   : std_ulogic;
     signal cr_write_valid  : std_ulogic;
@@ -349,6 +395,9 @@ begin
             gpr_write_valid_in => gpr_write_valid,
             gpr_write_in       => gpr_write,
 
+            gpr_write2_valid_in => gpr_write2_valid,
+            gpr_write2_in       => gpr_write2,
+
             gpr_a_read_valid_in  => gpr_a_read_valid,
             gpr_a_read_in        => gpr_a_read,
 
@@ -358,6 +407,12 @@ begin
             gpr_c_read_valid_in  => gpr_c_read_valid,
             gpr_c_read_in        => gpr_c_read,
 
+            gpr_d_read_valid_in  => gpr_d_read_valid,
+            gpr_d_read_in        => gpr_d_read,
+
+            gpr_e_read_valid_in  => gpr_e_read_valid,
+            gpr_e_read_in        => gpr_e_read,
+
             execute_next_tag     => execute_bypass.tag,
             execute_next_cr_tag  => execute_cr_bypass.tag,
             execute2_next_tag    => execute2_bypass.tag,
@@ -376,6 +431,8 @@ begin
             gpr_bypass_a => gpr_a_bypass,
             gpr_bypass_b => gpr_b_bypass,
             gpr_bypass_c => gpr_c_bypass,
+            gpr_bypass_d => gpr_d_bypass,
+            gpr_bypass_e => gpr_e_bypass,
 
             instr_tag_out => instr_tag
             );
@@ -412,6 +469,12 @@ begin
                 assert decoded_reg_c.reg_valid = '0' or decoded_reg_c.reg = d_in.reg_c
                     report "Register mismatch: decoded_reg_c.reg = " & to_string(decoded_reg_c.reg) &  ", expected d_in.reg_c = " & to_string(d_in.reg_c)
                     severity failure;
+                assert decoded_reg_d.reg_valid = '0' or decoded_reg_d.reg = d_in.reg_d
+                    report "Register mismatch: decoded_reg_d.reg = " & to_string(decoded_reg_d.reg) &  ", expected d_in.reg_d = " & to_string(d_in.reg_d)
+                    severity failure;
+                assert decoded_reg_e.reg_valid = '0' or decoded_reg_e.reg = d_in.reg_e
+                    report "Register mismatch: decoded_reg_e.reg = " & to_string(decoded_reg_e.reg) &  ", expected d_in.reg_e = " & to_string(d_in.reg_e)
+                    severity failure;
             end if;
         end if;
     end process;
@@ -421,6 +484,8 @@ begin
     decode2_addrs: process(all)
         variable dec_a, dec_b, dec_c : decode_input_reg_t;
         variable dec_o : decode_output_reg_t;
+        variable dec_d, dec_e : decode_input_reg_t;
+        variable dec_o2 : decode_output_reg_t;
     begin
         dec_a := decode_input_reg_a (d_in.decode.input_reg_a, d_in.insn, d_in.prefix);
         dec_b := decode_input_reg_b (d_in.decode.input_reg_b, d_in.insn);
@@ -442,6 +507,12 @@ begin
                 if d_in.second = (d_in.big_endian or d_in.prefixed) then
                     dec_o.reg(0) := '1';
                 end if;
+            when DQP =>
+                -- queue pairs do FRS, FRS|1 or FRT, FRT|1 in either endian mode
+                if d_in.second = '1' then
+                    dec_c.reg(0) := '1';
+                    dec_o.reg(0) := '1';
+                end if;
             when others =>
         end case;
         -- For the second instance of a doubled instruction, we ignore the RA
@@ -458,13 +529,32 @@ begin
             dec_o.reg_valid := '0';
         end if;
 
+        -- The dual-issued instruction reads RA, zero or RS as its first
+        -- operand and RB or an immediate as its second, and writes RT or RA.
+        dec_d := decode_input_reg_a (d_in.decode2.input_reg_a, d_in.insn2, (others => '0'));
+        if d_in.decode2.input_reg_c = RS then
+            dec_d := decode_input_reg_c (d_in.decode2.input_reg_c, d_in.insn2);
+        end if;
+        dec_e := decode_input_reg_b (d_in.decode2.input_reg_b, d_in.insn2);
+        dec_o2 := decode_output_reg (d_in.decode2.output_reg_a, d_in.insn2);
+        if d_in.valid = '0' or d_in.dual = '0' then
+            dec_d.reg_valid := '0';
+            dec_e.reg_valid := '0';
+            dec_o2.reg_valid := '0';
+        end if;
+
         decoded_reg_a <= dec_a;
         decoded_reg_b <= dec_b;
         decoded_reg_c <= dec_c;
         decoded_reg_o <= dec_o;
+        decoded_reg_d <= dec_d;
+        decoded_reg_e <= dec_e;
+        decoded_reg_o2 <= dec_o2;
         r_out.read1_enable <= dec_a.reg_valid;
         r_out.read2_enable <= dec_b.reg_valid;
         r_out.read3_enable <= dec_c.reg_valid;
+        r_out.read4_enable <= dec_d.reg_valid;
+        r_out.read5_enable <= dec_e.reg_valid;
 
     end process;
 
@@ -660,18 +750,7 @@ begin
             end case;
             v.read_rspr := sprs_busy and d_in.valid;
 
-            case d_in.decode.length is
-                when is1B =>
-                    length := "0001";
-                when is2B =>
-                    length := "0010";
-                when is4B =>
-                    length := "0100";
-                when is8B =>
-                    length := "1000";
-                when NONE =>
-                    length := "0000";
-            end case;
+            length := decode_length(d_in.decode.length);
 
             -- execute unit
             v.e.nia := d_in.nia;
@@ -699,6 +778,7 @@ begin
             v.e.update := d_in.decode.update;
             v.e.reserve := d_in.decode.reserve;
             v.e.br_pred := d_in.br_pred;
+            v.e.br_target := d_in.br_target;
             v.e.result_sel := result_select(op);
             v.e.sub_select := subresult_select(op);
             if op = OP_MFSPR then
@@ -725,6 +805,7 @@ begin
             v.e.prefix := d_in.prefix;
             v.e.illegal_suffix := d_in.illegal_suffix;
             v.e.misaligned_prefix := d_in.misaligned_prefix;
+            v.e.fused := d_in.fused;
 
             -- rotator control signals
             v.e.right_shift := '1' when op = OP_SHR else '0';
@@ -734,6 +815,28 @@ begin
 
             v.e.do_popcnt := '1' when op = OP_COUNTB and d_in.insn(7 downto 6) = "11" else '0';
 
+            -- lets execute1 decide from registered state whether this can
+            -- issue behind a multiply in flight (mul2_ok)
+            v.e.mul64 := '1' when (op = OP_MUL_H64 or (op = OP_MUL_L64 and d_in.decode.is_32bit = '0')) and
+                         v.e.oe = '0' and d_in.prefixed = '0' else '0';
+
+            -- dual-issued instruction
+            v.e.dual.valid := d_in.valid and d_in.dual;
+            v.e.dual.insn_type := d_in.decode2.insn_type;
+            v.e.dual.insn := d_in.insn2;
+            v.e.dual.write_reg := decoded_reg_o2.reg;
+            v.e.dual.invert_a := d_in.decode2.invert_a;
+            v.e.dual.invert_out := d_in.decode2.invert_out;
+            v.e.dual.is_signed := d_in.decode2.is_signed;
+            v.e.dual.is_32bit := d_in.decode2.is_32bit;
+            v.e.dual.carry_in := '1' when d_in.decode2.input_carry = ONE else '0';
+            v.e.dual.output_cr := d_in.valid and d_in.dual and d_in.decode2.output_cr;
+            v.e.dual.data_len := decode_length(d_in.decode2.length);
+            v.reg_valid4 := decoded_reg_d.reg_valid;
+            v.read_reg4 := decoded_reg_d.reg;
+            v.reg_valid5 := decoded_reg_e.reg_valid;
+            v.read_reg5 := decoded_reg_e.reg;
+
             -- check for invalid forms that cause an illegal instruction interrupt
             -- Does RA = RT for a load quadword instr, or RB = RT for lqarx?
             if d_in.decode.repeat = DRTP and
@@ -741,8 +844,11 @@ begin
                  (d_in.decode.reserve = '1' and insn_rb(d_in.insn) = insn_rt(d_in.insn))) then
                 v.e.illegal_form := '1';
             end if;
-            -- Is RS/RT odd for a load/store quadword instruction?
-            if (d_in.decode.repeat = DRSP or d_in.decode.repeat = DRTP) and d_in.insn(21) = '1' then
+            -- Is RS/RT odd for a load/store quadword instruction,
+            -- or FRS/FRT odd for a queue pair transfer?
+            if (d_in.decode.repeat = DRSP or d_in.decode.repeat = DRTP or
+                (d_in.decode.repeat = DQP and d_in.decode.facility = FPU)) and
+                d_in.insn(21) = '1' then
                 v.e.illegal_form := '1';
             end if;
         end if;
@@ -763,7 +869,16 @@ begin
         gpr_c_read_valid <= v.e.reg_valid3;
         gpr_c_read <= v.e.read_reg3;
 
-        cr_write_valid <= v.e.output_cr or v.e.rc;
+        gpr_write2_valid <= v.e.dual.valid and not v.e.dual.output_cr;
+        gpr_write2 <= v.e.dual.write_reg;
+
+        gpr_d_read_valid <= v.reg_valid4;
+        gpr_d_read <= v.read_reg4;
+
+        gpr_e_read_valid <= v.reg_valid5;
+        gpr_e_read <= v.read_reg5;
+
+        cr_write_valid <= v.e.output_cr or v.e.rc or v.e.dual.output_cr;
         -- Since ops that write CR only write some of the fields,
         -- any op that writes CR effectively also reads it.
         cr_read_valid <= cr_write_valid or v.e.input_cr;
@@ -773,9 +888,7 @@ begin
 
         -- See if any of the operands can get their value via the bypass path.
         if gpr_a_bypass(0) = '1' then
-            v.e.read_data1 := andor(gpr_a_bypass(1), execute_bypass.data,
-                                    gpr_a_bypass(2), execute2_bypass.data,
-                                    gpr_a_bypass(3), writeback_bypass.data);
+            v.e.read_data1 := bypass_mux(gpr_a_bypass, execute_bypass, execute2_bypass, writeback_bypass);
         elsif dc2.busy = '0' then
             if decoded_reg_a.reg_valid = '1' then
                 v.e.read_data1 := r_in.read1_data;
@@ -784,9 +897,7 @@ begin
             end if;
         end if;
         if gpr_b_bypass(0) = '1' then
-            v.e.read_data2 := andor(gpr_b_bypass(1), execute_bypass.data,
-                                    gpr_b_bypass(2), execute2_bypass.data,
-                                    gpr_b_bypass(3), writeback_bypass.data);
+            v.e.read_data2 := bypass_mux(gpr_b_bypass, execute_bypass, execute2_bypass, writeback_bypass);
         elsif dc2.busy = '0' then
             if decoded_reg_b.reg_valid = '1' then
                 v.e.read_data2 := r_in.read2_data;
@@ -795,9 +906,7 @@ begin
             end if;
         end if;
         if gpr_c_bypass(0) = '1' then
-            v.e.read_data3 := andor(gpr_c_bypass(1), execute_bypass.data,
-                                    gpr_c_bypass(2), execute2_bypass.data,
-                                    gpr_c_bypass(3), writeback_bypass.data);
+            v.e.read_data3 := bypass_mux(gpr_c_bypass, execute_bypass, execute2_bypass, writeback_bypass);
         elsif dc2.busy = '0' then
             if decoded_reg_c.reg_valid = '1' then
                 v.e.read_data3 := r_in.read3_data;
@@ -805,6 +914,24 @@ begin
                 v.e.read_data3 := (others => '0');
             end if;
         end if;
+        if gpr_d_bypass(0) = '1' then
+            v.e.dual.read_data1 := bypass_mux(gpr_d_bypass, execute_bypass, execute2_bypass, writeback_bypass);
+        elsif dc2.busy = '0' then
+            if decoded_reg_d.reg_valid = '1' then
+                v.e.dual.read_data1 := r_in.read4_data;
+            else
+                v.e.dual.read_data1 := (others => '0');
+            end if;
+        end if;
+        if gpr_e_bypass(0) = '1' then
+            v.e.dual.read_data2 := bypass_mux(gpr_e_bypass, execute_bypass, execute2_bypass, writeback_bypass);
+        elsif dc2.busy = '0' then
+            if decoded_reg_e.reg_valid = '1' then
+                v.e.dual.read_data2 := r_in.read5_data;
+            else
+                v.e.dual.read_data2 := decode_b_const(d_in.decode2.const_sel, d_in.insn2, (others => '0'));
+            end if;
+        end if;
 
         case cr_bypass is
             when "10" =>
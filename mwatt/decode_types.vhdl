@@ -301,7 +301,7 @@ package decode_types is
     constant INSN_maddld     : insn_code_t := "0011110010";  -- 242
     constant INSN_maddhd     : insn_code_t := "0011110011";  -- 243
     constant INSN_maddhdu    : insn_code_t := "0011110100";  -- 244
-    constant INSN_245        : insn_code_t := "0011110101";  -- 245
+    constant INSN_stafdpxq   : insn_code_t := "0011110101";  -- 245
     constant INSN_246        : insn_code_t := "0011110110";  -- 246
     constant INSN_247        : insn_code_t := "0011110111";  -- 247
     constant INSN_248        : insn_code_t := "0011111000";  -- 248
@@ -351,8 +351,8 @@ package decode_types is
     constant INSN_mcrfs      : insn_code_t := "0100011011";  -- 283
     constant INSN_mtfsb      : insn_code_t := "0100011100";  -- 284
     constant INSN_mtfsfi     : insn_code_t := "0100011101";  -- 285
-    constant INSN_282        : insn_code_t := "0100011110";  -- 286
-    constant INSN_283        : insn_code_t := "0100011111";  -- 287
+    constant INSN_stfdpxq    : insn_code_t := "0100011110";  -- 286
+    constant INSN_lfdpxq     : insn_code_t := "0100011111";  -- 287
     constant INSN_284        : insn_code_t := "0100100000";  -- 288
     constant INSN_285        : insn_code_t := "0100100001";  -- 289
     constant INSN_286        : insn_code_t := "0100100010";  -- 290
@@ -465,7 +465,8 @@ package decode_types is
     type repeat_t is (NONE,             -- instruction is not repeated
                       DUPD,             -- update-form load
                       DRSP,             -- double RS (RS, RS+1)
-                      DRTP);            -- double RT (RT, RT+1, or RT+1, RT)
+                      DRTP,             -- double RT (RT, RT+1, or RT+1, RT)
+                      DQP);             -- queue pair (FRS/FRT then +1, or EA then EA+8)
 
     type decode_rom_t is record
         unit         : unit_t;
@@ -790,7 +791,7 @@ package body decode_types is
         when INSN_maddld     => return "INSN_maddld";
         when INSN_maddhd     => return "INSN_maddhd";
         when INSN_maddhdu    => return "INSN_maddhdu";
-        when INSN_245        => return "INSN_245";
+        when INSN_stafdpxq   => return "INSN_stafdpxq";
         when INSN_246        => return "INSN_246";
         when INSN_247        => return "INSN_247";
         when INSN_248        => return "INSN_248";
@@ -831,8 +832,8 @@ package body decode_types is
         when INSN_mcrfs      => return "INSN_mcrfs";
         when INSN_mtfsb      => return "INSN_mtfsb";
         when INSN_mtfsfi     => return "INSN_mtfsfi";
-        when INSN_282        => return "INSN_282";
-        when INSN_283        => return "INSN_283";
+        when INSN_stfdpxq    => return "INSN_stfdpxq";
+        when INSN_lfdpxq     => return "INSN_lfdpxq";
         when INSN_284        => return "INSN_284";
         when INSN_285        => return "INSN_285";
         when INSN_286        => return "INSN_286";
@@ -994,6 +995,9 @@ package body decode_types is
             when INSN_lfsxq   => return "011111";
             when INSN_stafsxq => return "011111";
             when INSN_stfsxq  => return "011111";
+            when INSN_lfdpxq  => return "011111";
+            when INSN_stafdpxq => return "011111";
+            when INSN_stfdpxq => return "011111";
             --
             when INSN_fre       => return "111111";
             when INSN_fmul      => return "111111";
@@ -0,0 +1,101 @@
+#include "console.h"
+#include "io.h"
+#include "microwatt_soc.h"
+
+#include "pmu.h"
+#include "time.h"
+
+/*
+ * Integer divide latency benchmark.
+ *
+ * Times dependent chains of divdu, divd and modud with dividends of
+ * different sizes, and prints the average number of PMU run cycles per
+ * operation.  The integer divider is only used when the core is built
+ * without the FPU (HAS_FPU false); compare builds with DIV_RADIX_BITS
+ * set to 1, 2 and 4.
+ */
+
+#define OPS 256
+
+static unsigned long __attribute__((noinline)) chain_divdu(unsigned long a, unsigned long b)
+{
+  unsigned long x = a;
+  int i;
+
+  for (i = 0; i < OPS; i++)
+    x = (x | a) / b;
+  return x;
+}
+
+static long __attribute__((noinline)) chain_divd(long a, long b)
+{
+  long x = a;
+  int i;
+
+  for (i = 0; i < OPS; i++)
+    x = (x | a) / b;
+  return x;
+}
+
+static unsigned long __attribute__((noinline)) chain_modud(unsigned long a, unsigned long b)
+{
+  unsigned long x = a;
+  int i;
+
+  for (i = 0; i < OPS; i++)
+    x = (x | a) % b;
+  return x;
+}
+
+static void report(const char *name, unsigned long dividend, uint64_t cycles)
+{
+  puts(name);
+  puts(" dividend bits ");
+  print_uint64(64 - __builtin_clzl(dividend | 1));
+  puts(": cycles/op ");
+  print_uint64(cycles / OPS);
+  puts("\n");
+}
+
+static const unsigned long dividends[] = {
+  0x7full,
+  0x7fffull,
+  0x7fffffffull,
+  0x7fffffffffffull,
+  0x7fffffffffffffffull,
+};
+
+int main(void)
+{
+  unsigned long a;
+  volatile unsigned long sink;
+  unsigned int i;
+
+  console_init();
+
+  for (i = 0; i < sizeof(dividends) / sizeof(dividends[0]); i++) {
+    a = dividends[i];
+
+    pmu_start(PMU_MMCR1(PMU_EV1_CYCLES, 0, 0, 0));
+    sink = chain_divdu(a, 3);
+    pmu_stop();
+    report("divdu", a, pmu_read(1));
+
+    pmu_start(PMU_MMCR1(PMU_EV1_CYCLES, 0, 0, 0));
+    sink = chain_divd(a, -3);
+    pmu_stop();
+    report("divd ", a, pmu_read(1));
+
+    pmu_start(PMU_MMCR1(PMU_EV1_CYCLES, 0, 0, 0));
+    sink = chain_modud(a, 1000003);
+    pmu_stop();
+    report("modud", a, pmu_read(1));
+  }
+  (void)sink;
+
+  return 0;
+}
+
+void secondary_main(void)
+{
+}
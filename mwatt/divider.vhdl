@@ -7,6 +7,11 @@ use work.common.all;
 use work.decode_types.all;
 
 entity divider is
+    generic (
+        -- Quotient bits generated per cycle: 1 (radix 2), 2 (radix 4)
+        -- or 4 (radix 16)
+        DIV_RADIX_BITS : positive := 1
+        );
     port (
         clk   : in std_logic;
         rst   : in std_logic;
@@ -32,8 +37,38 @@ architecture behaviour of divider is
     signal overflow   : std_ulogic;
     signal ovf32      : std_ulogic;
     signal did_ovf    : std_ulogic;
+
+    -- One restoring division step, producing one quotient bit
+    procedure div_step(dend : inout std_ulogic_vector(128 downto 0);
+                       quot : inout std_ulogic_vector(63 downto 0);
+                       ovf : inout std_ulogic; ovf32 : inout std_ulogic;
+                       div : unsigned(63 downto 0)) is
+    begin
+        ovf := ovf or quot(63);
+        ovf32 := ovf32 or quot(31);
+        if dend(128) = '1' or unsigned(dend(127 downto 64)) >= div then
+            dend := std_ulogic_vector(unsigned(dend(127 downto 64)) - div) &
+                    dend(63 downto 0) & '0';
+            quot := quot(62 downto 0) & '1';
+        else
+            dend := dend(127 downto 0) & '0';
+            quot := quot(62 downto 0) & '0';
+        end if;
+    end;
+
 begin
+    assert DIV_RADIX_BITS = 1 or DIV_RADIX_BITS = 2 or DIV_RADIX_BITS = 4
+        report "DIV_RADIX_BITS must be 1, 2 or 4" severity FAILURE;
+
     divider_0: process(clk)
+        variable d     : std_ulogic_vector(128 downto 0);
+        variable q     : std_ulogic_vector(63 downto 0);
+        variable ovf   : std_ulogic;
+        variable o32   : std_ulogic;
+        variable left  : unsigned(6 downto 0);
+        variable nbits : unsigned(6 downto 0);
+        variable lz    : natural range 0 to 60;
+        variable nz    : std_ulogic;
     begin
         if rising_edge(clk) then
             if rst = '1' or d_in.flush = '1' then
@@ -45,10 +80,22 @@ begin
                 is_32bit <= '0';
                 overflow <= '0';
             elsif d_in.valid = '1' then
+                -- A small dividend starts with leading zero quotient bits;
+                -- skip over them straight away, 4 at a time.
+                lz := 0;
+                nz := '0';
+                for i in 15 downto 1 loop
+                    nz := nz or (or d_in.dividend(i * 4 + 3 downto i * 4));
+                    if nz = '0' and d_in.divisor /= x"0000000000000000" then
+                        lz := lz + 4;
+                    end if;
+                end loop;
                 if d_in.is_extended = '1'  then
                     dend <= '0' & d_in.dividend & x"0000000000000000";
+                    lz := 0;
                 else
-                    dend <= '0' & x"0000000000000000" & d_in.dividend;
+                    dend <= '0' & x"0000000000000000" &
+                            std_ulogic_vector(shift_left(unsigned(d_in.dividend), lz));
                 end if;
                 div <= unsigned(d_in.divisor);
                 quot <= (others => '0');
@@ -57,33 +104,41 @@ begin
                 extended <= d_in.is_extended;
                 is_32bit <= d_in.is_32bit;
                 is_signed <= d_in.is_signed;
-                count <= "1111111";
+                count <= to_unsigned(lz, 7) - 1;
                 running <= '1';
                 overflow <= '0';
                 ovf32 <= '0';
             elsif running = '1' then
-                if count = "0111111" then
-                    running <= '0';
-                end if;
-                overflow <= quot(63);
-                if dend(128) = '1' or unsigned(dend(127 downto 64)) >= div then
-                    ovf32 <= ovf32 or quot(31);
-                    dend <= std_ulogic_vector(unsigned(dend(127 downto 64)) - div) &
-                            dend(63 downto 0) & '0';
-                    quot <= quot(62 downto 0) & '1';
-                    count <= count + 1;
-                elsif dend(128 downto 57) = x"000000000000000000" and count(6 downto 3) /= "0111" then
+                d := dend;
+                q := quot;
+                ovf := overflow;
+                o32 := ovf32;
+                -- quotient bits still to generate, 65 at the start
+                left := to_unsigned(64, 7) - count;
+                if d(128 downto 57) = x"000000000000000000" and left > 8 then
                     -- consume 8 bits of zeroes in one cycle
-                    ovf32 <= or (ovf32 & quot(31 downto 24));
-                    dend <= dend(120 downto 0) & x"00";
-                    quot <= quot(55 downto 0) & x"00";
-                    count <= count + 8;
+                    ovf := or (ovf & q(63 downto 56));
+                    o32 := or (o32 & q(31 downto 24));
+                    d := d(120 downto 0) & x"00";
+                    q := q(55 downto 0) & x"00";
+                    nbits := to_unsigned(8, 7);
+                elsif left >= DIV_RADIX_BITS then
+                    for i in 1 to DIV_RADIX_BITS loop
+                        div_step(d, q, ovf, o32, div);
+                    end loop;
+                    nbits := to_unsigned(DIV_RADIX_BITS, 7);
                 else
-                    ovf32 <= ovf32 or quot(31);
-                    dend <= dend(127 downto 0) & '0';
-                    quot <= quot(62 downto 0) & '0';
-                    count <= count + 1;
+                    div_step(d, q, ovf, o32, div);
+                    nbits := to_unsigned(1, 7);
+                end if;
+                if count + nbits = 64 then
+                    running <= '0';
                 end if;
+                dend <= d;
+                quot <= q;
+                overflow <= ovf;
+                ovf32 <= o32;
+                count <= count + nbits;
             else
                 count <= "0000000";
             end if;
@@ -14,7 +14,8 @@ library osvvm;
 use osvvm.RandomPkg.all;
 
 entity divider_tb is
-    generic (runner_cfg : string := runner_cfg_default);
+    generic (runner_cfg : string := runner_cfg_default;
+             DIV_RADIX_BITS : positive := 1);
 end divider_tb;
 
 architecture behave of divider_tb is
@@ -26,6 +27,7 @@ architecture behave of divider_tb is
     signal d2               : DividerToExecute1Type;
 begin
     divider_0: entity work.divider
+        generic map (DIV_RADIX_BITS => DIV_RADIX_BITS)
         port map (clk => clk, rst => rst, d_in => d1, d_out => d2);
 
     clk_process: process
@@ -104,6 +106,43 @@ begin
                 wait for clk_period;
                 check_false(?? d2.valid, result("for valid"));
 
+            elsif run("Test small dividend") then
+                -- 16-bit dividends should finish well before 64 cycles
+                for i in 0 to 100 loop
+                    ra := std_ulogic_vector(resize(unsigned(rnd.RandSlv(16)), 64));
+                    rb := std_ulogic_vector(resize(unsigned(rnd.RandSlv(8)), 64));
+                    -- divide by zero isn't short-cut
+                    if rb = x"0000000000000000" then
+                        rb := x"0000000000000001";
+                    end if;
+
+                    d1.dividend <= ra;
+                    d1.divisor <= rb;
+                    d1.is_modulus <= '0';
+                    if i mod 2 = 1 then
+                        d1.is_modulus <= '1';
+                    end if;
+                    d1.valid <= '1';
+
+                    wait for clk_period;
+
+                    d1.valid <= '0';
+                    for j in 0 to 20 loop
+                        wait for clk_period;
+                        if d2.valid = '1' then
+                            exit;
+                        end if;
+                    end loop;
+                    check_true(?? d2.valid, result("for early valid"));
+
+                    if i mod 2 = 1 then
+                        behave_rt := std_ulogic_vector(unsigned(ra) rem unsigned(rb));
+                    else
+                        behave_rt := ppc_divdu(ra, rb);
+                    end if;
+                    check_equal(d2.write_reg_data, behave_rt, result("for small dividend"));
+                end loop;
+
             elsif run("Test divd") then
                 divd_loop : for dlength in 1 to 8 loop
                     for vlength in 1 to dlength loop
@@ -0,0 +1,155 @@
+#include "console.h"
+#include "io.h"
+#include "microwatt_soc.h"
+
+#include "pmu.h"
+#include "time.h"
+
+/*
+ * Dual-issue benchmark (core DUAL_ISSUE, off by default; run core_tb
+ * with -gDUAL_ISSUE=true).
+ *
+ * Runs loops of simple integer instructions (add, addi, logical ops,
+ * rotates) laid out as independent pairs at doubleword boundaries,
+ * which can go down the pipe two at a time, and the same work written
+ * as one dependent chain, which can't.  Each loop reports PMU run
+ * cycles, completed instructions (a pair counts as two), and the number
+ * of second instructions issued alongside another, so the two loops of
+ * each kind complete the same number of instructions and differ in
+ * cycles and pairs.
+ */
+
+#define WORDS     256
+#define REPS      16
+
+static uint64_t table[WORDS];
+
+static uint64_t __attribute__((noinline)) indep_add_loop(const uint64_t *p)
+{
+  uint64_t a = p[0], b = p[1], c = p[2], d = p[3];
+  int i;
+
+  for (i = 0; i < WORDS; i += 4) {
+    __asm__ volatile(".p2align 3\n\t"
+                     "add %0,%0,%4\n\t"
+                     "add %1,%1,%4\n\t"
+                     "addi %2,%2,3\n\t"
+                     "addi %3,%3,5\n\t"
+                     "add %0,%0,%3\n\t"
+                     "add %1,%1,%2\n\t"
+                     "addi %2,%2,7\n\t"
+                     "addi %3,%3,9"
+                     : "+b"(a), "+b"(b), "+b"(c), "+b"(d) : "r"(p[i]));
+  }
+  return a + b + c + d;
+}
+
+static uint64_t __attribute__((noinline)) dep_add_loop(const uint64_t *p)
+{
+  uint64_t a = p[0], b = p[1], c = p[2], d = p[3];
+  int i;
+
+  for (i = 0; i < WORDS; i += 4) {
+    __asm__ volatile(".p2align 3\n\t"
+                     "add %0,%0,%4\n\t"
+                     "add %0,%0,%1\n\t"
+                     "addi %0,%0,3\n\t"
+                     "add %0,%0,%2\n\t"
+                     "add %0,%0,%3\n\t"
+                     "addi %0,%0,5\n\t"
+                     "add %0,%0,%1\n\t"
+                     "addi %0,%0,7"
+                     : "+b"(a) : "r"(b), "r"(c), "r"(d), "r"(p[i]));
+  }
+  return a + b + c + d;
+}
+
+static uint64_t __attribute__((noinline)) indep_logic_loop(const uint64_t *p)
+{
+  uint64_t a = p[0], b = p[1], c = p[2], d = p[3];
+  int i;
+
+  for (i = 0; i < WORDS; i += 4) {
+    __asm__ volatile(".p2align 3\n\t"
+                     "xor %0,%0,%4\n\t"
+                     "rotldi %1,%1,7\n\t"
+                     "and %2,%2,%4\n\t"
+                     "ori %3,%3,0x55\n\t"
+                     "rldicl %0,%0,3,8\n\t"
+                     "or %1,%1,%4\n\t"
+                     "xori %2,%2,0xaa\n\t"
+                     "slwi %3,%3,2"
+                     : "+r"(a), "+r"(b), "+r"(c), "+r"(d) : "r"(p[i]));
+  }
+  return a + b + c + d;
+}
+
+static uint64_t __attribute__((noinline)) dep_logic_loop(const uint64_t *p)
+{
+  uint64_t a = p[0];
+  int i;
+
+  for (i = 0; i < WORDS; i += 4) {
+    __asm__ volatile(".p2align 3\n\t"
+                     "xor %0,%0,%1\n\t"
+                     "rotldi %0,%0,7\n\t"
+                     "and %0,%0,%1\n\t"
+                     "ori %0,%0,0x55\n\t"
+                     "rldicl %0,%0,3,8\n\t"
+                     "or %0,%0,%1\n\t"
+                     "xori %0,%0,0xaa\n\t"
+                     "slwi %0,%0,2"
+                     : "+r"(a) : "r"(p[i]));
+  }
+  return a;
+}
+
+static void run(const char *name, uint64_t (*fn)(const uint64_t *))
+{
+  volatile uint64_t sink;
+  uint64_t cycles, insns, dual;
+  int i;
+
+  /* Once to get the code and table into the caches */
+  sink = fn(table);
+  pmu_start(PMU_MMCR1(PMU_EV1_CYCLES, 0, PMU_EV3_INSN_COMPLETE, PMU_EV4_DUAL_OP));
+  for (i = 0; i < REPS; i++)
+    sink = fn(table);
+  pmu_stop();
+
+  cycles = pmu_read(1);
+  insns = pmu_read(3);
+  dual = pmu_read(4);
+
+  puts(name);
+  puts(": cycles ");
+  print_uint64(cycles);
+  puts(" completed ");
+  print_uint64(insns);
+  puts(" dual ");
+  print_uint64(dual);
+  puts(" sum ");
+  print_uint64(sink);
+  puts("\n");
+}
+
+int main(void)
+{
+  unsigned long i;
+
+  console_init();
+
+  for (i = 0; i < WORDS; i++)
+    table[i] = i;
+
+  run("add independent   ", indep_add_loop);
+  run("add dependent     ", dep_add_loop);
+  run("logic independent ", indep_logic_loop);
+  run("logic dependent   ", dep_logic_loop);
+
+  return 0;
+}
+
+void secondary_main(void)
+{
+}
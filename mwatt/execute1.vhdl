@@ -9,13 +9,22 @@ use work.helpers.all;
 use work.crhelpers.all;
 use work.insn_helpers.all;
 use work.ppc_fx_insns.all;
+use work.sim_cosim.all;
 
 entity execute1 is
     generic (
         SIM : boolean := false;
         EX1_BYPASS : boolean := true;
         HAS_FPU : boolean := true;
+        -- Quotient bits per cycle of the integer divider (no FPU only)
+        DIV_RADIX_BITS : positive := 1;
+        -- Pipeline stages in the 64-bit multiplier
+        MUL_PIPELINE_DEPTH : positive := 3;
+        -- Execute a simple ALU op (e_in.dual) alongside the main one
+        DUAL_ISSUE : boolean := false;
         CPU_INDEX : natural;
+        -- Report dispatched instructions to the co-simulation checker
+        COSIM : boolean := false;
         -- Non-zero to enable log data collection
         LOG_LENGTH : natural := 0
         );
@@ -57,12 +66,19 @@ entity execute1 is
         ls_events    : in Loadstore1EventType;
         dc_events    : in DcacheEventType;
         ic_events    : in IcacheEventType;
+        l2_events    : in L2cacheEventType := L2cacheEventInit;
+        lb_events    : in LoopBufferEventType := LoopBufferEventInit;
 
         -- Access to SPRs from core_debug module
         dbg_spr_req   : in std_ulogic;
         dbg_spr_ack   : out std_ulogic;
         dbg_spr_addr  : in std_ulogic_vector(7 downto 0);
         dbg_spr_data  : out std_ulogic_vector(63 downto 0);
+        dbg_spr_wr    : in std_ulogic := '0';
+
+        -- MSR write from core_debug, with the core stopped
+        dbg_msr_wr    : in std_ulogic := '0';
+        dbg_wr_data   : in std_ulogic_vector(63 downto 0) := (others => '0');
 
         -- debug
         sim_dump      : in std_ulogic;
@@ -117,12 +133,14 @@ architecture behaviour of execute1 is
         new_msr : std_ulogic_vector(63 downto 0);
         take_branch : std_ulogic;
         direct_branch : std_ulogic;
+        ret_predicted : std_ulogic;
         start_mul : std_ulogic;
         start_div : std_ulogic;
         start_bsort : std_ulogic;
         start_bperm : std_ulogic;
         do_trace : std_ulogic;
         ciabr_trace : std_ulogic;
+        trace_dual : std_ulogic;
         fp_intr : std_ulogic;
         res2_sel : std_ulogic_vector(1 downto 0);
         bypass_valid : std_ulogic;
@@ -141,6 +159,8 @@ architecture behaviour of execute1 is
         fp_exception_next : std_ulogic;
         trace_next : std_ulogic;
         trace_ciabr : std_ulogic;
+        trace_dual : std_ulogic;
+        trace_nia : std_ulogic_vector(63 downto 3);
         prev_op : insn_type_t;
         prev_prefixed : std_ulogic;
         oe : std_ulogic;
@@ -153,14 +173,22 @@ architecture behaviour of execute1 is
         lr_from_next : std_ulogic;
 	mul_in_progress : std_ulogic;
         mul_finish : std_ulogic;
+        -- second multiply, issued while the one in e was in flight
+        mul2_in_progress : std_ulogic;
+        mul2_done : std_ulogic;
+        mul2_select : std_ulogic_vector(2 downto 0);
+        mul2_e : Execute1ToWritebackType;
         div_in_progress : std_ulogic;
         bsort_in_progress : std_ulogic;
         bperm_in_progress : std_ulogic;
         no_instr_avail : std_ulogic;
         instr_dispatch : std_ulogic;
+        instr_fused : std_ulogic;
+        instr_dual : std_ulogic;
         ext_interrupt : std_ulogic;
         taken_branch_event : std_ulogic;
         br_mispredict : std_ulogic;
+        br_ret_mispredict : std_ulogic;
         msr : std_ulogic_vector(63 downto 0);
         xerc : xer_common_t;
         xerc_valid : std_ulogic;
@@ -175,14 +203,18 @@ architecture behaviour of execute1 is
         (e => Execute1ToWritebackInit, se => side_effect_init,
          busy => '0',
          fp_exception_next => '0', trace_next => '0', trace_ciabr => '0',
+         trace_dual => '0', trace_nia => (others => '0'),
          prev_op => OP_ILLEGAL, prev_prefixed => '0',
          oe => '0', mul_select => "000", res2_sel => "00",
          spr_select => spr_id_init, pmu_spr_num => 5x"0",
          redir_to_next => '0', advance_nia => '0', lr_from_next => '0',
          mul_in_progress => '0', mul_finish => '0', div_in_progress => '0',
+         mul2_in_progress => '0', mul2_done => '0', mul2_select => "000",
+         mul2_e => Execute1ToWritebackInit,
          bsort_in_progress => '0', bperm_in_progress => '0',
-         no_instr_avail => '0', instr_dispatch => '0', ext_interrupt => '0',
-         taken_branch_event => '0', br_mispredict => '0',
+         no_instr_avail => '0', instr_dispatch => '0', instr_fused => '0', instr_dual => '0',
+         ext_interrupt => '0',
+         taken_branch_event => '0', br_mispredict => '0', br_ret_mispredict => '0',
          msr => 64x"0",
          xerc => xerc_init, xerc_valid => '0',
          ramspr_wraddr => (others => '0'), ramspr_odd_data => 64x"0",
@@ -195,6 +227,7 @@ architecture behaviour of execute1 is
         ext_interrupt : std_ulogic;
         taken_branch_event : std_ulogic;
         br_mispredict : std_ulogic;
+        br_ret_mispredict : std_ulogic;
         log_addr_spr : std_ulogic_vector(31 downto 0);
     end record;
     constant reg_stage2_type_init : reg_stage2_type :=
@@ -220,11 +253,17 @@ architecture behaviour of execute1 is
     signal adder_result: std_ulogic_vector(63 downto 0);
     signal misc_result: std_ulogic_vector(63 downto 0);
     signal multicyc_result: std_ulogic_vector(63 downto 0);
+    signal mul2_result: std_ulogic_vector(63 downto 0);
+    signal mul2_ok : std_ulogic;
     signal bsort_result: std_ulogic_vector(63 downto 0);
     signal spr_result: std_ulogic_vector(63 downto 0);
     signal next_nia : std_ulogic_vector(63 downto 0);
     signal s1_sel : std_ulogic_vector(2 downto 0);
 
+    -- dual-issued instruction
+    signal dual_result : std_ulogic_vector(63 downto 0);
+    signal dual_crf : std_ulogic_vector(3 downto 0);
+
     signal carry_32 : std_ulogic;
     signal carry_64 : std_ulogic;
     signal overflow_32 : std_ulogic;
@@ -240,6 +279,7 @@ architecture behaviour of execute1 is
     signal multiply_to_x: MultiplyOutputType;
     signal x_to_mult_32s: MultiplyInputType;
     signal mult_32s_to_x: MultiplyOutputType;
+    signal mul_small : std_ulogic;
 
     -- divider signals
     signal x_to_divider: Execute1ToDividerType;
@@ -279,6 +319,9 @@ architecture behaviour of execute1 is
     signal ramspr_odd_wr_data : std_ulogic_vector(63 downto 0);
     signal ramspr_odd_wr_enab : std_ulogic;
 
+    -- debug SPR write in this cycle
+    signal dbg_spr_write : std_ulogic;
+
     signal stage2_stall : std_ulogic;
 
     signal timebase : std_ulogic_vector(63 downto 0);
@@ -505,6 +548,9 @@ begin
 	    );
 
     multiply_0: entity work.multiply
+        generic map (
+            PIPELINE_DEPTH => MUL_PIPELINE_DEPTH
+            )
         port map (
             clk => clk,
             m_in => x_to_multiply,
@@ -521,6 +567,9 @@ begin
 
     divider_0: if not HAS_FPU generate
         div_0: entity work.divider
+            generic map (
+                DIV_RADIX_BITS => DIV_RADIX_BITS
+                )
             port map (
                 clk => clk,
                 rst => rst,
@@ -604,7 +653,102 @@ begin
     c_in <= e_in.read_data3;
     cr_in <= e_in.cr;
 
+    -- ALU for the dual-issued instruction.  It only does adds (without
+    -- carry out), logical ops, sign extension and rotate-and-mask with
+    -- an immediate shift, and compares, which set a CR field from the
+    -- operands and XER[SO].  It has no other CR, XER or SPR inputs or
+    -- outputs.
+    dual_alu: if DUAL_ISSUE generate
+        signal dual_sum : std_ulogic_vector(63 downto 0);
+        signal dual_logical : std_ulogic_vector(63 downto 0);
+        signal dual_rotated : std_ulogic_vector(63 downto 0);
+        signal dual_clear_left : std_ulogic;
+        signal dual_clear_right : std_ulogic;
+    begin
+        logical_1: entity work.logical
+            port map (
+                rs => e_in.dual.read_data1,
+                rb => e_in.dual.read_data2,
+                op => e_in.dual.insn_type,
+                invert_in => e_in.dual.invert_a,
+                invert_out => e_in.dual.invert_out,
+                is_signed => e_in.dual.is_signed,
+                result => dual_logical,
+                datalen => e_in.dual.data_len
+                );
+
+        dual_clear_left <= '1' when e_in.dual.insn_type = OP_RLC or e_in.dual.insn_type = OP_RLCL else '0';
+        dual_clear_right <= '1' when e_in.dual.insn_type = OP_RLC or e_in.dual.insn_type = OP_RLCR else '0';
+
+        rotator_1: entity work.rotator
+            port map (
+                rs => e_in.dual.read_data1,
+                ra => 64x"0",
+                shift => e_in.dual.read_data2(6 downto 0),
+                insn => e_in.dual.insn,
+                is_32bit => e_in.dual.is_32bit,
+                right_shift => '0',
+                arith => e_in.dual.is_signed,
+                clear_left => dual_clear_left,
+                clear_right => dual_clear_right,
+                sign_ext_rs => '0',
+                result => dual_rotated,
+                carry_out => open
+                );
+
+        dual_sum <= std_ulogic_vector(unsigned(e_in.dual.read_data1 xor (63 downto 0 => e_in.dual.invert_a)) +
+                                      unsigned(e_in.dual.read_data2) + unsigned'(0 => e_in.dual.carry_in));
+
+        with e_in.dual.insn_type select dual_result <=
+            dual_sum when OP_ADD,
+            dual_rotated when OP_RLC | OP_RLCL | OP_RLCR,
+            dual_logical when others;
+
+        -- cmp, cmpi, cmpl and cmpli
+        dual_compare: process(all)
+            variable a, b : std_ulogic_vector(63 downto 0);
+            variable lt, gt : std_ulogic;
+        begin
+            a := e_in.dual.read_data1;
+            b := e_in.dual.read_data2;
+            if insn_l(e_in.dual.insn) = '0' then
+                if e_in.dual.is_signed = '1' then
+                    a := std_ulogic_vector(resize(signed(a(31 downto 0)), 64));
+                    b := std_ulogic_vector(resize(signed(b(31 downto 0)), 64));
+                else
+                    a := 32x"0" & a(31 downto 0);
+                    b := 32x"0" & b(31 downto 0);
+                end if;
+            end if;
+            lt := '0';
+            gt := '0';
+            if is_X(a) or is_X(b) then
+                lt := 'X';
+                gt := 'X';
+            elsif e_in.dual.is_signed = '1' then
+                if signed(a) < signed(b) then
+                    lt := '1';
+                elsif signed(a) > signed(b) then
+                    gt := '1';
+                end if;
+            else
+                if unsigned(a) < unsigned(b) then
+                    lt := '1';
+                elsif unsigned(a) > unsigned(b) then
+                    gt := '1';
+                end if;
+            end if;
+            dual_crf <= lt & gt & not (lt or gt) & xerc_in.so;
+        end process;
+    end generate;
+
+    no_dual_alu: if not DUAL_ISSUE generate
+        dual_result <= (others => '0');
+        dual_crf <= (others => '0');
+    end generate;
+
     x_to_pmu.occur <= (instr_complete => wb_events.instr_complete,
+                       instr_complete2 => wb_events.instr_complete2,
                        fp_complete => wb_events.fp_complete,
                        ld_complete => ls_events.load_complete,
                        st_complete => ls_events.store_complete,
@@ -616,11 +760,17 @@ begin
                        dtlb_miss_resolved => dc_events.dtlb_miss_resolved,
                        icache_miss => ic_events.icache_miss,
                        itlb_miss_resolved => ic_events.itlb_miss_resolved,
+                       l2_hit => l2_events.hit,
+                       l2_miss => l2_events.miss,
+                       lb_hit => lb_events.hit,
                        no_instr_avail => ex1.no_instr_avail,
                        dispatch => ex1.instr_dispatch,
+                       fused_op => ex1.instr_fused,
+                       dual_op => ex1.instr_dual,
                        ext_interrupt => ex2.ext_interrupt,
                        br_taken_complete => ex2.taken_branch_event,
                        br_mispredict => ex2.br_mispredict,
+                       br_ret_mispredict => ex2.br_ret_mispredict,
                        others => '0');
     x_to_pmu.nia <= e_in.nia;
     x_to_pmu.addr <= l_in.ea_for_pmu;
@@ -644,8 +794,23 @@ begin
     xerc_in.ca32 <= ex1.xerc.ca32 when ex1.xerc_valid = '1' else e_in.xerc.ca32;
 
     -- N.B. the busy signal from each source includes the
-    -- stage2 stall from that source in it.
-    busy_out <= l_in.busy or ex1.busy or fp_in.busy or ctrl.wait_state;
+    -- stage2 stall from that source in it.  fp_in.busy covers the
+    -- whole of each FPU op, so only one is ever in flight; the FPU's
+    -- fast path shortens that op but can't overlap it with the next.
+    busy_out <= l_in.busy or (ex1.busy and not mul2_ok) or fp_in.busy or ctrl.wait_state;
+
+    -- While a 64-bit multiply with OE=0 is in flight, another one can
+    -- issue behind it, provided nothing could make it take an interrupt
+    -- instead.  Its result is held in ex1.mul2_e until the first one
+    -- has gone on to ex2, so they still complete in order.  This feeds
+    -- busy_out, so it only uses registered state: decode2 has already
+    -- worked out that e_in is such a multiply (which can't raise an
+    -- exception here), and it never takes the mult_32s path while a
+    -- multiply is in flight, so it will start the multiplier.
+    mul2_ok <= ex1.mul_in_progress and not ex1.oe and not ex1.mul2_in_progress and
+               not ex1.mul2_done and e_in.valid and e_in.mul64 and not e_in.dual.valid and
+               not ex1.trace_next and not ex1.fp_exception_next and
+               not (ex1.msr(MSR_EE) and (pmu_to_x.intr or ctrl.dec(63) or ext_irq_in));
 
     valid_in <= e_in.valid and not (busy_out or flush_in or ex1.e.redirect or ex1.e.interrupt);
 
@@ -699,6 +864,14 @@ begin
             even_wr_data := ramspr_even_data;
             odd_wr_data := ex1.ramspr_odd_data;
         end if;
+        -- Debug writes, which are only done with the core stopped
+        if interrupt_in.intr = '0' and dbg_spr_write = '1' and dbg_spr_addr(7) = '1' then
+            wr_addr := unsigned(dbg_spr_addr(3 downto 1));
+            even_wr_enab := not dbg_spr_addr(0);
+            odd_wr_enab := dbg_spr_addr(0);
+            even_wr_data := dbg_wr_data;
+            odd_wr_data := dbg_wr_data;
+        end if;
         ramspr_wr_addr <= wr_addr;
         ramspr_even_wr_data <= even_wr_data;
         ramspr_even_wr_enab <= even_wr_enab;
@@ -785,6 +958,9 @@ begin
 	end if;
     end process;
 
+    dbg_spr_write <= dbg_spr_req and dbg_spr_wr and e_in.dbg_spr_access and
+                     not dbg_spr_ack and not rst;
+
     ex_dbg_spr: process(clk)
     begin
         if rising_edge(clk) then
@@ -930,7 +1106,17 @@ begin
         -- signals to 32-bit multiplier
         x_to_mult_32s.data1 <= 32x"0" & a_in(31 downto 0);
         x_to_mult_32s.data2 <= 32x"0" & b_in(31 downto 0);
-        x_to_mult_32s.is_signed <= e_in.is_signed;
+        -- mulld with small operands also goes here, see below
+        x_to_mult_32s.is_signed <= e_in.is_signed or not e_in.is_32bit;
+
+        -- The low 64 bits of the product of two sign-extended 32-bit
+        -- values are given exactly by the 32-bit multiplier, and
+        -- can't overflow, so mulld can take the 1-cycle path.
+        mul_small <= '0';
+        if signed(a_in) = resize(signed(a_in(31 downto 0)), 64) and
+            signed(b_in) = resize(signed(b_in(31 downto 0)), 64) then
+            mul_small <= '1';
+        end if;
         -- The following are unused, but set here to avoid X states
         x_to_mult_32s.subtract <= '0';
         x_to_mult_32s.addend <= (others => '0');
@@ -950,6 +1136,15 @@ begin
         else
             multicyc_result <= bsort_result;
         end if;
+        case ex1.mul2_select(1 downto 0) is
+            when "00" =>
+                mul2_result <= multiply_to_x.result(63 downto 0);
+            when "01" =>
+                mul2_result <= multiply_to_x.result(63 downto 32) &
+                               multiply_to_x.result(63 downto 32);
+            when others =>
+                mul2_result <= multiply_to_x.result(127 downto 64);
+        end case;
 
         -- Compute misc_result
         case e_in.sub_select is
@@ -1150,6 +1345,10 @@ begin
         elsif e_in.output_cr = '1' and not is_X(bf) then
             crnum := to_integer(unsigned(bf));
             write_cr_mask <= num_to_fxm(crnum);
+        elsif DUAL_ISSUE and e_in.dual.output_cr = '1' and not is_X(e_in.dual.insn) then
+            -- decode1 only pairs a compare with an op that doesn't write CR
+            crnum := to_integer(unsigned(insn_bf(e_in.dual.insn)));
+            write_cr_mask <= num_to_fxm(crnum);
         else
             write_cr_mask <= (others => '0');
         end if;
@@ -1158,6 +1357,8 @@ begin
                 write_cr_data(i*4 + 3 downto i*4) <= cr_in(i*4 + 3 downto i*4);
             elsif e_in.insn_type = OP_MTCRF then
                 write_cr_data(i*4 + 3 downto i*4) <= c_in(i*4 + 3 downto i*4);
+            elsif DUAL_ISSUE and e_in.dual.output_cr = '1' then
+                write_cr_data(i*4 + 3 downto i*4) <= dual_crf;
             else
                 write_cr_data(i*4 + 3 downto i*4) <= newcrf;
             end if;
@@ -1192,6 +1393,14 @@ begin
         v.e.mode_32bit := not ex1.msr(MSR_SF);
         v.e.instr_tag := e_in.instr_tag;
         v.e.last_nia := e_in.nia;
+        v.e.fused := e_in.fused;
+        if DUAL_ISSUE then
+            v.e.dual := e_in.dual.valid;
+            v.e.write_enable2 := e_in.dual.valid and not e_in.dual.output_cr;
+            v.e.write_cr_enable := e_in.output_cr or e_in.dual.output_cr;
+            v.e.write_reg2 := e_in.dual.write_reg;
+            v.e.write_data2 := dual_result;
+        end if;
 
         v.se.ramspr_write_even := e_in.ramspr_write_even;
         v.se.ramspr_write_odd := e_in.ramspr_write_odd;
@@ -1330,8 +1539,20 @@ begin
 		bo := insn_bo(e_in.insn);
 		bi := insn_bi(e_in.insn);
                 v.take_branch := ppc_bc_taken(bo, bi, cr_in, ramspr_odd);
-                -- Indirect branches are never predicted taken
-                v.e.redirect := v.take_branch;
+                if e_in.br_pred = '1' then
+                    -- blr predicted by the return address stack in decode1;
+                    -- check both the direction and the predicted target.
+                    v.ret_predicted := '1';
+                    if v.take_branch = '0' then
+                        v.e.redirect := '1';
+                        v.redir_to_next := '1';
+                    elsif ramspr_result(63 downto 2) /= e_in.br_target(63 downto 2) then
+                        v.e.redirect := '1';
+                    end if;
+                else
+                    -- Other indirect branches are never predicted taken
+                    v.e.redirect := v.take_branch;
+                end if;
                 v.e.br_taken := v.take_branch;
                 if ex1.msr(MSR_BE) = '1' then
                     v.do_trace := '1';
@@ -1433,6 +1654,15 @@ begin
                         v.fp_intr := fp_in.exception and
                                      (c_in(MSR_FE0) or c_in(MSR_FE1));
                     end if;
+                    -- Turning on single-step refetches the following
+                    -- instructions, since decode1 may already have fused
+                    -- some of them.
+                    if c_in(MSR_SE) = '1' and ex1.msr(MSR_SE) = '0' then
+                        v.e.redirect := '1';
+                        v.redir_to_next := '1';
+                        v.e.redir_mode := v.new_msr(MSR_IR) & not v.new_msr(MSR_PR) &
+                                          not v.new_msr(MSR_LE) & not v.new_msr(MSR_SF);
+                    end if;
                 end if;
 	    when OP_MTSPR =>
                 if e_in.valid = '1' and not is_X(e_in.insn) then
@@ -1505,7 +1735,9 @@ begin
                 owait := '1';
 
 	    when OP_MUL_L64 =>
-                if e_in.is_32bit = '1' then
+                if e_in.is_32bit = '1' or
+                    (mul_small = '1' and e_in.oe = '0' and e_in.reg_valid3 = '0' and
+                     ex1.mul_in_progress = '0') then
                     v.se.mult_32s := '1';
                     v.res2_sel := "00";
                 else
@@ -1659,6 +1891,22 @@ begin
             v.bypass_valid := e_in.valid and not slow_op;
         end if;
 
+        -- If the first instruction of a dual-issued pair is to be traced,
+        -- the second isn't executed, and the trace interrupt is taken
+        -- with SRR0 pointing to it.  A CIABR match on the second one
+        -- gives a trace interrupt after both.
+        if DUAL_ISSUE and e_in.dual.valid = '1' then
+            if v.do_trace = '1' or v.ciabr_trace = '1' then
+                v.e.dual := '0';
+                v.e.write_enable2 := '0';
+                v.e.write_cr_enable := e_in.output_cr;
+                v.trace_dual := '1';
+            elsif ctrl.ciabr(0) = '1' and ctrl.ciabr(1) = not ex1.msr(MSR_PR) and
+                ctrl.ciabr(63 downto 2) = e_in.nia(63 downto 3) & '1' then
+                v.ciabr_trace := '1';
+            end if;
+        end if;
+
         actions <= v;
     end process;
 
@@ -1676,7 +1924,7 @@ begin
         variable dex : aspect_bits_t;
     begin
 	v := ex1;
-        if busy_out = '0' then
+        if busy_out = '0' and ex1.busy = '0' then
             v.e := actions.e;
             v.e.valid := '0';
             v.oe := e_in.oe;
@@ -1702,6 +1950,7 @@ begin
         v.ext_interrupt := '0';
         v.taken_branch_event := '0';
         v.br_mispredict := '0';
+        v.br_ret_mispredict := '0';
         v.busy := '0';
         bypass_valid := actions.bypass_valid;
 
@@ -1740,6 +1989,9 @@ begin
                     v.e.srr1(47 - 36) := '1';
                 end if;
                 v.e.srr1(47 - 43) := ex1.trace_ciabr;
+                if DUAL_ISSUE and ex1.trace_dual = '1' then
+                    v.e.last_nia := ex1.trace_nia & "100";
+                end if;
 
             elsif irq_valid = '1' then
                 -- Don't deliver the interrupt until we have a valid instruction
@@ -1766,6 +2018,8 @@ begin
 
         go := valid_in and not exception;
         v.instr_dispatch := go;
+        v.instr_fused := go and e_in.fused;
+        v.instr_dual := go and e_in.dual.valid and not actions.trace_dual;
 
 	if go = '1' then
             v.se := actions.se;
@@ -1773,17 +2027,29 @@ begin
             v.taken_branch_event := actions.take_branch;
             v.trace_next := actions.do_trace or actions.ciabr_trace;
             v.trace_ciabr := actions.ciabr_trace;
+            v.trace_dual := actions.trace_dual;
+            v.trace_nia := e_in.nia(63 downto 3);
             v.fp_exception_next := actions.fp_intr;
             v.res2_sel := actions.res2_sel;
             v.msr := actions.new_msr;
             x_to_multiply.valid <= actions.start_mul;
             x_to_mult_32s.valid <= actions.se.mult_32s;
-            v.mul_in_progress := actions.start_mul;
+            if ex1.busy = '0' then
+                v.mul_in_progress := actions.start_mul;
+            else
+                -- second multiply, see mul2_ok
+                assert actions.start_mul = '1' and actions.exception = '0'
+                    report "second multiply issued without starting the multiplier" severity failure;
+                v.mul2_in_progress := '1';
+                v.mul2_e := actions.e;
+                v.mul2_select := e_in.sub_select;
+            end if;
             x_to_divider.valid <= actions.start_div;
             v.div_in_progress := actions.start_div;
             v.bsort_in_progress := actions.start_bsort;
             v.bperm_in_progress := actions.start_bperm;
             v.br_mispredict := v.e.redirect and actions.direct_branch;
+            v.br_ret_mispredict := v.e.redirect and actions.ret_predicted;
             v.advance_nia := actions.advance_nia;
             v.redir_to_next := actions.redir_to_next;
             exception := actions.trap;
@@ -1791,8 +2057,8 @@ begin
             -- Go busy while division is happening because the
             -- divider is not pipelined.  Also go busy while a
             -- multiply is happening in order to stop following
-            -- instructions from using the wrong XER value
-            -- (and for simplicity in the OE=0 case).
+            -- instructions from using the wrong XER value; in the
+            -- OE=0 case a second multiply can still issue (mul2_ok).
             v.busy := actions.start_div or actions.start_mul or
                       actions.start_bsort or actions.start_bperm;
 
@@ -1836,7 +2102,26 @@ begin
             v.e.valid := multiply_to_x.valid and not ex1.oe;
             v.busy := not v.e.valid;
             v.e.write_data := alu_result;
-            bypass_valid := v.e.valid;
+            -- e_in may be the second multiply rather than this one
+            bypass_valid := v.e.valid and not (go or ex1.mul2_in_progress);
+        elsif ex1.mul2_in_progress = '1' then
+            v.mul2_in_progress := not multiply_to_x.valid;
+            v.mul2_done := multiply_to_x.valid;
+            v.mul2_e.write_data := mul2_result;
+        end if;
+        if ex1.mul_in_progress = '0' and (ex1.mul2_in_progress or ex1.mul2_done) = '1' and
+            stage2_stall = '0' then
+            -- the first multiply goes to ex2 now, move the second up
+            v.e := v.mul2_e;
+            v.e.valid := v.mul2_done;
+            v.mul_in_progress := v.mul2_in_progress;
+            v.mul_select := ex1.mul2_select;
+            v.mul2_in_progress := '0';
+            v.mul2_done := '0';
+            v.busy := v.mul_in_progress;
+        end if;
+        if v.mul2_in_progress = '1' or v.mul2_done = '1' then
+            v.busy := '1';
         end if;
         if ex1.mul_finish = '1' then
             v.mul_finish := '0';
@@ -1884,11 +2169,20 @@ begin
             v.div_in_progress := '0';
             v.mul_in_progress := '0';
             v.mul_finish := '0';
+            v.mul2_in_progress := '0';
+            v.mul2_done := '0';
             v.xerc_valid := '0';
         end if;
         if flush_in = '1' or interrupt_in.intr = '1' then
             v.msr := ctrl_tmp.msr;
         end if;
+        if dbg_msr_wr = '1' then
+            v.msr := dbg_wr_data;
+        end if;
+        -- a debug write to XER makes any CA value held here stale
+        if dbg_spr_write = '1' and dbg_spr_addr = "0000" & SPRSEL_XER then
+            v.xerc_valid := '0';
+        end if;
         if interrupt_in.intr = '1' then
             v.trace_next := '0';
             v.fp_exception_next := '0';
@@ -1897,8 +2191,11 @@ begin
         bypass_data.tag.valid <= e_in.write_reg_enable and bypass_valid;
         bypass_data.tag.tag <= e_in.instr_tag.tag;
         bypass_data.data <= alu_result;
+        bypass_data.tag2.valid <= actions.e.write_enable2 and bypass_valid;
+        bypass_data.tag2.tag <= e_in.instr_tag.tag;
+        bypass_data.data2 <= dual_result;
 
-        bypass_cr_data.tag.valid <= e_in.output_cr and bypass_valid;
+        bypass_cr_data.tag.valid <= actions.e.write_cr_enable and bypass_valid;
         bypass_cr_data.tag.tag <= e_in.instr_tag.tag;
         bypass_cr_data.data <= write_cr_data;
 
@@ -1927,6 +2224,7 @@ begin
         lv.mode_32bit := not ex1.msr(MSR_SF);
         lv.is_32bit := e_in.is_32bit;
         lv.prefixed := e_in.prefixed;
+        lv.fused := e_in.fused;
         lv.repeat := e_in.repeat;
         lv.second := e_in.second;
         lv.e2stall := fp_in.f2stall;
@@ -2011,6 +2309,7 @@ begin
             v.ext_interrupt := ex1.ext_interrupt;
             v.taken_branch_event := ex1.taken_branch_event;
             v.br_mispredict := ex1.br_mispredict;
+            v.br_ret_mispredict := ex1.br_ret_mispredict;
             if ex1.advance_nia = '1' then
                 v.e.last_nia := next_nia;
             end if;
@@ -2038,12 +2337,14 @@ begin
 
         if v.e.valid = '0' or flush_in = '1' then
             v.e.write_enable := '0';
+            v.e.write_enable2 := '0';
             v.e.write_cr_enable := '0';
             v.e.write_xerc_enable := '0';
             v.e.redirect := '0';
             v.e.br_last := '0';
             v.taken_branch_event := '0';
             v.br_mispredict := '0';
+            v.br_ret_mispredict := '0';
         end if;
         if flush_in = '1' then
             v.e.valid := '0';
@@ -2170,6 +2471,34 @@ begin
             end if;
         end if;
 
+        -- Debug writes, which are only done with the core stopped
+        if dbg_msr_wr = '1' then
+            ctrl_tmp.msr <= dbg_wr_data;
+        end if;
+        if dbg_spr_write = '1' and dbg_spr_addr(7) = '0' then
+            case dbg_spr_addr(3 downto 0) is
+                when SPRSEL_XER =>
+                    ctrl_tmp.xer_low <= dbg_wr_data(17 downto 0);
+                when SPRSEL_CFAR =>
+                    ctrl_tmp.cfar <= dbg_wr_data;
+                when SPRSEL_HEIR =>
+                    ctrl_tmp.heir <= dbg_wr_data;
+                when SPRSEL_FSCR =>
+                    ctrl_tmp.fscr_ic <= dbg_wr_data(59 downto 56);
+                    ctrl_tmp.fscr_pref <= dbg_wr_data(FSCR_PREFIX);
+                    ctrl_tmp.fscr_scv <= dbg_wr_data(FSCR_SCV);
+                    ctrl_tmp.fscr_tar <= dbg_wr_data(FSCR_TAR);
+                    ctrl_tmp.fscr_dscr <= dbg_wr_data(FSCR_DSCR);
+                when SPRSEL_HFSCR =>
+                    ctrl_tmp.hfscr_ic <= dbg_wr_data(59 downto 56);
+                    ctrl_tmp.hfscr_pref <= dbg_wr_data(HFSCR_PREFIX);
+                    ctrl_tmp.hfscr_tar <= dbg_wr_data(HFSCR_TAR);
+                    ctrl_tmp.hfscr_dscr <= dbg_wr_data(HFSCR_DSCR);
+                    ctrl_tmp.hfscr_fp <= dbg_wr_data(HFSCR_FP);
+                when others =>
+            end case;
+        end if;
+
         -- pending exceptions clear any wait state
         -- ex1.fp_exception_next is not tested because it is not possible to
         -- get into wait state with a pending FP exception.
@@ -2203,6 +2532,9 @@ begin
         bypass2_data.tag.valid <= ex1.e.write_enable and bypass_valid;
         bypass2_data.tag.tag <= ex1.e.instr_tag.tag;
         bypass2_data.data <= ex_result;
+        bypass2_data.tag2.valid <= ex1.e.write_enable2 and bypass_valid;
+        bypass2_data.tag2.tag <= ex1.e.instr_tag.tag;
+        bypass2_data.data2 <= ex1.e.write_data2;
 
         bypass2_cr_data.tag.valid <= (ex1.e.write_cr_enable or (ex1.e.rc and ex1.e.write_enable))
                                      and bypass_valid;
@@ -2242,6 +2574,28 @@ begin
         sim_dump_done <= '0';
     end generate;
 
+    -- Dispatch trace for the co-simulation checker in sim_cosim_c.c,
+    -- which matches it up with the completions writeback reports by tag.
+    -- A fused pair or a dual-issued pair counts as two instructions.
+    cosim_dispatch_trace: if COSIM generate
+        cosim_1: process(clk)
+            variable insns : integer;
+        begin
+            if rising_edge(clk) then
+                if rst = '0' and ex1in.instr_dispatch = '1' then
+                    insns := 1;
+                    if ex1in.instr_fused = '1' then
+                        insns := insns + 1;
+                    end if;
+                    if ex1in.instr_dual = '1' then
+                        insns := insns + 1;
+                    end if;
+                    cosim_dispatch(CPU_INDEX, e_in.instr_tag.tag, e_in.nia, ex1.msr, insns);
+                end if;
+            end if;
+        end process;
+    end generate;
+
     e1_log: if LOG_LENGTH > 0 generate
         signal log_data : std_ulogic_vector(11 downto 0);
     begin
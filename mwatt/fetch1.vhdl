@@ -11,7 +11,10 @@ entity fetch1 is
 	RESET_ADDRESS     : std_logic_vector(63 downto 0) := (others => '0');
 	ALT_RESET_ADDRESS : std_logic_vector(63 downto 0) := (others => '0');
         TLB_SIZE          : positive := 64;        -- L1 ITLB number of entries (direct mapped)
-        HAS_BTC           : boolean := true
+        HAS_BTC           : boolean := true;
+        BTC_ADDR_BITS     : positive := 10;        -- log2 of number of BTC entries (direct mapped)
+        DUAL_ISSUE        : boolean := false;      -- fetch a doubleword (two instructions) at a time
+        TLB_LARGE_SIZE    : natural := 4           -- L1 ITLB entries for 2MB/1GB pages (fully associative)
 	);
     port(
 	clk           : in std_ulogic;
@@ -69,7 +72,18 @@ architecture behaviour of fetch1 is
     signal erat_hit : std_ulogic;
     signal erat_sel : std_ulogic;
 
-    constant BTC_ADDR_BITS : integer := 10;
+    -- With DUAL_ISSUE the BTC is indexed by doubleword address, since
+    -- sequential fetches are a doubleword apart, and the bottom bit of
+    -- the tag says which word of the doubleword holds the branch.
+    function btc_index_lsb(dual : boolean) return natural is
+    begin
+        if dual then
+            return 3;
+        else
+            return 2;
+        end if;
+    end;
+    constant BTC_INDEX_LSB : natural := btc_index_lsb(DUAL_ISSUE);
     constant BTC_TAG_BITS : integer := 62 - BTC_ADDR_BITS;
     constant BTC_TARGET_BITS : integer := 62;
     constant BTC_SIZE : integer := 2 ** BTC_ADDR_BITS;
@@ -96,12 +110,34 @@ architecture behaviour of fetch1 is
     signal itlb_tags : tlb_tags_t;
     signal itlb_ptes : tlb_ptes_t;
 
+    -- Large page ITLB; a hit here replaces the entry read from the main ITLB
+    type ltlb_entry_t is record
+        valid : std_ulogic;
+        huge  : std_ulogic;
+        tag   : std_ulogic_vector(63 downto 21);
+        pte   : tlb_pte_t;
+    end record;
+    type ltlb_t is array(0 to maximum(TLB_LARGE_SIZE, 1) - 1) of ltlb_entry_t;
+    signal itlb_large : ltlb_t;
+    signal ltlb_repl : integer range 0 to maximum(TLB_LARGE_SIZE, 1) - 1;
+
     -- Values read from above arrays on a clock edge
     signal itlb_valid : std_ulogic;
     signal itlb_ttag : tlb_tag_t;
     signal itlb_pte : tlb_pte_t;
     signal itlb_hit : std_ulogic;
 
+    function btc_tag(nia : std_ulogic_vector(63 downto 0)) return std_ulogic_vector is
+        variable tag : std_ulogic_vector(BTC_TAG_BITS - 1 downto 0);
+    begin
+        if DUAL_ISSUE then
+            tag := nia(63 downto BTC_ADDR_BITS + 3) & nia(2);
+        else
+            tag := nia(63 downto BTC_ADDR_BITS + 2);
+        end if;
+        return tag;
+    end;
+
     -- Simple hash for direct-mapped TLB index
     function hash_ea(addr: std_ulogic_vector(63 downto 0)) return std_ulogic_vector is
         variable hash : std_ulogic_vector(TLB_BITS - 1 downto 0);
@@ -160,9 +196,9 @@ begin
     begin
         btc_wr_data <= w_in.br_taken &
                        r.virt_mode &
-                       w_in.br_nia(63 downto BTC_ADDR_BITS + 2) &
+                       btc_tag(w_in.br_nia) &
                        w_in.redirect_nia(63 downto 2);
-        btc_wr_addr <= w_in.br_nia(BTC_ADDR_BITS + 1 downto 2);
+        btc_wr_addr <= w_in.br_nia(BTC_ADDR_BITS + BTC_INDEX_LSB - 1 downto BTC_INDEX_LSB);
         btc_wr <= w_in.br_last;
 
         btc_ram : process(clk)
@@ -230,6 +266,7 @@ begin
     -- Read TLB using the NIA for the next cycle
     itlb_read : process(clk)
 	variable tlb_req_index : std_ulogic_vector(TLB_BITS - 1 downto 0);
+        variable lpte : tlb_pte_t;
     begin
         if rising_edge(clk) then
             if advance_nia = '1' then
@@ -243,6 +280,21 @@ begin
                     itlb_ttag <= itlb_tags(to_integer(unsigned(tlb_req_index)));
 		    itlb_valid <= itlb_valids(to_integer(unsigned(tlb_req_index)));
                 end if;
+                for i in 0 to TLB_LARGE_SIZE - 1 loop
+                    if itlb_large(i).valid = '1' and
+                        itlb_large(i).tag(63 downto 30) = r_next.nia(63 downto 30) and
+                        (itlb_large(i).huge = '1' or
+                         itlb_large(i).tag(29 downto 21) = r_next.nia(29 downto 21)) then
+                        lpte := itlb_large(i).pte;
+                        if itlb_large(i).huge = '1' then
+                            lpte(29 downto 21) := r_next.nia(29 downto 21);
+                        end if;
+                        lpte(20 downto 12) := r_next.nia(20 downto 12);
+                        itlb_pte <= lpte;
+                        itlb_ttag <= r_next.nia(63 downto MIN_LG_PGSZ + TLB_BITS);
+                        itlb_valid <= '1';
+                    end if;
+                end loop;
             end if;
         end if;
     end process;
@@ -262,6 +314,23 @@ begin
     begin
         if rising_edge(clk) then
             wr_index := hash_ea(m_in.addr);
+            if rst = '1' or m_in.tlbie = '1' then
+                -- any tlbie flushes the whole large page ITLB
+                for i in 0 to TLB_LARGE_SIZE - 1 loop
+                    itlb_large(i).valid <= '0';
+                end loop;
+                ltlb_repl <= 0;
+            elsif m_in.tlbld = '1' and (m_in.large or m_in.huge) = '1' and TLB_LARGE_SIZE > 0 then
+                itlb_large(ltlb_repl).valid <= '1';
+                itlb_large(ltlb_repl).huge <= m_in.huge;
+                itlb_large(ltlb_repl).tag <= m_in.addr(63 downto 21);
+                itlb_large(ltlb_repl).pte <= m_in.pte;
+                if ltlb_repl = TLB_LARGE_SIZE - 1 then
+                    ltlb_repl <= 0;
+                else
+                    ltlb_repl <= ltlb_repl + 1;
+                end if;
+            end if;
             if rst = '1' or (m_in.tlbie = '1' and m_in.doall = '1') then
                 -- clear all valid bits
                 for i in tlb_index_t loop
@@ -271,7 +340,7 @@ begin
 		assert not is_X(wr_index) report "icache index invalid on write" severity FAILURE;
                 -- clear entry regardless of hit or miss
                 itlb_valids(to_integer(unsigned(wr_index))) <= '0';
-            elsif m_in.tlbld = '1' then
+            elsif m_in.tlbld = '1' and not ((m_in.large or m_in.huge) = '1' and TLB_LARGE_SIZE > 0) then
 		assert not is_X(wr_index) report "icache index invalid on write" severity FAILURE;
                 itlb_tags(to_integer(unsigned(wr_index))) <= m_in.addr(63 downto MIN_LG_PGSZ + TLB_BITS);
                 itlb_ptes(to_integer(unsigned(wr_index))) <= m_in.pte;
@@ -288,11 +357,14 @@ begin
         variable m32 : std_ulogic;
         variable ehit, esel : std_ulogic;
         variable eaa_priv : std_ulogic;
+        variable btag : std_ulogic_vector(BTC_TAG_BITS - 1 downto 0);
+        variable btc_hit : std_ulogic;
     begin
 	v := r;
 	v_int := r_int;
         v.predicted := '0';
         v.pred_ntaken := '0';
+        v.pred_slot := '0';
         v.req := not stop_in;
         v_int.tlbstall := r_int.tlbcheck;
         v_int.tlbcheck := '0';
@@ -329,13 +401,23 @@ begin
         end if;
         v.nia := next_nia;
 
-        v_int.next_nia := std_ulogic_vector(unsigned(next_nia) + 4);
+        -- With DUAL_ISSUE, fetch both words of a doubleword when nia is
+        -- doubleword-aligned, except while the debug interface is
+        -- stopping the core, so that single-stepping still goes one
+        -- instruction at a time.
+        v.dual := '0';
+        if DUAL_ISSUE and next_nia(2) = '0' and stop_in = '0' then
+            v.dual := '1';
+            v_int.next_nia := std_ulogic_vector(unsigned(next_nia) + 8);
+        else
+            v_int.next_nia := std_ulogic_vector(unsigned(next_nia) + 4);
+        end if;
 
         -- Use v_int.next_nia as the BTC read address before it gets possibly
         -- overridden with the reset or interrupt address or the predicted branch
         -- target address, in order to improve timing.  If it gets overridden then
         -- rd_is_niap4 gets cleared to indicate that the BTC data doesn't apply.
-        btc_rd_addr <= unsigned(v_int.next_nia(BTC_ADDR_BITS + 1 downto 2));
+        btc_rd_addr <= unsigned(v_int.next_nia(BTC_ADDR_BITS + BTC_INDEX_LSB - 1 downto BTC_INDEX_LSB));
         v_int.rd_is_niap4 := '1';
 
         -- If the last NIA value went down with a stop mark, it didn't get
@@ -416,16 +498,29 @@ begin
         -- (w_in.redirect = '0' and d_in.redirect = '0' and r_int.tlbstall = '0')
         -- implies v.nia = r_int.next_nia.
         -- r_int.rd_is_niap4 implies r_int.next_nia is the address used to read the BTC.
+        -- For a dual fetch (which always has r_int.next_nia doubleword-aligned
+        -- here) the entry can be for either word; if it predicts the first
+        -- word taken, the second word isn't on the predicted path.
+        btag := btc_tag(r_int.next_nia);
+        btc_hit := '0';
+        if btc_rd_data(BTC_WIDTH - 3 downto BTC_TARGET_BITS + 1) = btag(BTC_TAG_BITS - 1 downto 1) and
+            (v.dual = '1' or btc_rd_data(BTC_TARGET_BITS) = btag(0)) then
+            btc_hit := '1';
+        end if;
 	if v.req = '1' and w_in.redirect = '0' and d_in.redirect = '0' and r_int.tlbstall = '0' and 
                 btc_rd_valid = '1' and r_int.rd_is_niap4 = '1' and
-                btc_rd_data(BTC_WIDTH - 2) = r.virt_mode and
-                btc_rd_data(BTC_WIDTH - 3 downto BTC_TARGET_BITS)
-                    = r_int.next_nia(BTC_TAG_BITS + BTC_ADDR_BITS + 1 downto BTC_ADDR_BITS + 2) then
+                btc_rd_data(BTC_WIDTH - 2) = r.virt_mode and btc_hit = '1' then
             v.predicted := btc_rd_data(BTC_WIDTH - 1);
             v.pred_ntaken := not btc_rd_data(BTC_WIDTH - 1);
+            if DUAL_ISSUE then
+                v.pred_slot := btc_rd_data(BTC_TARGET_BITS);
+            end if;
             if btc_rd_data(BTC_WIDTH - 1) = '1' then
                 v_int.next_nia := btc_rd_data(BTC_TARGET_BITS - 1 downto 0) & "00";
                 v_int.rd_is_niap4 := '0';
+                if v.pred_slot = '0' then
+                    v.dual := '0';
+                end if;
             end if;
         end if;
 
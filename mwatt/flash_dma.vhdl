@@ -0,0 +1,142 @@
+-- Simple copy engine for microwatt, used by the boot loader to move
+-- ELF segments from the SPI flash map to DRAM without the CPU.
+--
+-- It copies LEN bytes from SRC to DST one doubleword at a time, a read
+-- then a write on the main 64-bit bus, dropping cyc in between so that
+-- the source and destination can be on different slaves. Addresses
+-- and length are rounded down and up to 8 bytes respectively.
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library work;
+use work.wishbone_types.all;
+
+entity flash_dma is
+    port (
+        clk : in std_ulogic;
+        rst : in std_ulogic;
+
+        -- Register wishbone
+        wb_in  : in wb_io_master_out;
+        wb_out : out wb_io_slave_out;
+
+        -- Bus master wishbone
+        wb_dma_out : out wishbone_master_out;
+        wb_dma_in  : in  wishbone_slave_out
+        );
+end entity flash_dma;
+
+architecture behaviour of flash_dma is
+    constant DMA_REG_BITS : positive := 2;
+
+    -- Register addresses, matching addr downto 2, so 4 bytes per reg
+    constant DMA_REG_SRC  : std_ulogic_vector(DMA_REG_BITS-1 downto 0) := "00";
+    constant DMA_REG_DST  : std_ulogic_vector(DMA_REG_BITS-1 downto 0) := "01";
+    constant DMA_REG_LEN  : std_ulogic_vector(DMA_REG_BITS-1 downto 0) := "10";
+    -- write 1 to bit 0 to start, reads back 1 in bit 0 while busy
+    constant DMA_REG_CTRL : std_ulogic_vector(DMA_REG_BITS-1 downto 0) := "11";
+
+    -- READ_DONE and WRITE_DONE hold cyc low for a cycle after each
+    -- transfer so that every access is a bus cycle of its own.
+    type state_t is (IDLE, READ, READ_ACK, READ_DONE, WRITE, WRITE_ACK, WRITE_DONE);
+
+    -- Addresses in doublewords, length in bytes (counts down)
+    signal reg_src : unsigned(28 downto 0);
+    signal reg_dst : unsigned(28 downto 0);
+    signal reg_len : unsigned(31 downto 0);
+    signal data    : wishbone_data_type;
+    signal state   : state_t;
+
+    signal wb_rsp  : wb_io_slave_out;
+    signal reg_out : std_ulogic_vector(31 downto 0);
+    signal busy    : std_ulogic;
+begin
+    busy <= '0' when state = IDLE else '1';
+
+    -- Wishbone response
+    wb_rsp.ack <= wb_in.cyc and wb_in.stb;
+    with wb_in.adr(DMA_REG_BITS - 1 downto 0) select reg_out <=
+        std_ulogic_vector(reg_src) & "000" when DMA_REG_SRC,
+        std_ulogic_vector(reg_dst) & "000" when DMA_REG_DST,
+        std_ulogic_vector(reg_len)         when DMA_REG_LEN,
+        (0 => busy, others => '0')         when others;
+    wb_rsp.dat <= reg_out;
+    wb_rsp.stall <= '0';
+
+    -- Bus master
+    wb_dma_out.adr <= std_ulogic_vector(reg_dst) when state = WRITE or state = WRITE_ACK
+                      else std_ulogic_vector(reg_src);
+    wb_dma_out.dat <= data;
+    wb_dma_out.sel <= x"ff";
+    wb_dma_out.cyc <= '1' when state = READ or state = READ_ACK or
+                      state = WRITE or state = WRITE_ACK else '0';
+    wb_dma_out.stb <= '1' when state = READ or state = WRITE else '0';
+    wb_dma_out.we  <= '1' when state = WRITE or state = WRITE_ACK else '0';
+
+    dma_engine: process(clk)
+    begin
+        if rising_edge(clk) then
+            wb_out <= wb_rsp;
+
+            if rst = '1' then
+                reg_src <= (others => '0');
+                reg_dst <= (others => '0');
+                reg_len <= (others => '0');
+                state <= IDLE;
+                wb_out.ack <= '0';
+            else
+                case state is
+                    when IDLE =>
+                        null;
+                    when READ =>
+                        if wb_dma_in.stall = '0' then
+                            state <= READ_ACK;
+                        end if;
+                    when READ_ACK =>
+                        if wb_dma_in.ack = '1' then
+                            data <= wb_dma_in.dat;
+                            state <= READ_DONE;
+                        end if;
+                    when READ_DONE =>
+                        state <= WRITE;
+                    when WRITE =>
+                        if wb_dma_in.stall = '0' then
+                            state <= WRITE_ACK;
+                        end if;
+                    when WRITE_ACK =>
+                        if wb_dma_in.ack = '1' then
+                            reg_src <= reg_src + 1;
+                            reg_dst <= reg_dst + 1;
+                            state <= WRITE_DONE;
+                        end if;
+                    when WRITE_DONE =>
+                        if reg_len > 8 then
+                            reg_len <= reg_len - 8;
+                            state <= READ;
+                        else
+                            reg_len <= (others => '0');
+                            state <= IDLE;
+                        end if;
+                end case;
+
+                -- Registers can only be written while idle
+                if wb_in.cyc = '1' and wb_in.stb = '1' and wb_in.we = '1' and busy = '0' then
+                    case wb_in.adr(DMA_REG_BITS - 1 downto 0) is
+                        when DMA_REG_SRC =>
+                            reg_src <= unsigned(wb_in.dat(31 downto 3));
+                        when DMA_REG_DST =>
+                            reg_dst <= unsigned(wb_in.dat(31 downto 3));
+                        when DMA_REG_LEN =>
+                            reg_len <= unsigned(wb_in.dat);
+                        when others =>
+                            if wb_in.dat(0) = '1' and reg_len /= 0 then
+                                state <= READ;
+                            end if;
+                    end case;
+                end if;
+            end if;
+        end if;
+    end process;
+
+end architecture behaviour;
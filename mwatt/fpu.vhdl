@@ -12,6 +12,10 @@ use work.helpers.all;
 use work.common.all;
 
 entity fpu is
+    generic (
+        -- Short-latency path for normal-operand add/mul/fma
+        HAS_FAST_PATH : boolean := false
+        );
     port (
         clk : in std_ulogic;
         rst : in std_ulogic;
@@ -74,6 +78,7 @@ architecture behaviour of fpu is
                      ROUND_UFLOW, ROUND_OFLOW,
                      ROUNDING, ROUNDING_2, ROUNDING_3,
                      DENORM,
+                     FAST_WAIT,
                      RENORM_A, RENORM_A2,
                      RENORM_B, RENORM_B2,
                      RENORM_C, RENORM_C2,
@@ -170,6 +175,10 @@ architecture behaviour of fpu is
         xerc         : xer_common_t;
         xerc_result  : xer_common_t;
         res_sign     : std_ulogic;
+        fast_state   : state_t;
+        fast_opsel_a : std_ulogic_vector(1 downto 0);
+        res_fast     : std_ulogic;
+        fast_data    : std_ulogic_vector(63 downto 0);
     end record;
 
     type lookup_table is array(0 to 1023) of std_ulogic_vector(17 downto 0);
@@ -200,6 +209,8 @@ architecture behaviour of fpu is
     signal msel_add      : std_ulogic_vector(1 downto 0);
     signal msel_inv      : std_ulogic;
     signal inverse_est   : std_ulogic_vector(18 downto 0);
+    signal f_to_fast     : FPUFastInputType;
+    signal fast_to_f     : FPUFastOutputType;
 
     -- opsel values
     constant AIN_R    : std_ulogic_vector(1 downto 0) := "00";
@@ -691,6 +702,40 @@ architecture behaviour of fpu is
         end case;
     end;
 
+    -- True for a DP value that is finite, nonzero and not denormalized
+    function is_normal(fpr: std_ulogic_vector(63 downto 0)) return boolean is
+    begin
+        return fpr(62 downto 52) /= 11x"000" and fpr(62 downto 52) /= 11x"7ff";
+    end;
+
+    -- Double-precision fadd, fsub, fmul and fmadd family with all the
+    -- operands normalized, in round-to-nearest mode with FP exceptions
+    -- disabled (so nothing can cause an interrupt), go down the fast path.
+    function fast_eligible(e: Execute1ToFPUType; fpscr: std_ulogic_vector(31 downto 0))
+        return boolean is
+        variable need_b, need_c : boolean;
+    begin
+        if e.op /= OP_FP_ARITH or e.single = '1' or e.fe_mode /= "00" or
+            fpscr(FPSCR_RN+1 downto FPSCR_RN) /= "00" then
+            return false;
+        end if;
+        case e.insn(5 downto 1) is
+            when "10100" | "10101" =>       -- fsub, fadd
+                need_b := true;
+                need_c := false;
+            when "11001" =>                 -- fmul
+                need_b := false;
+                need_c := true;
+            when "11100" | "11101" | "11110" | "11111" =>
+                need_b := true;
+                need_c := true;
+            when others =>
+                return false;
+        end case;
+        return is_normal(e.fra) and (is_normal(e.frb) or not need_b) and
+            (is_normal(e.frc) or not need_c);
+    end;
+
 begin
     fpu_multiply_0: entity work.multiply
         port map (
@@ -699,6 +744,27 @@ begin
             m_out => multiply_to_f
             );
 
+    fast_path: if HAS_FAST_PATH generate
+        fpu_fast_0: entity work.fpu_fast
+            port map (
+                clk      => clk,
+                flush_in => rst or flush_in,
+                f_in     => f_to_fast,
+                f_out    => fast_to_f
+                );
+
+        f_to_fast.valid <= '1' when e_in.valid = '1' and fast_eligible(e_in, r.fpscr) else '0';
+        f_to_fast.op <= e_in.insn(5 downto 1);
+        f_to_fast.fra <= e_in.fra;
+        f_to_fast.frb <= e_in.frb;
+        f_to_fast.frc <= e_in.frc;
+    end generate;
+
+    no_fast_path: if not HAS_FAST_PATH generate
+        f_to_fast <= FPUFastInputInit;
+        fast_to_f <= FPUFastOutputInit;
+    end generate;
+
     fpu_0: process(clk)
     begin
         if rising_edge(clk) then
@@ -852,6 +918,7 @@ begin
         variable int_result  : std_ulogic;
         variable illegal     : std_ulogic;
         variable rsign       : std_ulogic;
+        variable fast_done   : std_ulogic;
     begin
         v := r;
         v.complete := '0';
@@ -1079,6 +1146,7 @@ begin
         rnd_b32 := '0';
         int_result := '0';
         illegal := '0';
+        fast_done := '0';
 
         re_sel1 <= REXP1_ZERO;
         re_sel2 <= REXP2_CON;
@@ -1125,6 +1193,11 @@ begin
                         end case;
                     end if;
                     v.state := exec_state;
+                    if f_to_fast.valid = '1' then
+                        v.fast_state := exec_state;
+                        v.fast_opsel_a := v.opsel_a;
+                        v.state := FAST_WAIT;
+                    end if;
                 end if;
                 v.x := '0';
                 v.old_exc := r.fpscr(FPSCR_VX downto FPSCR_XX);
@@ -1134,6 +1207,28 @@ begin
                 illegal := '1';
                 v.instr_done := '1';
 
+            when FAST_WAIT =>
+                -- wait for the fast path; if the result is zero, tiny
+                -- or huge, do the whole thing again in the state machine,
+                -- starting from the state and A input that IDLE chose
+                if fast_to_f.valid = '1' then
+                    if fast_to_f.ok = '1' then
+                        v.fpscr(FPSCR_FR) := fast_to_f.fr;
+                        v.fpscr(FPSCR_FI) := fast_to_f.fi;
+                        if fast_to_f.fi = '1' then
+                            v.fpscr(FPSCR_XX) := '1';
+                        end if;
+                        v.fpscr(FPSCR_C downto FPSCR_FU) := result_flags(fast_to_f.result(63),
+                                                                         FINITE, '1');
+                        update_fx := '1';
+                        fast_done := '1';
+                        v.instr_done := '1';
+                    else
+                        v.opsel_a := r.fast_opsel_a;
+                        v.state := r.fast_state;
+                    end if;
+                end if;
+
             when DO_MCRFS =>
                 j := to_integer(unsigned(insn_bfa(r.insn)));
                 for i in 0 to 7 loop
@@ -3558,6 +3653,8 @@ begin
                 v.illegal := illegal;
                 v.nsnan_result := v.quieten_nan;
                 v.res_sign := rsign;
+                v.res_fast := fast_done;
+                v.fast_data := fast_to_f.result;
                 if r.integer_op = '1' then
                     v.cr_mask := num_to_fxm(0);
                 elsif r.is_cmp = '0' then
@@ -3587,6 +3684,8 @@ begin
         -- This mustn't depend on any fields of r that are modified in IDLE state.
         if r.int_result = '1' then
             fp_result <= r.r;
+        elsif r.res_fast = '1' then
+            fp_result <= r.fast_data;
         else
             fp_result <= pack_dp(r.res_sign, r.result_class, r.result_exp, r.r,
                                  r.sp_result, r.nsnan_result);
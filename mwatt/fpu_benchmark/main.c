@@ -0,0 +1,138 @@
+#include "console.h"
+#include "io.h"
+#include "microwatt_soc.h"
+
+#include "pmu.h"
+#include "time.h"
+
+/*
+ * Floating-point add/multiply/fma benchmark for the FPU fast path.
+ *
+ * For each of fadd, fmul and fmadd it times a dependent chain and four
+ * independent chains interleaved, and prints the average number of PMU
+ * run cycles per operation.  execute1 keeps one FPU operation in flight,
+ * so the two come out about the same: the fast path cuts the latency of
+ * each operation, it doesn't let them overlap.  A last run feeds
+ * denormal operands to fmadd, which always takes the state machine
+ * path.  Compare a build with HAS_FPU_FAST_PATH against one without.
+ */
+
+#define OPS 256
+
+static inline void enable_fp(void)
+{
+  unsigned long msr;
+
+  __asm__ volatile("mfmsr %0" : "=r"(msr));
+  msr |= 0x2000;        /* MSR[FP] */
+  __asm__ volatile("mtmsr %0" : : "r"(msr));
+}
+
+static double __attribute__((noinline)) fadd_dep(double x, double y)
+{
+  int i;
+
+  for (i = 0; i < OPS; i++)
+    x = x + y;
+  return x;
+}
+
+static double __attribute__((noinline)) fadd_indep(double x, double y)
+{
+  double a = x, b = x, c = x, d = x;
+  int i;
+
+  for (i = 0; i < OPS; i += 4) {
+    a = a + y;
+    b = b + y;
+    c = c + y;
+    d = d + y;
+  }
+  return a + b + c + d;
+}
+
+static double __attribute__((noinline)) fmul_dep(double x, double y)
+{
+  int i;
+
+  for (i = 0; i < OPS; i++)
+    x = x * y;
+  return x;
+}
+
+static double __attribute__((noinline)) fmul_indep(double x, double y)
+{
+  double a = x, b = x, c = x, d = x;
+  int i;
+
+  for (i = 0; i < OPS; i += 4) {
+    a = a * y;
+    b = b * y;
+    c = c * y;
+    d = d * y;
+  }
+  return a + b + c + d;
+}
+
+static double __attribute__((noinline)) fmadd_dep(double x, double y)
+{
+  int i;
+
+  for (i = 0; i < OPS; i++)
+    x = __builtin_fma(x, y, y);
+  return x;
+}
+
+static double __attribute__((noinline)) fmadd_indep(double x, double y)
+{
+  double a = x, b = x, c = x, d = x;
+  int i;
+
+  for (i = 0; i < OPS; i += 4) {
+    a = __builtin_fma(a, y, y);
+    b = __builtin_fma(b, y, y);
+    c = __builtin_fma(c, y, y);
+    d = __builtin_fma(d, y, y);
+  }
+  return a + b + c + d;
+}
+
+static void report(const char *name, uint64_t cycles)
+{
+  puts(name);
+  puts(": cycles/op ");
+  print_uint64(cycles / OPS);
+  puts("\n");
+}
+
+static void run(const char *name, double (*fn)(double, double), double x, double y)
+{
+  volatile double sink;
+
+  pmu_start(PMU_MMCR1(PMU_EV1_CYCLES, 0, 0, 0));
+  sink = fn(x, y);
+  pmu_stop();
+  (void)sink;
+  report(name, pmu_read(1));
+}
+
+int main(void)
+{
+  console_init();
+  enable_fp();
+
+  /* values chosen so that the chains stay normal and finite */
+  run("fadd  dependent  ", fadd_dep, 1.5, 0.25);
+  run("fadd  independent", fadd_indep, 1.5, 0.25);
+  run("fmul  dependent  ", fmul_dep, 1.5, 1.0000001);
+  run("fmul  independent", fmul_indep, 1.5, 1.0000001);
+  run("fmadd dependent  ", fmadd_dep, 1.5, 0.5);
+  run("fmadd independent", fmadd_indep, 1.5, 0.5);
+  run("fmadd denormal   ", fmadd_dep, 1.5, 0x1p-1060);
+
+  return 0;
+}
+
+void secondary_main(void)
+{
+}
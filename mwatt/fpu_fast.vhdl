@@ -0,0 +1,241 @@
+-- Fast path for the floating-point unit
+--
+-- Does double-precision fadd, fsub, fmul and the fmadd family in four
+-- registered stages with round-to-nearest-even, for operands that are all
+-- normalized, finite and nonzero.  The FPU only has one operation in
+-- flight at a time, so this shortens latency, not throughput.  Results
+-- that come out zero, tiny or huge are flagged with ok = 0 so that the
+-- FPU state machine can redo the operation with the full handling of
+-- denormals, overflow and signed zeroes.
+--
+-- The operation is computed as P + B, where P = A * C (C = 1.0 for
+-- fadd/fsub) and B = 0 for fmul.  Both are placed in a 128-bit window
+-- with the larger one's leading bit at bit 125 and the smaller one
+-- shifted right, with any bits shifted out ORed into bit 0.  When the
+-- exponents are close enough for the add to cancel leading bits, no
+-- bits are shifted out, so the sticky bit never affects rounding.
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library work;
+use work.common.all;
+use work.helpers.all;
+
+entity fpu_fast is
+    port (
+        clk      : in std_ulogic;
+        flush_in : in std_ulogic;
+
+        f_in     : in FPUFastInputType;
+        f_out    : out FPUFastOutputType
+        );
+end entity fpu_fast;
+
+architecture behaviour of fpu_fast is
+    constant EXP_BITS : natural := 13;
+
+    -- operands decoded
+    type stage1_t is record
+        valid  : std_ulogic;
+        ma     : std_ulogic_vector(52 downto 0);
+        mb     : std_ulogic_vector(52 downto 0);
+        mc     : std_ulogic_vector(52 downto 0);
+        ep     : signed(EXP_BITS-1 downto 0);   -- exponent of product bit 104
+        eb     : signed(EXP_BITS-1 downto 0);
+        sp     : std_ulogic;
+        sb     : std_ulogic;
+        b_zero : std_ulogic;
+        negate : std_ulogic;
+    end record;
+
+    -- product formed, alignment shifts worked out
+    type stage2_t is record
+        valid  : std_ulogic;
+        prod   : std_ulogic_vector(105 downto 0);
+        mb     : std_ulogic_vector(52 downto 0);
+        t      : signed(EXP_BITS-1 downto 0);   -- exponent of window bit 126
+        dp     : signed(EXP_BITS-1 downto 0);
+        db     : signed(EXP_BITS-1 downto 0);
+        sp     : std_ulogic;
+        sb     : std_ulogic;
+        b_zero : std_ulogic;
+        negate : std_ulogic;
+    end record;
+
+    -- aligned and added
+    type stage3_t is record
+        valid  : std_ulogic;
+        sum    : std_ulogic_vector(127 downto 0);
+        t      : signed(EXP_BITS-1 downto 0);
+        sign   : std_ulogic;
+    end record;
+
+    type reg_type is record
+        s1  : stage1_t;
+        s2  : stage2_t;
+        s3  : stage3_t;
+        res : FPUFastOutputType;
+    end record;
+
+    signal r, rin : reg_type;
+
+    -- Shift right by d (d >= 1), ORing any bits shifted out into bit 0
+    function shift_right_jam(x : std_ulogic_vector(127 downto 0); d : signed)
+        return std_ulogic_vector is
+        variable y    : std_ulogic_vector(127 downto 0);
+        variable lost : std_ulogic_vector(127 downto 0);
+        variable n    : natural;
+        constant ones : unsigned(127 downto 0) := (others => '1');
+    begin
+        if is_X(d) then
+            y := (others => 'X');
+        elsif d > 127 then
+            y := (others => '0');
+            y(0) := or x;
+        else
+            n := to_integer(d);
+            y := std_ulogic_vector(shift_right(unsigned(x), n));
+            lost := x and not std_ulogic_vector(shift_left(ones, n));
+            y(0) := y(0) or (or lost);
+        end if;
+        return y;
+    end;
+
+    function unbiased_exp(x : std_ulogic_vector(63 downto 0)) return signed is
+    begin
+        return signed(resize(unsigned(x(62 downto 52)), EXP_BITS)) - 1023;
+    end;
+
+begin
+    fpu_fast_0: process(clk)
+    begin
+        if rising_edge(clk) then
+            if flush_in = '1' then
+                r.s1.valid <= '0';
+                r.s2.valid <= '0';
+                r.s3.valid <= '0';
+                r.res.valid <= '0';
+            else
+                r <= rin;
+            end if;
+        end if;
+    end process;
+
+    fpu_fast_1: process(all)
+        variable v     : reg_type;
+        variable ec    : signed(EXP_BITS-1 downto 0);
+        variable tp    : signed(EXP_BITS-1 downto 0);
+        variable pa    : std_ulogic_vector(127 downto 0);
+        variable ba    : std_ulogic_vector(127 downto 0);
+        variable clz   : std_ulogic_vector(5 downto 0);
+        variable lz    : natural range 0 to 127;
+        variable norm  : std_ulogic_vector(127 downto 0);
+        variable mant  : std_ulogic_vector(53 downto 0);
+        variable gbit  : std_ulogic;
+        variable xbit  : std_ulogic;
+        variable inc   : std_ulogic;
+        variable rexp  : signed(EXP_BITS-1 downto 0);
+    begin
+        v := r;
+
+        -- Stage 1: unpack the operands
+        v.s1.valid := f_in.valid;
+        v.s1.ma := '1' & f_in.fra(51 downto 0);
+        v.s1.mb := '1' & f_in.frb(51 downto 0);
+        v.s1.eb := unbiased_exp(f_in.frb);
+        -- fsub, fmsub and fnmsub subtract B, fnmadd and fnmsub negate the result
+        v.s1.sb := f_in.frb(63) xor not f_in.op(0);
+        v.s1.b_zero := '0';
+        v.s1.negate := '0';
+        if f_in.op(4 downto 1) = "1010" then
+            -- fadd/fsub: multiply A by 1.0
+            v.s1.mc := '1' & 52x"0";
+            ec := to_signed(0, EXP_BITS);
+            v.s1.sp := f_in.fra(63);
+        else
+            v.s1.mc := '1' & f_in.frc(51 downto 0);
+            ec := unbiased_exp(f_in.frc);
+            v.s1.sp := f_in.fra(63) xor f_in.frc(63);
+            if f_in.op(2) = '0' then
+                -- fmul: no addend
+                v.s1.b_zero := '1';
+            else
+                v.s1.negate := f_in.op(1);
+            end if;
+        end if;
+        v.s1.ep := unbiased_exp(f_in.fra) + ec;
+
+        -- Stage 2: multiply, and work out the window exponent and shifts
+        v.s2.valid := r.s1.valid;
+        v.s2.prod := std_ulogic_vector(unsigned(r.s1.ma) * unsigned(r.s1.mc));
+        v.s2.mb := r.s1.mb;
+        v.s2.sp := r.s1.sp;
+        v.s2.sb := r.s1.sb;
+        v.s2.b_zero := r.s1.b_zero;
+        v.s2.negate := r.s1.negate;
+        tp := r.s1.ep + 1;
+        if r.s1.b_zero = '1' or tp >= r.s1.eb then
+            v.s2.t := tp + 1;
+        else
+            v.s2.t := r.s1.eb + 1;
+        end if;
+        v.s2.dp := v.s2.t - tp;
+        v.s2.db := v.s2.t - r.s1.eb;
+
+        -- Stage 3: align and add
+        v.s3.valid := r.s2.valid;
+        v.s3.t := r.s2.t;
+        pa := shift_right_jam('0' & r.s2.prod & 21x"0", r.s2.dp);
+        if r.s2.b_zero = '1' then
+            ba := (others => '0');
+        else
+            ba := shift_right_jam('0' & r.s2.mb & 74x"0", r.s2.db);
+        end if;
+        if r.s2.sp = r.s2.sb then
+            v.s3.sum := std_ulogic_vector(unsigned(pa) + unsigned(ba));
+            v.s3.sign := r.s2.sp;
+        elsif unsigned(pa) >= unsigned(ba) then
+            v.s3.sum := std_ulogic_vector(unsigned(pa) - unsigned(ba));
+            v.s3.sign := r.s2.sp;
+        else
+            v.s3.sum := std_ulogic_vector(unsigned(ba) - unsigned(pa));
+            v.s3.sign := r.s2.sb;
+        end if;
+        v.s3.sign := v.s3.sign xor r.s2.negate;
+
+        -- Stage 4: normalize and round
+        if r.s3.sum(127 downto 64) /= 64x"0" then
+            clz := count_left_zeroes(r.s3.sum(127 downto 64));
+            lz := to_integer(unsigned(clz));
+        else
+            clz := count_left_zeroes(r.s3.sum(63 downto 0));
+            lz := 64 + to_integer(unsigned(clz));
+        end if;
+        norm := std_ulogic_vector(shift_left(unsigned(r.s3.sum), lz));
+        gbit := norm(74);
+        xbit := or norm(73 downto 0);
+        inc := gbit and (xbit or norm(75));
+        mant := std_ulogic_vector(unsigned('0' & norm(127 downto 75)) + inc);
+        rexp := r.s3.t + 1 - lz;
+        if mant(53) = '1' then
+            mant := '0' & mant(53 downto 1);
+            rexp := rexp + 1;
+        end if;
+        v.res.valid := r.s3.valid;
+        v.res.ok := '0';
+        if r.s3.sum /= 128x"0" and rexp >= -1022 and rexp <= 1023 then
+            v.res.ok := '1';
+        end if;
+        v.res.result := r.s3.sign & std_ulogic_vector(resize(unsigned(rexp + 1023), 11)) &
+                        mant(51 downto 0);
+        v.res.fr := inc;
+        v.res.fi := gbit or xbit;
+
+        f_out <= r.res;
+
+        rin <= v;
+    end process;
+
+end architecture behaviour;
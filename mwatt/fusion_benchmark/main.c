@@ -0,0 +1,133 @@
+#include "console.h"
+#include "io.h"
+#include "microwatt_soc.h"
+
+#include "pmu.h"
+#include "time.h"
+
+/*
+ * Instruction fusion benchmark (core HAS_FUSION).
+ *
+ * Runs loops of the addis+ld pairs used for TOC-relative loads, of
+ * lis+addi constant formation, and of addis+ld pairs where the load
+ * goes to a different register, which can't be fused.  Each loop
+ * reports PMU run cycles, completed instructions (a fused pair counts
+ * as two) and fused ops, so the fused and unfused versions of the same
+ * work can be compared.
+ */
+
+#define WORDS     256
+#define REPS      16
+
+static uint64_t table[WORDS];
+
+static uint64_t __attribute__((noinline)) fused_ld_loop(const uint64_t *p)
+{
+  uint64_t a, b, c, d, sum = 0;
+  int i;
+
+  for (i = 0; i < WORDS; i += 4, p += 4) {
+    __asm__ volatile("addis %0,%4,0\n\t"
+                     "ld %0,0(%0)\n\t"
+                     "addis %1,%4,0\n\t"
+                     "ld %1,8(%1)\n\t"
+                     "addis %2,%4,0\n\t"
+                     "ld %2,16(%2)\n\t"
+                     "addis %3,%4,0\n\t"
+                     "ld %3,24(%3)"
+                     : "=&b"(a), "=&b"(b), "=&b"(c), "=&b"(d) : "b"(p));
+    sum += a + b + c + d;
+  }
+  return sum;
+}
+
+static uint64_t __attribute__((noinline)) split_ld_loop(const uint64_t *p)
+{
+  uint64_t a, b, c, d, t0, t1, sum = 0;
+  int i;
+
+  for (i = 0; i < WORDS; i += 4, p += 4) {
+    __asm__ volatile("addis %4,%6,0\n\t"
+                     "ld %0,0(%4)\n\t"
+                     "addis %5,%6,0\n\t"
+                     "ld %1,8(%5)\n\t"
+                     "addis %4,%6,0\n\t"
+                     "ld %2,16(%4)\n\t"
+                     "addis %5,%6,0\n\t"
+                     "ld %3,24(%5)"
+                     : "=&r"(a), "=&r"(b), "=&r"(c), "=&r"(d),
+                       "=&b"(t0), "=&b"(t1) : "b"(p));
+    sum += a + b + c + d;
+  }
+  return sum;
+}
+
+static uint64_t __attribute__((noinline)) addi_loop(const uint64_t *p)
+{
+  uint64_t a, b, c, d, sum = 0;
+  int i;
+
+  (void)p;
+  for (i = 0; i < WORDS; i += 4) {
+    __asm__ volatile("lis %0,0x1234\n\t"
+                     "addi %0,%0,0x5678\n\t"
+                     "lis %1,0x2345\n\t"
+                     "addi %1,%1,-0x6789\n\t"
+                     "lis %2,0x3456\n\t"
+                     "addi %2,%2,0x789a\n\t"
+                     "lis %3,0x4567\n\t"
+                     "addi %3,%3,-0x1abc"
+                     : "=&b"(a), "=&b"(b), "=&b"(c), "=&b"(d));
+    sum += a + b + c + d;
+  }
+  return sum;
+}
+
+static void run(const char *name, uint64_t (*fn)(const uint64_t *))
+{
+  volatile uint64_t sink;
+  uint64_t cycles, insns, fused;
+  int i;
+
+  /* Once to get the table into the dcache */
+  sink = fn(table);
+  pmu_start(PMU_MMCR1(PMU_EV1_CYCLES, PMU_EV2_FUSED_OP, PMU_EV3_INSN_COMPLETE, 0));
+  for (i = 0; i < REPS; i++)
+    sink = fn(table);
+  pmu_stop();
+
+  cycles = pmu_read(1);
+  fused = pmu_read(2);
+  insns = pmu_read(3);
+
+  puts(name);
+  puts(": cycles ");
+  print_uint64(cycles);
+  puts(" completed ");
+  print_uint64(insns);
+  puts(" fused ");
+  print_uint64(fused);
+  puts(" sum ");
+  print_uint64(sink);
+  puts("\n");
+}
+
+int main(void)
+{
+  unsigned long i;
+
+  console_init();
+
+  for (i = 0; i < WORDS; i++)
+    table[i] = i;
+
+  run("addis+ld fused   ", fused_ld_loop);
+  run("addis+ld unfused ", split_ld_loop);
+  run("lis+addi         ", addi_loop);
+
+  return 0;
+}
+
+void secondary_main(void)
+{
+}
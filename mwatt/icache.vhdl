@@ -164,6 +164,10 @@ architecture rtl of icache is
         big_endian  : std_ulogic;
         predicted   : std_ulogic;
         pred_ntaken : std_ulogic;
+        pred_slot   : std_ulogic;
+        dual        : std_ulogic;
+        hit_fwd     : std_ulogic;
+        fwd_row     : cache_row_t;
 
         -- Cache miss state (reload state machine)
         state       : state_t;
@@ -196,6 +200,7 @@ architecture rtl of icache is
     signal req_tag     : cache_tag_t;
     signal req_is_hit  : std_ulogic;
     signal req_is_miss : std_ulogic;
+    signal req_is_fwd  : std_ulogic;
     signal req_raddr   : real_addr_t;
 
     signal real_addr : real_addr_t;
@@ -488,9 +493,13 @@ begin
     -- Cache hit detection, output to fetch2 and other misc logic
     icache_comb : process(all)
         variable is_hit  : std_ulogic;
+        variable is_fwd  : std_ulogic;
         variable hit_way : way_sig_t;
         variable insn    : std_ulogic_vector(ICWORDLEN - 1 downto 0);
         variable icode   : insn_code_t;
+        variable insn2   : std_ulogic_vector(ICWORDLEN - 1 downto 0);
+        variable icode2  : insn_code_t;
+        variable nia2    : std_ulogic_vector(63 downto 0);
         variable ra      : real_addr_t;
     begin
         -- Extract line, row and tag from request
@@ -509,6 +518,7 @@ begin
         -- Test if pending request is a hit on any way
         hit_way := to_unsigned(0, WAY_BITS);
         is_hit  := '0';
+        is_fwd  := '0';
         if i_in.req = '1' then
             assert not is_X(req_index) and not is_X(req_row) severity failure;
         end if;
@@ -528,6 +538,19 @@ begin
             is_hit  := '1';
             hit_way := r.store_way;
         end if;
+        -- Critical row forwarding: the reload starts with the row that
+        -- missed, and the row being written to the cache RAM in this cycle
+        -- can't be read back from it until the next cycle, so take it
+        -- straight from the predecoder output instead.
+        if r.state = WAIT_ACK and r.store_valid = '1' and r.recv_valid = '1' and
+            inval_in = '0' and
+            req_index = r.store_index and
+            req_tag = r.store_tag and
+            req_row = r.store_row then
+            is_hit  := '1';
+            is_fwd  := '1';
+            hit_way := r.store_way;
+        end if;
         if r.stalled_hit = '1' then
             is_hit  := '1';
             hit_way := r.stalled_way;
@@ -541,6 +564,7 @@ begin
             req_is_hit  <= '0';
             req_is_miss <= '0';
         end if;
+        req_is_fwd  <= is_fwd and not r.stalled_hit;
         req_hit_way <= hit_way;
 
         -- Output instruction from current cache row
@@ -551,11 +575,21 @@ begin
         --       I prefer not to do just yet as it would force fetch2 to know about
         --       some of the cache geometry information.
         --
+        -- For a dual fetch, the second word of the doubleword is always
+        -- in the same row, so we can supply it alongside the first.
+        --
         icode := INSN_illegal;
-        if is_X(r.hit_way) then
+        icode2 := INSN_illegal;
+        nia2 := r.hit_nia(63 downto 3) & "100";
+        if r.hit_fwd = '1' then
+            insn := read_insn_word(r.hit_nia, r.fwd_row);
+            insn2 := read_insn_word(nia2, r.fwd_row);
+        elsif is_X(r.hit_way) then
             insn := (others => 'X');
+            insn2 := (others => 'X');
         else
             insn := read_insn_word(r.hit_nia, cache_out(to_integer(r.hit_way)));
+            insn2 := read_insn_word(nia2, cache_out(to_integer(r.hit_way)));
         end if;
         assert not (r.hit_valid = '1' and is_X(r.hit_way)) severity failure;
         -- Currently we use only the top bit for indicating illegal
@@ -566,6 +600,12 @@ begin
             icode := insn(ICWORDLEN-1 downto INSN_IMAGE_BITS);
             insn(31 downto 26) := recode_primary_opcode(icode);
         end if;
+        if is_X(insn2) then
+            insn2 := (others => '0');
+        elsif insn2(ICWORDLEN - 1) = '0' then
+            icode2 := insn2(ICWORDLEN-1 downto INSN_IMAGE_BITS);
+            insn2(31 downto 26) := recode_primary_opcode(icode2);
+        end if;
 
         i_out.insn             <= insn(31 downto 0);
         i_out.icode            <= icode;
@@ -577,6 +617,10 @@ begin
         i_out.big_endian       <= r.big_endian;
         i_out.next_predicted   <= r.predicted;
         i_out.next_pred_ntaken <= r.pred_ntaken;
+        i_out.pred_slot        <= r.pred_slot;
+        i_out.dual             <= r.dual;
+        i_out.insn2            <= insn2(31 downto 0);
+        i_out.icode2           <= icode2;
 
         -- Stall fetch1 if we have a cache miss
         stall_out <= i_in.req and not is_hit and not flush_in;
@@ -593,6 +637,7 @@ begin
             -- except that flush or reset sets valid to 0
             if rst = '1' or flush_in = '1' then
                 r.hit_valid   <= '0';
+                r.hit_fwd     <= '0';
                 r.stalled_hit <= '0';
                 r.stalled_way <= to_unsigned(0, WAY_BITS);
             elsif stall_in = '1' then
@@ -608,6 +653,10 @@ begin
                 -- will be available on the cache_out output of the corresponding way
                 --
                 r.hit_valid <= req_is_hit;
+                r.hit_fwd   <= req_is_hit and req_is_fwd;
+                if req_is_fwd = '1' then
+                    r.fwd_row <= cache_wr_data;
+                end if;
                 if req_is_hit = '1' then
                     r.hit_way <= req_hit_way;
                     -- this is a bit fragile but better than propogating bad values
@@ -631,6 +680,8 @@ begin
                 r.big_endian   <= i_in.big_endian;
                 r.predicted    <= i_in.predicted;
                 r.pred_ntaken  <= i_in.pred_ntaken;
+                r.pred_slot    <= i_in.pred_slot;
+                r.dual         <= i_in.dual;
                 r.fetch_failed <= i_in.fetch_fail and not flush_in;
             end if;
             if i_out.valid = '1' then
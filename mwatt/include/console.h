@@ -23,6 +23,29 @@ int puts(const char *str);
 /* Printers */
 void print_uint64(uint64_t val);
 
+/* Raw UART access, never blocks */
+int console_tx_room(void);
+void console_tx_byte(uint8_t c);
+bool console_rx_ready(void);
+uint8_t console_rx_byte(void);
+
+/*
+ * Buffered, interrupt driven console (lib/console_buffered.c).
+ *
+ * console_buffered_init() routes the UART interrupt through XICS to the
+ * calling core and sets MSR[EE]. The program's 0x500 vector must call
+ * console_isr(). Output is queued in a ring that the UART TX interrupt
+ * drains; when the ring is full, output is dropped rather than waited
+ * for and counted in console_dropped().
+ */
+void console_buffered_init(void);
+void console_isr(void);
+int console_putc(int c);
+int console_getc(void);
+int console_printf(const char *fmt, ...);
+void console_flush(void);
+uint64_t console_dropped(void);
+
 #ifndef __USE_LIBC
 size_t strlen(const char *s);
 #endif
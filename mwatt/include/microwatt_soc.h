@@ -15,6 +15,7 @@
 #define XICS_ICS_BASE   0xc0005000  /* Interrupt controller */
 #define SPI_FCTRL_BASE  0xc0006000  /* SPI flash controller registers */
 #define GPIO_BASE       0xc0007000  /* GPIO registers */
+#define FLASH_DMA_BASE  0xc0008000  /* Flash DMA engine */
 #define DRAM_CTRL_BASE	0xc8000000  /* LiteDRAM control registers */
 #define LETH_CSR_BASE	0xc8020000  /* LiteEth CSR registers */
 #define LETH_SRAM_BASE	0xc8030000  /* LiteEth MMIO space */
@@ -46,6 +47,7 @@
 #define   SYS_REG_INFO_HAS_UART1 		(1ull << 6)
 #define   SYS_REG_INFO_HAS_ARTB                 (1ull << 7)
 #define   SYS_REG_INFO_HAS_LITESDCARD 		(1ull << 8)
+#define   SYS_REG_INFO_HAS_FLASH_DMA 		(1ull << 9)
 #define SYS_REG_BRAMINFO		0x10
 #define   SYS_REG_BRAMINFO_SIZE_MASK		0xfffffffffffffull
 #define SYS_REG_DRAMINFO		0x18
@@ -67,6 +69,7 @@
 #define   SYS_REG_GIT_IS_DIRTY			(1ull << 63)
 #define SYS_REG_CPU_CTRL		0x58
 #define   SYS_REG_CPU_CTRL_ENABLE		0xff
+#define   SYS_REG_CPU_CTRL_NCPUS_SHIFT		8
 #define SYS_REG_TB_CTRL			0x60
 #define   SYS_REG_TB_CTRL_FREEZE		0x01
 #define   SYS_REG_TB_CTRL_RD_PROTECT		0x02
@@ -99,6 +102,7 @@
 #define   UART_REG_IER_MSI      0x08
 #define UART_REG_DLM      0x04
 #define UART_REG_IIR      0x08
+#define   UART_REG_IIR_FIFOS    0xc0
 #define UART_REG_FCR      0x08
 #define   UART_REG_FCR_EN_FIFO  0x01
 #define   UART_REG_FCR_CLR_RCVR 0x02
@@ -159,6 +163,8 @@
 #define     SPI_REG_AUT_CFG_MODE_DUAL           (2 << 11)
 #define     SPI_REG_AUT_CFG_MODE_QUAD           (3 << 11)
 #define   SPI_REG_AUTO_CFG_ADDR4                (1u << 13) /* 3 or 4 addr bytes */
+#define   SPI_REG_AUTO_CFG_WADR                 (1u << 14) /* addr + mode byte in wire mode */
+#define   SPI_REG_AUTO_CFG_XIP                  (1u << 15) /* continuous read, needs WADR */
 #define   SPI_REG_AUTO_CFG_CKDIV_SHIFT          16    /* clock div */
 #define   SPI_REG_AUTO_CFG_CKDIV_MASK           (0xff << SPI_REG_AUTO_CFG_CKDIV_SHIFT)
 #define   SPI_REG_AUTO_CFG_CSTOUT_SHIFT         24    /* CS timeout */
@@ -180,4 +186,14 @@
 #define GPIO_REG_INT_BOTH_EDGE 0x38
 #define GPIO_REG_INT_LEVEL 0x3C
 
+/*
+ * Register definitions for the flash DMA engine
+ */
+#define FLASH_DMA_REG_SRC		0x00 /* Source address, 8-byte aligned */
+#define FLASH_DMA_REG_DST		0x04 /* Destination address, 8-byte aligned */
+#define FLASH_DMA_REG_LEN		0x08 /* Byte count, counts down to 0 */
+#define FLASH_DMA_REG_CTRL		0x0c
+#define   FLASH_DMA_CTRL_START			0x01  /* write: start the copy */
+#define   FLASH_DMA_CTRL_BUSY			0x01  /* read: copy in progress */
+
 #endif /* __MICROWATT_SOC_H */
@@ -0,0 +1,93 @@
+/**
+ * pmu.h - Performance monitor access for Microwatt
+ *
+ * This header provides helpers to program the PMU event selection in
+ * MMCR1 and to read the performance monitor counters.  Must be called
+ * in privileged mode.
+ */
+
+#ifndef PMU_H
+#define PMU_H
+
+#include <stdint.h>
+
+/* MMCR1 event selectors, one byte per counter PMC1..PMC4 */
+#define PMU_MMCR1(pmc1, pmc2, pmc3, pmc4) \
+	(((uint64_t)(pmc1) << 24) | ((pmc2) << 16) | ((pmc3) << 8) | (pmc4))
+
+/* PMC1 events */
+#define PMU_EV1_CYCLES			0xf0
+#define PMU_EV1_INSN_COMPLETE		0xf2
+#define PMU_EV1_ITLB_MISS		0xf6
+#define PMU_EV1_L2_HIT			0xee
+
+/* PMC2 events */
+#define PMU_EV2_DISPATCH		0xf2
+#define PMU_EV2_BR_TAKEN		0xfa
+#define PMU_EV2_ICACHE_MISS		0xfc
+#define PMU_EV2_FUSED_OP		0xee
+
+/* PMC3 events */
+#define PMU_EV3_DC_STORE_MISS		0xf0
+#define PMU_EV3_INSN_COMPLETE		0xf4
+#define PMU_EV3_BR_RET_MISPREDICT	0xfa
+#define PMU_EV3_L2_MISS			0xfc
+#define PMU_EV3_LOOP_BUF_HIT		0xee
+
+/* PMC4 events */
+#define PMU_EV4_DC_LOAD_MISS		0xf0
+#define PMU_EV4_BR_MISPREDICT		0xf6
+#define PMU_EV4_DUAL_OP			0xee
+
+/**
+ * Clear the counters, select events and unfreeze the PMU.
+ *
+ * @param mmcr1 Event selection, see PMU_MMCR1()
+ */
+static inline void pmu_start(uint64_t mmcr1)
+{
+	__asm__ volatile(
+			"mtspr  795, %1  \n\t" /* MMCR0: freeze */
+			"mtspr  798, %0  \n\t" /* MMCR1 */
+			"mtspr  787, %2  \n\t" /* PMC1..PMC6 */
+			"mtspr  788, %2  \n\t"
+			"mtspr  789, %2  \n\t"
+			"mtspr  790, %2  \n\t"
+			"mtspr  791, %2  \n\t"
+			"mtspr  792, %2  \n\t"
+			"mtspr  795, %2  \n\t" /* MMCR0: run */
+			:
+			: "r"(mmcr1), "r"(0x80000000ul), "r"(0ul)
+			: "memory");
+}
+
+/**
+ * Freeze all the counters.
+ */
+static inline void pmu_stop(void)
+{
+	__asm__ volatile("mtspr 795, %0" : : "r"(0x80000000ul) : "memory");
+}
+
+/**
+ * Read one of the performance monitor counters.
+ *
+ * @param n Counter number, 1 to 6
+ * @return The counter value
+ */
+static inline uint64_t pmu_read(int n)
+{
+	uint64_t v = 0;
+
+	switch (n) {
+	case 1: __asm__ volatile("mfspr %0, 787" : "=r"(v)); break;
+	case 2: __asm__ volatile("mfspr %0, 788" : "=r"(v)); break;
+	case 3: __asm__ volatile("mfspr %0, 789" : "=r"(v)); break;
+	case 4: __asm__ volatile("mfspr %0, 790" : "=r"(v)); break;
+	case 5: __asm__ volatile("mfspr %0, 791" : "=r"(v)); break;
+	case 6: __asm__ volatile("mfspr %0, 792" : "=r"(v)); break;
+	}
+	return v;
+}
+
+#endif /* PMU_H */
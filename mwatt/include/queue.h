@@ -19,6 +19,9 @@
  #define EO_LFSXQ 703   /* Read 32-bit float from queue */
  #define EO_STAFSXQ 704 /* Write address of 32-bit float to queue */
  #define EO_STFSXQ 705  /* Write 32-bit float to queue */
+ #define EO_LFDPXQ 706  /* Read two 64-bit floats into an even/odd FPR pair */
+ #define EO_STAFDPXQ 707 /* Write the addresses of two adjacent 64-bit floats */
+ #define EO_STFDPXQ 708 /* Write an even/odd FPR pair */
  
 /**
  * Enables floating-point operations by setting the MSR[FP] bit.
@@ -32,6 +35,12 @@
      __asm__ volatile("mtmsr %0" : : "r"(msr));
  }
 
+ /*
+  * Fixed-register forms. These take register numbers, so the caller has
+  * to pin values into those registers with inline asm; new code should
+  * use the typed intrinsics further down instead.
+  */
+
  /**
   * Internal function to generate X-form PowerISA instructions.
   *
@@ -112,4 +121,128 @@
    x_form(PO_X, frs, 0, 0, EO_STFDXQ, 1);
  }
  
+ /*
+  * Typed intrinsics
+  *
+  * These let the compiler pick the registers: the operand is substituted
+  * into the instruction word as a register number, so they work with any
+  * register allocation and need no pinned registers. They are volatile
+  * and clobber memory so that they stay in program order with respect to
+  * each other and to the loads and stores around them.
+  */
+
+ #define QUEUE_INSN(xo) ((PO_X << 26) | ((xo) << 1) | 1)
+
+ #define QUEUE_STR_(x) #x
+ #define QUEUE_STR(x) QUEUE_STR_(x)
+
+ /**
+  * Push the address of a double; the queue fetches it for the consumer.
+  */
+ static inline void queue_push_addr(const double *p) {
+   __asm__ volatile (".long " QUEUE_STR(QUEUE_INSN(EO_STAFDXQ)) " | (%0 << 11)"
+                     : : "r" (p) : "memory");
+ }
+
+ /**
+  * Push the address of a float; the queue fetches it for the consumer.
+  */
+ static inline void queue_push_addr_f32(const float *p) {
+   __asm__ volatile (".long " QUEUE_STR(QUEUE_INSN(EO_STAFSXQ)) " | (%0 << 11)"
+                     : : "r" (p) : "memory");
+ }
+
+ /**
+  * Push a double value.
+  */
+ static inline void queue_push_f64(double v) {
+   __asm__ volatile (".long " QUEUE_STR(QUEUE_INSN(EO_STFDXQ)) " | (%0 << 21)"
+                     : : "d" (v) : "memory");
+ }
+
+ /**
+  * Push a float value.
+  */
+ static inline void queue_push_f32(float v) {
+   __asm__ volatile (".long " QUEUE_STR(QUEUE_INSN(EO_STFSXQ)) " | (%0 << 21)"
+                     : : "d" (v) : "memory");
+ }
+
+ /**
+  * Pop a double, waiting until one is available.
+  */
+ static inline double queue_pop_f64(void) {
+   double v;
+
+   __asm__ volatile (".long " QUEUE_STR(QUEUE_INSN(EO_LFDXQ)) " | (%0 << 21)"
+                     : "=d" (v) : : "memory");
+   return v;
+ }
+
+ /**
+  * Pop a float, waiting until one is available.
+  */
+ static inline float queue_pop_f32(void) {
+   float v;
+
+   __asm__ volatile (".long " QUEUE_STR(QUEUE_INSN(EO_LFSXQ)) " | (%0 << 21)"
+                     : "=d" (v) : : "memory");
+   return v;
+ }
+
+ /**
+  * Push and pop raw 64-bit values (e.g. pointers or indices) through an
+  * FPR. The compiler moves the value between register files.
+  */
+ static inline void queue_push_u64(uint64_t v) {
+   union { uint64_t u; double d; } x = { .u = v };
+
+   queue_push_f64(x.d);
+ }
+
+ static inline uint64_t queue_pop_u64(void) {
+   union { uint64_t u; double d; } x;
+
+   x.d = queue_pop_f64();
+   return x.u;
+ }
+
+ /*
+  * Paired transfers: one instruction moves two items. The FPR pair
+  * must start at an even register, so these go through f12/f13, which
+  * the compiler can't otherwise be asked for.
+  */
+
+ /**
+  * Push the addresses of p[0] and p[1].
+  */
+ static inline void queue_push_addr2(const double *p) {
+   __asm__ volatile (".long " QUEUE_STR(QUEUE_INSN(EO_STAFDPXQ)) " | (%0 << 11)"
+                     : : "r" (p) : "memory");
+ }
+
+ /**
+  * Push two double values, a first.
+  */
+ static inline void queue_push2_f64(double a, double b) {
+   __asm__ volatile ("fmr 12,%0\n\t"
+                     "fmr 13,%1\n\t"
+                     ".long " QUEUE_STR(QUEUE_INSN(EO_STFDPXQ)) " | (12 << 21)"
+                     : : "d" (a), "d" (b) : "fr12", "fr13", "memory");
+ }
+
+ /**
+  * Pop two doubles, waiting until both are available.
+  */
+ static inline void queue_pop2_f64(double *a, double *b) {
+   double x, y;
+
+   __asm__ volatile (".long " QUEUE_STR(QUEUE_INSN(EO_LFDPXQ)) " | (12 << 21)\n\t"
+                     "fmr %0,12\n\t"
+                     "fmr %1,13"
+                     : "=d" (x), "=d" (y) : : "fr12", "fr13", "memory");
+   *a = x;
+   *b = y;
+ }
+
  #endif /* QUEUE_H */
\ No newline at end of file
@@ -0,0 +1,136 @@
+/**
+ * runtime.h - Bare-metal multicore runtime for Microwatt
+ *
+ * This header provides per-core state, barriers, a work-stealing task
+ * deque and parallel_for on top of multicore.h. See lib/runtime.c.
+ *
+ * Core 0 calls rt_init() from main(), which starts the other cores.
+ * Every other core must call rt_worker() from secondary_main(); it
+ * never returns and runs tasks stolen from the other cores' deques.
+ * Each core gets its own RT_STACK_SIZE stack from head.S: core n's
+ * stack top is n * RT_STACK_SIZE above core 0's, so core n's stack
+ * occupies the RT_STACK_SIZE bytes just above core n-1's stack top.
+ */
+
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define RT_MAX_CPUS	4
+#define RT_STACK_SIZE	0x2000
+#define RT_DEQUE_SIZE	256	/* tasks per core, power of 2 */
+#define RT_CACHE_LINE	64
+
+/**
+ * A range task: runs fn(arg, lo, hi) over the iterations [lo, hi).
+ */
+typedef struct rt_task {
+	void (*fn)(void *arg, long lo, long hi);
+	void *arg;
+	long lo;
+	long hi;
+} rt_task_t;
+
+/**
+ * Chase-Lev work-stealing deque. The owning core pushes and pops at the
+ * bottom, other cores steal from the top; only the last task needs a
+ * compare-and-swap to settle a race between the owner and a thief.
+ */
+typedef struct rt_deque {
+	volatile long top __attribute__((aligned(RT_CACHE_LINE)));
+	volatile long bottom __attribute__((aligned(RT_CACHE_LINE)));
+	rt_task_t tasks[RT_DEQUE_SIZE];
+} rt_deque_t;
+
+/**
+ * Sense-reversing barrier for a fixed number of cores.
+ */
+typedef struct rt_barrier {
+	volatile long count;
+	volatile long sense;
+	long n;
+} rt_barrier_t;
+
+/* Startup and per-core state */
+void rt_init(void);
+void rt_worker(void) __attribute__((noreturn));
+unsigned int rt_ncpus(void);
+void rt_set_ncpus(unsigned int n);
+unsigned int rt_cpu_id(void);
+void *rt_tls(void);
+void rt_set_tls(void *p);
+
+/* Barriers */
+void rt_barrier_init(rt_barrier_t *b, unsigned int n);
+void rt_barrier_wait(rt_barrier_t *b);
+
+/* Deques */
+void rt_deque_init(rt_deque_t *d);
+bool rt_deque_push(rt_deque_t *d, const rt_task_t *t);
+bool rt_deque_pop(rt_deque_t *d, rt_task_t *t);
+bool rt_deque_steal(rt_deque_t *d, rt_task_t *t);
+
+/**
+ * Run fn(arg, lo, hi) over [start, end) on all rt_ncpus() cores, in
+ * chunks of at most grain iterations, and return when all are done.
+ * Only one parallel_for may be in flight at a time, and fn must not
+ * call parallel_for itself.
+ */
+void parallel_for(long start, long end, long grain,
+		  void (*fn)(void *arg, long lo, long hi), void *arg);
+
+/**
+ * Run fn(arg, cpu, ncpus) once on each of the rt_ncpus() cores, e.g. for
+ * code that synchronises with rt_barrier_wait(), and return when all
+ * have finished.
+ */
+void rt_run_on_all(void (*fn)(void *arg, long cpu, long ncpus), void *arg);
+
+/* Atomics */
+static inline long rt_atomic_add(volatile long *p, long v)
+{
+	long t;
+
+	__asm__ volatile(
+			"1:             \n"
+			"ldarx  %0,0,%2 \n"
+			"add    %0,%0,%3\n"
+			"stdcx. %0,0,%2 \n"
+			"bne-   1b      \n"
+			: "=&r"(t), "+m"(*p)
+			: "r"(p), "r"(v)
+			: "cc", "memory");
+	return t;
+}
+
+static inline bool rt_atomic_cas(volatile long *p, long old, long new)
+{
+	long t;
+
+	__asm__ volatile(
+			"1:             \n"
+			"ldarx  %0,0,%2 \n"
+			"cmpd   %0,%3   \n"
+			"bne-   2f      \n"
+			"stdcx. %4,0,%2 \n"
+			"bne-   1b      \n"
+			"2:             \n"
+			: "=&r"(t), "+m"(*p)
+			: "r"(p), "r"(old), "r"(new)
+			: "cc", "memory");
+	return t == old;
+}
+
+static inline void rt_sync(void)
+{
+	__asm__ volatile("sync" ::: "memory");
+}
+
+static inline void rt_lwsync(void)
+{
+	__asm__ volatile("lwsync" ::: "memory");
+}
+
+#endif /* RUNTIME_H */
@@ -0,0 +1,87 @@
+/**
+ * slice.h - Two-core slice patterns on top of the queue intrinsics
+ *
+ * Each pattern is split into a producer half, run on the core that walks
+ * the index structure and pushes addresses with stafdxq, and a consumer
+ * half, run on the other core, which pops the loaded values with lfdxq
+ * and does the arithmetic. Both halves must agree on the element count;
+ * the queue stalls the producer while it is full and the consumer while
+ * it is empty, so no other synchronisation is needed.
+ *
+ * The FPU must be enabled (enable_fpu()) on both cores first.
+ */
+
+#ifndef SLICE_H
+#define SLICE_H
+
+#include <stdint.h>
+
+#include "queue.h"
+
+/**
+ * Gather: y[i] = x[idx[i]] for i in [0, n).
+ */
+ static inline void slice_gather_produce(const double *x, const uint64_t *idx,
+                                         long n) {
+   long i;
+
+   for (i = 0; i < n; i++)
+     queue_push_addr(&x[idx[i]]);
+ }
+
+ static inline void slice_gather_consume(double *y, long n) {
+   long i;
+
+   for (i = 0; i < n; i++)
+     y[i] = queue_pop_f64();
+ }
+
+/**
+ * Indirect sum: sum of x[idx[i]] for i in [0, n). The producer is the
+ * same as for the gather.
+ */
+ static inline void slice_isum_produce(const double *x, const uint64_t *idx,
+                                       long n) {
+   slice_gather_produce(x, idx, n);
+ }
+
+ static inline double slice_isum_consume(long n) {
+   double sum = 0.0;
+   double a, b;
+   long i;
+
+   for (i = 0; i + 1 < n; i += 2) {
+     queue_pop2_f64(&a, &b);
+     sum += a;
+     sum += b;
+   }
+   if (i < n)
+     sum += queue_pop_f64();
+   return sum;
+ }
+
+/**
+ * Pointer chase: sum of val over the first n nodes of a linked list,
+ * which must have at least n nodes or the consumer will wait forever. The
+ * producer takes the dependent next-pointer loads off the consumer's
+ * critical path and only sends the addresses of the payloads across.
+ */
+ struct slice_node {
+   struct slice_node *next;
+   double val;
+ };
+
+ static inline void slice_chase_produce(const struct slice_node *p, long n) {
+   long i;
+
+   for (i = 0; i < n; i++) {
+     queue_push_addr(&p->val);
+     p = p->next;
+   }
+ }
+
+ static inline double slice_chase_consume(long n) {
+   return slice_isum_consume(n);
+ }
+
+#endif /* SLICE_H */
@@ -0,0 +1,147 @@
+#include "console.h"
+#include "io.h"
+#include "microwatt_soc.h"
+
+#include "multicore.h"
+#include "pmu.h"
+#include "time.h"
+
+/*
+ * Two core benchmark for the shared L2 (soc HAS_SHARED_L2).
+ *
+ * Both cores repeatedly sum a table that is bigger than the L1 dcache
+ * but fits in the L2, so after the first pass their misses should hit
+ * in the L2.  Then each core rewrites its own half of the table; with
+ * the L2 snoop filter those stores are only sent to the other core if
+ * it has read the line.  Each phase reports timebase ticks, L2 hits,
+ * L2 misses and L1 dcache load misses per core.  Run it from DRAM, as
+ * the L2 only sits in front of DRAM.
+ */
+
+#define TABLE_WORDS (32 * 1024 / sizeof(uint64_t))
+#define PASSES      4
+
+static uint64_t table[TABLE_WORDS];
+
+struct result {
+  uint64_t ticks;
+  uint64_t l2_hit;
+  uint64_t l2_miss;
+  uint64_t dc_miss;
+  uint64_t sum;
+};
+
+static struct result results[2][2];
+static volatile int start[2];
+static volatile int done[2];
+
+static void run_start(void)
+{
+  pmu_start(PMU_MMCR1(PMU_EV1_L2_HIT, PMU_EV2_DISPATCH,
+                      PMU_EV3_L2_MISS, PMU_EV4_DC_LOAD_MISS));
+}
+
+static void run_stop(struct result *res, uint64_t t0, uint64_t sum)
+{
+  res->ticks = get_tb() - t0;
+  pmu_stop();
+  res->l2_hit = pmu_read(1);
+  res->l2_miss = pmu_read(3);
+  res->dc_miss = pmu_read(4);
+  res->sum = sum;
+}
+
+static void shared_read(int cpu)
+{
+  uint64_t t0, sum = 0;
+  unsigned long i;
+  int pass;
+
+  run_start();
+  t0 = get_tb();
+  for (pass = 0; pass < PASSES; pass++)
+    for (i = 0; i < TABLE_WORDS; i++)
+      sum += table[i];
+  run_stop(&results[cpu][0], t0, sum);
+}
+
+static void private_write(int cpu)
+{
+  unsigned long half = TABLE_WORDS / 2;
+  unsigned long i, base = cpu * half;
+  uint64_t t0;
+  int pass;
+
+  run_start();
+  t0 = get_tb();
+  for (pass = 0; pass < PASSES; pass++)
+    for (i = base; i < base + half; i++)
+      table[i] += pass;
+  run_stop(&results[cpu][1], t0, 0);
+}
+
+static void run(int cpu)
+{
+  while (!start[cpu])
+    ;
+  shared_read(cpu);
+  private_write(cpu);
+  sync_cores();
+  done[cpu] = 1;
+}
+
+static void report(int cpu, int phase, const char *name)
+{
+  struct result *res = &results[cpu][phase];
+
+  puts("core ");
+  print_uint64(cpu);
+  puts(" ");
+  puts(name);
+  puts(": tb ");
+  print_uint64(res->ticks);
+  puts(" l2_hit ");
+  print_uint64(res->l2_hit);
+  puts(" l2_miss ");
+  print_uint64(res->l2_miss);
+  puts(" dc_load_miss ");
+  print_uint64(res->dc_miss);
+  if (phase == 0) {
+    puts(" sum ");
+    print_uint64(res->sum);
+  }
+  puts("\n");
+}
+
+int main(void)
+{
+  unsigned long i;
+  int cpu;
+
+  console_init();
+
+  for (i = 0; i < TABLE_WORDS; i++)
+    table[i] = i;
+  sync_cores();
+
+  enable_cpus(0x03);
+  start[1] = 1;
+  start[0] = 1;
+  run(0);
+  while (!done[1])
+    ;
+
+  for (cpu = 0; cpu < 2; cpu++) {
+    report(cpu, 0, "shared read");
+    report(cpu, 1, "private write");
+  }
+
+  return 0;
+}
+
+void secondary_main(void)
+{
+  run(1);
+  for (;;)
+    ;
+}
@@ -14,6 +14,7 @@
 bool uart_is_std;
 
 static uint64_t uart_base;
+static int std_uart_tx_fifo;	/* bytes the TX FIFO holds when THRE is set */
 
 static unsigned long uart_divisor(unsigned long uart_freq, unsigned long bauds)
 {
@@ -133,6 +134,49 @@ static void std_uart_init(uint64_t uart_freq)
 	writeb(UART_REG_FCR_EN_FIFO |
 	       UART_REG_FCR_CLR_RCVR |
 	       UART_REG_FCR_CLR_XMIT, uart_base + UART_REG_FCR);
+
+	/*
+	 * With the FIFOs enabled THRE means the 16 byte TX FIFO is empty,
+	 * otherwise only that the holding register is.
+	 */
+	if ((readb(uart_base + UART_REG_IIR) & UART_REG_IIR_FIFOS) ==
+	    UART_REG_IIR_FIFOS)
+		std_uart_tx_fifo = 16;
+	else
+		std_uart_tx_fifo = 1;
+}
+
+/*
+ * Raw access to the UART, for the buffered console
+ */
+
+int console_tx_room(void)
+{
+	if (uart_is_std)
+		return std_uart_tx_full() ? 0 : std_uart_tx_fifo;
+	return potato_uart_tx_full() ? 0 : 1;
+}
+
+void console_tx_byte(uint8_t c)
+{
+	if (uart_is_std)
+		std_uart_write(c);
+	else
+		potato_uart_write(c);
+}
+
+bool console_rx_ready(void)
+{
+	if (uart_is_std)
+		return !std_uart_rx_empty();
+	return !potato_uart_rx_empty();
+}
+
+uint8_t console_rx_byte(void)
+{
+	if (uart_is_std)
+		return std_uart_read();
+	return potato_uart_read();
 }
 
 int getchar(void)
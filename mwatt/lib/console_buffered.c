@@ -0,0 +1,278 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+
+#include "console.h"
+#include "microwatt_soc.h"
+#include "io.h"
+
+/*
+ * Interrupt driven console on top of the polled UART code in console.c.
+ *
+ * Output goes into a TX ring that console_isr() copies into the UART
+ * while the UART TX interrupt is enabled, and input is copied from the
+ * UART into an RX ring by the same interrupt. The rings have a single
+ * producer and a single consumer, one of which is the interrupt handler,
+ * so they need no locking as long as only one core uses the console.
+ */
+
+#define TX_BUF_SIZE	4096	/* power of 2 */
+#define RX_BUF_SIZE	256	/* power of 2 */
+
+#define UART_PRIO	4
+#define XICS_XIRR	0x4
+#define XICS_SRC_BASE	16
+
+#define bswap32(x) (uint32_t)__builtin_bswap32((uint32_t)(x))
+
+static char tx_buf[TX_BUF_SIZE];
+static char rx_buf[RX_BUF_SIZE];
+static volatile unsigned int tx_head, tx_tail;
+static volatile unsigned int rx_head, rx_tail;
+static volatile bool tx_irq_on;
+static volatile uint64_t dropped;
+static unsigned long icp_base;
+
+static inline uint64_t mfpir(void)
+{
+	uint64_t v;
+
+	__asm__ volatile("mfspr %0, 1023" : "=r"(v));
+	return v;
+}
+
+static void tx_kick(void)
+{
+	if (!tx_irq_on) {
+		tx_irq_on = true;
+		console_set_irq_en(true, true);
+	}
+}
+
+/* Called from the interrupt handler only */
+static void uart_service(void)
+{
+	unsigned int tail = tx_tail;
+	int room;
+
+	while (console_rx_ready()) {
+		char c = console_rx_byte();
+
+		if (rx_head - rx_tail < RX_BUF_SIZE) {
+			rx_buf[rx_head & (RX_BUF_SIZE - 1)] = c;
+			rx_head = rx_head + 1;
+		} else {
+			dropped = dropped + 1;
+		}
+	}
+
+	room = console_tx_room();
+	while (room > 0 && tail != tx_head) {
+		console_tx_byte(tx_buf[tail & (TX_BUF_SIZE - 1)]);
+		tail++;
+		room--;
+	}
+	tx_tail = tail;
+
+	/*
+	 * Always turn the TX interrupt off once the ring is empty, even if
+	 * tx_irq_on says it is off: we may have interrupted tx_kick() between
+	 * it setting tx_irq_on and enabling the interrupt.
+	 */
+	if (tail == tx_head) {
+		tx_irq_on = false;
+		console_set_irq_en(true, false);
+	}
+}
+
+void console_isr(void)
+{
+	uint32_t xirr;
+
+	/* Accept the interrupt */
+	xirr = bswap32(readl(icp_base + XICS_XIRR));
+	/* Nothing pending, e.g. the source went away: nothing to EOI */
+	if ((xirr & 0xffffff) == 0)
+		return;
+	if ((xirr & 0xffffff) == XICS_SRC_BASE + IRQ_UART0)
+		uart_service();
+	/* EOI */
+	writel(bswap32(xirr), icp_base + XICS_XIRR);
+}
+
+void console_buffered_init(void)
+{
+	uint64_t pir = mfpir();
+	uint64_t msr;
+
+	icp_base = XICS_ICP_BASE + pir * 16;
+	tx_head = tx_tail = 0;
+	rx_head = rx_tail = 0;
+	tx_irq_on = false;
+
+	/* Send the UART interrupt to this core and let everything in */
+	writel(bswap32((pir << 8) | UART_PRIO),
+	       XICS_ICS_BASE + 0x800 + (IRQ_UART0 << 2));
+	writeb(0xff, icp_base + XICS_XIRR);
+	console_set_irq_en(true, false);
+
+	__asm__ volatile("mfmsr %0" : "=r"(msr));
+	msr |= 0x8000;		/* MSR[EE] */
+	__asm__ volatile("mtmsrd %0,1" : : "r"(msr) : "memory");
+}
+
+int console_putc(int c)
+{
+	unsigned int head = tx_head;
+
+	if (head - tx_tail >= TX_BUF_SIZE) {
+		dropped = dropped + 1;
+		return -1;
+	}
+	tx_buf[head & (TX_BUF_SIZE - 1)] = c;
+	__asm__ volatile("" : : : "memory");
+	tx_head = head + 1;
+	tx_kick();
+	return c;
+}
+
+int console_getc(void)
+{
+	unsigned int tail = rx_tail;
+	int c;
+
+	if (tail == rx_head)
+		return -1;
+	c = (unsigned char)rx_buf[tail & (RX_BUF_SIZE - 1)];
+	rx_tail = tail + 1;
+	return c;
+}
+
+void console_flush(void)
+{
+	while (tx_tail != tx_head)
+		/* Wait for the interrupt handler */ ;
+}
+
+uint64_t console_dropped(void)
+{
+	return dropped;
+}
+
+/*
+ * printf-style formatting into the TX ring
+ */
+
+struct fmt_out {
+	int count;
+};
+
+static void out_char(struct fmt_out *o, char c)
+{
+	if (c == '\n' && console_putc('\r') >= 0)
+		o->count++;
+	if (console_putc(c) >= 0)
+		o->count++;
+}
+
+static void out_num(struct fmt_out *o, uint64_t val, unsigned int base,
+		    bool neg, int width, char pad)
+{
+	char buf[24];
+	int pos = 0;
+
+	do {
+		unsigned int d = val % base;
+
+		buf[pos++] = d < 10 ? '0' + d : 'a' + d - 10;
+		val /= base;
+	} while (val);
+	if (neg)
+		width--;
+	if (neg && pad == '0')
+		out_char(o, '-');
+	for (; width > pos; width--)
+		out_char(o, pad);
+	if (neg && pad != '0')
+		out_char(o, '-');
+	while (pos > 0)
+		out_char(o, buf[--pos]);
+}
+
+/*
+ * Supports %c %s %d %i %u %x %p and %%, with an optional '0' flag, field
+ * width and l/ll/z length modifiers.
+ */
+int console_printf(const char *fmt, ...)
+{
+	struct fmt_out o = { 0 };
+	va_list ap;
+
+	va_start(ap, fmt);
+	for (; *fmt; fmt++) {
+		char pad = ' ';
+		int width = 0;
+		int lng = 0;
+		uint64_t uval;
+		int64_t sval;
+		const char *s;
+
+		if (*fmt != '%') {
+			out_char(&o, *fmt);
+			continue;
+		}
+		fmt++;
+		if (*fmt == '0') {
+			pad = '0';
+			fmt++;
+		}
+		while (*fmt >= '0' && *fmt <= '9')
+			width = width * 10 + *fmt++ - '0';
+		while (*fmt == 'l' || *fmt == 'z') {
+			lng++;
+			fmt++;
+		}
+
+		switch (*fmt) {
+		case 'c':
+			out_char(&o, va_arg(ap, int));
+			break;
+		case 's':
+			s = va_arg(ap, const char *);
+			if (!s)
+				s = "(null)";
+			for (; *s; s++)
+				out_char(&o, *s);
+			break;
+		case 'd':
+		case 'i':
+			sval = lng ? va_arg(ap, long) : va_arg(ap, int);
+			uval = sval < 0 ? -(uint64_t)sval : sval;
+			out_num(&o, uval, 10, sval < 0, width, pad);
+			break;
+		case 'u':
+		case 'x':
+			uval = lng ? va_arg(ap, unsigned long) : va_arg(ap, unsigned int);
+			out_num(&o, uval, *fmt == 'x' ? 16 : 10, false, width, pad);
+			break;
+		case 'p':
+			out_char(&o, '0');
+			out_char(&o, 'x');
+			out_num(&o, (unsigned long)va_arg(ap, void *), 16, false, 16, '0');
+			break;
+		case '%':
+			out_char(&o, '%');
+			break;
+		case '\0':
+			fmt--;
+			break;
+		default:
+			out_char(&o, '%');
+			out_char(&o, *fmt);
+			break;
+		}
+	}
+	va_end(ap);
+
+	return o.count;
+}
@@ -0,0 +1,283 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "microwatt_soc.h"
+#include "io.h"
+#include "multicore.h"
+#include "runtime.h"
+
+/*
+ * Per-core state, one cache line each so that cores don't bounce lines
+ * while spinning on their own fields.
+ */
+struct rt_cpu {
+	void *tls;
+	unsigned int id;
+	unsigned int steal_from;
+} __attribute__((aligned(RT_CACHE_LINE)));
+
+static struct rt_cpu cpus[RT_MAX_CPUS];
+static rt_deque_t deques[RT_MAX_CPUS];
+static unsigned int ncpus_present;
+static volatile unsigned int ncpus_active;
+
+/* The parallel_for currently running, if any */
+static volatile long pf_remaining __attribute__((aligned(RT_CACHE_LINE)));
+static volatile long pf_active;
+static long pf_grain;
+
+/* The rt_run_on_all currently running, if any */
+static void (*volatile spmd_fn)(void *arg, long cpu, long ncpus);
+static void *spmd_arg;
+static volatile long spmd_gen __attribute__((aligned(RT_CACHE_LINE)));
+static volatile long spmd_done;
+
+/* Number of other cores that have reached rt_worker() */
+static volatile long workers_ready;
+
+unsigned int rt_cpu_id(void)
+{
+	return read_pir();
+}
+
+unsigned int rt_ncpus(void)
+{
+	return ncpus_active;
+}
+
+void rt_set_ncpus(unsigned int n)
+{
+	if (n < 1)
+		n = 1;
+	if (n > ncpus_present)
+		n = ncpus_present;
+	ncpus_active = n;
+	rt_sync();
+}
+
+void *rt_tls(void)
+{
+	return cpus[rt_cpu_id()].tls;
+}
+
+void rt_set_tls(void *p)
+{
+	cpus[rt_cpu_id()].tls = p;
+}
+
+/*
+ * Barriers
+ */
+
+void rt_barrier_init(rt_barrier_t *b, unsigned int n)
+{
+	b->n = n;
+	b->count = n;
+	b->sense = 0;
+	rt_sync();
+}
+
+void rt_barrier_wait(rt_barrier_t *b)
+{
+	/* The sense can't flip until we have arrived, so this is our episode */
+	long sense = b->sense;
+
+	if (rt_atomic_add(&b->count, -1) == 0) {
+		b->count = b->n;
+		rt_sync();
+		b->sense = !sense;
+	} else {
+		while (b->sense == sense)
+			/* spin */ ;
+	}
+	rt_sync();
+}
+
+/*
+ * Deques
+ */
+
+void rt_deque_init(rt_deque_t *d)
+{
+	d->top = 0;
+	d->bottom = 0;
+}
+
+bool rt_deque_push(rt_deque_t *d, const rt_task_t *t)
+{
+	long b = d->bottom;
+
+	if (b - d->top >= RT_DEQUE_SIZE)
+		return false;
+	d->tasks[b & (RT_DEQUE_SIZE - 1)] = *t;
+	/* The task must be visible before the new bottom */
+	rt_lwsync();
+	d->bottom = b + 1;
+	return true;
+}
+
+bool rt_deque_pop(rt_deque_t *d, rt_task_t *t)
+{
+	long b = d->bottom - 1;
+	long top;
+	bool ok = true;
+
+	d->bottom = b;
+	/* Publish the new bottom before looking at top */
+	rt_sync();
+	top = d->top;
+	if (top > b) {
+		d->bottom = b + 1;
+		return false;
+	}
+	*t = d->tasks[b & (RT_DEQUE_SIZE - 1)];
+	if (top == b) {
+		/* Last task, race any thieves for it */
+		ok = rt_atomic_cas(&d->top, top, top + 1);
+		d->bottom = b + 1;
+	}
+	return ok;
+}
+
+bool rt_deque_steal(rt_deque_t *d, rt_task_t *t)
+{
+	long top = d->top;
+	long b;
+
+	rt_sync();
+	b = d->bottom;
+	if (top >= b)
+		return false;
+	*t = d->tasks[top & (RT_DEQUE_SIZE - 1)];
+	return rt_atomic_cas(&d->top, top, top + 1);
+}
+
+/*
+ * Task execution
+ */
+
+/*
+ * Split off the top half of the range onto our own deque for others to
+ * steal until it is down to the grain size, then run what's left.
+ */
+static void run_task(rt_deque_t *d, rt_task_t *t)
+{
+	while (t->hi - t->lo > pf_grain) {
+		rt_task_t half = *t;
+
+		half.lo = t->lo + (t->hi - t->lo) / 2;
+		if (!rt_deque_push(d, &half))
+			break;
+		t->hi = half.lo;
+	}
+	t->fn(t->arg, t->lo, t->hi);
+	rt_atomic_add(&pf_remaining, -(t->hi - t->lo));
+}
+
+static bool find_task(struct rt_cpu *cpu, rt_task_t *t)
+{
+	unsigned int n = ncpus_active;
+	unsigned int i;
+
+	if (rt_deque_pop(&deques[cpu->id], t))
+		return true;
+	for (i = 0; i < n; i++) {
+		unsigned int victim = cpu->steal_from;
+
+		cpu->steal_from = victim + 1 < n ? victim + 1 : 0;
+		if (victim != cpu->id && rt_deque_steal(&deques[victim], t))
+			return true;
+	}
+	return false;
+}
+
+void parallel_for(long start, long end, long grain,
+		  void (*fn)(void *arg, long lo, long hi), void *arg)
+{
+	struct rt_cpu *cpu = &cpus[rt_cpu_id()];
+	rt_task_t t = { fn, arg, start, end };
+
+	if (end <= start)
+		return;
+	pf_grain = grain > 0 ? grain : 1;
+	pf_remaining = end - start;
+	rt_sync();
+	pf_active = 1;
+
+	run_task(&deques[cpu->id], &t);
+	while (pf_remaining > 0)
+		if (find_task(cpu, &t))
+			run_task(&deques[cpu->id], &t);
+
+	pf_active = 0;
+	rt_sync();
+}
+
+void rt_run_on_all(void (*fn)(void *arg, long cpu, long ncpus), void *arg)
+{
+	long n = ncpus_active;
+
+	spmd_fn = fn;
+	spmd_arg = arg;
+	spmd_done = 0;
+	rt_sync();
+	spmd_gen = spmd_gen + 1;
+
+	fn(arg, rt_cpu_id(), n);
+	rt_atomic_add(&spmd_done, 1);
+	while (spmd_done < n)
+		/* spin */ ;
+}
+
+void rt_worker(void)
+{
+	struct rt_cpu *cpu = &cpus[rt_cpu_id()];
+	long gen = spmd_gen;
+	rt_task_t t;
+
+	rt_atomic_add(&workers_ready, 1);
+	for (;;) {
+		if (spmd_gen != gen) {
+			gen = spmd_gen;
+			rt_sync();
+			if (cpu->id < ncpus_active) {
+				spmd_fn(spmd_arg, cpu->id, ncpus_active);
+				rt_atomic_add(&spmd_done, 1);
+			}
+		}
+		if (!pf_active || cpu->id >= ncpus_active)
+			continue;
+		if (find_task(cpu, &t))
+			run_task(&deques[cpu->id], &t);
+	}
+}
+
+void rt_init(void)
+{
+	unsigned int i, n;
+
+	n = readq(SYSCON_BASE + SYS_REG_CPU_CTRL) >> SYS_REG_CPU_CTRL_NCPUS_SHIFT;
+	if (n < 1)
+		n = 1;
+	if (n > RT_MAX_CPUS)
+		n = RT_MAX_CPUS;
+
+	for (i = 0; i < n; i++) {
+		cpus[i].id = i;
+		cpus[i].steal_from = i + 1 < n ? i + 1 : 0;
+		cpus[i].tls = NULL;
+		rt_deque_init(&deques[i]);
+	}
+	ncpus_present = n;
+	ncpus_active = n;
+	pf_active = 0;
+	workers_ready = 0;
+	rt_sync();
+
+	enable_cpus((1ul << n) - 1);
+
+	/* Don't hand out work before everyone is listening */
+	while (workers_ready < n - 1)
+		/* spin */ ;
+}
@@ -0,0 +1,27 @@
+#ifndef __LZ4_H
+#define __LZ4_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LZ4_FRAME_MAGIC		0x184d2204
+
+/*
+ * Compressed input. The decoder consumes bytes from p to end and calls
+ * refill() when it runs out, which should point p/end at the next chunk
+ * of the stream and return false at the end of the input.
+ */
+struct lz4_in {
+	const uint8_t *p;
+	const uint8_t *end;
+	bool (*refill)(struct lz4_in *in);
+	void *priv;
+};
+
+/*
+ * Decompress one LZ4 frame into dst, which must hold dst_size bytes.
+ * Returns the decompressed size or -1 on a malformed or oversized frame.
+ */
+long lz4_decompress(struct lz4_in *in, uint8_t *dst, unsigned long dst_size);
+
+#endif /* __LZ4_H */
@@ -0,0 +1,211 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "lz4.h"
+
+/*
+ * Streaming LZ4 frame decoder (https://github.com/lz4/lz4/tree/dev/doc).
+ *
+ * Output goes straight to its final place, so both linked and
+ * independent blocks work: matches can always reach back into earlier
+ * output. Checksums are skipped, dictionaries aren't supported.
+ */
+
+#define FLG_VERSION_MASK	0xc0
+#define FLG_VERSION		0x40
+#define FLG_BLOCK_CSUM		0x10
+#define FLG_CONTENT_SIZE	0x08
+#define FLG_CONTENT_CSUM	0x04
+#define FLG_DICT_ID		0x01
+
+#define BLOCK_UNCOMPRESSED	0x80000000u
+#define MIN_MATCH		4
+
+static bool in_avail(struct lz4_in *in)
+{
+	while (in->p == in->end)
+		if (!in->refill || !in->refill(in))
+			return false;
+	return true;
+}
+
+static int in_byte(struct lz4_in *in)
+{
+	if (!in_avail(in))
+		return -1;
+	return *in->p++;
+}
+
+static bool in_skip(struct lz4_in *in, unsigned long n)
+{
+	while (n) {
+		unsigned long c;
+
+		if (!in_avail(in))
+			return false;
+		c = in->end - in->p;
+		if (c > n)
+			c = n;
+		in->p += c;
+		n -= c;
+	}
+	return true;
+}
+
+static bool in_copy(struct lz4_in *in, uint8_t *d, unsigned long n)
+{
+	while (n) {
+		unsigned long c;
+
+		if (!in_avail(in))
+			return false;
+		c = in->end - in->p;
+		if (c > n)
+			c = n;
+		memcpy(d, in->p, c);
+		in->p += c;
+		d += c;
+		n -= c;
+	}
+	return true;
+}
+
+static bool in_le32(struct lz4_in *in, uint32_t *v)
+{
+	uint32_t r = 0;
+	int i, b;
+
+	for (i = 0; i < 4; i++) {
+		b = in_byte(in);
+		if (b < 0)
+			return false;
+		r |= (uint32_t)b << (8 * i);
+	}
+	*v = r;
+	return true;
+}
+
+/* Length field extension: more bytes follow while they are 255 */
+static bool in_len(struct lz4_in *in, unsigned long *len, unsigned long *left)
+{
+	int b;
+
+	do {
+		if (*left == 0)
+			return false;
+		b = in_byte(in);
+		if (b < 0)
+			return false;
+		(*left)--;
+		*len += b;
+	} while (b == 255);
+	return true;
+}
+
+/* Decode one compressed block of size bytes, appending at dst + *pos */
+static bool lz4_block(struct lz4_in *in, unsigned long size, uint8_t *dst,
+		      unsigned long *pos, unsigned long dst_size)
+{
+	unsigned long left = size;
+	unsigned long o = *pos;
+
+	while (left) {
+		unsigned long lit, mlen, off;
+		int token, lo, hi;
+
+		token = in_byte(in);
+		if (token < 0)
+			return false;
+		left--;
+
+		/* Literals */
+		lit = token >> 4;
+		if (lit == 15 && !in_len(in, &lit, &left))
+			return false;
+		if (lit > left || lit > dst_size - o)
+			return false;
+		if (!in_copy(in, dst + o, lit))
+			return false;
+		o += lit;
+		left -= lit;
+
+		/* The last sequence has no match */
+		if (left == 0)
+			break;
+
+		/* Match */
+		if (left < 2)
+			return false;
+		lo = in_byte(in);
+		hi = in_byte(in);
+		if (lo < 0 || hi < 0)
+			return false;
+		left -= 2;
+		off = lo | (hi << 8);
+		if (off == 0 || off > o)
+			return false;
+		mlen = token & 15;
+		if (mlen == 15 && !in_len(in, &mlen, &left))
+			return false;
+		mlen += MIN_MATCH;
+		if (mlen > dst_size - o)
+			return false;
+
+		/* An overlapping match repeats itself, go a byte at a time */
+		if (off >= mlen) {
+			memcpy(dst + o, dst + o - off, mlen);
+			o += mlen;
+		} else {
+			while (mlen--) {
+				dst[o] = dst[o - off];
+				o++;
+			}
+		}
+	}
+	*pos = o;
+	return true;
+}
+
+long lz4_decompress(struct lz4_in *in, uint8_t *dst, unsigned long dst_size)
+{
+	unsigned long pos = 0;
+	uint32_t magic, bsize;
+	int flg, bd;
+
+	if (!in_le32(in, &magic) || magic != LZ4_FRAME_MAGIC)
+		return -1;
+	flg = in_byte(in);
+	bd = in_byte(in);
+	if (flg < 0 || bd < 0)
+		return -1;
+	if ((flg & FLG_VERSION_MASK) != FLG_VERSION || (flg & FLG_DICT_ID))
+		return -1;
+
+	/* Optional content size, then the header checksum */
+	if (!in_skip(in, ((flg & FLG_CONTENT_SIZE) ? 8 : 0) + 1))
+		return -1;
+
+	for (;;) {
+		if (!in_le32(in, &bsize))
+			return -1;
+		if (bsize == 0)
+			break;
+		if (bsize & BLOCK_UNCOMPRESSED) {
+			bsize &= ~BLOCK_UNCOMPRESSED;
+			if (bsize > dst_size - pos)
+				return -1;
+			if (!in_copy(in, dst + pos, bsize))
+				return -1;
+			pos += bsize;
+		} else if (!lz4_block(in, bsize, dst, &pos, dst_size)) {
+			return -1;
+		}
+		if ((flg & FLG_BLOCK_CSUM) && !in_skip(in, 4))
+			return -1;
+	}
+	if ((flg & FLG_CONTENT_CSUM) && !in_skip(in, 4))
+		return -1;
+
+	return pos;
+}
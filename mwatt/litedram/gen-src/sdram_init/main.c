@@ -12,9 +12,12 @@
 #include "io.h"
 #include "sdram.h"
 #include "elf64.h"
+#include "lz4.h"
 
 #define FLASH_LOADER_USE_MAP
 
+static bool has_flash_dma;
+
 int _printf(const char *fmt, ...)
 {
 	int count;
@@ -215,12 +218,133 @@ static bool fl_read(void *dst, uint32_t offset, uint32_t size)
 	return true;
 }
 
+static uint64_t get_tb(void)
+{
+	uint64_t tb;
+
+	__asm__ volatile("mftb %0" : "=r" (tb));
+	return tb;
+}
+
+static void fl_dma_start(void *dst, uint32_t offset, uint32_t size)
+{
+	writel(SPI_FLASH_BASE + offset, FLASH_DMA_BASE + FLASH_DMA_REG_SRC);
+	writel((unsigned long)dst, FLASH_DMA_BASE + FLASH_DMA_REG_DST);
+	writel(size, FLASH_DMA_BASE + FLASH_DMA_REG_LEN);
+	writel(FLASH_DMA_CTRL_START, FLASH_DMA_BASE + FLASH_DMA_REG_CTRL);
+}
+
+static void fl_dma_wait(void)
+{
+	while (readl(FLASH_DMA_BASE + FLASH_DMA_REG_CTRL) & FLASH_DMA_CTRL_BUSY)
+		;
+}
+
+/*
+ * Load a segment and zero its BSS. The DMA engine only moves whole
+ * doublewords, so the CPU reads any unaligned segment or tail itself.
+ * The BSS starts after the file data, so it can be cleared while the
+ * DMA is running.
+ */
+static void fl_load(void *dst, uint32_t offset, uint32_t size, uint32_t bss)
+{
+	uint8_t *d = dst;
+	uint32_t dsize = 0;
+
+	if (has_flash_dma && ((offset | (unsigned long)d) & 7) == 0)
+		dsize = size & ~7u;
+	if (dsize)
+		fl_dma_start(d, offset, dsize);
+
+	memset(d + size, 0, bss);
+
+	if (dsize)
+		fl_dma_wait();
+	if (size > dsize)
+		fl_read(d + dsize, offset + dsize, size - dsize);
+}
+
+/*
+ * Segments flagged with PF_MW_LZ4 (by scripts/lz4_elf.py) hold an LZ4
+ * frame of p_filesz bytes instead of the raw data. With the DMA engine
+ * the frame is streamed from flash in chunks into two scratch buffers,
+ * so the next chunk is being read while the CPU decompresses this one.
+ */
+#define PF_MW_LZ4	0x00100000
+#define FL_CHUNK	0x4000
+
+struct fl_stream {
+	struct lz4_in in;
+	uint32_t offset;	/* next flash offset to fetch */
+	uint32_t left;		/* bytes not fetched yet */
+	uint8_t *buf[2];
+	uint32_t len[2];
+	int next;		/* buffer to hand out next */
+};
+
+static void fl_stream_fetch(struct fl_stream *s, int b)
+{
+	uint32_t n = s->left < FL_CHUNK ? s->left : FL_CHUNK;
+
+	s->len[b] = n;
+	if (n)
+		fl_dma_start(s->buf[b], s->offset, (n + 7) & ~7u);
+	s->offset += n;
+	s->left -= n;
+}
+
+static bool fl_stream_refill(struct lz4_in *in)
+{
+	struct fl_stream *s = in->priv;
+	int b = s->next;
+
+	if (!s->len[b])
+		return false;
+	fl_dma_wait();
+	in->p = s->buf[b];
+	in->end = s->buf[b] + s->len[b];
+
+	/* The other buffer has been consumed, refill it behind our back */
+	s->next = b ^ 1;
+	fl_stream_fetch(s, b ^ 1);
+	return true;
+}
+
+static long fl_load_lz4(void *dst, uint32_t offset, uint32_t size,
+			unsigned long max, uint8_t *scratch)
+{
+	struct fl_stream s;
+	long len;
+
+	memset(&s, 0, sizeof(s));
+	s.in.priv = &s;
+	if (has_flash_dma && (offset & 7) == 0) {
+		s.offset = offset;
+		s.left = size;
+		s.buf[0] = scratch;
+		s.buf[1] = scratch + FL_CHUNK;
+		s.in.refill = fl_stream_refill;
+		fl_stream_fetch(&s, 0);
+	} else {
+		s.in.p = (const uint8_t *)(unsigned long)(SPI_FLASH_BASE + offset);
+		s.in.end = s.in.p + size;
+	}
+	len = lz4_decompress(&s.in, dst, max);
+	if (has_flash_dma)
+		fl_dma_wait();
+	return len;
+}
+
 static unsigned long boot_flash(unsigned int offset)
 {
 	Elf64_Ehdr ehdr;
 	Elf64_Phdr ph;
-	unsigned int i, poff, size, off;
-	void *addr;
+	unsigned int i, poff, size, bss, off;
+	unsigned long total = 0, flash = 0, top = 0;
+	uint64_t clk, tb, rate;
+	uint8_t *scratch;
+	uint8_t *addr;
+	long len;
 
 	printf("Trying flash...\n");
 	if (!fl_read(&ehdr, offset, sizeof(ehdr)))
@@ -235,8 +359,19 @@ static unsigned long boot_flash(unsigned int offset)
 		goto dump;
 	}
 
+	/* Scratch space for streaming compressed segments, above them all */
+	poff = offset + ehdr.e_phoff;
+	for (i = 0; i < ehdr.e_phnum; i++, poff += ehdr.e_phentsize) {
+		if (!fl_read(&ph, poff, sizeof(ph)))
+			goto dump;
+		if (ph.p_type == PT_LOAD && ph.p_vaddr + ph.p_memsz > top)
+			top = ph.p_vaddr + ph.p_memsz;
+	}
+	scratch = (uint8_t *)((top + 0xffff) & ~0xfffful);
+
+	tb = get_tb();
 	poff = offset + ehdr.e_phoff;
-	for (i = 0; i < ehdr.e_phnum; i++) {
+	for (i = 0; i < ehdr.e_phnum; i++, poff += ehdr.e_phentsize) {
 		if (!fl_read(&ph, poff, sizeof(ph)))
 			goto dump;
 		if (ph.p_type != PT_LOAD)
@@ -244,12 +379,34 @@ static unsigned long boot_flash(unsigned int offset)
 
 		/* XXX Add bound checking ! */
 		size = ph.p_filesz;
-		addr = (void *)ph.p_vaddr;
+		addr = (uint8_t *)ph.p_vaddr;
 		off  = offset + ph.p_offset;
-		printf("Copy segment %d (0x%x bytes) to %p\n", i, size, addr);
-		fl_read(addr, off, size);
-		poff += ehdr.e_phentsize;
+		if (ph.p_flags & PF_MW_LZ4) {
+			printf("Decompress segment %d (0x%x bytes) to %p\n", i, size, addr);
+			len = fl_load_lz4(addr, off, size, ph.p_memsz, scratch);
+			if (len < 0) {
+				printf("Bad LZ4 data\n");
+				goto dump;
+			}
+			memset(addr + len, 0, ph.p_memsz - len);
+		} else {
+			bss = ph.p_memsz > size ? ph.p_memsz - size : 0;
+			printf("Copy segment %d (0x%x bytes) to %p\n", i, size, addr);
+			fl_load(addr, off, size, bss);
+			len = size;
+		}
+		total += len;
+		flash += size;
 	}
+	tb = get_tb() - tb;
+
+	/* The timebase runs at the system clock */
+	clk = readq(SYSCON_BASE + SYS_REG_CLKINFO) & SYS_REG_CLKINFO_FREQ_MASK;
+	rate = tb ? total * 100 * clk / tb / (1024 * 1024) : 0;
+	printf("Loaded %ld bytes (%ld from flash) in %ld ms (%ld.%02ld MB/s%s)\n",
+	       total, flash, (unsigned long)(tb * 1000 / clk),
+	       (unsigned long)(rate / 100), (unsigned long)(rate % 100),
+	       has_flash_dma ? ", DMA" : "");
 
 	printf("Booting from DRAM at %x\n", (unsigned int)ehdr.e_entry);
 	flush_cpu_icache();
@@ -266,8 +423,23 @@ static void boot_sdram(void)
 	void *s = (void *)(DRAM_INIT_BASE + 0x6000);
 	void *d = (void *)DRAM_BASE;
 	int  sz = (0x10000 - 0x6000);
-	printf("Copying payload to DRAM...\n");
-	memcpy(d, s, sz);
+	struct lz4_in in;
+	unsigned long max;
+	long len;
+
+	if (*(uint32_t *)s == LZ4_FRAME_MAGIC) {
+		printf("Decompressing payload to DRAM...\n");
+		in.p = s;
+		in.end = (const uint8_t *)s + sz;
+		in.refill = NULL;
+		max = readq(SYSCON_BASE + SYS_REG_DRAMINFO) & SYS_REG_DRAMINFO_SIZE_MASK;
+		len = lz4_decompress(&in, d, max);
+		if (len < 0)
+			printf("Bad LZ4 payload\n");
+	} else {
+		printf("Copying payload to DRAM...\n");
+		memcpy(d, s, sz);
+	}
 	printf("Booting from DRAM...\n");
 	flush_cpu_icache();
 }
@@ -302,6 +474,8 @@ uint64_t main(void)
 		printf("ETHERNET ");
 	if (ftr & SYS_REG_INFO_HAS_LITESDCARD)
 		printf("SDCARD ");
+	if (ftr & SYS_REG_INFO_HAS_FLASH_DMA)
+		printf("FLASHDMA ");
 	printf("\n");
 	if (ftr & SYS_REG_INFO_HAS_BRAM) {
 		val = readq(SYSCON_BASE + SYS_REG_BRAMINFO) & SYS_REG_BRAMINFO_SIZE_MASK;
@@ -318,6 +492,7 @@ uint64_t main(void)
 	if (ftr & SYS_REG_INFO_HAS_SPI_FLASH) {
 		val = readq(SYSCON_BASE + SYS_REG_SPI_INFO);
 		try_flash = check_flash();
+		has_flash_dma = !!(ftr & SYS_REG_INFO_HAS_FLASH_DMA);
 		fl_off = val & SYS_REG_SPI_INFO_FLASH_OFF_MASK;
 		printf(" SPI FLASH OFF: 0x%x bytes\n", fl_off);
 		try_flash = true;
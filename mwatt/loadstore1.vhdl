@@ -3,18 +3,27 @@ use ieee.std_logic_1164.all;
 use ieee.numeric_std.all;
 
 library work;
+use work.utils.all;
 use work.decode_types.all;
 use work.common.all;
 use work.insn_helpers.all;
 use work.helpers.all;
+use work.sim_cosim.all;
 
 -- 2 cycle LSU
 -- We calculate the address in the first cycle
 
 entity loadstore1 is
     generic (
-        HAS_FPU    : boolean := true;
-        LOG_LENGTH : natural := 0
+        HAS_FPU            : boolean := true;
+        -- Number of doublewords in the store buffer, 0 for none
+        STORE_BUFFER_DEPTH : natural := 0;
+        -- Line size of the dcache, for loads that cross a doubleword
+        DCACHE_LINE_SIZE   : positive := 64;
+        CPU_INDEX          : natural := 0;
+        -- Report stores to the co-simulation checker
+        COSIM              : boolean := false;
+        LOG_LENGTH         : natural := 0
     );
     port (
         -- Clock and reset
@@ -68,6 +77,12 @@ architecture behave of loadstore1 is
 
     constant num_dawr : positive := 2;
 
+    constant SB_ENABLED : boolean  := STORE_BUFFER_DEPTH > 0;
+    constant SB_DEPTH   : positive := maximum(STORE_BUFFER_DEPTH, 1);
+    subtype sb_index_t is integer range 0 to SB_DEPTH - 1;
+
+    constant DC_LINE_BITS : natural := log2(DCACHE_LINE_SIZE);
+
     type byte_index_t is array(0 to 7) of unsigned(2 downto 0);
     subtype byte_trim_t is std_ulogic_vector(1 downto 0);
     type trim_ctl_t is array(0 to 7) of byte_trim_t;
@@ -91,6 +106,7 @@ architecture behave of loadstore1 is
         do_update    : std_ulogic;
         mode_32bit   : std_ulogic;
         prefixed     : std_ulogic;
+        fused        : std_ulogic;
         addr         : std_ulogic_vector(63 downto 0);
         byte_sel     : std_ulogic_vector(7 downto 0);
         second_bytes : std_ulogic_vector(7 downto 0);
@@ -121,6 +137,7 @@ architecture behave of loadstore1 is
         dword_index  : std_ulogic;
         two_dwords   : std_ulogic;
         incomplete   : std_ulogic;
+        dual         : std_ulogic;      -- one dcache access for both doublewords
         ea_valid     : std_ulogic;
         -- Queue instructions
         ldq_op       : std_ulogic;
@@ -129,7 +146,10 @@ architecture behave of loadstore1 is
         is_32bit     : std_ulogic;
         --
         queue_data   : std_ulogic_vector(63 downto 0);
-    --
+        -- Store buffer
+        sb_store     : std_ulogic;      -- store goes into the store buffer
+        sb_fwd       : std_ulogic;      -- load data comes from the store buffer
+        sb_idx       : sb_index_t;      -- entry to forward from
     end record;
     constant request_init : request_t := (
         addr         => (others => '0'),
@@ -145,6 +165,7 @@ architecture behave of loadstore1 is
         sprsel       => "0000",
         ric          => "00",
         queue_data   => (others => '0'),
+        sb_idx       => 0,
         others       => '0'
     );
 
@@ -156,6 +177,7 @@ architecture behave of loadstore1 is
         dawr_ll : std_ulogic_vector(num_dawr-1 downto 0);
         dawr_ul : std_ulogic_vector(num_dawr-1 downto 0);
         dawr_ud : std_ulogic;
+        sb_hold : std_ulogic;           -- request is waiting for the store buffer
     end record;
 
     type reg_stage2_t is record
@@ -172,6 +194,7 @@ architecture behave of loadstore1 is
         sprsel      : std_ulogic_vector(3 downto 0);
         dbg_spr     : std_ulogic_vector(63 downto 0);
         dbg_spr_ack : std_ulogic;
+        sb_data     : std_ulogic_vector(63 downto 0);
     end record;
 
     type dawr_array_t is array(0 to num_dawr - 1) of std_ulogic_vector(63 downto 3);
@@ -204,16 +227,41 @@ architecture behave of loadstore1 is
         dawr_upd     : std_ulogic;
     end record;
 
+    -- Store buffer entries, oldest at head
+    type sb_entry_t is record
+        addr      : std_ulogic_vector(63 downto 3);
+        byte_sel  : std_ulogic_vector(7 downto 0);
+        data      : std_ulogic_vector(63 downto 0);
+        priv_mode : std_ulogic;
+    end record;
+    type sb_array_t is array(0 to SB_DEPTH - 1) of sb_entry_t;
+
+    type store_buf_t is record
+        ent      : sb_array_t;
+        head     : sb_index_t;
+        tail     : sb_index_t;
+        count    : integer range 0 to SB_DEPTH;
+        inflight : unsigned(1 downto 0);  -- drained stores not yet acked by the dcache
+        age      : unsigned(2 downto 0);  -- cycles the oldest entry has been kept waiting
+        dreq     : std_ulogic;            -- drain request sent last cycle
+        ddata    : std_ulogic_vector(63 downto 0);
+    end record;
+
     signal req_in   : request_t;
     signal r1, r1in : reg_stage1_t;
     signal r2, r2in : reg_stage2_t;
     signal r3, r3in : reg_stage3_t;
+    signal sb, sbin : store_buf_t;
 
     signal flush    : std_ulogic;
     signal busy     : std_ulogic;
     signal complete : std_ulogic;
     signal flushing : std_ulogic;
 
+    signal dc_valid : std_ulogic;
+    signal sb_push  : std_ulogic;
+    signal sb_drain : std_ulogic;
+
     signal store_sp_data : std_ulogic_vector(31 downto 0);
     signal load_dp_data  : std_ulogic_vector(63 downto 0);
     signal store_data    : std_ulogic_vector(63 downto 0);
@@ -404,6 +452,7 @@ begin
                 r1.dawr_ll         <= (others => '0');
                 r1.dawr_ul         <= (others => '0');
                 r1.dawr_ud         <= '0';
+                r1.sb_hold         <= '0';
 
                 -- Register initialization for r2
                 r2.req.valid       <= '0';
@@ -430,6 +479,8 @@ begin
                 r3.stage1_en             <= '1';
                 r3.events.load_complete  <= '0';
                 r3.events.store_complete <= '0';
+                r3.events.queue_empty_wait <= '0';
+                r3.events.queue_full_wait  <= '0';
                 for i in 0 to num_dawr - 1 loop
                     r3.dawr(i)       <= (others => '0');
                     r3.dawrx(i)      <= (others => '0');
@@ -437,6 +488,14 @@ begin
                 end loop;
                 r3.dawr_upd <= '0';
 
+                -- Register initialization for the store buffer
+                sb.head     <= 0;
+                sb.tail     <= 0;
+                sb.count    <= 0;
+                sb.inflight <= "00";
+                sb.age      <= "000";
+                sb.dreq     <= '0';
+
                 -- Register initialization for global flushing flag
                 flushing <= '0';
             else
@@ -445,6 +504,7 @@ begin
                 r1 <= r1in;
                 r2 <= r2in;
                 r3 <= r3in;
+                sb <= sbin;
 
                 -- 1. Sets flushing if it was already set
                 -- 2. OR if there's a valid request with an alignment or watchpoint interrupt
@@ -458,12 +518,13 @@ begin
             stage1_dreq <= stage1_dcreq;
 
             -- Assertion for correct dcache operation
-            if d_in.valid = '1' then
+            if dc_valid = '1' then
                 assert r2.req.valid = '1' and r2.req.dc_req = '1' and r3.state = IDLE severity failure;
             end if;
             -- Assertion for correct state when dcache error
             if d_in.error = '1' then
-                assert r2.req.valid = '1' and r2.req.dc_req = '1' and r3.state = IDLE severity failure;
+                assert r2.req.valid = '1' and r2.req.dc_req = '1' and r3.state = IDLE and
+                    sb.inflight = 0 severity failure;
             end if;
             -- Assertion for correct state when mmu error
             if m_in.done = '1' or m_in.err = '1' then
@@ -664,6 +725,7 @@ begin
         variable misaligned : std_ulogic;
         variable addr_mask  : std_ulogic_vector(2 downto 0);
         variable hash_nop   : std_ulogic;
+        variable quadword   : std_ulogic;
     begin
         -- Defaults
         v := request_init;
@@ -673,6 +735,7 @@ begin
         v.instr_tag    := l_in.instr_tag;
         v.mode_32bit   := l_in.mode_32bit;
         v.prefixed     := l_in.prefixed;
+        v.fused        := l_in.fused;
         v.write_reg    := l_in.write_reg;
         v.length       := l_in.length;
         v.elt_length   := l_in.length;
@@ -734,10 +797,17 @@ begin
             v.two_dwords := '1';
         end if;
 
+        -- Queue pairs (lfdpxq, stafdpxq, stfdpxq) are repeated like the
+        -- quadword ops, but they are two independent queue transfers.
+        quadword := l_in.repeat and not l_in.update;
+        if l_in.op = OP_LDQ or l_in.op = OP_STAQ or l_in.op = OP_STQ then
+            quadword := '0';
+        end if;
+
         -- Check if the address is properly aligned for the access size
         addr_mask  := std_ulogic_vector(unsigned(l_in.length(2 downto 0)) - 1);
         misaligned := or (addr_mask and addr(2 downto 0));
-        if l_in.repeat = '1' and l_in.update = '0' and addr(3) /= l_in.second then
+        if quadword = '1' and addr(3) /= l_in.second then
             misaligned := '1';
         end if;
 
@@ -748,7 +818,7 @@ begin
         v.atomic_first := not misaligned and not l_in.second;
         v.atomic_last  := not misaligned and (l_in.second or not l_in.repeat);
         -- Is this a quadword load or store? i.e. lq plq stq pstq lqarx stqcx.
-        if l_in.repeat = '1' and l_in.update = '0' then
+        if quadword = '1' then
             if misaligned = '0' then
                 -- Since the access is aligned we have to do it atomically
                 v.atomic_qw := '1';
@@ -835,8 +905,19 @@ begin
         -- Detemine if a data cache request is needed
         v.dc_req := l_in.valid and (v.load or v.store or v.sync or v.dcbz) and not v.align_intr and not hash_nop;
 
+        -- A plain load that crosses a doubleword but not a dcache line gets
+        -- both doublewords from one dcache access.  There is no dual write,
+        -- so a store that crosses a doubleword is still two accesses, and
+        -- it doesn't go in the store buffer either.
+        if v.dc_req = '1' and v.two_dwords = '1' and v.load = '1' and
+            (v.load_sp or v.reserve or v.atomic_qw or v.nc or v.flush or v.touch or v.hashcmp) = '0' and
+            (r3.dawrx(0)(5) or r3.dawrx(1)(5)) = '0' and
+            addr(DC_LINE_BITS - 1 downto 3) /= (DC_LINE_BITS - 1 downto 3 => '1') then
+            v.dual := '1';
+        end if;
+
         -- Determine if "incomplete," meaning it will need a second access (for operations spanning two doublewords)
-        v.incomplete := v.dc_req and v.two_dwords;
+        v.incomplete := v.dc_req and v.two_dwords and not v.dual;
 
         -- Calculates a mask used for byte-reversal operations
         brev_lenm1 := "000";
@@ -852,8 +933,13 @@ begin
     -- Flag to indicate if loadstore unit is busy
     busy <= dc_stall or d_in.error or r1.busy or r2.busy;
 
+    -- dcache completions for requests from the pipeline, as opposed to
+    -- stores drained from the store buffer.  The dcache completes requests
+    -- in order and the two never have requests outstanding at once.
+    dc_valid <= d_in.valid when sb.inflight = 0 else '0';
+
     -- Flag to indicate if a loadstore unit has finished executing
-    complete <= r2.one_cycle or (r2.wait_dc and d_in.valid) or r3.complete;
+    complete <= r2.one_cycle or (r2.wait_dc and dc_valid) or r3.complete;
 
     -- Processing done in the first cycle of a load/store instruction
     loadstore1_1 : process(all)
@@ -864,6 +950,16 @@ begin
         variable addr  : std_ulogic_vector(63 downto 3);
         variable addl  : unsigned(64 downto 3);
         variable addu  : unsigned(64 downto 3);
+        variable sb_block : std_ulogic;
+        variable sb_pend  : std_ulogic;
+        variable sb_match : std_ulogic;
+        variable sb_cover : std_ulogic;
+        variable sb_fidx  : sb_index_t;
+        variable sb_addr2 : std_ulogic_vector(63 downto 3);
+        variable sb_used  : integer range 0 to SB_DEPTH + 1;
+        variable sb_st_ok : std_ulogic;
+        variable sb_ld_ok : std_ulogic;
+        variable j        : sb_index_t;
     begin
         v          := r1;
         issue      := '0';
@@ -885,7 +981,10 @@ begin
             end if;
         else
             req := r1.req;
-            if r1.req.dc_req = '1' and r1.issued = '0' then
+            if r1.sb_hold = '1' then
+                -- retry a request that was waiting for the store buffer
+                issue := r1.req.dc_req;
+            elsif r1.req.dc_req = '1' and r1.issued = '0' then
                 issue := '1';
             elsif r1.req.incomplete = '1' then
                 -- construct the second request for a misaligned access
@@ -910,6 +1009,93 @@ begin
             end if;
         end if;
 
+        -- Store buffer.  A store that can't take an interrupt in the dcache
+        -- (real mode, cacheable, one doubleword, no stcx. or watchpoint) goes
+        -- into the buffer and completes without waiting for the dcache.
+        -- A similar load can go to the dcache ahead of buffered stores to
+        -- other doublewords, or take its data from the youngest buffered
+        -- store if that has all its bytes.  Anything else waits until the
+        -- buffer has drained and the dcache has finished with it.
+        sb_block := '0';
+        if SB_ENABLED and (r1.busy = '0' or r1.sb_hold = '1') and req.valid = '1' then
+            -- a store in r1 is written to the buffer this cycle
+            sb_pend := r1.req.valid and r1.req.sb_store;
+            sb_used := sb.count;
+            if sb_pend = '1' then
+                sb_used := sb.count + 1;
+            end if;
+
+            -- the second doubleword of a dual load is in the same line
+            sb_addr2 := req.addr(63 downto 3);
+            sb_addr2(DC_LINE_BITS - 1 downto 3) :=
+                std_ulogic_vector(unsigned(req.addr(DC_LINE_BITS - 1 downto 3)) + 1);
+
+            sb_match := '0';
+            sb_cover := '0';
+            sb_fidx  := 0;
+            for i in 0 to SB_DEPTH - 1 loop
+                j := (sb.head + i) mod SB_DEPTH;
+                if i < sb.count and sb.ent(j).addr = req.addr(63 downto 3) then
+                    sb_match := '1';
+                    sb_cover := not (or (req.byte_sel and not sb.ent(j).byte_sel));
+                    sb_fidx  := j;
+                end if;
+                if i < sb.count and req.dual = '1' and sb.ent(j).addr = sb_addr2 then
+                    sb_match := '1';
+                end if;
+            end loop;
+            if sb_pend = '1' and r1.req.addr(63 downto 3) = req.addr(63 downto 3) then
+                sb_match := '1';
+                sb_cover := not (or (req.byte_sel and not r1.req.byte_sel));
+                sb_fidx  := sb.tail;
+            end if;
+            if sb_pend = '1' and req.dual = '1' and r1.req.addr(63 downto 3) = sb_addr2 then
+                sb_match := '1';
+            end if;
+            -- a dual load is never forwarded from the buffer
+            sb_cover := sb_cover and not req.dual;
+
+            sb_st_ok := not (req.reserve or req.nc or req.virt_mode or req.touch or req.hashst or
+                             req.two_dwords or req.atomic_qw or r3.dawrx(0)(6) or r3.dawrx(1)(6));
+            sb_ld_ok := not (req.reserve or req.nc or req.virt_mode or req.flush or req.hashcmp or
+                             (req.two_dwords and not req.dual));
+
+            if req.dc_req = '1' and req.store = '1' and sb_st_ok = '1' then
+                if sb_used < SB_DEPTH then
+                    req.dc_req   := '0';
+                    req.sb_store := '1';
+                    issue        := '0';
+                else
+                    sb_block := '1';
+                end if;
+            elsif req.dc_req = '1' and req.load = '1' and sb_ld_ok = '1' then
+                if sb_match = '0' then
+                    -- don't let a stream of loads keep the buffer from draining
+                    if sb.inflight /= 0 or sb.age = "111" then
+                        sb_block := '1';
+                    end if;
+                elsif sb_cover = '1' and
+                    (req.load_sp or req.touch or r3.dawrx(0)(5) or r3.dawrx(1)(5)) = '0' then
+                    req.dc_req := '0';
+                    req.sb_fwd := '1';
+                    req.sb_idx := sb_fidx;
+                    issue      := '0';
+                else
+                    sb_block := '1';
+                end if;
+            elsif (req.dc_req or req.mmu_op or req.staq_op or req.stq_op) = '1' then
+                -- sync, larx/stcx., dcbz, dcbf, virtual and cache-inhibited
+                -- accesses, MMU ops and queue pushes are ordered after all
+                -- buffered stores
+                if sb_used /= 0 or sb.inflight /= 0 then
+                    sb_block := '1';
+                end if;
+            end if;
+            if sb_block = '1' then
+                issue := '0';
+            end if;
+        end if;
+
         -- Do subtractions for DAWR0/1 matches
         for i in 0 to 1 loop
             addr := req.addr(63 downto 3);
@@ -930,6 +1116,7 @@ begin
             v.req.incomplete := '0';
             v.issued         := '0';
             v.busy           := '0';
+            v.sb_hold        := '0';
         elsif (dc_stall or d_in.error or r2.busy) = '0' then
             -- we can change what's in r1 next cycle because the current thing
             -- in r1 will go into r2
@@ -948,6 +1135,10 @@ begin
             end if;
             dcreq    := issue;
             v.issued := issue;
+            v.sb_hold := sb_block;
+            if sb_block = '1' then
+                v.busy := '1';
+            end if;
         else
             -- pipeline is stalled
             if r1.issued = '1' and d_in.error = '1' then
@@ -984,6 +1175,8 @@ begin
         variable queue_op    : std_ulogic;
     begin
         v := r2;
+        v.one_cycle := '0';
+        sb_push     <= '0';
 
         -- Byte reversing and rotating for stores.
         -- Done in the second cycle (the cycle after l_in.valid = 1).
@@ -1044,7 +1237,7 @@ begin
         end if;
 
         if (dc_stall or d_in.error or r2.busy or l_in.e2stall) = '0' then
-            if r1.req.valid = '0' or r1.issued = '1' or r1.req.dc_req = '0' then
+            if (r1.req.valid = '0' or r1.issued = '1' or r1.req.dc_req = '0') and r1.sb_hold = '0' then
                 v.req            := r1.req;
                 v.addr0          := r1.addr0;
                 v.req.store_data := store_data;
@@ -1071,6 +1264,12 @@ begin
                     v.addr0 := sprval;
                 end if;
 
+                -- Store buffer write, and forwarding to a load
+                sb_push <= r1.req.valid and r1.req.sb_store;
+                if r1.req.sb_fwd = '1' then
+                    v.sb_data := sb.ent(r1.req.sb_idx).data;
+                end if;
+
                 -- Work out load formatter controls for next cycle
                 for i in 0 to 7 loop
                     idx             := to_unsigned(i, 3) xor r1.req.brev_mask;
@@ -1093,7 +1292,7 @@ begin
             v.wait_mmu := '0';
         end if;
         if r2.busy = '1' and r2.wait_mmu = '0' and r2.wait_queue = '0' then
-            if r2.req.hashcmp = '0' or d_in.valid = '1' then
+            if r2.req.hashcmp = '0' or dc_valid = '1' then
                 v.busy := '0';
             end if;
         end if;
@@ -1119,7 +1318,7 @@ begin
 
         -- Process queue operations if not stalled
         if (dc_stall or d_in.error or r2.busy or l_in.e2stall) = '0' then
-            if r1.req.valid = '1' then
+            if r1.req.valid = '1' and r1.sb_hold = '0' then
                 if r1.req.ldq_op = '1' then
                     if empty_i = '0' then
                         -- Queue has data -> Read it
@@ -1199,6 +1398,63 @@ begin
         dbg_spr_ack  <= r2.dbg_spr_ack;
     end process;
 
+    -- Store buffer.  Entries are written from stage 2 and sent to the
+    -- dcache in order whenever the pipeline has no dcache request of its
+    -- own outstanding.  The store data follows a cycle after the request,
+    -- as it does for stores from stage 1.
+    loadstore1_sb : process(all)
+        variable v     : store_buf_t;
+        variable drain : std_ulogic;
+        variable cnt   : integer range 0 to SB_DEPTH + 1;
+    begin
+        v      := sb;
+        v.dreq := '0';
+        drain  := '0';
+
+        if SB_ENABLED then
+            if sb.inflight /= 0 and d_in.valid = '1' then
+                v.inflight := sb.inflight - 1;
+            end if;
+
+            if sb.count /= 0 and sb.inflight /= 3 and stage1_dcreq = '0' and
+                r3.stage1_en = '1' and r3.state = IDLE and
+                (dc_stall or d_in.error or l_in.e2stall) = '0' and
+                (r1.issued or (r2.req.valid and r2.req.dc_req)) = '0' then
+                drain      := '1';
+                v.dreq     := '1';
+                v.ddata    := sb.ent(sb.head).data;
+                v.head     := (sb.head + 1) mod SB_DEPTH;
+                v.inflight := v.inflight + 1;
+            end if;
+
+            if drain = '1' or sb.count = 0 then
+                v.age := "000";
+            elsif sb.age /= "111" then
+                v.age := sb.age + 1;
+            end if;
+
+            if sb_push = '1' then
+                v.ent(sb.tail).addr      := r1.req.addr(63 downto 3);
+                v.ent(sb.tail).byte_sel  := r1.req.byte_sel;
+                v.ent(sb.tail).data      := store_data;
+                v.ent(sb.tail).priv_mode := r1.req.priv_mode;
+                v.tail                   := (sb.tail + 1) mod SB_DEPTH;
+            end if;
+
+            cnt := sb.count;
+            if sb_push = '1' then
+                cnt := cnt + 1;
+            end if;
+            if drain = '1' then
+                cnt := cnt - 1;
+            end if;
+            v.count := cnt;
+        end if;
+
+        sb_drain <= drain;
+        sbin     <= v;
+    end process;
+
     -- Processing done in the third cycle of a load/store instruction.
     -- At this stage we can do things that have side effects without
     -- fear of the instruction getting flushed.  This is the point at
@@ -1222,6 +1478,7 @@ begin
         variable itlb_fault    : std_ulogic;
         variable trim_ctl      : trim_ctl_t;
         variable hashchk_trap  : std_ulogic;
+        variable ld_data       : std_ulogic_vector(63 downto 0);
     begin
         v := r3;
 
@@ -1248,12 +1505,22 @@ begin
 
         -- load data formatting
         -- shift and byte-reverse data bytes
+        if r2.req.sb_fwd = '1' then
+            ld_data := r2.sb_data;
+        else
+            ld_data := d_in.data;
+        end if;
         for i in 0 to 7 loop
             if is_X(r2.byte_index(i)) then
                 data_permuted(i * 8 + 7 downto i * 8) := (others => 'X');
             else
-                j                                     := to_integer(r2.byte_index(i)) * 8;
-                data_permuted(i * 8 + 7 downto i * 8) := d_in.data(j + 7 downto j);
+                -- a dual load has the second doubleword in d_in.data2
+                j := to_integer(r2.byte_index(i)) * 8;
+                if r2.req.dual = '1' and r2.use_second(i) = '1' then
+                    data_permuted(i * 8 + 7 downto i * 8) := d_in.data2(j + 7 downto j);
+                else
+                    data_permuted(i * 8 + 7 downto i * 8) := ld_data(j + 7 downto j);
+                end if;
             end if;
         end loop;
 
@@ -1306,12 +1573,12 @@ begin
             v.ld_sp_lz   := count_left_zeroes(data_trimmed(22 downto 0));
         end if;
 
-        if d_in.valid = '1' and r2.req.load = '1' then
+        if dc_valid = '1' and r2.req.load = '1' then
             v.load_data := data_permuted;
         end if;
 
         hashchk_trap := '0';
-        if d_in.valid = '1' and r2.req.hashcmp = '1' then
+        if dc_valid = '1' and r2.req.hashcmp = '1' then
             if d_in.data = r2.req.store_data then
                 v.complete := '1';
             else
@@ -1366,7 +1633,7 @@ begin
             v.state := MMU_WAIT;
         end if;
 
-        if d_in.valid = '1' then
+        if dc_valid = '1' then
             if r2.req.incomplete = '0' then
                 write_enable := r2.req.load and not r2.req.load_sp and
                                 not r2.req.flush and not r2.req.touch and not r2.req.hashcmp;
@@ -1374,6 +1641,11 @@ begin
                 do_update := r2.req.update and r2.req.store;
             end if;
         end if;
+        if r2.one_cycle = '1' then
+            -- loads forwarded from the store buffer, and stores put in it
+            write_enable := write_enable or r2.req.sb_fwd;
+            do_update    := do_update or (r2.req.update and r2.req.sb_store);
+        end if;
         if d_in.error = '1' then
             if d_in.cache_paradox = '1' or d_in.reserve_nc = '1' or r2.req.dawr_intr = '1' then
                 -- signal an interrupt straight away
@@ -1418,6 +1690,8 @@ begin
 
         v.events.load_complete  := r2.req.load and complete;
         v.events.store_complete := (r2.req.store or r2.req.dcbz) and complete;
+        v.events.queue_empty_wait := r2.wait_queue and r2.req.ldq_op;
+        v.events.queue_full_wait  := r2.wait_queue and (r2.req.staq_op or r2.req.stq_op);
 
         -- generate DSI or DSegI for load/store exceptions
         -- or ISI or ISegI for instruction fetch exceptions
@@ -1478,7 +1752,24 @@ begin
         end case;
 
         -- Update outputs to dcache
-        if r3.stage1_en = '1' then
+        if sb_drain = '1' then
+            d_out.valid        <= '1';
+            d_out.load         <= '0';
+            d_out.dcbz         <= '0';
+            d_out.flush        <= '0';
+            d_out.touch        <= '0';
+            d_out.sync         <= '0';
+            d_out.nc           <= '0';
+            d_out.reserve      <= '0';
+            d_out.atomic_qw    <= '0';
+            d_out.atomic_first <= '1';
+            d_out.atomic_last  <= '1';
+            d_out.dual         <= '0';
+            d_out.addr         <= sb.ent(sb.head).addr & "000";
+            d_out.byte_sel     <= sb.ent(sb.head).byte_sel;
+            d_out.virt_mode    <= '0';
+            d_out.priv_mode    <= sb.ent(sb.head).priv_mode;
+        elsif r3.stage1_en = '1' then
             d_out.valid        <= stage1_dcreq;
             d_out.load         <= stage1_req.load;
             d_out.dcbz         <= stage1_req.dcbz;
@@ -1490,6 +1781,7 @@ begin
             d_out.atomic_qw    <= stage1_req.atomic_qw;
             d_out.atomic_first <= stage1_req.atomic_first;
             d_out.atomic_last  <= stage1_req.atomic_last;
+            d_out.dual         <= stage1_req.dual;
             d_out.addr         <= stage1_req.addr;
             d_out.byte_sel     <= stage1_req.byte_sel;
             d_out.virt_mode    <= stage1_req.virt_mode;
@@ -1506,6 +1798,7 @@ begin
             d_out.atomic_qw    <= r2.req.atomic_qw;
             d_out.atomic_first <= r2.req.atomic_first;
             d_out.atomic_last  <= r2.req.atomic_last;
+            d_out.dual         <= r2.req.dual;
             d_out.addr         <= r2.req.addr;
             d_out.byte_sel     <= r2.req.byte_sel;
             d_out.virt_mode    <= r2.req.virt_mode;
@@ -1514,6 +1807,9 @@ begin
         if stage1_dreq = '1' then
             d_out.data       <= store_data;
             d_out.dawr_match <= stage1_dawr_match;
+        elsif sb.dreq = '1' then
+            d_out.data       <= sb.ddata;
+            d_out.dawr_match <= '0';
         else
             d_out.data       <= r2.req.store_data;
             d_out.dawr_match <= r2.req.dawr_intr;
@@ -1546,6 +1842,7 @@ begin
         l_out.interrupt    <= r3.interrupt;
         l_out.intr_vec     <= r3.intr_vec;
         l_out.srr1         <= r3.srr1;
+        l_out.fused        <= r2.req.fused and complete;
 
         -- update busy signal back to execute1
         e_out.busy    <= busy;
@@ -1584,4 +1881,43 @@ begin
         log_out <= log_data;
     end generate;
 
+    -- Store trace for the co-simulation checker in sim_cosim_c.c: the
+    -- real address, byte selects and data of each doubleword written,
+    -- when the dcache accepts it or it goes into the store buffer, with
+    -- the instruction's tag.  A dcbz is reported as a doubleword of
+    -- zeroes for each doubleword of the line.  Sampled on the falling
+    -- edge, so that the last doubleword of a store gets to the checker
+    -- before writeback reports the store complete on the next rising
+    -- edge.
+    cosim_store_trace: if COSIM generate
+        cosim_1: process(clk)
+            variable ra : std_ulogic_vector(63 downto 0);
+        begin
+            if falling_edge(clk) and rst = '0' then
+                if dc_valid = '1' and d_in.store_done = '1' and
+                    (r2.req.store or r2.req.dcbz) = '1' then
+                    ra := (63 downto REAL_ADDR_BITS => '0') & d_in.real_addr;
+                    if r2.req.dcbz = '1' then
+                        for i in 0 to DCACHE_LINE_SIZE / 8 - 1 loop
+                            ra(DC_LINE_BITS - 1 downto 0) :=
+                                std_ulogic_vector(to_unsigned(i * 8, DC_LINE_BITS));
+                            cosim_store(CPU_INDEX, r2.req.instr_tag.tag, ra, x"ff",
+                                        (others => '0'));
+                        end loop;
+                    else
+                        ra(2 downto 0) := "000";
+                        cosim_store(CPU_INDEX, r2.req.instr_tag.tag, ra, r2.req.byte_sel,
+                                    r2.req.store_data);
+                    end if;
+                end if;
+                if sb_push = '1' then
+                    ra := (63 downto REAL_ADDR_BITS => '0') &
+                          r1.req.addr(REAL_ADDR_BITS - 1 downto 3) & "000";
+                    cosim_store(CPU_INDEX, r1.req.instr_tag.tag, ra, r1.req.byte_sel,
+                                store_data);
+                end if;
+            end if;
+        end process;
+    end generate;
+
 end;
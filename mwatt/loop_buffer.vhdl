@@ -0,0 +1,267 @@
+-- Loop buffer, between the icache and decode1.
+--
+-- It watches the instructions decode1 takes from the icache.  After a
+-- relative branch predicted taken (by the BTC or by decode1) goes back
+-- at most SIZE entries, it records the icache output entries, with
+-- their predecoded icode, from the branch target onwards.  If they are
+-- all sequential and the same branch takes us back to the target
+-- again, the loop is complete and from then on it is fed to decode1
+-- from the buffer, with the back-edge marked as predicted taken so
+-- that decode1 doesn't redirect fetch1.  Meanwhile fetch1 and the
+-- icache are stalled.
+--
+-- Replay ends with any flush (a mispredicted branch, most often the
+-- loop's own branch falling through, an interrupt, or an isync after
+-- code has been modified) and with decode1 predicting a branch in the
+-- loop taken; in both cases fetch1 is being redirected anyway.  A debug
+-- stop makes the buffer redirect fetch1 itself to the next instruction
+-- in the loop.
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library work;
+use work.common.all;
+use work.decode_types.all;
+
+entity loop_buffer is
+    generic (
+        -- Number of icache entries (one or two instructions each) held
+        SIZE : positive := 16
+        );
+    port (
+        clk         : in std_ulogic;
+        rst         : in std_ulogic;
+
+        flush_in    : in std_ulogic;
+        redirect_in : in std_ulogic;  -- decode1 is redirecting fetch1
+        busy_in     : in std_ulogic;  -- decode1 isn't taking i_out
+        stop_in     : in std_ulogic;
+
+        i_in        : in IcacheToDecode1Type;
+        i_out       : out IcacheToDecode1Type;
+
+        -- decode1's redirects, passed on to fetch1 along with our own
+        d_in        : in Decode1ToFetch1Type;
+        f_out       : out Decode1ToFetch1Type;
+
+        busy_out    : out std_ulogic;  -- replaying, fetch1 and icache hold
+        flush_out   : out std_ulogic;
+
+        events      : out LoopBufferEventType
+        );
+end entity loop_buffer;
+
+architecture behaviour of loop_buffer is
+    type state_t is (IDLE, CAPTURE, REPLAY);
+
+    subtype lb_index_t is integer range 0 to SIZE - 1;
+    type lb_array_t is array(lb_index_t) of IcacheToDecode1Type;
+
+    type reg_t is record
+        state        : state_t;
+        -- the last entry decode1 took, and whether it could close a loop
+        prev_valid   : std_ulogic;
+        prev_nia     : std_ulogic_vector(63 downto 0);
+        prev_close   : std_ulogic;
+        -- loop being captured or replayed
+        start        : std_ulogic_vector(63 downto 0);
+        start_dual   : std_ulogic;
+        next_nia     : std_ulogic_vector(63 downto 0);
+        count        : integer range 0 to SIZE;
+        idx          : lb_index_t;
+        redirect     : std_ulogic;
+        redirect_nia : std_ulogic_vector(63 downto 0);
+        hit          : std_ulogic;
+    end record;
+    constant reg_init : reg_t := (state => IDLE, prev_nia => (others => '0'),
+                                  start => (others => '0'), next_nia => (others => '0'),
+                                  count => 0, idx => 0, redirect_nia => (others => '0'),
+                                  others => '0');
+
+    signal r, rin : reg_t;
+
+    signal buf     : lb_array_t;
+    signal buf_we  : std_ulogic;
+    signal buf_idx : lb_index_t;
+    signal buf_in  : IcacheToDecode1Type;
+
+    function is_branch(icode : insn_code_t) return boolean is
+    begin
+        case icode is
+            when INSN_brel | INSN_babs | INSN_bcrel | INSN_bcabs |
+                INSN_bcctr | INSN_bclr | INSN_bctar =>
+                return true;
+            when others =>
+                return false;
+        end case;
+    end;
+
+    function is_rel_branch(icode : insn_code_t) return std_ulogic is
+    begin
+        if icode = INSN_brel or icode = INSN_bcrel then
+            return '1';
+        end if;
+        return '0';
+    end;
+
+    -- Address of the entry after e when fetching sequentially
+    function entry_next(e : IcacheToDecode1Type) return std_ulogic_vector is
+    begin
+        if e.dual = '1' then
+            return std_ulogic_vector(unsigned(e.nia) + 8);
+        end if;
+        return std_ulogic_vector(unsigned(e.nia) + 4);
+    end;
+
+begin
+    lb_sync : process(clk)
+    begin
+        if rising_edge(clk) then
+            if rst = '1' then
+                r <= reg_init;
+            else
+                r <= rin;
+            end if;
+            if buf_we = '1' then
+                buf(buf_idx) <= buf_in;
+            end if;
+        end if;
+    end process;
+
+    lb_comb : process(all)
+        variable v     : reg_t;
+        variable o     : IcacheToDecode1Type;
+        variable take  : std_ulogic;
+        variable close : std_ulogic;
+        variable ok    : std_ulogic;
+        variable leave : std_ulogic;
+    begin
+        v := r;
+        v.redirect := '0';
+        v.hit := '0';
+        leave := '0';
+        buf_we <= '0';
+        buf_idx <= 0;
+
+        if r.state = REPLAY then
+            o := buf(r.idx);
+            o.valid := '1';
+            if r.idx = r.count - 1 then
+                -- the loop's own branch
+                o.next_predicted := '1';
+                o.next_pred_ntaken := '0';
+                o.pred_slot := o.dual;
+            end if;
+        else
+            o := i_in;
+            if r.redirect = '1' then
+                o.valid := '0';
+                o.fetch_failed := '0';
+            end if;
+        end if;
+        buf_in <= o;
+        take := o.valid and not busy_in;
+        ok := not o.stop_mark and not o.fetch_failed and not stop_in;
+
+        -- Can o be the end of a loop?  Its last instruction must be a
+        -- relative branch that is being predicted taken, and any other
+        -- instruction in it must not be a branch.
+        if o.dual = '0' then
+            close := is_rel_branch(o.icode);
+        elsif not is_branch(o.icode) then
+            close := is_rel_branch(o.icode2);
+        else
+            close := '0';
+        end if;
+        close := close and ok and
+                 (redirect_in or (o.next_predicted and (o.pred_slot or not o.dual)));
+
+        case r.state is
+            when IDLE =>
+            when CAPTURE =>
+                if take = '1' then
+                    if ok = '1' and o.nia = r.next_nia and r.count < SIZE then
+                        buf_we <= '1';
+                        buf_idx <= r.count;
+                        v.count := r.count + 1;
+                        v.next_nia := entry_next(o);
+                    elsif ok = '1' and o.nia = r.start and o.dual = r.start_dual and
+                        r.prev_close = '1' and redirect_in = '0' and
+                        (o.next_predicted = '0' or r.count = 1) then
+                        -- decode1 takes the loop head from the icache this
+                        -- time, the rest comes from the buffer.  The head
+                        -- mustn't be predicted taken unless it is the whole
+                        -- loop, else the buffer would be on the wrong path.
+                        v.state := REPLAY;
+                        if r.count = 1 then
+                            v.idx := 0;
+                        else
+                            v.idx := 1;
+                        end if;
+                    else
+                        v.state := IDLE;
+                    end if;
+                end if;
+            when REPLAY =>
+                if take = '1' then
+                    v.hit := '1';
+                    if r.idx = r.count - 1 then
+                        v.idx := 0;
+                    else
+                        v.idx := r.idx + 1;
+                    end if;
+                    if stop_in = '1' then
+                        leave := '1';
+                        v.state := IDLE;
+                        v.redirect := '1';
+                        v.redirect_nia := buf(v.idx).nia;
+                    end if;
+                end if;
+        end case;
+
+        -- Start capturing at the target of a backward branch
+        if r.state /= REPLAY and v.state = IDLE and take = '1' and ok = '1' and
+            r.prev_valid = '1' and r.prev_close = '1' and
+            unsigned(o.nia) < unsigned(r.prev_nia) and
+            unsigned(r.prev_nia) - unsigned(o.nia) < to_unsigned(4 * SIZE, 64) then
+            buf_we <= '1';
+            buf_idx <= 0;
+            v.state := CAPTURE;
+            v.start := o.nia;
+            v.start_dual := o.dual;
+            v.count := 1;
+            v.next_nia := entry_next(o);
+        end if;
+
+        if take = '1' then
+            v.prev_valid := '1';
+            v.prev_nia := o.nia;
+            v.prev_close := close;
+        end if;
+
+        if flush_in = '1' or (redirect_in = '1' and r.state = REPLAY) then
+            v.state := IDLE;
+            v.prev_valid := '0';
+            v.redirect := '0';
+            leave := '0';
+        end if;
+
+        rin <= v;
+
+        i_out <= o;
+        f_out <= d_in;
+        if r.redirect = '1' then
+            f_out.redirect <= '1';
+            f_out.redirect_nia <= r.redirect_nia;
+        end if;
+        if r.state = REPLAY and flush_in = '0' and redirect_in = '0' and leave = '0' then
+            busy_out <= '1';
+        else
+            busy_out <= '0';
+        end if;
+        flush_out <= leave or r.redirect;
+        events.hit <= r.hit;
+    end process;
+
+end architecture behaviour;
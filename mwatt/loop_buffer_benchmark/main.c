@@ -0,0 +1,126 @@
+#include "console.h"
+#include "io.h"
+#include "microwatt_soc.h"
+
+#include "pmu.h"
+#include "time.h"
+
+/*
+ * Loop buffer benchmark (core HAS_LOOP_BUFFER, off by default; run core_tb
+ * with -gHAS_LOOP_BUFFER=true).
+ *
+ * Runs a checksum loop and a copy loop, both short enough to be
+ * replayed from the loop buffer, and a copy loop unrolled so far that
+ * its body doesn't fit.  Each loop reports PMU run cycles, dispatched
+ * instructions and the number of icache entries decode1 took from the
+ * loop buffer instead of the icache.
+ */
+
+#define WORDS     512
+#define REPS      16
+
+static uint64_t src[WORDS];
+static uint64_t dst[WORDS];
+
+static uint64_t __attribute__((noinline)) sum_loop(void)
+{
+  const uint64_t *p = src;
+  uint64_t sum = 0;
+  long n = WORDS;
+
+  __asm__ volatile("mtctr %2\n"
+                   "1:\tld 9,0(%1)\n\t"
+                   "addi %1,%1,8\n\t"
+                   "add %0,%0,9\n\t"
+                   "bdnz 1b"
+                   : "+r"(sum), "+b"(p) : "r"(n) : "r9", "ctr");
+  return sum;
+}
+
+static uint64_t __attribute__((noinline)) copy_loop(void)
+{
+  const uint64_t *s = src;
+  uint64_t *d = dst;
+  long n = WORDS / 2;
+
+  __asm__ volatile("mtctr %2\n"
+                   "1:\tld 9,0(%0)\n\t"
+                   "ld 10,8(%0)\n\t"
+                   "addi %0,%0,16\n\t"
+                   "std 9,0(%1)\n\t"
+                   "std 10,8(%1)\n\t"
+                   "addi %1,%1,16\n\t"
+                   "bdnz 1b"
+                   : "+b"(s), "+b"(d) : "r"(n) : "r9", "r10", "ctr", "memory");
+  return dst[WORDS - 1];
+}
+
+#define COPY4(o) \
+  "ld 9," #o "(%0)\n\t" "ld 10," #o "+8(%0)\n\t" \
+  "std 9," #o "(%1)\n\t" "std 10," #o "+8(%1)\n\t"
+
+static uint64_t __attribute__((noinline)) unrolled_copy_loop(void)
+{
+  const uint64_t *s = src;
+  uint64_t *d = dst;
+  long n = WORDS / 16;
+
+  __asm__ volatile("mtctr %2\n"
+                   "1:\t"
+                   COPY4(0) COPY4(16) COPY4(32) COPY4(48)
+                   COPY4(64) COPY4(80) COPY4(96) COPY4(112)
+                   "addi %0,%0,128\n\t"
+                   "addi %1,%1,128\n\t"
+                   "bdnz 1b"
+                   : "+b"(s), "+b"(d) : "r"(n) : "r9", "r10", "ctr", "memory");
+  return dst[WORDS - 1];
+}
+
+static void run(const char *name, uint64_t (*fn)(void))
+{
+  volatile uint64_t sink;
+  uint64_t cycles, insns, hits;
+  int i;
+
+  /* Once to get the code and data into the caches */
+  sink = fn();
+  pmu_start(PMU_MMCR1(PMU_EV1_CYCLES, PMU_EV2_DISPATCH, PMU_EV3_LOOP_BUF_HIT, 0));
+  for (i = 0; i < REPS; i++)
+    sink = fn();
+  pmu_stop();
+
+  cycles = pmu_read(1);
+  insns = pmu_read(2);
+  hits = pmu_read(3);
+
+  puts(name);
+  puts(": cycles ");
+  print_uint64(cycles);
+  puts(" dispatched ");
+  print_uint64(insns);
+  puts(" loop buffer ");
+  print_uint64(hits);
+  puts(" sum ");
+  print_uint64(sink);
+  puts("\n");
+}
+
+int main(void)
+{
+  unsigned long i;
+
+  console_init();
+
+  for (i = 0; i < WORDS; i++)
+    src[i] = i;
+
+  run("checksum        ", sum_loop);
+  run("copy            ", copy_loop);
+  run("copy, unrolled  ", unrolled_copy_loop);
+
+  return 0;
+}
+
+void secondary_main(void)
+{
+}
@@ -0,0 +1,246 @@
+library vunit_lib;
+context vunit_lib.vunit_context;
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library work;
+use work.common.all;
+use work.decode_types.all;
+
+entity loop_buffer_tb is
+    generic (runner_cfg : string := runner_cfg_default);
+end loop_buffer_tb;
+
+architecture behave of loop_buffer_tb is
+    constant clk_period : time := 10 ns;
+
+    -- A run of addi, with a four instruction loop at LOOP_START whose
+    -- bc back to LOOP_START the BTC predicts taken while btc_taken = 1
+    constant FETCH_START : std_ulogic_vector(63 downto 0) := x"00000000000000f0";
+    constant LOOP_START  : std_ulogic_vector(63 downto 0) := x"0000000000000100";
+    constant LOOP_BRANCH : std_ulogic_vector(63 downto 0) := x"000000000000010c";
+    constant LOOP_EXIT   : std_ulogic_vector(63 downto 0) := x"0000000000000110";
+    constant ELSEWHERE   : std_ulogic_vector(63 downto 0) := x"0000000000000200";
+
+    signal clk         : std_ulogic;
+    signal rst         : std_ulogic := '1';
+    signal flush_in    : std_ulogic := '0';
+    signal redirect_in : std_ulogic := '0';
+    signal stop_in     : std_ulogic := '0';
+    signal i_in        : IcacheToDecode1Type;
+    signal i_out       : IcacheToDecode1Type;
+    signal d_in        : Decode1ToFetch1Type := (redirect => '0', redirect_nia => (others => '0'));
+    signal f_out       : Decode1ToFetch1Type;
+    signal busy_out    : std_ulogic;
+    signal flush_out   : std_ulogic;
+    signal events      : LoopBufferEventType;
+
+    -- fetch1 and icache stand-in
+    signal fpc       : std_ulogic_vector(63 downto 0);
+    signal fvalid    : std_ulogic;
+    signal btc_taken : std_ulogic := '1';
+    signal flush_nia : std_ulogic_vector(63 downto 0) := (others => '0');
+
+begin
+    loop_buffer_0: entity work.loop_buffer
+        generic map (
+            SIZE => 8
+            )
+        port map (
+            clk         => clk,
+            rst         => rst,
+            flush_in    => flush_in,
+            redirect_in => redirect_in,
+            busy_in     => '0',
+            stop_in     => stop_in,
+            i_in        => i_in,
+            i_out       => i_out,
+            d_in        => d_in,
+            f_out       => f_out,
+            busy_out    => busy_out,
+            flush_out   => flush_out,
+            events      => events
+            );
+
+    clk_process: process
+    begin
+        clk <= '0';
+        wait for clk_period/2;
+        clk <= '1';
+        wait for clk_period/2;
+    end process;
+
+    -- One instruction per icache entry.  Fetch holds while the loop
+    -- buffer is busy, has nothing after a flush from the loop buffer
+    -- until the redirect that follows it, and goes to flush_nia on
+    -- flush_in, as if execute1 had found the loop's branch not taken.
+    fetch_out: process(all)
+    begin
+        i_in <= IcacheToDecode1Init;
+        i_in.valid <= fvalid;
+        i_in.nia <= fpc;
+        if fpc = LOOP_BRANCH then
+            i_in.insn <= x"4200fff4";       -- bdnz .-12
+            i_in.icode <= INSN_bcrel;
+            i_in.next_predicted <= btc_taken;
+        else
+            i_in.insn <= x"38630001";       -- addi r3,r3,1
+            i_in.icode <= INSN_addi;
+        end if;
+    end process;
+
+    fetch: process(clk)
+    begin
+        if rising_edge(clk) then
+            if rst = '1' then
+                fpc <= FETCH_START;
+                fvalid <= '1';
+            elsif flush_in = '1' then
+                fpc <= flush_nia;
+                fvalid <= '1';
+            elsif f_out.redirect = '1' then
+                fpc <= f_out.redirect_nia;
+                fvalid <= '1';
+            elsif flush_out = '1' then
+                fvalid <= '0';
+            elsif busy_out = '0' and fvalid = '1' then
+                if fpc = LOOP_BRANCH and btc_taken = '1' then
+                    fpc <= LOOP_START;
+                else
+                    fpc <= std_ulogic_vector(unsigned(fpc) + 4);
+                end if;
+            end if;
+        end if;
+    end process;
+
+    stim: process
+        variable expect : std_ulogic_vector(63 downto 0);
+        variable hits   : natural;
+        variable busy   : natural;
+
+        -- The instruction after expect in program order
+        procedure advance is
+        begin
+            if expect = LOOP_BRANCH and btc_taken = '1' then
+                expect := LOOP_START;
+            else
+                expect := std_ulogic_vector(unsigned(expect) + 4);
+            end if;
+        end procedure;
+
+        -- Run n cycles, starting just after a falling edge, checking that
+        -- decode1 is given the program in order wherever it comes from
+        procedure run_cycles(n : natural) is
+        begin
+            for i in 1 to n loop
+                wait for 1 ns;
+                if i_out.valid = '1' then
+                    check_equal(i_out.nia, expect, result("for next instruction"));
+                    advance;
+                end if;
+                if events.hit = '1' then
+                    hits := hits + 1;
+                end if;
+                if busy_out = '1' then
+                    busy := busy + 1;
+                end if;
+                wait until falling_edge(clk);
+            end loop;
+        end procedure;
+
+    begin
+        test_runner_setup(runner, runner_cfg);
+
+        while test_suite loop
+            rst <= '1';
+            btc_taken <= '1';
+            wait for 3 * clk_period;
+            wait until falling_edge(clk);
+            rst <= '0';
+            expect := FETCH_START;
+            hits := 0;
+            busy := 0;
+
+            if run("Test replay of a loop") then
+                run_cycles(40);
+                check(busy > 0, "loop buffer never replayed");
+                check(hits > 0, "no loop buffer hit events");
+                check_equal(busy_out, '1', "replaying at the end");
+
+            elsif run("Test leaving replay on a flush") then
+                run_cycles(30);
+                check_equal(busy_out, '1', "replaying before the flush");
+
+                -- the loop's branch falls through
+                flush_in <= '1';
+                flush_nia <= LOOP_EXIT;
+                btc_taken <= '0';
+                wait for 1 ns;
+                check_equal(busy_out, '0', "busy during the flush");
+                wait until falling_edge(clk);
+                flush_in <= '0';
+
+                expect := LOOP_EXIT;
+                busy := 0;
+                run_cycles(20);
+                check_equal(busy, 0, "busy after the flush");
+                check(unsigned(expect) > unsigned(LOOP_EXIT), "nothing fetched after the flush");
+
+            elsif run("Test leaving replay on a decode1 redirect") then
+                run_cycles(30);
+                check_equal(busy_out, '1', "replaying before the redirect");
+
+                -- decode1 predicts a branch taken and redirects fetch1
+                redirect_in <= '1';
+                d_in <= (redirect => '1', redirect_nia => ELSEWHERE);
+                wait for 1 ns;
+                check_equal(busy_out, '0', "busy during the redirect");
+                check_equal(f_out.redirect, '1', "redirect not passed to fetch1");
+                check_equal(f_out.redirect_nia, ELSEWHERE, "redirect address");
+                wait until falling_edge(clk);
+                redirect_in <= '0';
+                d_in.redirect <= '0';
+
+                expect := ELSEWHERE;
+                busy := 0;
+                run_cycles(20);
+                check_equal(busy, 0, "busy after the redirect");
+                check(unsigned(expect) > unsigned(ELSEWHERE), "nothing fetched after the redirect");
+
+            elsif run("Test leaving replay on a debug stop") then
+                run_cycles(30);
+                check_equal(busy_out, '1', "replaying before the stop");
+
+                -- decode1 takes one more instruction from the buffer, then
+                -- the buffer sends fetch1 to the one after it
+                stop_in <= '1';
+                wait for 1 ns;
+                check_equal(i_out.valid, '1', "no instruction as the stop arrives");
+                check_equal(i_out.nia, expect, "instruction as the stop arrives");
+                advance;
+                check_equal(busy_out, '0', "busy on the stop");
+                check_equal(flush_out, '1', "fetch1 not flushed on the stop");
+                wait until falling_edge(clk);
+                wait for 1 ns;
+                check_equal(i_out.valid, '0', "instruction during the redirect");
+                check_equal(f_out.redirect, '1', "fetch1 not redirected after the stop");
+                check_equal(f_out.redirect_nia, expect, "redirect address after the stop");
+                wait until falling_edge(clk);
+
+                -- nothing is captured while stopped
+                busy := 0;
+                run_cycles(20);
+                check_equal(busy, 0, "busy while stopped");
+
+                -- and the loop is picked up again after
+                stop_in <= '0';
+                run_cycles(30);
+                check(busy > 0, "loop not replayed after the stop");
+            end if;
+        end loop;
+
+        test_runner_cleanup(runner);
+    end process;
+end behave;
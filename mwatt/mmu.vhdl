@@ -3,13 +3,28 @@ use ieee.std_logic_1164.all;
 use ieee.numeric_std.all;
 
 library work;
+use work.utils.all;
 use work.common.all;
 
 -- Radix MMU
 -- Supports 4-level trees as in arch 3.0B, but not the two-step translation for
 -- guests under a hypervisor (i.e. there is no gRA -> hRA translation).
+--
+-- Leaf PTEs found by table walks are kept in a second-level TLB shared by
+-- the instruction and data sides, and the PDE pointing to the last level
+-- of the tree is kept in a small page walk cache, so that most L1 TLB
+-- misses don't need a full walk.  Both are flushed by any tlbie, slbia
+-- or write to PID or PTCR.
 
 entity mmu is
+    generic (
+        -- L2 TLB entries for 4kB pages (direct mapped, 0 to disable)
+        L2TLB_SIZE       : natural := 64;
+        -- L2 TLB entries for 64kB, 2MB and 1GB pages (fully associative)
+        L2TLB_LARGE_SIZE : natural := 8;
+        -- Page walk cache entries (fully associative)
+        PWC_SIZE         : natural := 4
+        );
     port (
         clk   : in std_ulogic;
         rst   : in std_ulogic;
@@ -71,10 +86,66 @@ architecture behave of mmu is
         segerror  : std_ulogic;
         perm_err  : std_ulogic;
         rc_error  : std_ulogic;
+        from_l2   : std_ulogic;
     end record;
 
     signal r, rin : reg_stage_t;
 
+    -- L2 TLB and page walk cache lookup results for r.addr
+    signal l2_hit     : std_ulogic;
+    signal l2_pte     : std_ulogic_vector(63 downto 0);
+    signal l2_shift   : unsigned(5 downto 0);
+    signal l2s_hit    : std_ulogic;
+    signal l2s_pte    : std_ulogic_vector(63 downto 0);
+    signal l2l_hit    : std_ulogic;
+    signal l2l_shift  : unsigned(5 downto 0);
+    signal l2l_pte    : std_ulogic_vector(63 downto 0);
+    signal pwc_hit    : std_ulogic;
+    signal pwc_pgbase : std_ulogic_vector(55 downto 0);
+    signal pwc_msize  : unsigned(4 downto 0);
+    signal pwc_shift  : unsigned(5 downto 0);
+
+    -- L2 TLB and page walk cache updates
+    signal l2_wr      : std_ulogic;
+    signal l2_inval   : std_ulogic;
+    signal pwc_wr     : std_ulogic;
+    signal walk_flush : std_ulogic;
+
+    -- Check the permission and reference/change bits of a leaf PTE,
+    -- returning perm_ok & rc_ok.
+    function leaf_check(pte : std_ulogic_vector(63 downto 0);
+                        priv, iside, store : std_ulogic) return std_ulogic_vector is
+        variable perm_ok : std_ulogic;
+        variable rc_ok   : std_ulogic;
+    begin
+        perm_ok := '0';
+        if priv = '1' or pte(3) = '0' then
+            if iside = '0' then
+                perm_ok := pte(1) or (pte(2) and not store);
+            else
+                -- no IAMR, so no KUEP support for now
+                -- deny execute permission if cache inhibited
+                perm_ok := pte(0) and not pte(5);
+            end if;
+        end if;
+        rc_ok := pte(8) and (pte(7) or not store);
+        return perm_ok & rc_ok;
+    end;
+
+    -- Mask selecting the EA bits above a region of 2^(12 + shift) bytes
+    function region_mask(shift : unsigned(5 downto 0)) return std_ulogic_vector is
+        variable m : std_ulogic_vector(63 downto 12);
+    begin
+        for i in 12 to 63 loop
+            if i - 12 >= to_integer(shift) then
+                m(i) := '1';
+            else
+                m(i) := '0';
+            end if;
+        end loop;
+        return m;
+    end;
+
     signal addrsh  : std_ulogic_vector(15 downto 0);
     signal mask    : std_ulogic_vector(15 downto 0);
     signal finalmask : std_ulogic_vector(43 downto 0);
@@ -191,6 +262,201 @@ begin
         finalmask <= m;
     end process;
 
+    -- L2 TLB for 4kB pages, direct mapped
+    l2tlb_small : if L2TLB_SIZE > 0 generate
+        constant SET_BITS : natural := log2(L2TLB_SIZE);
+        subtype tag_t is std_ulogic_vector(63 downto 12 + SET_BITS);
+        type tags_t is array(0 to L2TLB_SIZE - 1) of tag_t;
+        type ptes_t is array(0 to L2TLB_SIZE - 1) of std_ulogic_vector(63 downto 0);
+        signal valids : std_ulogic_vector(L2TLB_SIZE - 1 downto 0);
+        signal tags   : tags_t;
+        signal ptes   : ptes_t;
+        attribute ram_style : string;
+        attribute ram_style of tags : signal is "distributed";
+        attribute ram_style of ptes : signal is "distributed";
+    begin
+        l2s_lookup : process(all)
+            variable idx : std_ulogic_vector(SET_BITS - 1 downto 0);
+        begin
+            idx := r.addr(12 + SET_BITS - 1 downto 12);
+            l2s_hit <= '0';
+            l2s_pte <= (others => '0');
+            if not is_X(idx) then
+                l2s_pte <= ptes(to_integer(unsigned(idx)));
+                if valids(to_integer(unsigned(idx))) = '1' and
+                    tags(to_integer(unsigned(idx))) = r.addr(63 downto 12 + SET_BITS) then
+                    l2s_hit <= '1';
+                end if;
+            end if;
+        end process;
+
+        l2s_update : process(clk)
+            variable idx : std_ulogic_vector(SET_BITS - 1 downto 0);
+        begin
+            if rising_edge(clk) then
+                idx := r.addr(12 + SET_BITS - 1 downto 12);
+                if rst = '1' or walk_flush = '1' then
+                    valids <= (others => '0');
+                elsif l2_inval = '1' and l2s_hit = '1' then
+                    valids(to_integer(unsigned(idx))) <= '0';
+                elsif l2_wr = '1' and r.shift = 0 then
+                    assert not is_X(idx) report "L2 TLB index invalid on write" severity FAILURE;
+                    tags(to_integer(unsigned(idx))) <= r.addr(63 downto 12 + SET_BITS);
+                    ptes(to_integer(unsigned(idx))) <= r.pde;
+                    valids(to_integer(unsigned(idx))) <= '1';
+                end if;
+            end if;
+        end process;
+    end generate;
+
+    no_l2tlb_small : if L2TLB_SIZE = 0 generate
+        l2s_hit <= '0';
+        l2s_pte <= (others => '0');
+    end generate;
+
+    -- L2 TLB for 64kB, 2MB and 1GB pages, fully associative, round-robin
+    -- replacement
+    l2tlb_large : if L2TLB_LARGE_SIZE > 0 generate
+        type entry_t is record
+            valid : std_ulogic;
+            large : std_ulogic;         -- 2MB
+            huge  : std_ulogic;         -- 1GB
+            tag   : std_ulogic_vector(63 downto 16);
+            pte   : std_ulogic_vector(63 downto 0);
+        end record;
+        type entries_t is array(0 to L2TLB_LARGE_SIZE - 1) of entry_t;
+        signal entries : entries_t;
+        signal repl    : integer range 0 to L2TLB_LARGE_SIZE - 1;
+
+        function entry_match(e : entry_t; addr : std_ulogic_vector(63 downto 0)) return boolean is
+        begin
+            return e.tag(63 downto 30) = addr(63 downto 30) and
+                (e.huge = '1' or (e.tag(29 downto 21) = addr(29 downto 21) and
+                                  (e.large = '1' or e.tag(20 downto 16) = addr(20 downto 16))));
+        end;
+    begin
+        l2l_lookup : process(all)
+        begin
+            l2l_hit <= '0';
+            l2l_shift <= to_unsigned(4, 6);
+            l2l_pte <= (others => '0');
+            for i in 0 to L2TLB_LARGE_SIZE - 1 loop
+                if entries(i).valid = '1' and entry_match(entries(i), r.addr) then
+                    l2l_hit <= '1';
+                    if entries(i).huge = '1' then
+                        l2l_shift <= to_unsigned(18, 6);
+                    elsif entries(i).large = '1' then
+                        l2l_shift <= to_unsigned(9, 6);
+                    end if;
+                    l2l_pte <= entries(i).pte;
+                end if;
+            end loop;
+        end process;
+
+        l2l_update : process(clk)
+        begin
+            if rising_edge(clk) then
+                if rst = '1' or walk_flush = '1' then
+                    for i in 0 to L2TLB_LARGE_SIZE - 1 loop
+                        entries(i).valid <= '0';
+                    end loop;
+                    repl <= 0;
+                elsif l2_inval = '1' then
+                    for i in 0 to L2TLB_LARGE_SIZE - 1 loop
+                        if entry_match(entries(i), r.addr) then
+                            entries(i).valid <= '0';
+                        end if;
+                    end loop;
+                elsif l2_wr = '1' and (r.shift = 4 or r.shift = 9 or r.shift = 18) then
+                    entries(repl).valid <= '1';
+                    entries(repl).large <= r.shift(0);
+                    entries(repl).huge <= r.shift(4);
+                    entries(repl).tag <= r.addr(63 downto 16);
+                    entries(repl).pte <= r.pde;
+                    if repl = L2TLB_LARGE_SIZE - 1 then
+                        repl <= 0;
+                    else
+                        repl <= repl + 1;
+                    end if;
+                end if;
+            end if;
+        end process;
+    end generate;
+
+    no_l2tlb_large : if L2TLB_LARGE_SIZE = 0 generate
+        l2l_hit <= '0';
+        l2l_shift <= (others => '0');
+        l2l_pte <= (others => '0');
+    end generate;
+
+    l2_hit <= l2s_hit or l2l_hit;
+    l2_pte <= l2s_pte when l2s_hit = '1' else l2l_pte;
+    l2_shift <= to_unsigned(0, 6) when l2s_hit = '1' else l2l_shift;
+
+    -- Page walk cache, holding the PDE that points to the last level of
+    -- the tree for a region of 2^(12 + region) bytes.
+    pwc : if PWC_SIZE > 0 generate
+        type entry_t is record
+            valid     : std_ulogic;
+            tag       : std_ulogic_vector(63 downto 12);
+            region    : unsigned(5 downto 0);
+            pgbase    : std_ulogic_vector(55 downto 0);
+            mask_size : unsigned(4 downto 0);
+            shift     : unsigned(5 downto 0);
+        end record;
+        type entries_t is array(0 to PWC_SIZE - 1) of entry_t;
+        signal entries : entries_t;
+        signal repl    : integer range 0 to PWC_SIZE - 1;
+    begin
+        pwc_lookup : process(all)
+        begin
+            pwc_hit <= '0';
+            pwc_pgbase <= (others => '0');
+            pwc_msize <= (others => '0');
+            pwc_shift <= (others => '0');
+            for i in 0 to PWC_SIZE - 1 loop
+                if entries(i).valid = '1' and
+                    (r.addr(63 downto 12) and region_mask(entries(i).region)) = entries(i).tag then
+                    pwc_hit <= '1';
+                    pwc_pgbase <= entries(i).pgbase;
+                    pwc_msize <= entries(i).mask_size;
+                    pwc_shift <= entries(i).shift;
+                end if;
+            end loop;
+        end process;
+
+        pwc_update : process(clk)
+        begin
+            if rising_edge(clk) then
+                if rst = '1' or walk_flush = '1' then
+                    for i in 0 to PWC_SIZE - 1 loop
+                        entries(i).valid <= '0';
+                    end loop;
+                    repl <= 0;
+                elsif pwc_wr = '1' then
+                    entries(repl).valid <= '1';
+                    entries(repl).tag <= r.addr(63 downto 12) and region_mask(r.shift);
+                    entries(repl).region <= r.shift;
+                    entries(repl).pgbase <= rin.pgbase;
+                    entries(repl).mask_size <= rin.mask_size;
+                    entries(repl).shift <= rin.shift;
+                    if repl = PWC_SIZE - 1 then
+                        repl <= 0;
+                    else
+                        repl <= repl + 1;
+                    end if;
+                end if;
+            end if;
+        end process;
+    end generate;
+
+    no_pwc : if PWC_SIZE = 0 generate
+        pwc_hit <= '0';
+        pwc_pgbase <= (others => '0');
+        pwc_msize <= (others => '0');
+        pwc_shift <= (others => '0');
+    end generate;
+
     mmu_1: process(all)
         variable v : reg_stage_t;
         variable dcreq : std_ulogic;
@@ -211,6 +477,9 @@ begin
         variable pgtbl : std_ulogic_vector(63 downto 0);
         variable perm_ok : std_ulogic;
         variable rc_ok : std_ulogic;
+        variable leaf_ok : std_ulogic_vector(1 downto 0);
+        variable large : std_ulogic;
+        variable huge : std_ulogic;
         variable addr : std_ulogic_vector(63 downto 0);
         variable data : std_ulogic_vector(63 downto 0);
     begin
@@ -230,6 +499,9 @@ begin
         v.inval_all := '0';
         ptbl_rd := '0';
         prtbl_rd := '0';
+        l2_wr <= '0';
+        l2_inval <= '0';
+        pwc_wr <= '0';
 
         -- Radix tree data structures in memory are big-endian,
         -- so we need to byte-swap them
@@ -257,6 +529,7 @@ begin
 
             if l_in.valid = '1' then
                 v.addr := l_in.addr;
+                v.from_l2 := '0';
                 v.iside := l_in.iside;
                 v.store := not (l_in.load or l_in.iside);
                 v.priv := l_in.priv;
@@ -378,7 +651,24 @@ begin
             elsif mbits < 5 or mbits > 16 or mbits > (r.shift + (31 - 12)) then
                 v.state := RADIX_FINISH;
                 v.badtree := '1';
+            elsif l2_hit = '1' and leaf_check(l2_pte, r.priv, r.iside, r.store) = "11" then
+                -- Leaf PTE is in the L2 TLB, no walk needed
+                v.pde := l2_pte;
+                v.shift := l2_shift;
+                v.from_l2 := '1';
+                v.state := RADIX_LOAD_TLB;
             else
+                -- An L2 TLB entry that fails the permission or RC check
+                -- may be stale (the OS may have set R/C or widened the
+                -- permissions since), so drop it and walk the tree; the
+                -- error is only reported if the PTE in memory fails too.
+                l2_inval <= l2_hit;
+                if pwc_hit = '1' then
+                    -- Start the walk at the last level of the tree
+                    v.pgbase := pwc_pgbase;
+                    v.mask_size := pwc_msize;
+                    v.shift := pwc_shift;
+                end if;
                 v.state := RADIX_LOOKUP;
             end if;
 
@@ -394,17 +684,9 @@ begin
                     -- test leaf bit
                     if data(62) = '1' then
                         -- check permissions and RC bits
-                        perm_ok := '0';
-                        if r.priv = '1' or data(3) = '0' then
-                            if r.iside = '0' then
-                                perm_ok := data(1) or (data(2) and not r.store);
-                            else
-                                -- no IAMR, so no KUEP support for now
-                                -- deny execute permission if cache inhibited
-                                perm_ok := data(0) and not data(5);
-                            end if;
-                        end if;
-                        rc_ok := data(8) and (data(7) or not r.store);
+                        leaf_ok := leaf_check(data, r.priv, r.iside, r.store);
+                        perm_ok := leaf_ok(1);
+                        rc_ok := leaf_ok(0);
                         if perm_ok = '1' and rc_ok = '1' then
                             v.state := RADIX_LOAD_TLB;
                         else
@@ -423,6 +705,12 @@ begin
                             v.mask_size := mbits(4 downto 0);
                             v.pgbase := data(55 downto 8) & x"00";
                             v.state := RADIX_LOOKUP;
+                            -- Remember pointers to the last level of the tree.
+                            -- A directory translates at least 5 bits, so a
+                            -- shift under 5 (4kB or 64kB pages) is the last.
+                            if v.shift < 5 then
+                                pwc_wr <= '1';
+                            end if;
                         end if;
                     end if;
                 else
@@ -438,6 +726,7 @@ begin
 
         when RADIX_LOAD_TLB =>
             tlb_load := '1';
+            l2_wr <= not r.from_l2;
             if r.iside = '0' then
                 dcreq := '1';
                 v.state := TLB_WAIT;
@@ -473,6 +762,15 @@ begin
                ((r.pde(55 downto 12) and not finalmask) or (r.addr(55 downto 12) and finalmask))
                & r.pde(11 downto 0);
 
+        -- page size of the PTE being loaded into the L1 TLBs
+        large := '0';
+        huge := '0';
+        if r.shift = 9 then
+            large := '1';
+        elsif r.shift = 18 then
+            huge := '1';
+        end if;
+
         -- update registers
         rin <= v;
 
@@ -508,12 +806,18 @@ begin
         d_out.tlbld <= tlb_load;
         d_out.addr <= addr;
         d_out.pte <= tlb_data;
+        d_out.large <= tlb_load and large;
+        d_out.huge <= tlb_load and huge;
 
         i_out.tlbld <= itlb_load;
         i_out.tlbie <= tlbie_req;
         i_out.doall <= r.inval_all;
         i_out.addr <= addr;
         i_out.pte <= tlb_data;
+        i_out.large <= itlb_load and large;
+        i_out.huge <= itlb_load and huge;
+
+        walk_flush <= tlbie_req;
 
     end process;
 end;
@@ -0,0 +1,147 @@
+#include "console.h"
+#include "io.h"
+#include "microwatt_soc.h"
+
+#include "pmu.h"
+#include "time.h"
+
+/*
+ * Integer multiply benchmark.
+ *
+ * Times dependent chains and four interleaved independent chains of
+ * mullw, of mulld with operands that fit in 32 bits (which take the
+ * 1-cycle 32-bit multiplier), of mulld with full 64-bit operands and of
+ * mulhdu, and prints the average number of PMU run cycles per multiply.
+ * Compare builds with different MUL_PIPELINE_DEPTH values.
+ */
+
+#define OPS 256
+
+static unsigned int __attribute__((noinline)) mullw_dep(unsigned int x, unsigned int y)
+{
+  int i;
+
+  for (i = 0; i < OPS; i++)
+    x = x * y;
+  return x;
+}
+
+static unsigned int __attribute__((noinline)) mullw_indep(unsigned int x, unsigned int y)
+{
+  unsigned int a = x, b = x + 1, c = x + 2, d = x + 3;
+  int i;
+
+  for (i = 0; i < OPS; i += 4) {
+    a = a * y;
+    b = b * y;
+    c = c * y;
+    d = d * y;
+  }
+  return a + b + c + d;
+}
+
+static long __attribute__((noinline)) mulld_small_dep(long x, long y)
+{
+  int i;
+
+  for (i = 0; i < OPS; i++)
+    x = (x * y) & 0xffff;
+  return x;
+}
+
+static long __attribute__((noinline)) mulld_small_indep(long x, long y)
+{
+  long a = x, b = x + 1, c = x + 2, d = x + 3;
+  int i;
+
+  for (i = 0; i < OPS; i += 4) {
+    a = (a * y) & 0xffff;
+    b = (b * y) & 0xffff;
+    c = (c * y) & 0xffff;
+    d = (d * y) & 0xffff;
+  }
+  return a + b + c + d;
+}
+
+static long __attribute__((noinline)) mulld_dep(long x, long y)
+{
+  int i;
+
+  for (i = 0; i < OPS; i++)
+    x = x * y;
+  return x;
+}
+
+static long __attribute__((noinline)) mulld_indep(long x, long y)
+{
+  long a = x, b = x + 1, c = x + 2, d = x + 3;
+  int i;
+
+  for (i = 0; i < OPS; i += 4) {
+    a = a * y;
+    b = b * y;
+    c = c * y;
+    d = d * y;
+  }
+  return a + b + c + d;
+}
+
+static long __attribute__((noinline)) mulhdu_dep(long x, long y)
+{
+  unsigned long v = x;
+  int i;
+
+  for (i = 0; i < OPS; i++)
+    v = ((unsigned __int128)(v | y) * (unsigned long)y) >> 64;
+  return v;
+}
+
+static void report(const char *name, uint64_t cycles)
+{
+  puts(name);
+  puts(": cycles/op ");
+  print_uint64(cycles / OPS);
+  puts("\n");
+}
+
+static void run32(const char *name, unsigned int (*fn)(unsigned int, unsigned int),
+                  unsigned int x, unsigned int y)
+{
+  volatile unsigned int sink;
+
+  pmu_start(PMU_MMCR1(PMU_EV1_CYCLES, 0, 0, 0));
+  sink = fn(x, y);
+  pmu_stop();
+  (void)sink;
+  report(name, pmu_read(1));
+}
+
+static void run64(const char *name, long (*fn)(long, long), long x, long y)
+{
+  volatile long sink;
+
+  pmu_start(PMU_MMCR1(PMU_EV1_CYCLES, 0, 0, 0));
+  sink = fn(x, y);
+  pmu_stop();
+  (void)sink;
+  report(name, pmu_read(1));
+}
+
+int main(void)
+{
+  console_init();
+
+  run32("mullw        dependent  ", mullw_dep, 3, 0x9e3779b9);
+  run32("mullw        independent", mullw_indep, 3, 0x9e3779b9);
+  run64("mulld small  dependent  ", mulld_small_dep, 3, 12345);
+  run64("mulld small  independent", mulld_small_indep, 3, 12345);
+  run64("mulld        dependent  ", mulld_dep, 3, 0x9e3779b97f4a7c15l);
+  run64("mulld        independent", mulld_indep, 3, 0x9e3779b97f4a7c15l);
+  run64("mulhdu       dependent  ", mulhdu_dep, 3, 0x9e3779b97f4a7c15l);
+
+  return 0;
+}
+
+void secondary_main(void)
+{
+}
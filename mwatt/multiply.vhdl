@@ -20,6 +20,23 @@ end entity multiply;
 architecture behaviour of multiply is
     signal m: MultiplyInputType := MultiplyInputInit;
 
+    -- With PIPELINE_DEPTH >= 2 the first stage just forms the four
+    -- 33x33 partial products of the high and low halves, and the
+    -- second stage adds them and the addend, so that no single stage
+    -- has a full 65x65 multiply in it.
+    type partial_products_type is record
+        valid    : std_ulogic;
+        subtract : std_ulogic;
+        addend   : std_ulogic_vector(127 downto 0);
+        hh       : signed(65 downto 0);
+        hl       : signed(65 downto 0);
+        lh       : signed(65 downto 0);
+        ll       : signed(65 downto 0);
+    end record;
+    constant PartialProductsInit : partial_products_type := (valid => '0', subtract => '0',
+                                                              addend => (others => '0'),
+                                                              others => (others => '0'));
+
     type multiply_pipeline_stage is record
         valid     : std_ulogic;
         data      : unsigned(127 downto 0);
@@ -28,16 +45,22 @@ architecture behaviour of multiply is
 								     data => (others => '0'));
 
     type multiply_pipeline_type is array(0 to PIPELINE_DEPTH-1) of multiply_pipeline_stage;
+    -- stage that the partial products get summed into
+    constant SUM_STAGE : natural := minimum(1, PIPELINE_DEPTH-1);
     constant MultiplyPipelineInit : multiply_pipeline_type := (others => MultiplyPipelineStageInit);
 
     type reg_type is record
+        pp                : partial_products_type;
         multiply_pipeline : multiply_pipeline_type;
     end record;
 
-    signal r, rin : reg_type := (multiply_pipeline => MultiplyPipelineInit);
+    signal r, rin : reg_type := (pp => PartialProductsInit,
+                                 multiply_pipeline => MultiplyPipelineInit);
     signal overflow : std_ulogic;
     signal ovf_in   : std_ulogic;
 begin
+    assert PIPELINE_DEPTH >= 1 report "PIPELINE_DEPTH must be at least 1" severity FAILURE;
+
     multiply_0: process(clk)
     begin
         if rising_edge(clk) then
@@ -50,7 +73,9 @@ begin
     multiply_1: process(all)
         variable v : reg_type;
         variable a, b : std_ulogic_vector(64 downto 0);
+        variable ah, al, bh, bl : signed(32 downto 0);
         variable prod : std_ulogic_vector(129 downto 0);
+        variable sum : signed(129 downto 0);
         variable d : std_ulogic_vector(127 downto 0);
         variable d2 : std_ulogic_vector(63 downto 0);
 	variable ov : std_ulogic;
@@ -58,15 +83,41 @@ begin
         v := r;
         a := (m.is_signed and m.data1(63)) & m.data1;
         b := (m.is_signed and m.data2(63)) & m.data2;
-        prod := std_ulogic_vector(signed(a) * signed(b));
-        v.multiply_pipeline(0).valid := m.valid;
-        if m.subtract = '1' then
-            v.multiply_pipeline(0).data := unsigned(m.addend) - unsigned(prod(127 downto 0));
+
+        if PIPELINE_DEPTH = 1 then
+            prod := std_ulogic_vector(signed(a) * signed(b));
+            v.multiply_pipeline(0).valid := m.valid;
+            if m.subtract = '1' then
+                v.multiply_pipeline(0).data := unsigned(m.addend) - unsigned(prod(127 downto 0));
+            else
+                v.multiply_pipeline(0).data := unsigned(m.addend) + unsigned(prod(127 downto 0));
+            end if;
         else
-            v.multiply_pipeline(0).data := unsigned(m.addend) + unsigned(prod(127 downto 0));
+            ah := signed(a(64 downto 32));
+            al := signed('0' & a(31 downto 0));
+            bh := signed(b(64 downto 32));
+            bl := signed('0' & b(31 downto 0));
+            v.pp.valid := m.valid;
+            v.pp.subtract := m.subtract;
+            v.pp.addend := m.addend;
+            v.pp.hh := ah * bh;
+            v.pp.hl := ah * bl;
+            v.pp.lh := al * bh;
+            v.pp.ll := al * bl;
+
+            sum := shift_left(resize(r.pp.hh, 130), 64) +
+                   shift_left(resize(r.pp.hl, 130) + resize(r.pp.lh, 130), 32) +
+                   resize(r.pp.ll, 130);
+            prod := std_ulogic_vector(sum);
+            v.multiply_pipeline(SUM_STAGE).valid := r.pp.valid;
+            if r.pp.subtract = '1' then
+                v.multiply_pipeline(SUM_STAGE).data := unsigned(r.pp.addend) - unsigned(prod(127 downto 0));
+            else
+                v.multiply_pipeline(SUM_STAGE).data := unsigned(r.pp.addend) + unsigned(prod(127 downto 0));
+            end if;
         end if;
 
-        loop_0: for i in 1 to PIPELINE_DEPTH-1 loop
+        loop_0: for i in 2 to PIPELINE_DEPTH-1 loop
             v.multiply_pipeline(i) := r.multiply_pipeline(i-1);
         end loop;
 
@@ -14,14 +14,15 @@ library osvvm;
 use osvvm.RandomPkg.all;
 
 entity multiply_tb is
-    generic (runner_cfg : string := runner_cfg_default);
+    generic (runner_cfg : string := runner_cfg_default;
+             PIPELINE_DEPTH : integer := 4);
 end multiply_tb;
 
 architecture behave of multiply_tb is
     signal clk              : std_ulogic;
     constant clk_period     : time := 10 ns;
 
-    constant pipeline_depth : integer := 4;
+    type result_array is array(0 to 15) of std_ulogic_vector(63 downto 0);
 
     signal m1               : MultiplyInputType := MultiplyInputInit;
     signal m2               : MultiplyOutputType;
@@ -43,6 +44,8 @@ begin
         variable ra, rb, rt, behave_rt: std_ulogic_vector(63 downto 0);
         variable si: std_ulogic_vector(15 downto 0);
         variable rnd : RandomPType;
+        variable exp_lo, exp_hi : result_array;
+        variable j : integer;
     begin
         rnd.InitSeed(stim_process'path_name);
 
@@ -61,11 +64,10 @@ begin
 
                 m1.valid <= '0';
 
-                wait for clk_period;
-                check_false(?? m2.valid, result("for valid"));
-
-                wait for clk_period;
-                check_false(?? m2.valid, result("for valid"));
+                for i in 1 to pipeline_depth-2 loop
+                    wait for clk_period;
+                    check_false(?? m2.valid, result("for valid"));
+                end loop;
 
                 wait for clk_period;
                 check_true(?? m2.valid, result("for valid"));
@@ -259,6 +261,41 @@ begin
                     check_true(?? m2.valid, result("for valid"));
                     check_equal(m2.result(63 downto 0), behave_rt, result("for mulli " & to_hstring(behave_rt)));
                 end loop;
+
+            elsif run("Test back-to-back") then
+                -- A new multiply every cycle, each result must come out
+                -- pipeline_depth cycles after it went in
+                b2b_loop : for i in 0 to 1000 + pipeline_depth - 1 loop
+                    if i <= 1000 then
+                        ra := rnd.RandSlv(ra'length);
+                        rb := rnd.RandSlv(rb'length);
+                        exp_lo(i mod 16) := ppc_mulld(ra, rb);
+                        exp_hi(i mod 16) := ppc_mulhd(ra, rb);
+
+                        m1.data1 <= ra;
+                        m1.data2 <= rb;
+                        m1.is_signed <= '1';
+                        m1.subtract <= '0';
+                        m1.addend <= (others => '0');
+                        m1.valid <= '1';
+                    else
+                        m1.valid <= '0';
+                    end if;
+
+                    wait for clk_period;
+
+                    j := i - (pipeline_depth - 1);
+                    if j >= 0 then
+                        check_true(?? m2.valid, result("for valid"));
+                        check_equal(m2.result(63 downto 0), exp_lo(j mod 16),
+                                    result("for mulld " & to_hstring(exp_lo(j mod 16))));
+                        check_equal(m2.result(127 downto 64), exp_hi(j mod 16),
+                                    result("for mulhd " & to_hstring(exp_hi(j mod 16))));
+                    end if;
+                end loop;
+
+                wait for clk_period;
+                check_false(?? m2.valid, result("for valid"));
             end if;
         end loop;
 
@@ -0,0 +1,53 @@
+library ieee;
+use ieee.std_logic_1164.all;
+
+-- Synthesis stand-in for sim_cosim.vhdl.  The calls are only made
+-- when the COSIM generic is true, which it never is outside simulation.
+
+package sim_cosim is
+    procedure cosim_dispatch (core: integer; tag: integer;
+                              nia: std_ulogic_vector(63 downto 0);
+                              msr: std_ulogic_vector(63 downto 0); insns: integer);
+
+    procedure cosim_retire (core: integer; tag: integer; flags: std_ulogic_vector(8 downto 0);
+                            reg: integer; data: std_ulogic_vector(63 downto 0);
+                            reg2: integer; data2: std_ulogic_vector(63 downto 0);
+                            cr_mask: std_ulogic_vector(7 downto 0);
+                            cr_data: std_ulogic_vector(31 downto 0);
+                            xer: std_ulogic_vector(4 downto 0); vec: integer;
+                            srr0: std_ulogic_vector(63 downto 0);
+                            msr: std_ulogic_vector(63 downto 0);
+                            srr1: std_ulogic_vector(15 downto 0));
+
+    procedure cosim_store (core: integer; tag: integer;
+                           addr: std_ulogic_vector(63 downto 0);
+                           sel: std_ulogic_vector(7 downto 0);
+                           data: std_ulogic_vector(63 downto 0));
+end sim_cosim;
+
+package body sim_cosim is
+    procedure cosim_dispatch (core: integer; tag: integer;
+                              nia: std_ulogic_vector(63 downto 0);
+                              msr: std_ulogic_vector(63 downto 0); insns: integer) is
+    begin
+    end cosim_dispatch;
+
+    procedure cosim_retire (core: integer; tag: integer; flags: std_ulogic_vector(8 downto 0);
+                            reg: integer; data: std_ulogic_vector(63 downto 0);
+                            reg2: integer; data2: std_ulogic_vector(63 downto 0);
+                            cr_mask: std_ulogic_vector(7 downto 0);
+                            cr_data: std_ulogic_vector(31 downto 0);
+                            xer: std_ulogic_vector(4 downto 0); vec: integer;
+                            srr0: std_ulogic_vector(63 downto 0);
+                            msr: std_ulogic_vector(63 downto 0);
+                            srr1: std_ulogic_vector(15 downto 0)) is
+    begin
+    end cosim_retire;
+
+    procedure cosim_store (core: integer; tag: integer;
+                           addr: std_ulogic_vector(63 downto 0);
+                           sel: std_ulogic_vector(7 downto 0);
+                           data: std_ulogic_vector(63 downto 0)) is
+    begin
+    end cosim_store;
+end sim_cosim;
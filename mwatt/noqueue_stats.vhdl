@@ -0,0 +1,17 @@
+library ieee;
+use ieee.std_logic_1164.all;
+
+-- Synthesis stand-in for sim_queue_stats.vhdl.  The samples are only
+-- taken when the queue's SIM generic is true.
+
+package sim_queue_stats is
+    procedure sim_queue_sample (id: integer; occupancy: integer;
+                                events: std_ulogic_vector(7 downto 0); latency: integer);
+end sim_queue_stats;
+
+package body sim_queue_stats is
+    procedure sim_queue_sample (id: integer; occupancy: integer;
+                                events: std_ulogic_vector(7 downto 0); latency: integer) is
+    begin
+    end sim_queue_sample;
+end sim_queue_stats;
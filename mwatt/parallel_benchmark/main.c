@@ -0,0 +1,105 @@
+#include "console.h"
+#include "io.h"
+#include "microwatt_soc.h"
+
+#include "runtime.h"
+#include "time.h"
+
+/*
+ * Scaling benchmark for the multicore runtime (lib/runtime.c).
+ *
+ * Runs the same parallel_for over a table on 1, 2, 4 ... cores, up to
+ * the number the SoC was built with (soc NCPUS), and prints the
+ * timebase ticks and the speedup over one core. Then times a barrier
+ * episode across all the cores. Build the SoC with NCPUS = 1, 2 and 4
+ * to compare.
+ */
+
+#define N        4096
+#define GRAIN    64
+#define ROUNDS   32
+#define BARRIERS 1000
+
+static uint64_t table[N];
+static rt_barrier_t barrier;
+
+static void kernel(void *arg, long lo, long hi)
+{
+  uint64_t *t = arg;
+  long i;
+  int r;
+
+  for (i = lo; i < hi; i++) {
+    uint64_t x = t[i];
+
+    for (r = 0; r < ROUNDS; r++)
+      x = x * 6364136223846793005ul + 1442695040888963407ul;
+    t[i] = x;
+  }
+}
+
+static void barrier_loop(void *arg, long cpu, long ncpus)
+{
+  int i;
+
+  for (i = 0; i < BARRIERS; i++)
+    rt_barrier_wait(&barrier);
+}
+
+static void print_fixed2(uint64_t val)
+{
+  print_uint64(val / 100);
+  puts(".");
+  if (val % 100 < 10)
+    puts("0");
+  print_uint64(val % 100);
+}
+
+int main(void)
+{
+  uint64_t t0, ticks, base = 0;
+  unsigned int ncpus, n;
+  long i;
+
+  console_init();
+  rt_init();
+  ncpus = rt_ncpus();
+
+  for (n = 1; n <= ncpus; n *= 2) {
+    for (i = 0; i < N; i++)
+      table[i] = i;
+    rt_set_ncpus(n);
+
+    t0 = get_tb();
+    parallel_for(0, N, GRAIN, kernel, table);
+    ticks = get_tb() - t0;
+    if (n == 1)
+      base = ticks;
+
+    puts("parallel_for cores ");
+    print_uint64(n);
+    puts(": tb ");
+    print_uint64(ticks);
+    puts(" speedup ");
+    print_fixed2(base * 100 / ticks);
+    puts("\n");
+  }
+
+  rt_set_ncpus(ncpus);
+  rt_barrier_init(&barrier, ncpus);
+  t0 = get_tb();
+  rt_run_on_all(barrier_loop, NULL);
+  ticks = get_tb() - t0;
+  puts("barrier cores ");
+  print_uint64(ncpus);
+  puts(": tb/barrier ");
+  print_uint64(ticks / BARRIERS);
+  puts("\n");
+
+  return 0;
+}
+
+void secondary_main(void)
+{
+  rt_worker();
+}
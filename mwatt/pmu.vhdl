@@ -115,6 +115,7 @@ architecture behaviour of pmu is
     signal sier  : std_ulogic_vector(63 downto 0);
 
     signal doinc : std_ulogic_vector(1 to 6);
+    signal dotwo : std_ulogic_vector(1 to 6);
     signal doalert : std_ulogic;
     signal doevent : std_ulogic;
 
@@ -149,6 +150,8 @@ begin
                 for i in 1 to 6 loop
                     if p_in.mtspr = '1' and to_integer(unsigned(p_in.spr_num(3 downto 0))) = i + 2 then
                         pmcs(i) <= p_in.spr_val(31 downto 0);
+                    elsif doinc(i) = '1' and dotwo(i) = '1' then
+                        pmcs(i) <= std_ulogic_vector(unsigned(pmcs(i)) + 2);
                     elsif doinc(i) = '1' then
                         pmcs(i) <= std_ulogic_vector(unsigned(pmcs(i)) + 1);
                     end if;
@@ -211,6 +214,7 @@ begin
         variable event  : std_ulogic;
         variable j      : integer;
         variable inc    : std_ulogic_vector(1 to 6);
+        variable two    : std_ulogic_vector(1 to 6);
         variable fc14wo : std_ulogic;
     begin
         event := '0';
@@ -240,8 +244,10 @@ begin
             event := '1';
         end if;
 
-        -- Event selection
+        -- Event selection.  A fused pair completes as one op but counts
+        -- as two instructions.
         inc := (others => '0');
+        two := (others => '0');
         fc14wo := '0';
         case mmcr1(31 downto 24) is
             when x"f0" =>
@@ -249,6 +255,7 @@ begin
                 fc14wo := '1';          -- override MMCR0[FC1_4WAIT]
             when x"f2" | x"fe" =>
                 inc(1) := p_in.occur.instr_complete;
+                two(1) := p_in.occur.instr_complete2;
             when x"f4" =>
                 inc(1) := p_in.occur.fp_complete;
             when x"f6" =>
@@ -259,6 +266,8 @@ begin
                 inc(1) := p_in.run;
             when x"fc" =>
                 inc(1) := p_in.occur.ld_complete;
+            when x"ee" =>
+                inc(1) := p_in.occur.l2_hit;
             when others =>
         end case;
 
@@ -279,6 +288,8 @@ begin
                 inc(2) := p_in.occur.icache_miss;
             when x"fe" =>
                 inc(2) := p_in.occur.dc_miss_resolved;
+            when x"ee" =>
+                inc(2) := p_in.occur.fused_op;
             when others =>
         end case;
 
@@ -289,12 +300,19 @@ begin
                 inc(3) := p_in.occur.dispatch;
             when x"f4" =>
                 inc(3) := p_in.occur.instr_complete and p_in.run;
+                two(3) := p_in.occur.instr_complete2;
             when x"f6" =>
                 inc(3) := p_in.occur.dc_ld_miss_resolved;
             when x"f8" =>
                 inc(3) := tbbit;
+            when x"fa" =>
+                inc(3) := p_in.occur.br_ret_mispredict;
+            when x"fc" =>
+                inc(3) := p_in.occur.l2_miss;
             when x"fe" =>
                 inc(3) := p_in.occur.dtlb_miss;
+            when x"ee" =>
+                inc(3) := p_in.occur.lb_hit;
             when others =>
         end case;
 
@@ -311,14 +329,18 @@ begin
                 inc(4) := p_in.occur.ipref_discard;
             when x"fa" =>
                 inc(4) := p_in.occur.instr_complete and p_in.run;
+                two(4) := p_in.occur.instr_complete2;
             when x"fc" =>
                 inc(4) := p_in.occur.itlb_miss_resolved;
             when x"fe" =>
                 inc(4) := p_in.occur.ld_miss_nocache;
+            when x"ee" =>
+                inc(4) := p_in.occur.dual_op;
             when others =>
         end case;
 
         inc(5) := (mmcr0(MMCR0_CC56RUN) or p_in.run) and p_in.occur.instr_complete;
+        two(5) := p_in.occur.instr_complete2;
         inc(6) := mmcr0(MMCR0_CC56RUN) or p_in.run;
 
         -- Evaluate freeze conditions
@@ -362,6 +384,7 @@ begin
         end if;
 
         doinc <= inc;
+        dotwo <= two;
         doevent <= event;
         doalert <= event and mmcr0(MMCR0_PMAE);
     end process;
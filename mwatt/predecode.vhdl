@@ -313,6 +313,9 @@ architecture behaviour of predecoder is
         2#0_10101_11111# => INSN_lfsxq,   -- Extended opcode 703
         2#0_10110_00000# => INSN_stafsxq, -- Extended opcode 704
         2#0_10110_00001# => INSN_stfsxq,  -- Extended opcode 705
+        2#0_10110_00010# => INSN_lfdpxq,   -- Extended opcode 706
+        2#0_10110_00011# => INSN_stafdpxq, -- Extended opcode 707
+        2#0_10110_00100# => INSN_stfdpxq,  -- Extended opcode 708
         --
         2#0_00001_10100# => INSN_lbarx,
         2#0_11010_10101# => INSN_lbzcix,
@@ -4,9 +4,12 @@ use ieee.numeric_std.all;
 
 library work;
 use work.common.all;
+use work.sim_queue_stats.all;
 
 entity queue is
   generic (
+    SIM         : boolean := false;
+    CPU_INDEX   : natural := 0;
     QUEUE_DEPTH : natural := 8
   );
   port (
@@ -31,7 +34,11 @@ entity queue is
 
     -- Connection to mmu unit
     m_in  : in  MmuToLoadstore1Type;
-    m_out : out Loadstore1ToMmuType
+    m_out : out Loadstore1ToMmuType;
+
+    -- Loadstore units waiting on this queue, for statistics only
+    read_wait_i  : in std_ulogic := '0';
+    write_wait_i : in std_ulogic := '0'
   );
 end entity queue;
 
@@ -316,4 +323,61 @@ begin
   d_out            <= internal_bus.main.comb.dout;
   m_out            <= internal_bus.main.comb.mout;
 
+  ------------------------------------------------------------
+  -- STATISTICS (simulation only)
+  ------------------------------------------------------------
+
+  -- Sends one sample per cycle to the VHPI sink in sim_queue_stats_c.c,
+  -- which accumulates them and prints a summary when the simulation
+  -- exits. Event bits:
+  --   7 push, 6 push of an address (stafdxq/stafsxq), 5 pop,
+  --   4 producer waiting on full, 3 consumer waiting on empty,
+  --   2 MMU request, 1 dcache response, 0 that entry went via the MMU
+  -- The latency is from the address push to the entry becoming READY,
+  -- and is only valid with bit 1.
+  queue_stats : if SIM generate
+    stats : process(clk)
+      type stamp_array_t is array(0 to QUEUE_DEPTH-1) of natural;
+      variable cycle   : natural := 0;
+      variable pushed  : stamp_array_t := (others => 0);
+      variable via_mmu : std_ulogic_vector(0 to QUEUE_DEPTH-1) := (others => '0');
+      variable ev      : std_ulogic_vector(7 downto 0);
+      variable latency : integer;
+      variable rptr    : ptr_t;
+    begin
+      if rising_edge(clk) then
+        if internal_bus.rst = '0' then
+          ev      := (others => '0');
+          latency := 0;
+          rptr    := internal_bus.reg.dresp_ptr;
+
+          if internal_bus.din.error = '1' then
+            via_mmu(rptr) := '1';
+          end if;
+          if internal_bus.din.valid = '1' then
+            ev(1)   := '1';
+            ev(0)   := via_mmu(rptr);
+            latency := cycle - pushed(rptr);
+          end if;
+          if internal_bus.is_write = '1' and internal_bus.write_type = '1' then
+            pushed(internal_bus.reg.write_ptr)  := cycle;
+            via_mmu(internal_bus.reg.write_ptr) := '0';
+          end if;
+
+          ev(7) := internal_bus.is_write;
+          ev(6) := internal_bus.is_write and internal_bus.write_type;
+          ev(5) := internal_bus.is_read;
+          ev(4) := write_wait_i;
+          ev(3) := read_wait_i;
+          ev(2) := internal_bus.main.comb.mout.valid;
+
+          sim_queue_sample(CPU_INDEX,
+                           (internal_bus.reg.write_ptr - internal_bus.reg.read_ptr) mod QUEUE_DEPTH,
+                           ev, latency);
+          cycle := cycle + 1;
+        end if;
+      end if;
+    end process;
+  end generate;
+
 end architecture rtl;
@@ -9,6 +9,8 @@ entity register_file is
     generic (
         SIM : boolean := false;
         HAS_FPU : boolean := true;
+        -- Second write port and read ports 4 and 5, for dual issue
+        DUAL_ISSUE : boolean := false;
         -- Non-zero to enable log data collection
         LOG_LENGTH : natural := 0
         );
@@ -23,9 +25,11 @@ entity register_file is
         w_in          : in WritebackToRegisterFileType;
 
         dbg_gpr_req   : in std_ulogic;
+        dbg_gpr_wr    : in std_ulogic := '0';
         dbg_gpr_ack   : out std_ulogic;
         dbg_gpr_addr  : in gspr_index_t;
         dbg_gpr_data  : out std_ulogic_vector(63 downto 0);
+        dbg_gpr_wdata : in std_ulogic_vector(63 downto 0) := (others => '0');
 
         -- debug
         sim_dump      : in std_ulogic;
@@ -38,26 +42,55 @@ end entity register_file;
 architecture behaviour of register_file is
     type regfile is array(0 to 63) of std_ulogic_vector(63 downto 0);
     signal registers : regfile := (others => (others => '0'));
+
+    -- With DUAL_ISSUE, the second write port writes a second copy of the
+    -- register file, and the live value table records which copy holds
+    -- the current value of each register.  That keeps each copy to one
+    -- write port, so it can still be built from distributed RAM.
+    signal registers2 : regfile := (others => (others => '0'));
+    signal lvt : std_ulogic_vector(0 to 63) := (others => '0');
+
+    function read_reg(r1 : regfile; r2 : regfile; lv : std_ulogic_vector(0 to 63);
+                      addr : gspr_index_t) return std_ulogic_vector is
+    begin
+        if is_X(addr) then
+            return 64x"X";
+        elsif lv(to_integer(unsigned(addr))) = '1' then
+            return r2(to_integer(unsigned(addr)));
+        else
+            return r1(to_integer(unsigned(addr)));
+        end if;
+    end;
+
     signal dbg_data : std_ulogic_vector(63 downto 0);
     signal dbg_ack : std_ulogic;
     signal dbg_gpr_done : std_ulogic;
     signal addr_1_reg : gspr_index_t;
     signal addr_2_reg : gspr_index_t;
     signal addr_3_reg : gspr_index_t;
+    signal addr_4_reg : gspr_index_t;
+    signal addr_5_reg : gspr_index_t;
     signal rd_2 : std_ulogic;
     signal fwd_1 : std_ulogic;
     signal fwd_2 : std_ulogic;
     signal fwd_3 : std_ulogic;
+    signal fwd_4 : std_ulogic;
+    signal fwd_5 : std_ulogic;
+    signal fwd2 : std_ulogic_vector(1 to 5);
     signal data_1 : std_ulogic_vector(63 downto 0);
     signal data_2 : std_ulogic_vector(63 downto 0);
     signal data_3 : std_ulogic_vector(63 downto 0);
+    signal data_4 : std_ulogic_vector(63 downto 0);
+    signal data_5 : std_ulogic_vector(63 downto 0);
     signal prev_write_data : std_ulogic_vector(63 downto 0);
+    signal prev_write_data2 : std_ulogic_vector(63 downto 0);
 
 begin
     -- synchronous reads and writes
     register_write_0: process(clk)
         variable a_addr, b_addr, c_addr : gspr_index_t;
-        variable w_addr : gspr_index_t;
+        variable d_addr, e_addr : gspr_index_t;
+        variable w_addr, w2_addr : gspr_index_t;
         variable b_enable : std_ulogic;
     begin
         if rising_edge(clk) then
@@ -71,27 +104,59 @@ begin
                 end if;
                 assert not(is_x(w_in.write_data)) and not(is_x(w_in.write_reg)) severity failure;
                 registers(to_integer(unsigned(w_addr))) <= w_in.write_data;
+                if DUAL_ISSUE then
+                    lvt(to_integer(unsigned(w_addr))) <= '0';
+                end if;
+            elsif dbg_gpr_req = '1' and dbg_gpr_wr = '1' and dbg_gpr_done = '0' and
+                (HAS_FPU or dbg_gpr_addr(5) = '0') then
+                -- Debug writes use the first write port when writeback isn't;
+                -- FPR writes are dropped without an FPU.  core_debug only
+                -- sends them with the core stopped.
+                w_addr := dbg_gpr_addr;
+                report "Debug writing GSPR " & to_hstring(w_addr) & " " & to_hstring(dbg_gpr_wdata);
+                registers(to_integer(unsigned(w_addr))) <= dbg_gpr_wdata;
+                if DUAL_ISSUE then
+                    lvt(to_integer(unsigned(w_addr))) <= '0';
+                end if;
+            end if;
+            -- The second port only ever writes GPRs
+            if DUAL_ISSUE and w_in.write_enable2 = '1' then
+                w2_addr := '0' & w_in.write_reg2(4 downto 0);
+                report "Writing GPR " & to_hstring(w2_addr) & " " & to_hstring(w_in.write_data2);
+                assert not(is_x(w_in.write_data2)) and not(is_x(w_in.write_reg2)) severity failure;
+                assert not (w_in.write_enable = '1' and w_addr = w2_addr)
+                    report "Both write ports writing the same register" severity failure;
+                registers2(to_integer(unsigned(w2_addr))) <= w_in.write_data2;
+                lvt(to_integer(unsigned(w2_addr))) <= '1';
             end if;
 
             a_addr := d1_in.reg_1_addr;
             b_addr := d1_in.reg_2_addr;
             c_addr := d1_in.reg_3_addr;
+            d_addr := d1_in.reg_4_addr;
+            e_addr := d1_in.reg_5_addr;
             b_enable := d1_in.read_2_enable;
             if stall = '1' then
                 a_addr := addr_1_reg;
                 b_addr := addr_2_reg;
                 c_addr := addr_3_reg;
+                d_addr := addr_4_reg;
+                e_addr := addr_5_reg;
                 b_enable := rd_2;
             else
                 addr_1_reg <= a_addr;
                 addr_2_reg <= b_addr;
                 addr_3_reg <= c_addr;
+                addr_4_reg <= d_addr;
+                addr_5_reg <= e_addr;
                 rd_2 <= b_enable;
             end if;
 
             fwd_1 <= '0';
             fwd_2 <= '0';
             fwd_3 <= '0';
+            fwd_4 <= '0';
+            fwd_5 <= '0';
             if w_in.write_enable = '1' then
                 if w_addr = a_addr then
                     fwd_1 <= '1';
@@ -102,11 +167,39 @@ begin
                 if w_addr = c_addr then
                     fwd_3 <= '1';
                 end if;
+                if w_addr = d_addr then
+                    fwd_4 <= '1';
+                end if;
+                if w_addr = e_addr then
+                    fwd_5 <= '1';
+                end if;
+            end if;
+            fwd2 <= (others => '0');
+            if DUAL_ISSUE and w_in.write_enable2 = '1' then
+                if w2_addr = a_addr then
+                    fwd2(1) <= '1';
+                end if;
+                if w2_addr = b_addr then
+                    fwd2(2) <= '1';
+                end if;
+                if w2_addr = c_addr then
+                    fwd2(3) <= '1';
+                end if;
+                if w2_addr = d_addr then
+                    fwd2(4) <= '1';
+                end if;
+                if w2_addr = e_addr then
+                    fwd2(5) <= '1';
+                end if;
             end if;
 
             -- Do debug reads to GPRs and FPRs using the B port when it is not in use
             if dbg_gpr_req = '1' then
-                if b_enable = '0' then
+                if dbg_gpr_wr = '1' then
+                    if w_in.write_enable = '0' then
+                        dbg_gpr_done <= '1';
+                    end if;
+                elsif b_enable = '0' then
                     b_addr := dbg_gpr_addr(5 downto 0);
                     dbg_gpr_done <= '1';
                 end if;
@@ -120,23 +213,17 @@ begin
                 b_addr(5) := '0';
                 c_addr(5) := '0';
             end if;
-	    if is_X(a_addr) then
-		data_1 <= (others => 'X');
-	    else
-		data_1 <= registers(to_integer(unsigned(a_addr)));
-	    end if;
-	    if is_X(b_addr) then
-		data_2 <= (others => 'X');
-	    else
-		data_2 <= registers(to_integer(unsigned(b_addr)));
-	    end if;
-	    if is_X(c_addr) then
-		data_3 <= (others => 'X');
-	    else
-		data_3 <= registers(to_integer(unsigned(c_addr)));
-	    end if;
+            -- Only GPRs are read through ports 4 and 5
+            d_addr(5) := '0';
+            e_addr(5) := '0';
+            data_1 <= read_reg(registers, registers2, lvt, a_addr);
+            data_2 <= read_reg(registers, registers2, lvt, b_addr);
+            data_3 <= read_reg(registers, registers2, lvt, c_addr);
+            data_4 <= read_reg(registers, registers2, lvt, d_addr);
+            data_5 <= read_reg(registers, registers2, lvt, e_addr);
 
             prev_write_data <= w_in.write_data;
+            prev_write_data2 <= w_in.write_data2;
         end if;
     end process register_write_0;
 
@@ -145,10 +232,14 @@ begin
         variable out_data_1 : std_ulogic_vector(63 downto 0);
         variable out_data_2 : std_ulogic_vector(63 downto 0);
         variable out_data_3 : std_ulogic_vector(63 downto 0);
+        variable out_data_4 : std_ulogic_vector(63 downto 0);
+        variable out_data_5 : std_ulogic_vector(63 downto 0);
     begin
         out_data_1 := data_1;
         out_data_2 := data_2;
         out_data_3 := data_3;
+        out_data_4 := data_4;
+        out_data_5 := data_5;
         if fwd_1 = '1' then
             out_data_1 := prev_write_data;
         end if;
@@ -158,6 +249,27 @@ begin
         if fwd_3 = '1' then
             out_data_3 := prev_write_data;
         end if;
+        if fwd_4 = '1' then
+            out_data_4 := prev_write_data;
+        end if;
+        if fwd_5 = '1' then
+            out_data_5 := prev_write_data;
+        end if;
+        if fwd2(1) = '1' then
+            out_data_1 := prev_write_data2;
+        end if;
+        if fwd2(2) = '1' then
+            out_data_2 := prev_write_data2;
+        end if;
+        if fwd2(3) = '1' then
+            out_data_3 := prev_write_data2;
+        end if;
+        if fwd2(4) = '1' then
+            out_data_4 := prev_write_data2;
+        end if;
+        if fwd2(5) = '1' then
+            out_data_5 := prev_write_data2;
+        end if;
 
         if d_in.read1_enable = '1' then
             report "Reading GPR " & to_hstring(addr_1_reg) & " " & to_hstring(out_data_1);
@@ -172,6 +284,8 @@ begin
         d_out.read1_data <= out_data_1;
         d_out.read2_data <= out_data_2;
         d_out.read3_data <= out_data_3;
+        d_out.read4_data <= out_data_4;
+        d_out.read5_data <= out_data_5;
     end process register_read_0;
 
     -- Latch read data and ack if dbg read requested and B port not busy
@@ -198,7 +312,8 @@ begin
         begin
             if sim_dump = '1' then
                 loop_0: for i in 0 to 31 loop
-                    report "GPR" & integer'image(i) & " " & to_hstring(registers(i));
+                    report "GPR" & integer'image(i) & " " &
+                        to_hstring(read_reg(registers, registers2, lvt, std_ulogic_vector(to_unsigned(i, 6))));
                 end loop loop_0;
                 sim_dump_done <= '1';
             else
@@ -16,14 +16,29 @@ PRJ.add_library("lib").add_source_files([
 ] + [
     src_file
     for src_file in ROOT.glob("*.vhdl")
-    # Use multiply.vhd and not xilinx-mult.vhd. Use VHDL-based random.
-    if not any(exclude in str(src_file) for exclude in ["xilinx-mult", "foreign_random", "nonrandom", "dmi_dtm_ecp5", "dmi_dtm_xilinx"])
+    # Use multiply.vhd and not xilinx-mult.vhd. Use VHDL-based random and the
+    # simulation versions of the sim_* packages.
+    if not any(exclude in str(src_file) for exclude in ["xilinx-mult", "foreign_random", "nonrandom",
+                                                        "nocosim", "noqueue_stats",
+                                                        "dmi_dtm_ecp5", "dmi_dtm_xilinx"])
 ])
 
 PRJ.add_library("unisim").add_source_files(ROOT / "sim-unisim" / "*.vhdl")
 
 PRJ.set_sim_option("disable_ieee_warnings", True)
 
+# Run the divider tests at each supported radix
+divider_tb = PRJ.library("lib").test_bench("divider_tb")
+for radix_bits in (1, 2, 4):
+    divider_tb.add_config(name=f"radix_bits={radix_bits}",
+                          generics=dict(DIV_RADIX_BITS=radix_bits))
+
+# Run the multiplier tests at a few pipeline depths
+multiply_tb = PRJ.library("lib").test_bench("multiply_tb")
+for depth in (2, 3, 4):
+    multiply_tb.add_config(name=f"depth={depth}",
+                           generics=dict(PIPELINE_DEPTH=depth))
+
 def _gen_vhdl_ls(vu):
     """
     Generate the vhdl_ls.toml file required by VHDL-LS language server.
@@ -0,0 +1,85 @@
+#!/usr/bin/python3
+
+# Compress the PT_LOAD segments of a little-endian ELF64 file (such as
+# the kernel's dtbImage.microwatt.elf) for the sdram_init flash loader.
+#
+# Each loadable segment is replaced by an LZ4 frame, made by the lz4
+# tool, and flagged with PF_MW_LZ4 in p_flags. p_filesz becomes the
+# size of the frame, p_memsz is left alone. Segments that don't shrink
+# are stored as they are. Section headers are dropped since they would
+# no longer match the file.
+
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+
+PT_LOAD = 1
+PF_MW_LZ4 = 0x00100000
+
+EHDR = '<16sHHIQQQIHHHHHH'
+PHDR = '<IIQQQQQQ'
+
+def lz4(data):
+    with tempfile.NamedTemporaryFile() as f:
+        f.write(data)
+        f.flush()
+        return subprocess.run(['lz4', '-9', '-BD', '--content-size', '--no-frame-crc',
+                               '-c', '-q', f.name],
+                              check=True, stdout=subprocess.PIPE).stdout
+
+def align(n, a):
+    return (n + a - 1) & ~(a - 1)
+
+if len(sys.argv) != 3:
+    print("Usage: lz4_elf.py <input.elf> <output.elf>")
+    sys.exit(1)
+
+elf = open(sys.argv[1], 'rb').read()
+ehdr = list(struct.unpack_from(EHDR, elf, 0))
+ident = ehdr[0]
+if ident[:4] != b'\x7fELF' or ident[4] != 2 or ident[5] != 1:
+    print("%s: not a little-endian ELF64 file" % sys.argv[1])
+    sys.exit(1)
+
+phoff, phentsize, phnum = ehdr[5], ehdr[9], ehdr[10]
+out = bytearray(elf[:phoff + phentsize * phnum])
+raw_total = 0
+out_total = 0
+
+for i in range(phnum):
+    off = phoff + i * phentsize
+    ph = list(struct.unpack_from(PHDR, elf, off))
+    p_type, p_flags, p_offset, p_filesz = ph[0], ph[1], ph[2], ph[5]
+    if p_filesz == 0:
+        continue
+    data = elf[p_offset:p_offset + p_filesz]
+    if p_type == PT_LOAD:
+        z = lz4(data)
+        if len(z) < len(data):
+            data = z
+            ph[1] = p_flags | PF_MW_LZ4
+        raw_total += p_filesz
+        out_total += len(data)
+        print("segment %d: %d -> %d bytes" % (i, p_filesz, len(data)))
+
+    # The loader DMAs from 8-byte aligned flash offsets
+    out += bytes(align(len(out), 8) - len(out))
+    ph[2] = len(out)
+    ph[5] = len(data)
+    out += data
+    struct.pack_into(PHDR, out, off, *ph)
+
+# No section headers
+ehdr[6] = 0
+ehdr[11] = 0
+ehdr[12] = 0
+ehdr[13] = 0
+struct.pack_into(EHDR, out, 0, *ehdr)
+
+with open(sys.argv[2], 'wb') as f:
+    f.write(out)
+
+if raw_total:
+    print("total: %d -> %d bytes (%d%%)" % (raw_total, out_total, out_total * 100 // raw_total))
@@ -0,0 +1,414 @@
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library work;
+use work.utils.all;
+use work.wishbone_types.all;
+
+-- Shared L2 cache
+--
+-- Sits on the crossbar's DRAM port, in front of main memory, and is
+-- shared by all the cores. It is write-through with no write allocate,
+-- so it never holds dirty data, and DMA and debug writes going through it
+-- keep it up to date.
+--
+-- For each line it records which cores have read or written it (the
+-- sharers). An L1 may hold a line that is in the directory only if it is
+-- one of the line's sharers; lines that are not in the directory may be
+-- in any L1 (a dcbz allocates in the L1 without reading the line). So:
+--  - before a line that has sharers is evicted, an invalidation for it is
+--    sent to those cores on the snoop bus;
+--  - before a line is installed, an invalidation for it is sent to every
+--    core, so no L1 copy that the new entry doesn't list survives;
+--  - a write that misses in the directory is snooped by every core.
+-- That lets the SoC send a snooped write that hits only to the cores that
+-- may hold the line (sharers_out) instead of making every L1 look up
+-- every store. An L1 refill holds the crossbar's DRAM port for the whole
+-- line, so no other master's miss can evict the line part way through
+-- it; and if one did, the L1 would just be left holding a line that is
+-- not in the directory, which the rules above allow.
+--
+entity shared_l2 is
+    generic (
+        NCPUS     : positive := 1;
+        -- Number of sets
+        NUM_LINES : positive := 256;
+        NUM_WAYS  : positive := 4;
+        -- Line size in bytes, same as the L1s
+        LINE_SIZE : positive := 64
+        );
+    port (
+        clk : in std_ulogic;
+        rst : in std_ulogic;
+
+        -- From the crossbar. req_cores is the core issuing the request
+        -- (one-hot), or none for DMA and debug.
+        wb_in     : in wishbone_master_out;
+        wb_out    : out wishbone_slave_out;
+        req_cores : in std_ulogic_vector(NCPUS-1 downto 0);
+
+        -- To memory
+        mem_out : out wishbone_master_out;
+        mem_in  : in wishbone_slave_out;
+
+        -- Cores that may hold the line being written on wb_in; all of
+        -- them if it isn't in the directory
+        sharers_out : out std_ulogic_vector(NCPUS-1 downto 0);
+
+        -- Invalidation of an evicted or newly installed line, and the
+        -- cores to send it to
+        inval_out     : out wishbone_master_out;
+        inval_sharers : out std_ulogic_vector(NCPUS-1 downto 0);
+
+        -- Per core hit/miss events for the PMUs
+        hit_out  : out std_ulogic_vector(NCPUS-1 downto 0);
+        miss_out : out std_ulogic_vector(NCPUS-1 downto 0)
+        );
+end entity shared_l2;
+
+architecture rtl of shared_l2 is
+    constant ROW_SIZE     : natural := wishbone_data_bits / 8;
+    constant ROW_PER_LINE : natural := LINE_SIZE / ROW_SIZE;
+    constant ROW_LINEBITS : natural := log2(ROW_PER_LINE);
+    constant INDEX_BITS   : natural := log2(NUM_LINES);
+    -- Row address within the data RAMs: index & row in line
+    constant ROW_BITS     : natural := INDEX_BITS + ROW_LINEBITS;
+    constant TAG_BITS     : natural := wishbone_addr_bits - ROW_BITS;
+
+    subtype index_t is integer range 0 to NUM_LINES-1;
+    subtype way_t is integer range 0 to NUM_WAYS-1;
+    subtype row_t is std_ulogic_vector(ROW_BITS-1 downto 0);
+    subtype tag_t is std_ulogic_vector(TAG_BITS-1 downto 0);
+    subtype cores_t is std_ulogic_vector(NCPUS-1 downto 0);
+
+    -- Directory: tags, valid bits and sharers. Kept in registers so the
+    -- sharers of a snooped write can be looked up in the same cycle.
+    type dir_entry_t is record
+        valid   : std_ulogic;
+        tag     : tag_t;
+        sharers : cores_t;
+    end record;
+    constant dir_entry_init : dir_entry_t := (valid => '0', tag => (others => '0'),
+                                              sharers => (others => '0'));
+    type dir_set_t is array(way_t) of dir_entry_t;
+    type dir_t is array(index_t) of dir_set_t;
+    signal dir : dir_t;
+
+    signal dir_wr       : std_ulogic;
+    signal dir_wr_index : index_t;
+    signal dir_wr_way   : way_t;
+    signal dir_wr_entry : dir_entry_t;
+
+    -- Lookup of the incoming request
+    signal req_hit : std_ulogic;
+    signal req_way : way_t;
+
+    type state_t is (IDLE, INVAL, INVAL_NEW, FILL, WRITE_THROUGH);
+
+    type reg_t is record
+        state     : state_t;
+        -- Request being handled
+        adr       : wishbone_addr_type;
+        cores     : cores_t;
+        -- Way being refilled, and the next victim
+        way       : way_t;
+        repl      : way_t;
+        -- Rows requested from and received from memory
+        issued    : unsigned(ROW_LINEBITS downto 0);
+        recvd     : unsigned(ROW_LINEBITS downto 0);
+        mem       : wishbone_master_out;
+        -- Response, with data from a data RAM way or from dat
+        ack       : std_ulogic;
+        ack_ram   : std_ulogic;
+        ack_way   : way_t;
+        dat       : wishbone_data_type;
+        inval     : wishbone_master_out;
+        inval_sharers : cores_t;
+    end record;
+    constant reg_init : reg_t := (state => IDLE, adr => (others => '0'),
+                                  cores => (others => '0'), way => 0, repl => 0,
+                                  issued => (others => '0'), recvd => (others => '0'),
+                                  mem => wishbone_master_out_init,
+                                  ack => '0', ack_ram => '0', ack_way => 0,
+                                  dat => (others => '0'),
+                                  inval => wishbone_master_out_init,
+                                  inval_sharers => (others => '0'));
+
+    signal r, rin : reg_t;
+
+    -- Data RAMs, one per way
+    type way_data_t is array(way_t) of wishbone_data_type;
+    type way_sel_t is array(way_t) of wishbone_sel_type;
+    signal ram_rd_en   : std_ulogic;
+    signal ram_rd_addr : row_t;
+    signal ram_rd_data : way_data_t;
+    signal ram_wr_sel  : way_sel_t;
+    signal ram_wr_addr : row_t;
+    signal ram_wr_data : wishbone_data_type;
+
+    function get_index(adr : wishbone_addr_type) return index_t is
+    begin
+        return to_integer(unsigned(adr(ROW_BITS-1 downto ROW_LINEBITS)));
+    end;
+
+    function get_tag(adr : wishbone_addr_type) return tag_t is
+    begin
+        return adr(wishbone_addr_bits-1 downto ROW_BITS);
+    end;
+
+    function get_row(adr : wishbone_addr_type) return row_t is
+    begin
+        return adr(ROW_BITS-1 downto 0);
+    end;
+
+begin
+
+    assert LINE_SIZE mod ROW_SIZE = 0 and ispow2(ROW_PER_LINE)
+        report "LINE_SIZE must be a power of 2 multiple of the bus width" severity FAILURE;
+    assert ispow2(NUM_LINES) report "NUM_LINES not power of 2" severity FAILURE;
+
+    rams: for i in way_t generate
+        way_ram: entity work.cache_ram
+            generic map (
+                ROW_BITS => ROW_BITS,
+                WIDTH    => wishbone_data_bits
+                )
+            port map (
+                clk     => clk,
+                rd_en   => ram_rd_en,
+                rd_addr => ram_rd_addr,
+                rd_data => ram_rd_data(i),
+                wr_sel  => ram_wr_sel(i),
+                wr_addr => ram_wr_addr,
+                wr_data => ram_wr_data
+                );
+    end generate;
+
+    -- Look up the incoming address in the directory
+    l2_lookup: process(all)
+        variable set : dir_set_t;
+    begin
+        req_hit <= '0';
+        req_way <= 0;
+        sharers_out <= (others => '1');
+        if not is_X(wb_in.adr) then
+            set := dir(get_index(wb_in.adr));
+            for i in way_t loop
+                if set(i).valid = '1' and set(i).tag = get_tag(wb_in.adr) then
+                    req_hit <= '1';
+                    req_way <= i;
+                    sharers_out <= set(i).sharers;
+                end if;
+            end loop;
+        end if;
+    end process;
+
+    wb_out.ack <= r.ack;
+    wb_out.dat <= ram_rd_data(r.ack_way) when r.ack_ram = '1' else r.dat;
+    wb_out.stall <= '0' when r.state = IDLE else '1';
+
+    mem_out <= r.mem;
+    inval_out <= r.inval;
+    inval_sharers <= r.inval_sharers;
+
+    l2_comb: process(all)
+        variable v      : reg_t;
+        variable index  : index_t;
+        variable victim : way_t;
+        variable entry  : dir_entry_t;
+        variable found  : boolean;
+    begin
+        v := r;
+        v.ack := '0';
+        v.ack_ram := '0';
+        v.inval.cyc := '0';
+        v.inval.stb := '0';
+
+        ram_rd_en <= '0';
+        ram_rd_addr <= get_row(wb_in.adr);
+        ram_wr_sel <= (others => (others => '0'));
+        ram_wr_addr <= get_row(wb_in.adr);
+        ram_wr_data <= wb_in.dat;
+
+        dir_wr <= '0';
+        dir_wr_index <= 0;
+        dir_wr_way <= 0;
+        dir_wr_entry <= dir_entry_init;
+
+        hit_out <= (others => '0');
+        miss_out <= (others => '0');
+
+        case r.state is
+            when IDLE =>
+                if wb_in.cyc = '1' and wb_in.stb = '1' then
+                    index := get_index(wb_in.adr);
+                    v.adr := wb_in.adr;
+                    v.cores := req_cores;
+                    if wb_in.we = '1' then
+                        -- Update our copy if we have one, and pass the
+                        -- write on to memory
+                        if req_hit = '1' then
+                            ram_wr_sel(req_way) <= wb_in.sel;
+                            -- The writer may now hold the line (dcbz)
+                            entry := dir(index)(req_way);
+                            if (entry.sharers or req_cores) /= entry.sharers then
+                                entry.sharers := entry.sharers or req_cores;
+                                dir_wr <= '1';
+                                dir_wr_index <= index;
+                                dir_wr_way <= req_way;
+                                dir_wr_entry <= entry;
+                            end if;
+                        end if;
+                        v.mem := wb_in;
+                        v.state := WRITE_THROUGH;
+                    elsif req_hit = '1' then
+                        ram_rd_en <= '1';
+                        v.ack := '1';
+                        v.ack_ram := '1';
+                        v.ack_way := req_way;
+                        hit_out <= req_cores;
+                        entry := dir(index)(req_way);
+                        if (entry.sharers or req_cores) /= entry.sharers then
+                            entry.sharers := entry.sharers or req_cores;
+                            dir_wr <= '1';
+                            dir_wr_index <= index;
+                            dir_wr_way <= req_way;
+                            dir_wr_entry <= entry;
+                        end if;
+                    else
+                        miss_out <= req_cores;
+                        -- Pick an invalid way if there is one, else round robin
+                        victim := r.repl;
+                        found := false;
+                        for i in way_t loop
+                            if not found and dir(index)(i).valid = '0' then
+                                victim := i;
+                                found := true;
+                            end if;
+                        end loop;
+                        if not found then
+                            if r.repl = NUM_WAYS - 1 then
+                                v.repl := 0;
+                            else
+                                v.repl := r.repl + 1;
+                            end if;
+                        end if;
+                        v.way := victim;
+
+                        -- Drop the victim now; it is refilled at the end
+                        entry := dir(index)(victim);
+                        dir_wr <= '1';
+                        dir_wr_index <= index;
+                        dir_wr_way <= victim;
+                        dir_wr_entry <= dir_entry_init;
+
+                        -- Line address to refill from
+                        v.mem.adr := wb_in.adr;
+                        v.mem.adr(ROW_LINEBITS-1 downto 0) := (others => '0');
+                        v.mem.sel := (others => '1');
+                        v.mem.we := '0';
+                        v.issued := (others => '0');
+                        v.recvd := (others => '0');
+
+                        v.inval.sel := (others => '1');
+                        v.inval.we := '1';
+                        v.inval.cyc := '1';
+                        v.inval.stb := '1';
+                        if entry.valid = '1' and entry.sharers /= (cores_t'range => '0') then
+                            -- Evicting a line some L1s may hold
+                            v.inval.adr := entry.tag & wb_in.adr(ROW_BITS-1 downto 0);
+                            v.inval.adr(ROW_LINEBITS-1 downto 0) := (others => '0');
+                            v.inval_sharers := entry.sharers;
+                            v.state := INVAL;
+                        else
+                            -- Clear out any copies of the new line
+                            v.inval.adr := v.mem.adr;
+                            v.inval_sharers := (others => '1');
+                            v.state := INVAL_NEW;
+                        end if;
+                    end if;
+                end if;
+
+            when INVAL =>
+                -- The eviction went out on the snoop bus last cycle; now
+                -- clear out any copies of the new line
+                v.inval.adr := r.mem.adr;
+                v.inval.cyc := '1';
+                v.inval.stb := '1';
+                v.inval_sharers := (others => '1');
+                v.state := INVAL_NEW;
+
+            when INVAL_NEW =>
+                v.mem.cyc := '1';
+                v.mem.stb := '1';
+                v.state := FILL;
+
+            when FILL =>
+                if r.mem.stb = '1' and mem_in.stall = '0' then
+                    v.issued := r.issued + 1;
+                    if v.issued = ROW_PER_LINE then
+                        v.mem.stb := '0';
+                    else
+                        v.mem.adr(ROW_LINEBITS-1 downto 0) :=
+                            std_ulogic_vector(v.issued(ROW_LINEBITS-1 downto 0));
+                    end if;
+                end if;
+                if mem_in.ack = '1' then
+                    ram_wr_addr <= r.adr(ROW_BITS-1 downto ROW_LINEBITS) &
+                                   std_ulogic_vector(r.recvd(ROW_LINEBITS-1 downto 0));
+                    ram_wr_data <= mem_in.dat;
+                    ram_wr_sel(r.way) <= (others => '1');
+                    -- Send the row that was asked for straight on
+                    if r.recvd(ROW_LINEBITS-1 downto 0) = unsigned(r.adr(ROW_LINEBITS-1 downto 0)) then
+                        v.ack := '1';
+                        v.dat := mem_in.dat;
+                    end if;
+                    v.recvd := r.recvd + 1;
+                    if v.recvd = ROW_PER_LINE then
+                        dir_wr <= '1';
+                        dir_wr_index <= get_index(r.adr);
+                        dir_wr_way <= r.way;
+                        dir_wr_entry <= (valid => '1', tag => get_tag(r.adr),
+                                         sharers => r.cores);
+                        v.mem.cyc := '0';
+                        v.state := IDLE;
+                    end if;
+                end if;
+
+            when WRITE_THROUGH =>
+                if mem_in.stall = '0' then
+                    v.mem.stb := '0';
+                end if;
+                if mem_in.ack = '1' then
+                    v.mem.cyc := '0';
+                    v.mem.stb := '0';
+                    v.ack := '1';
+                    v.dat := (others => '0');
+                    v.state := IDLE;
+                end if;
+        end case;
+
+        rin <= v;
+    end process;
+
+    l2_regs: process(clk)
+    begin
+        if rising_edge(clk) then
+            if rst = '1' then
+                r <= reg_init;
+                for i in index_t loop
+                    for j in way_t loop
+                        dir(i)(j).valid <= '0';
+                        dir(i)(j).sharers <= (others => '0');
+                    end loop;
+                end loop;
+            else
+                r <= rin;
+                if dir_wr = '1' then
+                    dir(dir_wr_index)(dir_wr_way) <= dir_wr_entry;
+                end if;
+            end if;
+        end if;
+    end process;
+end architecture rtl;
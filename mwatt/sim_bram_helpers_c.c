@@ -101,6 +101,18 @@ unsigned long behavioural_initialize(void *__f, unsigned long size)
 	return region_nr++;
 }
 
+/* Direct access to a region, for the fast-forward model */
+void *behavioural_region(unsigned long nr, unsigned long *size)
+{
+	if (nr >= region_nr) {
+		fprintf(stderr, "%s: bad index %lu\n", __func__, nr);
+		exit(1);
+	}
+
+	*size = behavioural_regions[nr].size;
+	return behavioural_regions[nr].m;
+}
+
 void behavioural_read(unsigned char *__val, unsigned char *__addr,
 			unsigned long sel, int identifier)
 {
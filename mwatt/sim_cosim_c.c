@@ -0,0 +1,631 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "sim_vhpi_c.h"
+#include "sim_isa_model_c.h"
+
+/*
+ * Lock-step co-simulation checker (core_tb -gCOSIM=true).
+ *
+ * execute1 reports each instruction it dispatches: its tag, NIA, MSR
+ * and whether a second instruction went with it (fused or dual-issued).
+ * writeback reports the GPR/FPR, CR and XER writes and each completion.
+ * loadstore1 reports the bytes each store writes, by real address and
+ * tag, before the store completes. At every completion the reference
+ * model in sim_isa_model_c.c steps the same instructions, on its own
+ * copy of main RAM taken when the core starts, and its register
+ * results, the bytes it stores and its next NIA and MSR must match the
+ * core's.
+ *
+ * Where the model stops (an unmodelled instruction, SPR or mode, IO, a
+ * time base read) it takes the core's results instead, including the
+ * core's stores to RAM, and the NIA and MSR of the next instruction
+ * dispatched. Interrupts the model doesn't take itself are followed the
+ * same way, with SRR0/SRR1 set as execute1 sets them. The first
+ * divergence is printed with the recent history and the model's
+ * registers, and ends the simulation.
+ *
+ * Other cores and DMA writing main RAM aren't seen by the model, so
+ * this is for single core runs.
+ */
+
+#define MAX_CORES	8
+#define MAX_INFLIGHT	64
+#define MAX_CORE_WRITES	8
+#define MAX_STORE_BYTES	256
+#define HISTORY		16
+
+/* Flags from writeback */
+#define RT_COMPLETE	(1 << 8)
+#define RT_WRITE	(1 << 7)
+#define RT_WRITE2	(1 << 6)
+#define RT_CR		(1 << 5)
+#define RT_XER		(1 << 4)
+#define RT_INTR		(1 << 3)
+#define RT_HV		(1 << 2)
+#define RT_SCV		(1 << 1)
+#define RT_FLUSH	(1 << 0)
+
+#define XER_COMMON	(ISA_XER_SO | ISA_XER_OV | ISA_XER_CA | \
+			 ISA_XER_OV32 | ISA_XER_CA32)
+
+/* As intr_srr1() in execute1 */
+#define SRR1_MSR_MASK	0xffffffff87c0fffful
+
+struct dispatched {
+	int tag;
+	uint64_t nia;
+	uint64_t msr;
+	int insns;
+};
+
+/* A byte stored by the core, or by the model */
+struct stored {
+	int tag;
+	uint64_t addr;
+	uint8_t val;
+};
+
+struct retired {
+	uint64_t nia;
+	uint32_t insn;
+	int vec;		/* interrupt taken, or 0 */
+	const char *why;	/* why the model didn't run it, or NULL */
+};
+
+struct cosim {
+	int id;
+	bool started;
+	bool resync;
+	struct isa_model m;
+
+	/* Dispatched and not yet completed, oldest first */
+	struct dispatched inflight[MAX_INFLIGHT];
+	int head;
+	int n;
+
+	/* The core's results since the last completion */
+	int nwrites;
+	struct isa_write writes[MAX_CORE_WRITES];
+	uint8_t cr_mask;
+	uint32_t cr_data;
+	bool xer_valid;
+	uint64_t xer;
+
+	/* Bytes stored by instructions not yet completed, oldest first */
+	int nstores;
+	struct stored stores[MAX_STORE_BYTES];
+
+	struct retired history[HISTORY];
+	uint64_t retired;
+	uint64_t from_core;
+};
+
+static struct cosim cores[MAX_CORES];
+
+void *behavioural_region(unsigned long nr, unsigned long *size);
+const struct isa_state *ffwd_state(void);
+
+static void cosim_dump(void)
+{
+	for (int i = 0; i < MAX_CORES; i++) {
+		struct cosim *c = &cores[i];
+
+		if (!c->started)
+			continue;
+		fprintf(stderr, "cosim: core %d: %lu instructions checked, %lu taken from the core\n",
+			i, c->retired - c->from_core, c->from_core);
+	}
+}
+
+static struct cosim *cosim_get(int core)
+{
+	static bool registered = false;
+	struct cosim *c;
+	const struct isa_state *s;
+	unsigned long size;
+	void *ram;
+
+	if (core < 0 || core >= MAX_CORES) {
+		fprintf(stderr, "cosim: bad core %d\n", core);
+		exit(1);
+	}
+	c = &cores[core];
+	if (c->started)
+		return c;
+
+	if (!registered) {
+		atexit(cosim_dump);
+		registered = true;
+	}
+
+	ram = behavioural_region(0, &size);
+	c->m.ram = malloc(size);
+	if (!ram || !c->m.ram) {
+		fprintf(stderr, "cosim: no main RAM to copy\n");
+		exit(1);
+	}
+	memcpy(c->m.ram, ram, size);
+	c->m.ram_size = size;
+	c->m.pir = core;
+	c->m.no_tb = true;
+	isa_reset(&c->m, 0);
+
+	/* Start from what the fast-forward handed over, if anything, or
+	 * else from wherever the core starts */
+	s = core == 0 ? ffwd_state() : NULL;
+	if (s)
+		c->m.s = *s;
+	else
+		c->resync = true;
+	c->id = core;
+	c->started = true;
+	return c;
+}
+
+static const char *reg_name(int reg)
+{
+	static char buf[8];
+
+	snprintf(buf, sizeof(buf), "%s%d", reg < 32 ? "r" : "f", reg % 32);
+	return buf;
+}
+
+static void __attribute__((noreturn, format(printf, 2, 3)))
+diverge(struct cosim *c, const char *fmt, ...)
+{
+	struct isa_state *s = &c->m.s;
+	va_list ap;
+	int i;
+
+	fprintf(stderr, "cosim: core %d: divergence after %lu instructions\n",
+		c->id, c->retired);
+	fprintf(stderr, "  ");
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fprintf(stderr, "\n");
+
+	fprintf(stderr, "  last instructions, oldest first:\n");
+	for (i = 0; i < HISTORY; i++) {
+		uint64_t n = c->retired + i - HISTORY;
+		struct retired *r = &c->history[n % HISTORY];
+
+		if (c->retired + i < HISTORY)
+			continue;
+		fprintf(stderr, "  %10lu %016lx %08x", n, r->nia, r->insn);
+		if (r->vec)
+			fprintf(stderr, " interrupt %x", r->vec);
+		if (r->why)
+			fprintf(stderr, " from core (%s)", r->why);
+		fprintf(stderr, "\n");
+	}
+
+	fprintf(stderr, "  core results:");
+	for (i = 0; i < c->nwrites; i++)
+		fprintf(stderr, " %s=%016lx", reg_name(c->writes[i].reg),
+			c->writes[i].val);
+	if (c->cr_mask)
+		fprintf(stderr, " cr=%08x/%02x", c->cr_data, c->cr_mask);
+	if (c->xer_valid)
+		fprintf(stderr, " xer=%08lx", c->xer);
+	fprintf(stderr, "\n");
+
+	fprintf(stderr, "  model state:\n");
+	for (i = 0; i < 32; i++)
+		fprintf(stderr, "  r%-2d %016lx%s", i, s->gpr[i],
+			i % 4 == 3 ? "\n" : "");
+	fprintf(stderr, "  nia %016lx msr %016lx cr %08x xer %08lx\n",
+		s->nia, s->msr, s->cr, s->xer);
+	fprintf(stderr, "  lr  %016lx ctr %016lx srr0 %016lx srr1 %016lx\n",
+		s->lr, s->ctr, s->srr0, s->srr1);
+	exit(1);
+}
+
+static void add_write(struct cosim *c, int reg, uint64_t val)
+{
+	int i;
+
+	for (i = 0; i < c->nwrites; i++) {
+		if (c->writes[i].reg == reg) {
+			c->writes[i].val = val;
+			return;
+		}
+	}
+	if (c->nwrites == MAX_CORE_WRITES) {
+		fprintf(stderr, "cosim: core %d: too many writes for one instruction\n",
+			c->id);
+		exit(1);
+	}
+	c->writes[c->nwrites].reg = reg;
+	c->writes[c->nwrites].val = val;
+	c->nwrites++;
+}
+
+/* CR bits covered by a writeback CR field mask, CR0 in mask bit 7 */
+static uint32_t cr_bits(uint8_t mask)
+{
+	uint32_t b = 0;
+	int f;
+
+	for (f = 0; f < 8; f++)
+		if (mask & (0x80 >> f))
+			b |= 0xfu << (28 - 4 * f);
+	return b;
+}
+
+static struct retired *log_retired(struct cosim *c)
+{
+	struct retired *r = &c->history[c->retired % HISTORY];
+
+	r->nia = c->m.cia;
+	r->insn = c->m.insn;
+	r->vec = 0;
+	r->why = NULL;
+	c->retired++;
+	return r;
+}
+
+static struct dispatched *pop_dispatched(struct cosim *c, int tag)
+{
+	struct dispatched *d;
+
+	if (!c->n || c->inflight[c->head].tag != tag)
+		return NULL;
+	d = &c->inflight[c->head];
+	c->head = (c->head + 1) % MAX_INFLIGHT;
+	c->n--;
+	return d;
+}
+
+/* Line the model up with the next instruction the core runs */
+static void check_next(struct cosim *c, struct dispatched *d)
+{
+	if (c->resync) {
+		c->m.s.nia = d->nia;
+		c->m.s.msr = d->msr;
+		c->resync = false;
+		return;
+	}
+	if (c->m.s.nia != d->nia)
+		diverge(c, "core ran %016lx next, model %016lx", d->nia, c->m.s.nia);
+	if (c->m.s.msr != d->msr)
+		diverge(c, "at %016lx: core MSR %016lx, model %016lx",
+			d->nia, d->msr, c->m.s.msr);
+}
+
+/* Take the bytes the core stored for an instruction out of the list */
+static int take_stores(struct cosim *c, int tag, struct stored *st)
+{
+	int i, j = 0, n = 0;
+
+	for (i = 0; i < c->nstores; i++) {
+		if (c->stores[i].tag == tag)
+			st[n++] = c->stores[i];
+		else
+			c->stores[j++] = c->stores[i];
+	}
+	c->nstores = j;
+	return n;
+}
+
+/* Write bytes the core stored into the model's RAM; IO is left alone */
+static void apply_stores(struct cosim *c, const struct stored *st, int n)
+{
+	uint8_t *p;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		p = isa_ram_ptr(&c->m, st[i].addr, 1);
+		if (p)
+			*p = st[i].val;
+	}
+}
+
+/* Add the bytes of the model's last store to a list */
+static int model_stores(struct cosim *c, struct stored *st, int n)
+{
+	int k;
+
+	for (k = 0; k < c->m.st_size; k++) {
+		st[n].tag = 0;
+		st[n].addr = c->m.st_addr + k;
+		st[n].val = k < 8 ? c->m.st_val >> (8 * k) : 0;
+		n++;
+	}
+	return n;
+}
+
+/* Whether two real addresses are the same byte, allowing for the alias of RAM */
+static bool same_byte(struct cosim *c, uint64_t a, uint64_t b)
+{
+	uint8_t *pa = isa_ram_ptr(&c->m, a, 1);
+	uint8_t *pb = isa_ram_ptr(&c->m, b, 1);
+
+	if (pa || pb)
+		return pa == pb;
+	return a == b;
+}
+
+/* Take the results of something the model couldn't run from the core */
+static void take_core_results(struct cosim *c, const struct stored *cs, int ncs)
+{
+	struct isa_state *s = &c->m.s;
+	uint32_t b = cr_bits(c->cr_mask);
+	int i;
+
+	for (i = 0; i < c->nwrites; i++) {
+		if (c->writes[i].reg < 32)
+			s->gpr[c->writes[i].reg] = c->writes[i].val;
+		else
+			s->fpr[c->writes[i].reg - 32] = c->writes[i].val;
+	}
+	s->cr = (s->cr & ~b) | (c->cr_data & b);
+	if (c->xer_valid)
+		s->xer = (s->xer & ~XER_COMMON) | c->xer;
+	apply_stores(c, cs, ncs);
+	c->resync = true;
+	c->from_core++;
+}
+
+static void compare_stores(struct cosim *c, const struct stored *cs, int ncs,
+			   const struct stored *ms, int nms)
+{
+	int i, j;
+
+	for (i = 0; i < ncs; i++) {
+		for (j = nms - 1; j >= 0; j--)
+			if (same_byte(c, cs[i].addr, ms[j].addr))
+				break;
+		if (j < 0)
+			diverge(c, "core stored %02x at %016lx, model didn't store there",
+				cs[i].val, cs[i].addr);
+		if (ms[j].val != cs[i].val)
+			diverge(c, "store to %016lx: core %02x, model %02x",
+				cs[i].addr, cs[i].val, ms[j].val);
+	}
+	for (j = 0; j < nms; j++) {
+		for (i = 0; i < ncs; i++)
+			if (same_byte(c, cs[i].addr, ms[j].addr))
+				break;
+		if (i == ncs)
+			diverge(c, "model stored %02x at %016lx, core didn't store there",
+				ms[j].val, ms[j].addr);
+	}
+}
+
+static void compare(struct cosim *c, const struct isa_state *before,
+		    const struct isa_write *mw, int nmw)
+{
+	struct isa_state *s = &c->m.s;
+	uint32_t b = cr_bits(c->cr_mask);
+	uint32_t cr;
+	uint64_t xer;
+	int i, j;
+
+	for (i = 0; i < c->nwrites; i++) {
+		const struct isa_write *w = &c->writes[i];
+
+		for (j = nmw - 1; j >= 0; j--)
+			if (mw[j].reg == w->reg)
+				break;
+		if (j < 0)
+			diverge(c, "core wrote %s=%016lx, model didn't write it",
+				reg_name(w->reg), w->val);
+		if (mw[j].val != w->val)
+			diverge(c, "%s: core %016lx, model %016lx",
+				reg_name(w->reg), w->val, mw[j].val);
+	}
+	for (j = 0; j < nmw; j++) {
+		for (i = 0; i < c->nwrites; i++)
+			if (c->writes[i].reg == mw[j].reg)
+				break;
+		if (i == c->nwrites)
+			diverge(c, "model wrote %s=%016lx, core didn't write it",
+				reg_name(mw[j].reg), mw[j].val);
+	}
+
+	cr = (before->cr & ~b) | (c->cr_data & b);
+	if (cr != s->cr)
+		diverge(c, "CR: core %08x, model %08x", cr, s->cr);
+	xer = c->xer_valid ? c->xer : before->xer & XER_COMMON;
+	if (xer != (s->xer & XER_COMMON))
+		diverge(c, "XER: core %08lx, model %08lx", xer, s->xer & XER_COMMON);
+}
+
+static void complete(struct cosim *c, int tag)
+{
+	struct isa_write mw[2 * ISA_MAX_WRITES];
+	struct stored cs[MAX_STORE_BYTES], ms[MAX_STORE_BYTES];
+	struct isa_state before;
+	struct dispatched *d;
+	struct retired *r;
+	int i, rc = ISA_OK, nmw = 0, ncs, nms = 0;
+
+	d = pop_dispatched(c, tag);
+	if (!d)
+		diverge(c, "core completed tag %d, which isn't the oldest instruction dispatched",
+			tag);
+	check_next(c, d);
+	ncs = take_stores(c, tag, cs);
+
+	before = c->m.s;
+	for (i = 0; i < d->insns; i++) {
+		rc = isa_step(&c->m);
+		r = log_retired(c);
+		if (rc != ISA_OK) {
+			r->why = rc == ISA_ATTN ? "attn" : c->m.why;
+			break;
+		}
+		memcpy(&mw[nmw], c->m.writes, c->m.nwrites * sizeof(mw[0]));
+		nmw += c->m.nwrites;
+		nms = model_stores(c, ms, nms);
+	}
+	if (rc != ISA_OK) {
+		take_core_results(c, cs, ncs);
+	} else {
+		compare(c, &before, mw, nmw);
+		compare_stores(c, cs, ncs, ms, nms);
+	}
+}
+
+static void interrupt(struct cosim *c, int tag, int vec, uint64_t srr0,
+		      uint64_t msr, uint64_t flags, uint64_t srr1_flags)
+{
+	struct isa_state *s = &c->m.s;
+	struct isa_state before;
+	struct dispatched *d;
+	struct retired *r;
+	struct stored cs[MAX_STORE_BYTES];
+	uint64_t count, srr1;
+	int ncs;
+
+	/* A store that took an interrupt part way (a DSI on its second
+	 * doubleword) has still written what went before */
+	ncs = take_stores(c, tag, cs);
+	apply_stores(c, cs, ncs);
+
+	srr1 = (msr & SRR1_MSR_MASK) | (((srr1_flags >> 11) & 0xf) << 27) |
+		((srr1_flags & 0x3f) << 16);
+
+	/* An interrupt caused by a dispatched instruction, which the model
+	 * may take itself (sc) */
+	d = (flags & RT_COMPLETE) ? pop_dispatched(c, tag) : NULL;
+	if (d) {
+		check_next(c, d);
+		before = *s;
+		count = c->m.count;
+		if (isa_step(&c->m) == ISA_OK && s->nia == (uint64_t)vec) {
+			r = log_retired(c);
+			r->vec = vec;
+			if (s->srr0 != srr0 || s->srr1 != srr1)
+				diverge(c, "SRR0/1: core %016lx %016lx, model %016lx %016lx",
+					srr0, srr1, s->srr0, s->srr1);
+			return;
+		}
+		*s = before;
+		c->m.count = count;
+	}
+
+	r = &c->history[c->retired % HISTORY];
+	r->nia = d ? d->nia : srr0;
+	r->insn = 0;
+	r->vec = vec;
+	r->why = "interrupt";
+	c->retired++;
+
+	if (flags & RT_SCV) {
+		s->lr = srr0;
+		s->ctr = msr;
+	} else if (flags & RT_HV) {
+		s->hsrr0 = srr0;
+		s->hsrr1 = srr1;
+	} else {
+		s->srr0 = srr0;
+		s->srr1 = srr1;
+	}
+	s->reserve = false;
+	c->resync = true;
+	c->from_core++;
+}
+
+void cosim_dispatch(int core, int tag, unsigned char *__nia,
+		    unsigned char *__msr, int insns)
+{
+	struct cosim *c = cosim_get(core);
+	struct dispatched *d;
+
+	if (c->n == MAX_INFLIGHT) {
+		fprintf(stderr, "cosim: core %d: too many instructions in flight\n",
+			core);
+		exit(1);
+	}
+	d = &c->inflight[(c->head + c->n) % MAX_INFLIGHT];
+	d->tag = tag;
+	d->nia = from_std_logic_vector(__nia, 64);
+	d->msr = from_std_logic_vector(__msr, 64);
+	d->insns = insns;
+	c->n++;
+}
+
+void cosim_retire(int core, int tag, unsigned char *__flags,
+		  int reg, unsigned char *__data,
+		  int reg2, unsigned char *__data2,
+		  unsigned char *__cr_mask, unsigned char *__cr_data,
+		  unsigned char *__xer, int vec, unsigned char *__srr0,
+		  unsigned char *__msr, unsigned char *__srr1)
+{
+	struct cosim *c = cosim_get(core);
+	uint64_t flags = from_std_logic_vector(__flags, 9);
+	uint64_t xer;
+	uint32_t b;
+
+	if (flags & RT_WRITE)
+		add_write(c, reg, from_std_logic_vector(__data, 64));
+	if (flags & RT_WRITE2)
+		add_write(c, reg2, from_std_logic_vector(__data2, 64));
+	if (flags & RT_CR) {
+		b = cr_bits(from_std_logic_vector(__cr_mask, 8));
+		c->cr_data = (c->cr_data & ~b) |
+			(from_std_logic_vector(__cr_data, 32) & b);
+		c->cr_mask |= from_std_logic_vector(__cr_mask, 8);
+	}
+	if (flags & RT_XER) {
+		/* SO OV CA OV32 CA32 */
+		xer = from_std_logic_vector(__xer, 5);
+		c->xer = ((xer & 0x10) ? ISA_XER_SO : 0) |
+			((xer & 0x08) ? ISA_XER_OV : 0) |
+			((xer & 0x04) ? ISA_XER_CA : 0) |
+			((xer & 0x02) ? ISA_XER_OV32 : 0) |
+			((xer & 0x01) ? ISA_XER_CA32 : 0);
+		c->xer_valid = true;
+	}
+
+	if (flags & (RT_INTR | RT_COMPLETE)) {
+		if (flags & RT_INTR)
+			interrupt(c, tag, vec, from_std_logic_vector(__srr0, 64),
+				  from_std_logic_vector(__msr, 64), flags,
+				  from_std_logic_vector(__srr1, 16));
+		else
+			complete(c, tag);
+		c->nwrites = 0;
+		c->cr_mask = 0;
+		c->cr_data = 0;
+		c->xer_valid = false;
+	}
+
+	/* Everything dispatched after the instruction that flushed goes */
+	if (flags & RT_FLUSH) {
+		c->n = 0;
+		c->nstores = 0;
+	}
+}
+
+void cosim_store(int core, int tag, unsigned char *__addr,
+		 unsigned char *__sel, unsigned char *__data)
+{
+	struct cosim *c = cosim_get(core);
+	uint64_t addr = from_std_logic_vector(__addr, 64);
+	uint64_t sel = from_std_logic_vector(__sel, 8);
+	uint64_t data = from_std_logic_vector(__data, 64);
+	struct stored *st;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		if (!(sel & (1 << i)))
+			continue;
+		if (c->nstores == MAX_STORE_BYTES) {
+			fprintf(stderr, "cosim: core %d: too many bytes stored in flight\n",
+				core);
+			exit(1);
+		}
+		st = &c->stores[c->nstores++];
+		st->tag = tag;
+		st->addr = addr + i;
+		st->val = data >> (8 * i);
+	}
+}
@@ -0,0 +1,26 @@
+library ieee;
+use ieee.std_logic_1164.all;
+
+package sim_ffwd is
+    procedure ffwd_syscon(idx: integer; val: std_ulogic_vector(63 downto 0));
+    attribute foreign of ffwd_syscon : procedure is "VHPIDIRECT ffwd_syscon";
+    procedure ffwd_run(insns: integer; pc: integer);
+    attribute foreign of ffwd_run : procedure is "VHPIDIRECT ffwd_run";
+    procedure ffwd_get_reg(idx: integer; val: out std_ulogic_vector(63 downto 0));
+    attribute foreign of ffwd_get_reg : procedure is "VHPIDIRECT ffwd_get_reg";
+end sim_ffwd;
+
+package body sim_ffwd is
+    procedure ffwd_syscon(idx: integer; val: std_ulogic_vector(63 downto 0)) is
+    begin
+        assert false report "VHPI" severity failure;
+    end ffwd_syscon;
+    procedure ffwd_run(insns: integer; pc: integer) is
+    begin
+        assert false report "VHPI" severity failure;
+    end ffwd_run;
+    procedure ffwd_get_reg(idx: integer; val: out std_ulogic_vector(63 downto 0)) is
+    begin
+        assert false report "VHPI" severity failure;
+    end ffwd_get_reg;
+end sim_ffwd;
@@ -0,0 +1,247 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "sim_vhpi_c.h"
+#include "sim_isa_model_c.h"
+
+/*
+ * Fast-forward for core_tb: run the start of a program in the ISA model
+ * on the main RAM image, then let sim_jtag load the model's registers
+ * into core 0 through the debug interface and start it.
+ *
+ * The model sees the syscon registers as read from the SoC beforehand
+ * and a console UART that prints to stderr like the simulated ones.
+ * Any other IO, a syscon write or a console read stops the model there.
+ */
+
+#define SYSCON_BASE		0xc0000000ul
+#define SYSCON_REGS		13
+#define SYS_REG_UART0_INFO	0x40
+#define SYS_REG_UART_IS_16550	(1ul << 32)
+
+#define UART0_BASE		0xc0002000ul
+#define UART0_SIZE		0x1000
+
+/* 16550 registers, 4 bytes apart */
+#define UART_REG_RX		0
+#define UART_REG_DLL		0
+#define UART_REG_IER		1
+#define UART_REG_FCR		2
+#define UART_REG_LCR		3
+#define UART_REG_MCR		4
+#define UART_REG_LSR		5
+#define UART_REG_MSR		6
+#define UART_REG_SCR		7
+#define UART_REG_LCR_DLAB	0x80
+#define UART_REG_LSR_IDLE	0x60	/* THRE | TEMT */
+
+/* Potato UART registers */
+#define POTATO_TX		0x00
+#define POTATO_RX		0x08
+#define POTATO_STATUS		0x10
+#define POTATO_CLOCK_DIV	0x18
+#define POTATO_IRQ_EN		0x20
+#define POTATO_STATUS_IDLE	0x03	/* RX_EMPTY | TX_EMPTY */
+
+/* Register numbers for ffwd_get_reg() past the GSPRs */
+#define FFWD_REG_NIA		0x100
+#define FFWD_REG_MSR		0x101
+#define FFWD_REG_CR		0x102
+
+void *behavioural_region(unsigned long nr, unsigned long *size);
+
+static struct isa_model model;
+static bool ffwd_done;
+static uint64_t syscon[SYSCON_REGS];
+static uint8_t uart_regs[8];
+static uint8_t uart_dl[2];
+static uint64_t potato_regs[5];
+
+static bool syscon_read(uint64_t off, int size, uint64_t *val)
+{
+	uint64_t v;
+
+	if (off / 8 >= SYSCON_REGS)
+		return false;
+	v = syscon[off / 8] >> (8 * (off % 8));
+	*val = size < 8 ? v & ((1ul << (8 * size)) - 1) : v;
+	return true;
+}
+
+static bool uart_is_16550(void)
+{
+	return syscon[SYS_REG_UART0_INFO / 8] & SYS_REG_UART_IS_16550;
+}
+
+static bool ffwd_io_read(struct isa_model *m, uint64_t addr, int size,
+			 uint64_t *val)
+{
+	uint64_t off;
+	int reg;
+
+	if (addr >= SYSCON_BASE && addr < SYSCON_BASE + 8 * SYSCON_REGS)
+		return syscon_read(addr - SYSCON_BASE, size, val);
+	if (addr < UART0_BASE || addr >= UART0_BASE + UART0_SIZE)
+		return false;
+
+	off = addr - UART0_BASE;
+	if (!uart_is_16550()) {
+		if (off == POTATO_STATUS)
+			*val = POTATO_STATUS_IDLE;
+		else if (off % 8 == 0 && off != POTATO_RX && off / 8 < 5)
+			*val = potato_regs[off / 8];
+		else
+			return false;
+		return true;
+	}
+
+	reg = off / 4;
+	if (off % 4 || reg > UART_REG_SCR)
+		return false;
+	switch (reg) {
+	case UART_REG_RX:
+	case UART_REG_IER:
+		if (!(uart_regs[UART_REG_LCR] & UART_REG_LCR_DLAB)) {
+			if (reg == UART_REG_RX)
+				return false;
+			*val = uart_regs[reg];
+		} else {
+			*val = uart_dl[reg];
+		}
+		break;
+	case UART_REG_FCR:
+		/* IIR, no interrupt pending */
+		*val = 0x01;
+		break;
+	case UART_REG_LSR:
+		*val = UART_REG_LSR_IDLE;
+		break;
+	case UART_REG_MSR:
+		*val = 0;
+		break;
+	default:
+		*val = uart_regs[reg];
+	}
+	return true;
+}
+
+static bool ffwd_io_write(struct isa_model *m, uint64_t addr, int size,
+			  uint64_t val)
+{
+	uint64_t off;
+	int reg;
+
+	if (addr < UART0_BASE || addr >= UART0_BASE + UART0_SIZE)
+		return false;
+
+	off = addr - UART0_BASE;
+	if (!uart_is_16550()) {
+		if (off == POTATO_TX)
+			fprintf(stderr, "%c", (int)(val & 0xff));
+		else if (off == POTATO_CLOCK_DIV || off == POTATO_IRQ_EN)
+			potato_regs[off / 8] = val;
+		else
+			return false;
+		return true;
+	}
+
+	reg = off / 4;
+	if (off % 4 || reg > UART_REG_SCR)
+		return false;
+	switch (reg) {
+	case UART_REG_RX:
+	case UART_REG_IER:
+		if (uart_regs[UART_REG_LCR] & UART_REG_LCR_DLAB)
+			uart_dl[reg] = val;
+		else if (reg == UART_REG_RX)
+			fprintf(stderr, "%c", (int)(val & 0xff));
+		else
+			uart_regs[reg] = val;
+		break;
+	case UART_REG_FCR:
+		break;
+	case UART_REG_LCR:
+	case UART_REG_MCR:
+	case UART_REG_SCR:
+		uart_regs[reg] = val;
+		break;
+	default:
+		return false;
+	}
+	return true;
+}
+
+void ffwd_syscon(int idx, unsigned char *__val)
+{
+	if (idx >= 0 && idx < SYSCON_REGS)
+		syscon[idx] = from_std_logic_vector(__val, 64);
+}
+
+void ffwd_run(int insns, int pc)
+{
+	struct isa_model *m = &model;
+	unsigned long size;
+	int rc = ISA_OK;
+
+	m->ram = behavioural_region(0, &size);
+	m->ram_size = size;
+	m->io_read = ffwd_io_read;
+	m->io_write = ffwd_io_write;
+	uart_regs[UART_REG_LCR] = 0x03;
+	isa_reset(m, 0);
+
+	while ((insns <= 0 || m->count < (uint64_t)insns) &&
+	       (pc < 0 || m->s.nia != (uint64_t)pc)) {
+		rc = isa_step(m);
+		if (rc != ISA_OK)
+			break;
+	}
+
+	ffwd_done = true;
+	fprintf(stderr, "ffwd: %lu instructions, handing over at %016lx",
+		m->count, m->s.nia);
+	if (rc == ISA_ATTN)
+		fprintf(stderr, " (attn)");
+	else if (rc != ISA_OK)
+		fprintf(stderr, " (%s: %08x)", m->why, m->insn);
+	fprintf(stderr, "\n");
+}
+
+void ffwd_get_reg(int idx, unsigned char *__val)
+{
+	struct isa_state *s = &model.s;
+	uint64_t val = 0;
+
+	if (idx < 0x20)
+		val = s->gpr[idx];
+	else if (idx >= 0x40 && idx < 0x60)
+		val = s->fpr[idx - 0x40];
+	else switch (idx) {
+	case 0x20:	val = s->lr; break;
+	case 0x21:	val = s->ctr; break;
+	case 0x22:	val = s->srr0; break;
+	case 0x23:	val = s->srr1; break;
+	case 0x24:	val = s->hsrr0; break;
+	case 0x25:	val = s->hsrr1; break;
+	case 0x26: case 0x27: case 0x28: case 0x29:
+		val = s->sprg[idx - 0x26];
+		break;
+	case 0x2a:	val = s->hsprg[0]; break;
+	case 0x2b:	val = s->hsprg[1]; break;
+	case 0x2c:	val = s->xer; break;
+	case 0x2d:	val = s->tar; break;
+	case 0x31:	val = s->cfar; break;
+	case FFWD_REG_NIA:	val = s->nia; break;
+	case FFWD_REG_MSR:	val = s->msr; break;
+	case FFWD_REG_CR:	val = s->cr; break;
+	}
+	to_std_logic_vector(val, __val, 64);
+}
+
+/* The state handed over to core 0, for the co-simulation checker */
+const struct isa_state *ffwd_state(void)
+{
+	return ffwd_done ? &model.s : NULL;
+}
@@ -0,0 +1,1362 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "sim_isa_model_c.h"
+
+/*
+ * Reference model for the sim fast-forward and co-simulation modes.
+ * It follows what the Microwatt RTL does where the architecture leaves
+ * a choice (results of overflowing divides, mulhw, the MSR bits that
+ * rfid and mtmsrd copy), so that its results can be compared with the
+ * core's bit for bit.
+ *
+ * Each step runs on a copy of the architected state, which is only
+ * written back once nothing can fail any more. A store is held back to
+ * the very end for the same reason.
+ */
+
+#define MSR_SF		(1ul << 63)
+#define MSR_HV		(1ul << 60)
+#define MSR_EE		(1ul << 15)
+#define MSR_PR		(1ul << 14)
+#define MSR_FP		(1ul << 13)
+#define MSR_FE0		(1ul << 11)
+#define MSR_SE		(1ul << 10)
+#define MSR_BE		(1ul << 9)
+#define MSR_FE1		(1ul << 8)
+#define MSR_IR		(1ul << 5)
+#define MSR_DR		(1ul << 4)
+#define MSR_RI		(1ul << 1)
+#define MSR_LE		(1ul << 0)
+
+/* The model only runs in real mode, 64-bit, little-endian, without
+ * tracing and with interrupts off */
+#define MSR_MODE_MASK	(MSR_SF | MSR_LE | MSR_IR | MSR_DR | MSR_PR | \
+			 MSR_EE | MSR_SE | MSR_BE)
+#define MSR_MODE	(MSR_SF | MSR_LE)
+
+/* SRR1 takes the MSR except for the interrupt flag bits */
+#define SRR1_MSR_MASK	0xffffffff87c0fffful
+
+/* The SoC bus decodes 32 address bits */
+#define REAL_ADDR_MASK	0xfffffffful
+
+#define PVR_MICROWATT	0x00630000ul
+
+#define DCBZ_SIZE	64
+
+#define PO(i)		((i) >> 26)
+#define RT(i)		(((i) >> 21) & 0x1f)
+#define RA(i)		(((i) >> 16) & 0x1f)
+#define RB(i)		(((i) >> 11) & 0x1f)
+#define RC(i)		(((i) >> 6) & 0x1f)
+#define XO10(i)		(((i) >> 1) & 0x3ff)
+#define XO9(i)		(((i) >> 1) & 0x1ff)
+#define OE(i)		(((i) >> 10) & 1)
+#define RCBIT(i)	((i) & 1)
+#define SI(i)		((uint64_t)(int64_t)(int16_t)((i) & 0xffff))
+#define UI(i)		((uint64_t)((i) & 0xffff))
+#define DS(i)		((uint64_t)(int64_t)(int16_t)((i) & 0xfffc))
+#define SPRN(i)		((((i) >> 16) & 0x1f) | ((((i) >> 11) & 0x1f) << 5))
+
+/* Flags for ldst() */
+#define LS_STORE	0x01
+#define LS_UPDATE	0x02
+#define LS_SIGN		0x04
+#define LS_BREV		0x08
+#define LS_FP		0x10
+#define LS_SINGLE	0x20
+#define LS_RESERVE	0x40
+
+struct step {
+	struct isa_model *m;
+	struct isa_state *n;
+	uint32_t insn;
+	uint64_t cia;
+
+	/* Store held back until the end of the step */
+	int st_size;
+	uint64_t st_ea;
+	uint64_t st_val;
+};
+
+static int stop(struct step *c, const char *why)
+{
+	if (!c->m->why)
+		c->m->why = why;
+	return ISA_STOP;
+}
+
+static void record(struct step *c, int reg, uint64_t val)
+{
+	struct isa_model *m = c->m;
+
+	if (m->nwrites < ISA_MAX_WRITES) {
+		m->writes[m->nwrites].reg = reg;
+		m->writes[m->nwrites].val = val;
+		m->nwrites++;
+	}
+}
+
+static void set_gpr(struct step *c, int r, uint64_t val)
+{
+	c->n->gpr[r] = val;
+	record(c, ISA_REG_GPR(r), val);
+}
+
+static void set_fpr(struct step *c, int r, uint64_t val)
+{
+	c->n->fpr[r] = val;
+	record(c, ISA_REG_FPR(r), val);
+}
+
+static uint64_t gpr0(struct step *c, int r)
+{
+	return r ? c->n->gpr[r] : 0;
+}
+
+/* MSB 0 numbered mask of bits mb to me, wrapping if mb > me */
+static uint64_t mask64(unsigned mb, unsigned me)
+{
+	uint64_t m1 = ~0ul >> mb;
+	uint64_t m2 = ~0ul << (63 - me);
+
+	return mb <= me ? (m1 & m2) : (m1 | m2);
+}
+
+/* LSB 0 numbered mask of bits hi down to lo */
+static uint64_t bits(unsigned hi, unsigned lo)
+{
+	return (~0ul >> (63 - hi)) & (~0ul << lo);
+}
+
+static uint64_t rotl64(uint64_t x, unsigned n)
+{
+	n &= 63;
+	return n ? (x << n) | (x >> (64 - n)) : x;
+}
+
+static uint64_t rotl32(uint64_t x, unsigned n)
+{
+	x &= 0xffffffff;
+	return rotl64(x | (x << 32), n);
+}
+
+static uint64_t sext32(uint64_t x)
+{
+	return (uint64_t)(int64_t)(int32_t)x;
+}
+
+static uint64_t byte_reverse(uint64_t x, int size)
+{
+	uint64_t r = 0;
+	int i;
+
+	for (i = 0; i < size; i++)
+		r |= ((x >> (8 * i)) & 0xff) << (8 * (size - 1 - i));
+	return r;
+}
+
+static unsigned cr_bit(struct isa_state *n, unsigned bi)
+{
+	return (n->cr >> (31 - bi)) & 1;
+}
+
+static unsigned cr_field(struct isa_state *n, unsigned bf)
+{
+	return (n->cr >> (28 - 4 * bf)) & 0xf;
+}
+
+static void set_cr_field(struct isa_state *n, unsigned bf, unsigned val)
+{
+	unsigned sh = 28 - 4 * bf;
+
+	n->cr = (n->cr & ~(0xfu << sh)) | ((val & 0xf) << sh);
+}
+
+static unsigned xer_so(struct isa_state *n)
+{
+	return !!(n->xer & ISA_XER_SO);
+}
+
+static unsigned cmp_signed(int64_t a, int64_t b)
+{
+	return a < b ? 8 : a > b ? 4 : 2;
+}
+
+static unsigned cmp_unsigned(uint64_t a, uint64_t b)
+{
+	return a < b ? 8 : a > b ? 4 : 2;
+}
+
+static void set_cr0(struct step *c, uint64_t val)
+{
+	set_cr_field(c->n, 0, cmp_signed(val, 0) | xer_so(c->n));
+}
+
+static void set_ca(struct isa_state *n, unsigned ca, unsigned ca32)
+{
+	n->xer &= ~(ISA_XER_CA | ISA_XER_CA32);
+	if (ca)
+		n->xer |= ISA_XER_CA;
+	if (ca32)
+		n->xer |= ISA_XER_CA32;
+}
+
+static void set_ov(struct isa_state *n, unsigned ov, unsigned ov32)
+{
+	n->xer &= ~(ISA_XER_OV | ISA_XER_OV32);
+	if (ov)
+		n->xer |= ISA_XER_OV | ISA_XER_SO;
+	if (ov32)
+		n->xer |= ISA_XER_OV32;
+}
+
+/* a + b + ci, with the carries and overflows out of 64 and 32 bits */
+static uint64_t add3(uint64_t a, uint64_t b, unsigned ci, unsigned *ca,
+		     unsigned *ca32, unsigned *ov, unsigned *ov32)
+{
+	uint64_t r = a + b + ci;
+	uint64_t o = ~(a ^ b) & (a ^ r);
+
+	*ca = ((unsigned __int128)a + b + ci) >> 64;
+	*ca32 = (((a & 0xffffffff) + (b & 0xffffffff) + ci) >> 32) & 1;
+	*ov = (o >> 63) & 1;
+	*ov32 = (o >> 31) & 1;
+	return r;
+}
+
+/* Load Floating-Point Single conversion, from the ISA */
+static uint64_t sp_to_dp(uint32_t w)
+{
+	uint64_t sign = (uint64_t)(w >> 31) << 63;
+	unsigned exp = (w >> 23) & 0xff;
+	uint64_t frac = w & 0x7fffff;
+	uint64_t w1 = (w >> 30) & 1;
+	int e;
+
+	if (exp == 0 && frac != 0) {
+		e = -126;
+		while (!(frac & 0x800000)) {
+			frac <<= 1;
+			e--;
+		}
+		return sign | ((uint64_t)(e + 1023) << 52) | ((frac & 0x7fffff) << 29);
+	}
+	if (exp != 0 && exp != 255)
+		w1 = !w1;
+	return sign | (((uint64_t)(w >> 30) & 1) << 62) | ((w1 ? 7ul : 0) << 59) |
+		((uint64_t)(w & 0x3fffffff) << 29);
+}
+
+/* Store Floating-Point Single conversion, from the ISA */
+static uint32_t dp_to_sp(uint64_t d)
+{
+	unsigned exp = (d >> 52) & 0x7ff;
+	uint64_t frac;
+	int e;
+
+	if (exp <= 896 && exp >= 874 && (d << 1) != 0) {
+		frac = (1ul << 52) | (d & bits(51, 0));
+		e = exp - 1023;
+		while (e < -126) {
+			frac >>= 1;
+			e++;
+		}
+		return ((d >> 63) << 31) | ((frac >> 29) & 0x7fffff);
+	}
+	return ((d >> 32) & 0xc0000000) | ((d >> 29) & 0x3fffffff);
+}
+
+static uint8_t *ram_ptr(struct isa_model *m, uint64_t ra, int size)
+{
+	if (ra >= ISA_RAM_ALIAS && ra < ISA_IO_BASE)
+		ra -= ISA_RAM_ALIAS;
+	if (ra >= m->ram_size || (uint64_t)size > m->ram_size - ra)
+		return NULL;
+	return m->ram + ra;
+}
+
+uint8_t *isa_ram_ptr(struct isa_model *m, uint64_t ra, int size)
+{
+	return ram_ptr(m, ra & REAL_ADDR_MASK, size);
+}
+
+static bool mem_read(struct step *c, uint64_t ea, int size, uint64_t *val)
+{
+	struct isa_model *m = c->m;
+	uint64_t ra = ea & REAL_ADDR_MASK;
+	uint8_t *p = ram_ptr(m, ra, size);
+	int i;
+
+	if (p) {
+		*val = 0;
+		for (i = 0; i < size; i++)
+			*val |= (uint64_t)p[i] << (8 * i);
+		return true;
+	}
+	if (ra >= ISA_IO_BASE && ra + size <= ISA_IO_END && size <= 8) {
+		if (m->io_read && m->io_read(m, ra, size, val))
+			return true;
+		stop(c, "IO load");
+		return false;
+	}
+	stop(c, "load outside RAM");
+	return false;
+}
+
+static bool mem_write(struct step *c, uint64_t ea, int size, uint64_t val)
+{
+	struct isa_model *m = c->m;
+	uint64_t ra = ea & REAL_ADDR_MASK;
+	uint8_t *p = ram_ptr(m, ra, size);
+	int i;
+
+	if (p) {
+		if (size == DCBZ_SIZE) {
+			memset(p, 0, size);
+			return true;
+		}
+		for (i = 0; i < size; i++)
+			p[i] = val >> (8 * i);
+		return true;
+	}
+	if (ra >= ISA_IO_BASE && ra + size <= ISA_IO_END && size <= 8) {
+		if (m->io_write && m->io_write(m, ra, size, val))
+			return true;
+		stop(c, "IO store");
+		return false;
+	}
+	stop(c, "store outside RAM");
+	return false;
+}
+
+static int ldst(struct step *c, uint64_t ea, int rt, int ra, int size, int flags)
+{
+	struct isa_state *n = c->n;
+	uint64_t val;
+	bool ok;
+
+	if ((flags & LS_UPDATE) &&
+	    (ra == 0 || (!(flags & (LS_STORE | LS_FP)) && ra == rt)))
+		return stop(c, "invalid update form");
+	if ((flags & LS_FP) && !(n->msr & MSR_FP))
+		return stop(c, "FP unavailable");
+	if ((flags & LS_RESERVE) && (ea & (size - 1)))
+		return stop(c, "unaligned larx/stcx.");
+
+	if (flags & LS_STORE) {
+		if (!(flags & LS_FP))
+			val = n->gpr[rt];
+		else if (flags & LS_SINGLE)
+			val = dp_to_sp(n->fpr[rt]);
+		else
+			val = n->fpr[rt];
+		if (flags & LS_BREV)
+			val = byte_reverse(val, size);
+		if (flags & LS_RESERVE) {
+			ok = n->reserve && n->reserve_addr == ea;
+			n->reserve = false;
+			set_cr_field(n, 0, (ok ? 2 : 0) | xer_so(n));
+			if (!ok)
+				return ISA_OK;
+		}
+		c->st_size = size;
+		c->st_ea = ea;
+		c->st_val = val;
+	} else {
+		if (!mem_read(c, ea, size, &val))
+			return ISA_STOP;
+		if (flags & LS_BREV)
+			val = byte_reverse(val, size);
+		if ((flags & LS_SIGN) && size < 8)
+			val = (uint64_t)((int64_t)(val << (64 - 8 * size)) >> (64 - 8 * size));
+		if (!(flags & LS_FP))
+			set_gpr(c, rt, val);
+		else if (flags & LS_SINGLE)
+			set_fpr(c, rt, sp_to_dp(val));
+		else
+			set_fpr(c, rt, val);
+		if (flags & LS_RESERVE) {
+			n->reserve = true;
+			n->reserve_addr = ea;
+		}
+	}
+	if (flags & LS_UPDATE)
+		set_gpr(c, ra, ea);
+	return ISA_OK;
+}
+
+static int ldst_d(struct step *c, int size, int flags)
+{
+	uint32_t i = c->insn;
+
+	return ldst(c, gpr0(c, RA(i)) + SI(i), RT(i), RA(i), size, flags);
+}
+
+static int ldst_ds(struct step *c, int size, int flags)
+{
+	uint32_t i = c->insn;
+
+	return ldst(c, gpr0(c, RA(i)) + DS(i), RT(i), RA(i), size, flags);
+}
+
+static int ldst_x(struct step *c, int size, int flags)
+{
+	uint32_t i = c->insn;
+
+	return ldst(c, gpr0(c, RA(i)) + c->n->gpr[RB(i)], RT(i), RA(i), size, flags);
+}
+
+static void branch(struct step *c, uint64_t target)
+{
+	c->n->cfar = c->cia;
+	c->n->nia = target;
+}
+
+/* BO test for bc, bclr, bcctr and bctar; decrements CTR if asked */
+static bool bo_taken(struct isa_state *n, unsigned bo, unsigned bi)
+{
+	bool ctr_ok = true;
+	bool cond_ok;
+
+	if (!(bo & 4)) {
+		n->ctr--;
+		ctr_ok = (n->ctr != 0) ^ !!(bo & 2);
+	}
+	cond_ok = (bo & 0x10) || cr_bit(n, bi) == !!(bo & 8);
+	return ctr_ok && cond_ok;
+}
+
+static bool trap_taken(unsigned to, int64_t a, int64_t b)
+{
+	return ((to & 0x10) && a < b) || ((to & 0x08) && a > b) ||
+		((to & 0x04) && a == b) ||
+		((to & 0x02) && (uint64_t)a < (uint64_t)b) ||
+		((to & 0x01) && (uint64_t)a > (uint64_t)b);
+}
+
+static void take_interrupt(struct step *c, uint64_t vec, uint64_t srr0)
+{
+	struct isa_state *n = c->n;
+
+	n->srr0 = srr0;
+	n->srr1 = n->msr & SRR1_MSR_MASK;
+	n->msr |= MSR_SF | MSR_LE;
+	n->msr &= ~(MSR_PR | MSR_SE | MSR_BE | MSR_FP | MSR_FE0 | MSR_FE1 |
+		    MSR_IR | MSR_DR | MSR_EE | MSR_RI);
+	n->nia = vec;
+}
+
+static uint64_t popcnt_bytes(uint64_t x)
+{
+	uint64_t r = 0;
+	int i;
+
+	for (i = 0; i < 8; i++)
+		r |= (uint64_t)__builtin_popcountll(x & (0xfful << (8 * i))) << (8 * i);
+	return r;
+}
+
+/*
+ * Microwatt's divider: any overflow, including divide by zero, gives
+ * 0, and a 32-bit divide zeroes the upper half of the quotient.
+ */
+static uint64_t divide(uint32_t insn, uint64_t a, uint64_t b, unsigned *ovf)
+{
+	unsigned xo = XO9(insn);
+	__int128 sq;
+	unsigned __int128 uq;
+	int32_t a32 = a, b32 = b;
+
+	*ovf = 1;
+	switch (xo) {
+	case 489:	/* divd */
+		if (b == 0 || ((int64_t)a == INT64_MIN && (int64_t)b == -1))
+			return 0;
+		*ovf = 0;
+		return (int64_t)a / (int64_t)b;
+	case 457:	/* divdu */
+		if (b == 0)
+			return 0;
+		*ovf = 0;
+		return a / b;
+	case 491:	/* divw */
+		if (b32 == 0 || (a32 == INT32_MIN && b32 == -1))
+			return 0;
+		*ovf = 0;
+		return (uint32_t)(a32 / b32);
+	case 459:	/* divwu */
+		if ((uint32_t)b == 0)
+			return 0;
+		*ovf = 0;
+		return (uint32_t)a / (uint32_t)b;
+	case 425:	/* divde */
+		if (b == 0)
+			return 0;
+		sq = ((__int128)(int64_t)a * ((__int128)1 << 64)) / (int64_t)b;
+		if (sq < INT64_MIN || sq > INT64_MAX)
+			return 0;
+		*ovf = 0;
+		return (uint64_t)sq;
+	case 393:	/* divdeu */
+		if (b == 0 || a >= b)
+			return 0;
+		uq = ((unsigned __int128)a << 64) / b;
+		*ovf = 0;
+		return (uint64_t)uq;
+	case 427:	/* divwe */
+		if (b32 == 0)
+			return 0;
+		sq = (int64_t)((uint64_t)(int64_t)a32 << 32) / b32;
+		if (sq < INT32_MIN || sq > INT32_MAX)
+			return 0;
+		*ovf = 0;
+		return (uint32_t)sq;
+	case 395:	/* divweu */
+		if ((uint32_t)b == 0 || (uint32_t)a >= (uint32_t)b)
+			return 0;
+		*ovf = 0;
+		return (uint32_t)(((uint64_t)(uint32_t)a << 32) / (uint32_t)b);
+	}
+	return 0;
+}
+
+/* XO-form arithmetic; returns -1 if xo isn't one */
+static int exec_xo(struct step *c)
+{
+	struct isa_state *n = c->n;
+	uint32_t i = c->insn;
+	uint64_t a = n->gpr[RA(i)], b = n->gpr[RB(i)], r;
+	unsigned ca = 0, ca32 = 0, ov = 0, ov32 = 0;
+	unsigned cin = !!(n->xer & ISA_XER_CA);
+	bool carry = false;
+	__int128 p;
+	unsigned __int128 up;
+
+	switch (XO9(i)) {
+	case 266:	/* add */
+		r = add3(a, b, 0, &ca, &ca32, &ov, &ov32);
+		break;
+	case 10:	/* addc */
+		r = add3(a, b, 0, &ca, &ca32, &ov, &ov32);
+		carry = true;
+		break;
+	case 138:	/* adde */
+		r = add3(a, b, cin, &ca, &ca32, &ov, &ov32);
+		carry = true;
+		break;
+	case 234:	/* addme */
+		r = add3(a, ~0ul, cin, &ca, &ca32, &ov, &ov32);
+		carry = true;
+		break;
+	case 202:	/* addze */
+		r = add3(a, 0, cin, &ca, &ca32, &ov, &ov32);
+		carry = true;
+		break;
+	case 40:	/* subf */
+		r = add3(~a, b, 1, &ca, &ca32, &ov, &ov32);
+		break;
+	case 8:		/* subfc */
+		r = add3(~a, b, 1, &ca, &ca32, &ov, &ov32);
+		carry = true;
+		break;
+	case 136:	/* subfe */
+		r = add3(~a, b, cin, &ca, &ca32, &ov, &ov32);
+		carry = true;
+		break;
+	case 232:	/* subfme */
+		r = add3(~a, ~0ul, cin, &ca, &ca32, &ov, &ov32);
+		carry = true;
+		break;
+	case 200:	/* subfze */
+		r = add3(~a, 0, cin, &ca, &ca32, &ov, &ov32);
+		carry = true;
+		break;
+	case 104:	/* neg */
+		r = add3(~a, 0, 1, &ca, &ca32, &ov, &ov32);
+		break;
+	case 235:	/* mullw */
+		r = (int64_t)(int32_t)a * (int32_t)b;
+		ov = ov32 = r != sext32(r);
+		break;
+	case 233:	/* mulld */
+		p = (__int128)(int64_t)a * (int64_t)b;
+		r = (uint64_t)p;
+		ov = ov32 = p != (int64_t)r;
+		break;
+	case 75:	/* mulhw */
+		if (OE(i))
+			return stop(c, "invalid form");
+		r = ((uint64_t)((int64_t)(int32_t)a * (int32_t)b) >> 32) & 0xffffffff;
+		r |= r << 32;
+		break;
+	case 11:	/* mulhwu */
+		if (OE(i))
+			return stop(c, "invalid form");
+		r = ((uint64_t)(uint32_t)a * (uint32_t)b) >> 32;
+		r |= r << 32;
+		break;
+	case 73:	/* mulhd */
+		if (OE(i))
+			return stop(c, "invalid form");
+		r = (uint64_t)(((__int128)(int64_t)a * (int64_t)b) >> 64);
+		break;
+	case 9:		/* mulhdu */
+		if (OE(i))
+			return stop(c, "invalid form");
+		up = (unsigned __int128)a * b;
+		r = up >> 64;
+		break;
+	case 489: case 457: case 491: case 459:
+	case 425: case 393: case 427: case 395:
+		r = divide(i, a, b, &ov);
+		ov32 = ov;
+		break;
+	default:
+		return -1;
+	}
+	if (carry)
+		set_ca(n, ca, ca32);
+	if (OE(i))
+		set_ov(n, ov, ov32);
+	set_gpr(c, RT(i), r);
+	if (RCBIT(i))
+		set_cr0(c, r);
+	return ISA_OK;
+}
+
+static int mfspr(struct step *c, unsigned spr, uint64_t *val)
+{
+	struct isa_state *n = c->n;
+
+	switch (spr) {
+	case 1:
+		*val = n->xer & (ISA_XER_SO | ISA_XER_OV | ISA_XER_CA |
+				 ISA_XER_OV32 | ISA_XER_CA32 | ISA_XER_LOW);
+		break;
+	case 8:		*val = n->lr; break;
+	case 9:		*val = n->ctr; break;
+	case 26:	*val = n->srr0; break;
+	case 27:	*val = n->srr1; break;
+	case 28:	*val = n->cfar; break;
+	case 259:	*val = n->sprg[3]; break;
+	case 268:
+	case 269:
+		if (c->m->no_tb)
+			return stop(c, "time base read");
+		*val = spr == 268 ? n->tb : n->tb >> 32;
+		break;
+	case 272: case 273: case 274: case 275:
+		*val = n->sprg[spr - 272];
+		break;
+	case 287:	*val = PVR_MICROWATT; break;
+	case 304:	*val = n->hsprg[0]; break;
+	case 305:	*val = n->hsprg[1]; break;
+	case 314:	*val = n->hsrr0; break;
+	case 315:	*val = n->hsrr1; break;
+	case 815:	*val = n->tar; break;
+	case 1023:	*val = c->m->pir; break;
+	default:
+		return stop(c, "mfspr from an unmodelled SPR");
+	}
+	return ISA_OK;
+}
+
+static int mtspr(struct step *c, unsigned spr, uint64_t val)
+{
+	struct isa_state *n = c->n;
+
+	switch (spr) {
+	case 1:
+		n->xer = val & (ISA_XER_SO | ISA_XER_OV | ISA_XER_CA |
+				ISA_XER_OV32 | ISA_XER_CA32 | ISA_XER_LOW);
+		break;
+	case 8:		n->lr = val; break;
+	case 9:		n->ctr = val; break;
+	case 26:	n->srr0 = val; break;
+	case 27:	n->srr1 = val; break;
+	case 28:	n->cfar = val; break;
+	case 272: case 273: case 274: case 275:
+		n->sprg[spr - 272] = val;
+		break;
+	case 304:	n->hsprg[0] = val; break;
+	case 305:	n->hsprg[1] = val; break;
+	case 314:	n->hsrr0 = val; break;
+	case 315:	n->hsrr1 = val; break;
+	case 815:	n->tar = val; break;
+	default:
+		return stop(c, "mtspr to an unmodelled SPR");
+	}
+	return ISA_OK;
+}
+
+/* Shifts and rotates of primary opcode 31; returns -1 if xo isn't one */
+static int exec_shift(struct step *c)
+{
+	struct isa_state *n = c->n;
+	uint32_t i = c->insn;
+	uint64_t s = n->gpr[RT(i)], b = n->gpr[RB(i)], r;
+	unsigned sh;
+	bool neg, lost;
+
+	switch (XO10(i)) {
+	case 24:	/* slw */
+		sh = b & 0x3f;
+		r = sh < 32 ? ((s & 0xffffffff) << sh) & 0xffffffff : 0;
+		break;
+	case 536:	/* srw */
+		sh = b & 0x3f;
+		r = sh < 32 ? (s & 0xffffffff) >> sh : 0;
+		break;
+	case 27:	/* sld */
+		sh = b & 0x7f;
+		r = sh < 64 ? s << sh : 0;
+		break;
+	case 539:	/* srd */
+		sh = b & 0x7f;
+		r = sh < 64 ? s >> sh : 0;
+		break;
+	case 792:	/* sraw */
+	case 824:	/* srawi */
+		sh = XO10(i) == 824 ? RB(i) : b & 0x3f;
+		neg = (int32_t)s < 0;
+		if (sh < 32) {
+			r = (uint64_t)((int64_t)(int32_t)s >> sh);
+			lost = neg && sh && (s & bits(sh - 1, 0));
+			set_ca(n, lost, lost);
+		} else {
+			r = neg ? ~0ul : 0;
+			set_ca(n, neg, neg);
+		}
+		break;
+	case 794:	/* srad */
+	case 826: case 827:	/* sradi */
+		sh = XO10(i) == 794 ? b & 0x7f : RB(i) | ((i & 2) << 4);
+		neg = (int64_t)s < 0;
+		if (sh < 64) {
+			r = (uint64_t)((int64_t)s >> sh);
+			lost = neg && sh && (s & bits(sh - 1, 0));
+			set_ca(n, lost, lost);
+		} else {
+			r = neg ? ~0ul : 0;
+			set_ca(n, neg, neg);
+		}
+		break;
+	case 890: case 891:	/* extswsli */
+		sh = RB(i) | ((i & 2) << 4);
+		r = sext32(s) << sh;
+		break;
+	default:
+		return -1;
+	}
+	set_gpr(c, RA(i), r);
+	if (RCBIT(i))
+		set_cr0(c, r);
+	return ISA_OK;
+}
+
+/* Logical and bit counting ops of primary opcode 31; -1 if not one */
+static int exec_logical(struct step *c)
+{
+	struct isa_state *n = c->n;
+	uint32_t i = c->insn;
+	uint64_t s = n->gpr[RT(i)], b = n->gpr[RB(i)], r;
+	bool rc = RCBIT(i);
+	int k;
+
+	switch (XO10(i)) {
+	case 28:	r = s & b; break;		/* and */
+	case 60:	r = s & ~b; break;		/* andc */
+	case 124:	r = ~(s | b); break;		/* nor */
+	case 444:	r = s | b; break;		/* or */
+	case 316:	r = s ^ b; break;		/* xor */
+	case 412:	r = s | ~b; break;		/* orc */
+	case 476:	r = ~(s & b); break;		/* nand */
+	case 284:	r = ~(s ^ b); break;		/* eqv */
+	case 954:	r = (int64_t)(int8_t)s; break;	/* extsb */
+	case 922:	r = (int64_t)(int16_t)s; break;	/* extsh */
+	case 986:	r = sext32(s); break;		/* extsw */
+	case 26:	/* cntlzw */
+		r = (uint32_t)s ? __builtin_clz((uint32_t)s) : 32;
+		break;
+	case 58:	/* cntlzd */
+		r = s ? __builtin_clzll(s) : 64;
+		break;
+	case 538:	/* cnttzw */
+		r = (uint32_t)s ? __builtin_ctz((uint32_t)s) : 32;
+		break;
+	case 570:	/* cnttzd */
+		r = s ? __builtin_ctzll(s) : 64;
+		break;
+	case 122:	/* popcntb */
+		r = popcnt_bytes(s);
+		rc = false;
+		break;
+	case 378:	/* popcntw */
+		r = __builtin_popcountll(s & 0xffffffff) |
+			((uint64_t)__builtin_popcountll(s >> 32) << 32);
+		rc = false;
+		break;
+	case 506:	/* popcntd */
+		r = __builtin_popcountll(s);
+		rc = false;
+		break;
+	case 154:	/* prtyw */
+		r = (__builtin_popcountll(s & 0x01010101) & 1) |
+			((uint64_t)(__builtin_popcountll(s & 0x0101010100000000ul) & 1) << 32);
+		rc = false;
+		break;
+	case 186:	/* prtyd */
+		r = __builtin_popcountll(s & 0x0101010101010101ul) & 1;
+		rc = false;
+		break;
+	case 508:	/* cmpb */
+		r = 0;
+		for (k = 0; k < 8; k++)
+			if (((s ^ b) >> (8 * k) & 0xff) == 0)
+				r |= 0xfful << (8 * k);
+		rc = false;
+		break;
+	case 252:	/* bpermd */
+		r = 0;
+		for (k = 0; k < 8; k++) {
+			unsigned idx = (s >> (56 - 8 * k)) & 0xff;
+
+			if (idx < 64 && ((b >> (63 - idx)) & 1))
+				r |= 1ul << (7 - k);
+		}
+		rc = false;
+		break;
+	default:
+		return -1;
+	}
+	set_gpr(c, RA(i), r);
+	if (rc)
+		set_cr0(c, r);
+	return ISA_OK;
+}
+
+static int exec_31(struct step *c)
+{
+	struct isa_state *n = c->n;
+	uint32_t i = c->insn;
+	uint64_t a = n->gpr[RA(i)], b = n->gpr[RB(i)], s = n->gpr[RT(i)];
+	uint64_t r, msk;
+	unsigned bf = RT(i) >> 2, fxm, f, cr;
+	int rc;
+
+	/* isel is A-form */
+	if (XO9(i) % 32 == 15) {
+		set_gpr(c, RT(i), cr_bit(n, RC(i)) ? gpr0(c, RA(i)) : b);
+		return ISA_OK;
+	}
+	rc = exec_xo(c);
+	if (rc < 0)
+		rc = exec_shift(c);
+	if (rc < 0)
+		rc = exec_logical(c);
+	if (rc >= 0)
+		return rc;
+
+	switch (XO10(i)) {
+	case 0:		/* cmp */
+		if (RT(i) & 1)
+			cr = cmp_signed(a, b);
+		else
+			cr = cmp_signed((int32_t)a, (int32_t)b);
+		set_cr_field(n, bf, cr | xer_so(n));
+		return ISA_OK;
+	case 32:	/* cmpl */
+		if (RT(i) & 1)
+			cr = cmp_unsigned(a, b);
+		else
+			cr = cmp_unsigned((uint32_t)a, (uint32_t)b);
+		set_cr_field(n, bf, cr | xer_so(n));
+		return ISA_OK;
+	case 4:		/* tw */
+		if (trap_taken(RT(i), (int32_t)a, (int32_t)b))
+			return stop(c, "trap");
+		return ISA_OK;
+	case 68:	/* td */
+		if (trap_taken(RT(i), a, b))
+			return stop(c, "trap");
+		return ISA_OK;
+
+	case 779:	/* modsw */
+		if ((int32_t)b == 0 || ((int32_t)a == INT32_MIN && (int32_t)b == -1))
+			r = 0;
+		else
+			r = (int64_t)((int32_t)a % (int32_t)b);
+		set_gpr(c, RT(i), r);
+		return ISA_OK;
+	case 267:	/* moduw */
+		r = (uint32_t)b ? (uint32_t)a % (uint32_t)b : 0;
+		set_gpr(c, RT(i), r);
+		return ISA_OK;
+	case 777:	/* modsd */
+		if (b == 0 || ((int64_t)a == INT64_MIN && (int64_t)b == -1))
+			r = 0;
+		else
+			r = (int64_t)a % (int64_t)b;
+		set_gpr(c, RT(i), r);
+		return ISA_OK;
+	case 265:	/* modud */
+		set_gpr(c, RT(i), b ? a % b : 0);
+		return ISA_OK;
+
+	case 19:	/* mfcr, mfocrf */
+		if (i & (1 << 20)) {
+			fxm = (i >> 12) & 0xff;
+			if (__builtin_popcount(fxm) != 1)
+				return stop(c, "mfocrf with more than one field");
+			f = __builtin_clz(fxm) - 24;
+			set_gpr(c, RT(i), n->cr & (0xfu << (28 - 4 * f)));
+		} else {
+			set_gpr(c, RT(i), n->cr);
+		}
+		return ISA_OK;
+	case 144:	/* mtcrf, mtocrf */
+		fxm = (i >> 12) & 0xff;
+		if ((i & (1 << 20)) && __builtin_popcount(fxm) != 1)
+			return stop(c, "mtocrf with more than one field");
+		msk = 0;
+		for (f = 0; f < 8; f++)
+			if (fxm & (0x80 >> f))
+				msk |= 0xful << (28 - 4 * f);
+		n->cr = (n->cr & ~msk) | (s & msk);
+		return ISA_OK;
+	case 576:	/* mcrxrx */
+		set_cr_field(n, bf, (!!(n->xer & ISA_XER_OV) << 3) |
+			     (!!(n->xer & ISA_XER_OV32) << 2) |
+			     (!!(n->xer & ISA_XER_CA) << 1) |
+			     !!(n->xer & ISA_XER_CA32));
+		return ISA_OK;
+	case 128:	/* setb */
+		cr = cr_field(n, RA(i) >> 2);
+		set_gpr(c, RT(i), (cr & 8) ? ~0ul : (cr & 4) ? 1 : 0);
+		return ISA_OK;
+
+	case 339:	/* mfspr */
+	case 371:	/* mftb */
+		rc = mfspr(c, SPRN(i), &r);
+		if (rc == ISA_OK)
+			set_gpr(c, RT(i), r);
+		return rc;
+	case 467:	/* mtspr */
+		return mtspr(c, SPRN(i), s);
+	case 83:	/* mfmsr */
+		set_gpr(c, RT(i), n->msr);
+		return ISA_OK;
+	case 146:	/* mtmsr */
+	case 178:	/* mtmsrd */
+		if (i & (1 << 16)) {
+			n->msr = (n->msr & ~(MSR_EE | MSR_RI)) | (s & (MSR_EE | MSR_RI));
+			return ISA_OK;
+		}
+		/* HV, ME and LE are left alone */
+		msk = bits(31, 13) | bits(11, 1);
+		if (XO10(i) == 178)
+			msk |= bits(63, 61) | bits(59, 32);
+		n->msr = (n->msr & ~msk) | (s & msk);
+		if (s & MSR_PR)
+			n->msr |= MSR_EE | MSR_IR | MSR_DR;
+		return ISA_OK;
+
+	/* Loads */
+	case 87:	return ldst_x(c, 1, 0);				/* lbzx */
+	case 119:	return ldst_x(c, 1, LS_UPDATE);			/* lbzux */
+	case 279:	return ldst_x(c, 2, 0);				/* lhzx */
+	case 311:	return ldst_x(c, 2, LS_UPDATE);			/* lhzux */
+	case 343:	return ldst_x(c, 2, LS_SIGN);			/* lhax */
+	case 375:	return ldst_x(c, 2, LS_SIGN | LS_UPDATE);	/* lhaux */
+	case 23:	return ldst_x(c, 4, 0);				/* lwzx */
+	case 55:	return ldst_x(c, 4, LS_UPDATE);			/* lwzux */
+	case 341:	return ldst_x(c, 4, LS_SIGN);			/* lwax */
+	case 373:	return ldst_x(c, 4, LS_SIGN | LS_UPDATE);	/* lwaux */
+	case 21:	return ldst_x(c, 8, 0);				/* ldx */
+	case 53:	return ldst_x(c, 8, LS_UPDATE);			/* ldux */
+	case 790:	return ldst_x(c, 2, LS_BREV);			/* lhbrx */
+	case 534:	return ldst_x(c, 4, LS_BREV);			/* lwbrx */
+	case 532:	return ldst_x(c, 8, LS_BREV);			/* ldbrx */
+	case 52:	return ldst_x(c, 1, LS_RESERVE);		/* lbarx */
+	case 116:	return ldst_x(c, 2, LS_RESERVE);		/* lharx */
+	case 20:	return ldst_x(c, 4, LS_RESERVE);		/* lwarx */
+	case 84:	return ldst_x(c, 8, LS_RESERVE);		/* ldarx */
+	case 853:	return ldst_x(c, 1, 0);				/* lbzcix */
+	case 821:	return ldst_x(c, 2, 0);				/* lhzcix */
+	case 789:	return ldst_x(c, 4, 0);				/* lwzcix */
+	case 885:	return ldst_x(c, 8, 0);				/* ldcix */
+
+	/* Stores */
+	case 215:	return ldst_x(c, 1, LS_STORE);			/* stbx */
+	case 247:	return ldst_x(c, 1, LS_STORE | LS_UPDATE);	/* stbux */
+	case 407:	return ldst_x(c, 2, LS_STORE);			/* sthx */
+	case 439:	return ldst_x(c, 2, LS_STORE | LS_UPDATE);	/* sthux */
+	case 151:	return ldst_x(c, 4, LS_STORE);			/* stwx */
+	case 183:	return ldst_x(c, 4, LS_STORE | LS_UPDATE);	/* stwux */
+	case 149:	return ldst_x(c, 8, LS_STORE);			/* stdx */
+	case 181:	return ldst_x(c, 8, LS_STORE | LS_UPDATE);	/* stdux */
+	case 918:	return ldst_x(c, 2, LS_STORE | LS_BREV);	/* sthbrx */
+	case 662:	return ldst_x(c, 4, LS_STORE | LS_BREV);	/* stwbrx */
+	case 660:	return ldst_x(c, 8, LS_STORE | LS_BREV);	/* stdbrx */
+	case 694:	return ldst_x(c, 1, LS_STORE | LS_RESERVE);	/* stbcx. */
+	case 726:	return ldst_x(c, 2, LS_STORE | LS_RESERVE);	/* sthcx. */
+	case 150:	return ldst_x(c, 4, LS_STORE | LS_RESERVE);	/* stwcx. */
+	case 214:	return ldst_x(c, 8, LS_STORE | LS_RESERVE);	/* stdcx. */
+	case 981:	return ldst_x(c, 1, LS_STORE);			/* stbcix */
+	case 949:	return ldst_x(c, 2, LS_STORE);			/* sthcix */
+	case 917:	return ldst_x(c, 4, LS_STORE);			/* stwcix */
+	case 1013:	return ldst_x(c, 8, LS_STORE);			/* stdcix */
+
+	/* Floating-point loads and stores */
+	case 535:	return ldst_x(c, 4, LS_FP | LS_SINGLE);			/* lfsx */
+	case 567:	return ldst_x(c, 4, LS_FP | LS_SINGLE | LS_UPDATE);	/* lfsux */
+	case 599:	return ldst_x(c, 8, LS_FP);				/* lfdx */
+	case 631:	return ldst_x(c, 8, LS_FP | LS_UPDATE);			/* lfdux */
+	case 855:	return ldst_x(c, 4, LS_FP | LS_SIGN);			/* lfiwax */
+	case 887:	return ldst_x(c, 4, LS_FP);				/* lfiwzx */
+	case 663:	return ldst_x(c, 4, LS_FP | LS_SINGLE | LS_STORE);	/* stfsx */
+	case 695:	return ldst_x(c, 4, LS_FP | LS_SINGLE | LS_STORE | LS_UPDATE); /* stfsux */
+	case 727:	return ldst_x(c, 8, LS_FP | LS_STORE);			/* stfdx */
+	case 759:	return ldst_x(c, 8, LS_FP | LS_STORE | LS_UPDATE);	/* stfdux */
+	case 983:	return ldst_x(c, 4, LS_FP | LS_STORE);			/* stfiwx */
+
+	case 1014:	/* dcbz */
+		c->st_size = DCBZ_SIZE;
+		c->st_ea = (gpr0(c, RA(i)) + b) & ~(uint64_t)(DCBZ_SIZE - 1);
+		return ISA_OK;
+	case 54:	/* dcbst */
+	case 86:	/* dcbf */
+	case 246:	/* dcbtst */
+	case 278:	/* dcbt */
+	case 22:	/* icbt */
+	case 982:	/* icbi */
+	case 598:	/* sync */
+	case 854:	/* eieio */
+		return ISA_OK;
+	}
+	return stop(c, "unmodelled instruction");
+}
+
+static int exec_19(struct step *c)
+{
+	struct isa_state *n = c->n;
+	uint32_t i = c->insn;
+	unsigned ba, bb, res;
+	uint64_t target, d, srr1;
+
+	/* addpcis is DX-form */
+	if (XO9(i) % 32 == 2) {
+		d = ((i >> 6) & 0x3ff) << 6 | ((i >> 16) & 0x1f) << 1 | (i & 1);
+		set_gpr(c, RT(i), c->cia + 4 + (SI(d) << 16));
+		return ISA_OK;
+	}
+
+	ba = cr_bit(n, RA(i));
+	bb = cr_bit(n, RB(i));
+	switch (XO10(i)) {
+	case 0:		/* mcrf */
+		set_cr_field(n, RT(i) >> 2, cr_field(n, RA(i) >> 2));
+		return ISA_OK;
+	case 257:	res = ba & bb; break;		/* crand */
+	case 449:	res = ba | bb; break;		/* cror */
+	case 193:	res = ba ^ bb; break;		/* crxor */
+	case 225:	res = !(ba & bb); break;	/* crnand */
+	case 33:	res = !(ba | bb); break;	/* crnor */
+	case 289:	res = !(ba ^ bb); break;	/* creqv */
+	case 129:	res = ba & !bb; break;		/* crandc */
+	case 417:	res = ba | !bb; break;		/* crorc */
+
+	case 16:	/* bclr */
+	case 528:	/* bcctr */
+	case 560:	/* bctar */
+		if (XO10(i) == 528 && !(RT(i) & 4))
+			return stop(c, "invalid form");
+		target = XO10(i) == 16 ? n->lr : XO10(i) == 528 ? n->ctr : n->tar;
+		target &= ~3ul;
+		if (bo_taken(n, RT(i), RA(i)))
+			branch(c, target);
+		if (RCBIT(i))
+			n->lr = c->cia + 4;
+		return ISA_OK;
+
+	case 18:	/* rfid */
+	case 274:	/* hrfid */
+		srr1 = XO10(i) == 18 ? n->srr1 : n->hsrr1;
+		target = XO10(i) == 18 ? n->srr0 : n->hsrr0;
+		n->msr = (n->msr & (bits(30, 27) | bits(21, 16))) |
+			(srr1 & ~(bits(30, 27) | bits(21, 16))) | MSR_HV;
+		if (srr1 & MSR_PR)
+			n->msr |= MSR_EE | MSR_IR | MSR_DR;
+		branch(c, target & ~3ul);
+		return ISA_OK;
+
+	case 150:	/* isync */
+		return ISA_OK;
+	default:
+		return stop(c, "unmodelled instruction");
+	}
+	n->cr = (n->cr & ~(1u << (31 - RT(i)))) | (res << (31 - RT(i)));
+	return ISA_OK;
+}
+
+static int exec_30(struct step *c)
+{
+	struct isa_state *n = c->n;
+	uint32_t i = c->insn;
+	uint64_t s = n->gpr[RT(i)], r, m;
+	unsigned sh = RB(i) | ((i & 2) << 4);
+	unsigned mb = ((i >> 6) & 0x1f) | (((i >> 5) & 1) << 5);
+
+	switch ((i >> 2) & 7) {
+	case 0:		/* rldicl */
+		r = rotl64(s, sh) & mask64(mb, 63);
+		break;
+	case 1:		/* rldicr */
+		r = rotl64(s, sh) & mask64(0, mb);
+		break;
+	case 2:		/* rldic */
+		r = rotl64(s, sh) & mask64(mb, 63 - sh);
+		break;
+	case 3:		/* rldimi */
+		m = mask64(mb, 63 - sh);
+		r = (rotl64(s, sh) & m) | (n->gpr[RA(i)] & ~m);
+		break;
+	case 4:
+		sh = n->gpr[RB(i)] & 63;
+		if (i & 2)	/* rldcr */
+			r = rotl64(s, sh) & mask64(0, mb);
+		else		/* rldcl */
+			r = rotl64(s, sh) & mask64(mb, 63);
+		break;
+	default:
+		return stop(c, "unmodelled instruction");
+	}
+	set_gpr(c, RA(i), r);
+	if (RCBIT(i))
+		set_cr0(c, r);
+	return ISA_OK;
+}
+
+static int exec_insn(struct step *c)
+{
+	struct isa_state *n = c->n;
+	uint32_t i = c->insn;
+	uint64_t a = n->gpr[RA(i)], s = n->gpr[RT(i)], r, m;
+	unsigned ca, ca32, ov, ov32, bf;
+
+	switch (PO(i)) {
+	case 0:
+		if (i == 0x00000200)
+			return ISA_ATTN;
+		break;
+	case 2:		/* tdi */
+		if (trap_taken(RT(i), a, SI(i)))
+			return stop(c, "trap");
+		return ISA_OK;
+	case 3:		/* twi */
+		if (trap_taken(RT(i), (int32_t)a, (int32_t)SI(i)))
+			return stop(c, "trap");
+		return ISA_OK;
+	case 7:		/* mulli */
+		set_gpr(c, RT(i), a * SI(i));
+		return ISA_OK;
+	case 8:		/* subfic */
+		r = add3(~a, SI(i), 1, &ca, &ca32, &ov, &ov32);
+		set_ca(n, ca, ca32);
+		set_gpr(c, RT(i), r);
+		return ISA_OK;
+	case 10:	/* cmpli */
+		bf = RT(i) >> 2;
+		if (RT(i) & 1)
+			set_cr_field(n, bf, cmp_unsigned(a, UI(i)) | xer_so(n));
+		else
+			set_cr_field(n, bf, cmp_unsigned((uint32_t)a, UI(i)) | xer_so(n));
+		return ISA_OK;
+	case 11:	/* cmpi */
+		bf = RT(i) >> 2;
+		if (RT(i) & 1)
+			set_cr_field(n, bf, cmp_signed(a, SI(i)) | xer_so(n));
+		else
+			set_cr_field(n, bf, cmp_signed((int32_t)a, SI(i)) | xer_so(n));
+		return ISA_OK;
+	case 12:	/* addic */
+	case 13:	/* addic. */
+		r = add3(a, SI(i), 0, &ca, &ca32, &ov, &ov32);
+		set_ca(n, ca, ca32);
+		set_gpr(c, RT(i), r);
+		if (PO(i) == 13)
+			set_cr0(c, r);
+		return ISA_OK;
+	case 14:	/* addi */
+		set_gpr(c, RT(i), gpr0(c, RA(i)) + SI(i));
+		return ISA_OK;
+	case 15:	/* addis */
+		set_gpr(c, RT(i), gpr0(c, RA(i)) + (SI(i) << 16));
+		return ISA_OK;
+	case 16:	/* bc */
+		r = SI(i & 0xfffc);
+		if (!(i & 2))
+			r += c->cia;
+		if (bo_taken(n, RT(i), RA(i)))
+			branch(c, r);
+		if (RCBIT(i))
+			n->lr = c->cia + 4;
+		return ISA_OK;
+	case 17:	/* sc */
+		if (!(i & 2))
+			return stop(c, "scv");
+		take_interrupt(c, 0xc00, c->cia + 4);
+		return ISA_OK;
+	case 18:	/* b */
+		r = (uint64_t)((int64_t)((uint64_t)(i & 0x03fffffc) << 38) >> 38);
+		if (!(i & 2))
+			r += c->cia;
+		branch(c, r);
+		if (RCBIT(i))
+			n->lr = c->cia + 4;
+		return ISA_OK;
+	case 19:
+		return exec_19(c);
+	case 20:	/* rlwimi */
+		m = mask64(RC(i) + 32, ((i >> 1) & 0x1f) + 32);
+		r = (rotl32(s, RB(i)) & m) | (a & ~m);
+		goto rotate;
+	case 21:	/* rlwinm */
+		m = mask64(RC(i) + 32, ((i >> 1) & 0x1f) + 32);
+		r = rotl32(s, RB(i)) & m;
+		goto rotate;
+	case 23:	/* rlwnm */
+		m = mask64(RC(i) + 32, ((i >> 1) & 0x1f) + 32);
+		r = rotl32(s, n->gpr[RB(i)] & 0x1f) & m;
+	rotate:
+		set_gpr(c, RA(i), r);
+		if (RCBIT(i))
+			set_cr0(c, r);
+		return ISA_OK;
+	case 24:	/* ori */
+		set_gpr(c, RA(i), s | UI(i));
+		return ISA_OK;
+	case 25:	/* oris */
+		set_gpr(c, RA(i), s | (UI(i) << 16));
+		return ISA_OK;
+	case 26:	/* xori */
+		set_gpr(c, RA(i), s ^ UI(i));
+		return ISA_OK;
+	case 27:	/* xoris */
+		set_gpr(c, RA(i), s ^ (UI(i) << 16));
+		return ISA_OK;
+	case 28:	/* andi. */
+		r = s & UI(i);
+		set_gpr(c, RA(i), r);
+		set_cr0(c, r);
+		return ISA_OK;
+	case 29:	/* andis. */
+		r = s & (UI(i) << 16);
+		set_gpr(c, RA(i), r);
+		set_cr0(c, r);
+		return ISA_OK;
+	case 30:
+		return exec_30(c);
+	case 31:
+		return exec_31(c);
+	case 32:	return ldst_d(c, 4, 0);				/* lwz */
+	case 33:	return ldst_d(c, 4, LS_UPDATE);			/* lwzu */
+	case 34:	return ldst_d(c, 1, 0);				/* lbz */
+	case 35:	return ldst_d(c, 1, LS_UPDATE);			/* lbzu */
+	case 36:	return ldst_d(c, 4, LS_STORE);			/* stw */
+	case 37:	return ldst_d(c, 4, LS_STORE | LS_UPDATE);	/* stwu */
+	case 38:	return ldst_d(c, 1, LS_STORE);			/* stb */
+	case 39:	return ldst_d(c, 1, LS_STORE | LS_UPDATE);	/* stbu */
+	case 40:	return ldst_d(c, 2, 0);				/* lhz */
+	case 41:	return ldst_d(c, 2, LS_UPDATE);			/* lhzu */
+	case 42:	return ldst_d(c, 2, LS_SIGN);			/* lha */
+	case 43:	return ldst_d(c, 2, LS_SIGN | LS_UPDATE);	/* lhau */
+	case 44:	return ldst_d(c, 2, LS_STORE);			/* sth */
+	case 45:	return ldst_d(c, 2, LS_STORE | LS_UPDATE);	/* sthu */
+	case 48:	return ldst_d(c, 4, LS_FP | LS_SINGLE);		/* lfs */
+	case 49:	return ldst_d(c, 4, LS_FP | LS_SINGLE | LS_UPDATE); /* lfsu */
+	case 50:	return ldst_d(c, 8, LS_FP);			/* lfd */
+	case 51:	return ldst_d(c, 8, LS_FP | LS_UPDATE);		/* lfdu */
+	case 52:	return ldst_d(c, 4, LS_FP | LS_SINGLE | LS_STORE); /* stfs */
+	case 53:	return ldst_d(c, 4, LS_FP | LS_SINGLE | LS_STORE | LS_UPDATE); /* stfsu */
+	case 54:	return ldst_d(c, 8, LS_FP | LS_STORE);		/* stfd */
+	case 55:	return ldst_d(c, 8, LS_FP | LS_STORE | LS_UPDATE); /* stfdu */
+	case 58:
+		switch (i & 3) {
+		case 0:	return ldst_ds(c, 8, 0);			/* ld */
+		case 1:	return ldst_ds(c, 8, LS_UPDATE);		/* ldu */
+		case 2:	return ldst_ds(c, 4, LS_SIGN);			/* lwa */
+		}
+		break;
+	case 62:
+		switch (i & 3) {
+		case 0:	return ldst_ds(c, 8, LS_STORE);			/* std */
+		case 1:	return ldst_ds(c, 8, LS_STORE | LS_UPDATE);	/* stdu */
+		}
+		break;
+	case 63:
+		/* fmr */
+		if (XO10(i) == 72 && !RCBIT(i)) {
+			if (!(n->msr & MSR_FP))
+				return stop(c, "FP unavailable");
+			set_fpr(c, RT(i), n->fpr[RB(i)]);
+			return ISA_OK;
+		}
+		break;
+	}
+	return stop(c, "unmodelled instruction");
+}
+
+void isa_reset(struct isa_model *m, uint64_t nia)
+{
+	memset(&m->s, 0, sizeof(m->s));
+	m->s.nia = nia;
+	m->s.msr = MSR_SF | MSR_HV | MSR_LE;
+	m->count = 0;
+	m->nwrites = 0;
+	m->why = NULL;
+}
+
+int isa_step(struct isa_model *m)
+{
+	struct isa_state n = m->s;
+	struct step c = { .m = m, .n = &n, .cia = m->s.nia };
+	uint8_t *p;
+	int rc;
+
+	m->nwrites = 0;
+	m->st_size = 0;
+	m->why = NULL;
+	m->cia = c.cia;
+	m->insn = 0;
+
+	if ((n.msr & MSR_MODE_MASK) != MSR_MODE)
+		rc = stop(&c, "MSR mode not modelled");
+	else if (!(p = ram_ptr(m, c.cia & REAL_ADDR_MASK, 4)))
+		rc = stop(&c, "fetch outside RAM");
+	else {
+		c.insn = p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+		m->insn = c.insn;
+		n.nia = c.cia + 4;
+		rc = exec_insn(&c);
+	}
+	if (rc == ISA_OK && c.st_size && !mem_write(&c, c.st_ea, c.st_size, c.st_val))
+		rc = ISA_STOP;
+	if (rc != ISA_OK) {
+		m->nwrites = 0;
+		return rc;
+	}
+
+	if (c.st_size) {
+		m->st_size = c.st_size;
+		m->st_addr = c.st_ea & REAL_ADDR_MASK;
+		m->st_val = c.st_size == DCBZ_SIZE ? 0 : c.st_val;
+	}
+	n.tb++;
+	m->s = n;
+	m->count++;
+	return ISA_OK;
+}
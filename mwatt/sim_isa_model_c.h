@@ -0,0 +1,112 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Functional model of the Power ISA subset that a Microwatt core runs
+ * from reset: real mode, 64-bit, little-endian, integer instructions
+ * and the floating-point loads and stores. Anything outside that
+ * (another mode, an unmodelled instruction or SPR, an interrupt other
+ * than sc, an unclaimed IO access) stops the model without changing
+ * its state, so the caller can hand over to, or resynchronise with,
+ * the RTL at that instruction.
+ */
+
+#define ISA_OK		0
+#define ISA_STOP	1	/* not modelled, state unchanged */
+#define ISA_ATTN	2	/* attn, state unchanged */
+
+#define ISA_MAX_WRITES	4
+
+/* Register numbers in isa_model.writes, as writeback numbers them */
+#define ISA_REG_GPR(n)	(n)
+#define ISA_REG_FPR(n)	(32 + (n))
+
+#define ISA_XER_SO	(1ul << 31)
+#define ISA_XER_OV	(1ul << 30)
+#define ISA_XER_CA	(1ul << 29)
+#define ISA_XER_OV32	(1ul << 19)
+#define ISA_XER_CA32	(1ul << 18)
+#define ISA_XER_LOW	0x3fffful
+
+/* Main RAM is repeated here */
+#define ISA_RAM_ALIAS	0x80000000ul
+#define ISA_IO_BASE	0xc0000000ul
+#define ISA_IO_END	0xd0000000ul
+
+struct isa_state {
+	uint64_t gpr[32];
+	uint64_t fpr[32];
+	uint64_t nia;
+	uint64_t msr;
+	uint32_t cr;
+	uint64_t xer;
+	uint64_t lr;
+	uint64_t ctr;
+	uint64_t tar;
+	uint64_t cfar;
+	uint64_t srr0;
+	uint64_t srr1;
+	uint64_t hsrr0;
+	uint64_t hsrr1;
+	uint64_t sprg[4];
+	uint64_t hsprg[2];
+	uint64_t tb;
+	bool reserve;
+	uint64_t reserve_addr;
+};
+
+struct isa_write {
+	int reg;
+	uint64_t val;
+};
+
+struct isa_model;
+
+/* Return false to refuse the access, which stops the model */
+typedef bool (*isa_io_read_t)(struct isa_model *m, uint64_t addr, int size,
+			      uint64_t *val);
+typedef bool (*isa_io_write_t)(struct isa_model *m, uint64_t addr, int size,
+			       uint64_t val);
+
+struct isa_model {
+	struct isa_state s;
+
+	/* Main RAM at 0 and at ISA_RAM_ALIAS, little-endian */
+	uint8_t *ram;
+	uint64_t ram_size;
+
+	/* Value read from PIR */
+	uint64_t pir;
+
+	/* Stop at time base reads, whose values depend on timing */
+	bool no_tb;
+
+	/* Accesses to [ISA_IO_BASE, ISA_IO_END) */
+	isa_io_read_t io_read;
+	isa_io_write_t io_write;
+	void *io_priv;
+
+	/* Instructions completed */
+	uint64_t count;
+
+	/* The last instruction stepped, and the registers it wrote */
+	uint64_t cia;
+	uint32_t insn;
+	int nwrites;
+	struct isa_write writes[ISA_MAX_WRITES];
+
+	/* and the store it made to RAM, if st_size isn't 0 (a dcbz is
+	 * st_size bytes of zeroes) */
+	int st_size;
+	uint64_t st_addr;
+	uint64_t st_val;
+
+	/* Why the last step stopped */
+	const char *why;
+};
+
+void isa_reset(struct isa_model *m, uint64_t nia);
+int isa_step(struct isa_model *m);
+
+/* Where real address ra is in the model's RAM, or NULL if it isn't */
+uint8_t *isa_ram_ptr(struct isa_model *m, uint64_t ra, int size);
@@ -4,11 +4,21 @@ use ieee.numeric_std.all;
 
 library work;
 use work.sim_jtag_socket.all;
+use work.sim_ffwd.all;
 
 library unisim;
 use unisim.vcomponents.all;
 
 entity sim_jtag is
+    generic (
+        -- Cores to start after a fast-forward
+        NCPUS      : positive := 1;
+        -- Fast-forward: run this many instructions, or up to this PC, in
+        -- the ISA model (sim_ffwd_c.c), load core 0 with the result over
+        -- DMI and start the cores, which the SoC must hold stopped
+        FFWD_INSNS : natural := 0;
+        FFWD_PC    : integer := -1
+        );
 end sim_jtag;
 
 architecture behaviour of sim_jtag is
@@ -63,6 +73,114 @@ begin
 	    clock(1);
 	end procedure clock_command;
 
+	-- One DMI access through the DTM, waiting for it to complete. The
+	-- response (and read data) comes back in the next shift.
+	procedure dmi_access(op   : in std_ulogic_vector(1 downto 0);
+			     addr : in std_ulogic_vector(7 downto 0);
+			     din  : in std_ulogic_vector(63 downto 0);
+			     dout : out std_ulogic_vector(63 downto 0)) is
+	    variable dcmd : std_ulogic_vector(0 to 73);
+	    variable drsp : std_ulogic_vector(0 to 73);
+	    variable nop  : std_ulogic_vector(0 to 73);
+	begin
+	    nop := (others => '0');
+	    for i in 0 to 1 loop
+		dcmd(i) := op(i);
+	    end loop;
+	    for i in 0 to 63 loop
+		dcmd(i + 2) := din(i);
+	    end loop;
+	    for i in 0 to 7 loop
+		dcmd(i + 66) := addr(i);
+	    end loop;
+	    -- Wait for the DTM to be idle, so it doesn't drop the command
+	    loop
+		clock_command(nop, drsp);
+		clock(dummy_clocks);
+		exit when drsp(0 to 1) = "00";
+	    end loop;
+	    clock_command(dcmd, drsp);
+	    clock(dummy_clocks);
+	    loop
+		clock_command(nop, drsp);
+		clock(dummy_clocks);
+		exit when drsp(0 to 1) = "00";
+	    end loop;
+	    for i in 0 to 63 loop
+		dout(i) := drsp(i + 2);
+	    end loop;
+	end procedure dmi_access;
+
+	procedure dmi_write(addr : in std_ulogic_vector(7 downto 0);
+			    data : in std_ulogic_vector(63 downto 0)) is
+	    variable dummy : std_ulogic_vector(63 downto 0);
+	begin
+	    dmi_access("10", addr, data, dummy);
+	end procedure dmi_write;
+
+	procedure dmi_read(addr : in std_ulogic_vector(7 downto 0);
+			   data : out std_ulogic_vector(63 downto 0)) is
+	begin
+	    dmi_access("01", addr, (others => '0'), data);
+	end procedure dmi_read;
+
+	-- DMI addresses: wishbone debug master, and core 0 debug registers
+	constant DMI_WB_ADDR     : std_ulogic_vector(7 downto 0) := x"00";
+	constant DMI_WB_DATA     : std_ulogic_vector(7 downto 0) := x"01";
+	constant DMI_WB_CTRL     : std_ulogic_vector(7 downto 0) := x"02";
+	constant DMI_CORE_NIA    : std_ulogic_vector(7 downto 0) := x"12";
+	constant DMI_CORE_MSR    : std_ulogic_vector(7 downto 0) := x"13";
+	constant DMI_GSPR_INDEX  : std_ulogic_vector(7 downto 0) := x"14";
+	constant DMI_GSPR_DATA   : std_ulogic_vector(7 downto 0) := x"15";
+	constant DMI_CORE_CR     : std_ulogic_vector(7 downto 0) := x"1a";
+	constant DMI_CORE_START  : std_ulogic_vector(63 downto 0) := x"0000000000000010";
+
+	constant SYSCON_BASE     : unsigned(63 downto 0) := x"00000000c0000000";
+	constant SYSCON_REGS     : integer := 13;
+	-- ffwd_get_reg numbers past the GSPRs
+	constant FFWD_REG_NIA    : integer := 16#100#;
+	constant FFWD_REG_MSR    : integer := 16#101#;
+	constant FFWD_REG_CR     : integer := 16#102#;
+
+	procedure fast_forward is
+	    variable data : std_ulogic_vector(63 downto 0);
+	begin
+	    -- Let the SoC come out of reset
+	    wait for 1 us;
+
+	    -- The model reads syscon from a snapshot
+	    dmi_write(DMI_WB_CTRL, x"00000000000000ff");
+	    for i in 0 to SYSCON_REGS - 1 loop
+		dmi_write(DMI_WB_ADDR, std_ulogic_vector(SYSCON_BASE + i * 8));
+		dmi_read(DMI_WB_DATA, data);
+		ffwd_syscon(i, data);
+	    end loop;
+
+	    ffwd_run(FFWD_INSNS, FFWD_PC);
+
+	    -- GPRs, the SPRs execute1 keeps (not FSCR, HFSCR and HEIR),
+	    -- CFAR and FPRs, then CR, MSR and last NIA, which is fetched in
+	    -- the mode the MSR gives
+	    for i in 0 to 16#5f# loop
+		if i <= 16#2d# or i = 16#31# or i >= 16#40# then
+		    ffwd_get_reg(i, data);
+		    dmi_write(DMI_GSPR_INDEX, std_ulogic_vector(to_unsigned(i, 64)));
+		    dmi_write(DMI_GSPR_DATA, data);
+		end if;
+	    end loop;
+	    ffwd_get_reg(FFWD_REG_CR, data);
+	    dmi_write(DMI_CORE_CR, data);
+	    ffwd_get_reg(FFWD_REG_MSR, data);
+	    dmi_write(DMI_CORE_MSR, data);
+	    ffwd_get_reg(FFWD_REG_NIA, data);
+	    dmi_write(DMI_CORE_NIA, data);
+
+	    -- Core 0 carries on from the model, any others start from reset
+	    for c in 0 to NCPUS - 1 loop
+		dmi_write(std_ulogic_vector(to_unsigned(16#10# * (c + 1), 8)), DMI_CORE_START);
+	    end loop;
+	end procedure fast_forward;
+
 	variable cmd   : std_ulogic_vector(0 to 247);
 	variable rsp   : std_ulogic_vector(0 to 247);
 	variable msize : std_ulogic_vector(7 downto 0);
@@ -89,6 +207,9 @@ begin
 	-- and clock when connected.
 	j.sel <= "0010";
 	clock(1);
+	if FFWD_INSNS /= 0 or FFWD_PC /= -1 then
+	    fast_forward;
+	end if;
 	rsp := (others => '0');
 	while true loop
 	    wait for poll_period;
@@ -0,0 +1,16 @@
+library ieee;
+use ieee.std_logic_1164.all;
+
+package sim_queue_stats is
+    procedure sim_queue_sample (id: integer; occupancy: integer;
+                                events: std_ulogic_vector(7 downto 0); latency: integer);
+    attribute foreign of sim_queue_sample : procedure is "VHPIDIRECT sim_queue_sample";
+end sim_queue_stats;
+
+package body sim_queue_stats is
+    procedure sim_queue_sample (id: integer; occupancy: integer;
+                                events: std_ulogic_vector(7 downto 0); latency: integer) is
+    begin
+        assert false report "VHPI" severity failure;
+    end sim_queue_sample;
+end sim_queue_stats;
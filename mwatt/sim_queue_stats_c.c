@@ -0,0 +1,120 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "sim_vhpi_c.h"
+
+/*
+ * Sink for the simulation-only queue statistics in queue.vhdl. Each
+ * queue sends one sample per cycle; the totals are printed to stderr
+ * when the simulation exits.
+ */
+
+#define MAX_QUEUES	8
+#define MAX_DEPTH	64
+
+#define EV_PUSH		(1 << 7)
+#define EV_PUSH_ADDR	(1 << 6)
+#define EV_POP		(1 << 5)
+#define EV_FULL_WAIT	(1 << 4)
+#define EV_EMPTY_WAIT	(1 << 3)
+#define EV_MMU_REQ	(1 << 2)
+#define EV_DC_RESP	(1 << 1)
+#define EV_VIA_MMU	(1 << 0)
+
+struct queue_stats {
+	bool seen;
+	uint64_t cycles;
+	uint64_t occupancy[MAX_DEPTH];
+	uint64_t pushes;
+	uint64_t addr_pushes;
+	uint64_t pops;
+	uint64_t full_wait;
+	uint64_t empty_wait;
+	uint64_t mmu_reqs;
+	uint64_t dcache_only;
+	uint64_t via_mmu;
+	uint64_t latency_sum;
+	uint64_t latency_max;
+	int max_occupancy;
+};
+
+static struct queue_stats stats[MAX_QUEUES];
+
+static void sim_queue_stats_dump(void)
+{
+	for (int i = 0; i < MAX_QUEUES; i++) {
+		struct queue_stats *s = &stats[i];
+		uint64_t resp = s->dcache_only + s->via_mmu;
+
+		if (!s->seen)
+			continue;
+
+		fprintf(stderr, "queue %d: %lu cycles\n", i, s->cycles);
+		fprintf(stderr, "  pushes %lu (address %lu, value %lu), pops %lu\n",
+			s->pushes, s->addr_pushes, s->pushes - s->addr_pushes,
+			s->pops);
+		fprintf(stderr, "  producer full wait %lu cycles, consumer empty wait %lu cycles\n",
+			s->full_wait, s->empty_wait);
+		fprintf(stderr, "  address loads: dcache %lu, via MMU %lu (MMU requests %lu)\n",
+			s->dcache_only, s->via_mmu, s->mmu_reqs);
+		if (resp)
+			fprintf(stderr, "  push to READY latency: avg %.2f max %lu cycles\n",
+				(double)s->latency_sum / resp, s->latency_max);
+		fprintf(stderr, "  occupancy:\n");
+		for (int j = 0; j <= s->max_occupancy; j++)
+			fprintf(stderr, "    %2d: %12lu %6.2f%%\n", j, s->occupancy[j],
+				100.0 * s->occupancy[j] / s->cycles);
+	}
+}
+
+void sim_queue_sample(int id, int occupancy, unsigned char *__events,
+		      int latency)
+{
+	static bool registered = false;
+	struct queue_stats *s;
+	unsigned long ev;
+
+	if (id < 0 || id >= MAX_QUEUES || occupancy < 0 || occupancy >= MAX_DEPTH) {
+		fprintf(stderr, "%s: bad queue %d occupancy %d\n", __func__,
+			id, occupancy);
+		exit(1);
+	}
+
+	if (!registered) {
+		atexit(sim_queue_stats_dump);
+		registered = true;
+	}
+
+	s = &stats[id];
+	ev = from_std_logic_vector(__events, 8);
+
+	s->seen = true;
+	s->cycles++;
+	s->occupancy[occupancy]++;
+	if (occupancy > s->max_occupancy)
+		s->max_occupancy = occupancy;
+
+	if (ev & EV_PUSH)
+		s->pushes++;
+	if (ev & EV_PUSH_ADDR)
+		s->addr_pushes++;
+	if (ev & EV_POP)
+		s->pops++;
+	if (ev & EV_FULL_WAIT)
+		s->full_wait++;
+	if (ev & EV_EMPTY_WAIT)
+		s->empty_wait++;
+	if (ev & EV_MMU_REQ)
+		s->mmu_reqs++;
+	if (ev & EV_DC_RESP) {
+		if (ev & EV_VIA_MMU)
+			s->via_mmu++;
+		else
+			s->dcache_only++;
+		s->latency_sum += latency;
+		if ((uint64_t)latency > s->latency_max)
+			s->latency_max = latency;
+	}
+}
@@ -0,0 +1,665 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "console.h"
+#include "io.h"
+#include "microwatt_soc.h"
+
+#include "multicore.h"
+#include "pmu.h"
+#include "queue.h"
+
+/*
+ * Indirect-access benchmarks for the inter-core queue.
+ *
+ * Each kernel is run three ways on core 0:
+ *
+ *  base   - plain single-core code
+ *  pf     - single core, with dcbt PF_DIST iterations ahead of the
+ *           indirect load
+ *  slice  - core 1 runs the address slice (index loads and address
+ *           arithmetic) and pushes the addresses with stafdxq, core 0
+ *           pops the loaded values with lfdxq and does the rest
+ *
+ * and core 0's PMU cycles and completed instructions are reported, plus
+ * core 1's instructions for the slice runs. Every variant's result is
+ * checked against the baseline's.
+ *
+ * The kernels are:
+ *
+ *  spmv   - CSR sparse matrix times dense vector, gathering x[col[k]]
+ *  bfs    - top-down BFS over a CSR graph, reading level[adj[e]]. The
+ *           frontier is built by the consumer, so the two cores meet at
+ *           every level, and a vertex reached twice in one level may come
+ *           through the queue with a stale level and has to be rechecked
+ *  pr     - pull PageRank over the same graph, gathering contrib[adj[e]]
+ *  hash   - hash join probe into an open addressed table; the slice
+ *           pushes the addresses of the first probed key and payload
+ *  hist   - histogram. Queued loads of the bins would race with the
+ *           increments, so here the slice only computes the bin numbers
+ *           and sends them as values with stfdxq; there is nothing for
+ *           the queue to prefetch
+ *
+ * Build with "make" and run under dcore_tb with main.bin as main_ram.bin.
+ */
+
+#define PF_DIST   16
+
+/* SpMV */
+#define SP_ROWS   512
+#define SP_COLS   2048
+#define SP_NNZ    8		/* per row */
+
+/* Graph */
+#define G_V       1024
+#define G_DEG     4
+#define G_E       (G_V * G_DEG)
+#define PR_ITERS  4
+#define UNVISITED (~0ul)
+
+/* Hash join */
+#define HT_SLOTS  2048	/* power of 2 */
+#define HT_KEYS   1536
+#define HJ_PROBES 2048
+
+/* Histogram */
+#define HI_N      4096
+#define HI_BINS   256
+
+enum {
+  CMD_IDLE,
+  CMD_SPMV,
+  CMD_BFS,
+  CMD_PR,
+  CMD_HASH,
+  CMD_HIST,
+};
+
+struct ht_slot {
+  uint64_t key;		/* 0 means empty */
+  uint64_t payload;
+};
+
+static double sp_val[SP_ROWS * SP_NNZ];
+static uint32_t sp_col[SP_ROWS * SP_NNZ];
+static double sp_x[SP_COLS];
+static double sp_y[SP_ROWS];
+
+static uint32_t g_row[G_V + 1];
+static uint32_t g_adj[G_E];
+static uint64_t g_level[G_V];
+static uint32_t g_frontier[2][G_V];
+static double pr_contrib[G_V];
+static double pr_rank[G_V];
+
+static struct ht_slot ht[HT_SLOTS];
+static uint64_t hj_keys[HJ_PROBES];
+
+static uint32_t hi_in[HI_N];
+static uint64_t hi_bins[HI_BINS];
+
+/* Shared with core 1 */
+static volatile long cmd;
+static volatile long gen;
+static volatile long frontier_n;
+static volatile long frontier_sel;
+static volatile uint64_t prod_insns;
+
+static uint64_t rng = 88172645463325252ul;
+
+static uint64_t rand64(void)
+{
+  rng ^= rng << 13;
+  rng ^= rng >> 7;
+  rng ^= rng << 17;
+  return rng;
+}
+
+static inline void prefetch(const void *p)
+{
+  __asm__ volatile("dcbt 0,%0" : : "r"(p));
+}
+
+static inline uint64_t hash_key(uint64_t k)
+{
+  return (k * 0x9e3779b97f4a7c15ul) >> 32;
+}
+
+static inline uint64_t hist_bin(uint32_t x)
+{
+  return ((x * 0x45d9f3bu) >> 24) & (HI_BINS - 1);
+}
+
+/* Checksum of the raw bits, so that variants have to match exactly */
+static uint64_t checksum(const void *p, long bytes)
+{
+  const uint64_t *q = p;
+  uint64_t s = 0;
+  long i;
+
+  for (i = 0; i < bytes / 8; i++)
+    s = s * 31 + q[i];
+  return s;
+}
+
+/*
+ * Data set up
+ */
+
+static void init_data(void)
+{
+  long i, j;
+
+  for (i = 0; i < SP_ROWS * SP_NNZ; i++) {
+    sp_val[i] = (double)(rand64() & 0xff) / 16.0;
+    sp_col[i] = rand64() & (SP_COLS - 1);
+  }
+  for (i = 0; i < SP_COLS; i++)
+    sp_x[i] = (double)(i & 0x3f);
+
+  for (i = 0; i <= G_V; i++)
+    g_row[i] = i * G_DEG;
+  for (i = 0; i < G_V; i++) {
+    /* a ring plus random chords, so everything is reachable */
+    g_adj[i * G_DEG] = (i + 1) % G_V;
+    for (j = 1; j < G_DEG; j++)
+      g_adj[i * G_DEG + j] = rand64() & (G_V - 1);
+  }
+
+  for (i = 0; i < HT_KEYS; i++) {
+    uint64_t k = (rand64() | 1);
+    uint64_t h = hash_key(k) & (HT_SLOTS - 1);
+
+    while (ht[h].key)
+      h = (h + 1) & (HT_SLOTS - 1);
+    ht[h].key = k;
+    ht[h].payload = i;
+    hj_keys[i] = k;
+  }
+  /* Probe with the build keys, shuffled, plus some that miss */
+  for (i = HT_KEYS; i < HJ_PROBES; i++)
+    hj_keys[i] = rand64() | 1;
+  for (i = HJ_PROBES - 1; i > 0; i--) {
+    uint64_t t;
+
+    j = rand64() % (i + 1);
+    t = hj_keys[i];
+    hj_keys[i] = hj_keys[j];
+    hj_keys[j] = t;
+  }
+
+  for (i = 0; i < HI_N; i++)
+    hi_in[i] = rand64();
+}
+
+/*
+ * Single core baseline and software prefetch variants
+ */
+
+static void spmv(bool pf)
+{
+  long r, k;
+
+  for (r = 0; r < SP_ROWS; r++) {
+    double sum = 0.0;
+
+    for (k = r * SP_NNZ; k < (r + 1) * SP_NNZ; k++) {
+      if (pf && k + PF_DIST < SP_ROWS * SP_NNZ)
+        prefetch(&sp_x[sp_col[k + PF_DIST]]);
+      sum += sp_val[k] * sp_x[sp_col[k]];
+    }
+    sp_y[r] = sum;
+  }
+}
+
+static void bfs(bool pf)
+{
+  uint32_t *cur = g_frontier[0], *next = g_frontier[1], *t;
+  long n = 1, m, i, e;
+  uint64_t d = 0;
+
+  for (i = 0; i < G_V; i++)
+    g_level[i] = UNVISITED;
+  g_level[0] = 0;
+  cur[0] = 0;
+
+  while (n) {
+    m = 0;
+    for (i = 0; i < n; i++) {
+      uint32_t v = cur[i];
+
+      if (pf && i + 1 < n)
+        for (e = g_row[cur[i + 1]]; e < g_row[cur[i + 1] + 1]; e++)
+          prefetch(&g_level[g_adj[e]]);
+      for (e = g_row[v]; e < g_row[v + 1]; e++) {
+        uint32_t u = g_adj[e];
+
+        if (g_level[u] == UNVISITED) {
+          g_level[u] = d + 1;
+          next[m++] = u;
+        }
+      }
+    }
+    t = cur;
+    cur = next;
+    next = t;
+    n = m;
+    d++;
+  }
+}
+
+static void pr_update(void)
+{
+  long v;
+
+  for (v = 0; v < G_V; v++)
+    pr_contrib[v] = pr_rank[v] / (g_row[v + 1] - g_row[v]);
+}
+
+static void pr_init(void)
+{
+  long v;
+
+  for (v = 0; v < G_V; v++)
+    pr_rank[v] = 1.0 / G_V;
+  pr_update();
+}
+
+static void pagerank(bool pf)
+{
+  long it, v, e;
+
+  pr_init();
+  for (it = 0; it < PR_ITERS; it++) {
+    for (v = 0; v < G_V; v++) {
+      double sum = 0.0;
+
+      for (e = g_row[v]; e < g_row[v + 1]; e++) {
+        if (pf && e + PF_DIST < G_E)
+          prefetch(&pr_contrib[g_adj[e + PF_DIST]]);
+        sum += pr_contrib[g_adj[e]];
+      }
+      pr_rank[v] = 0.15 / G_V + 0.85 * sum;
+    }
+    pr_update();
+  }
+}
+
+static uint64_t ht_walk(uint64_t key, uint64_t h)
+{
+  for (;;) {
+    h = (h + 1) & (HT_SLOTS - 1);
+    if (ht[h].key == key)
+      return ht[h].payload + 1;
+    if (!ht[h].key)
+      return 0;
+  }
+}
+
+static uint64_t hash_probe(bool pf)
+{
+  uint64_t sum = 0;
+  long i;
+
+  for (i = 0; i < HJ_PROBES; i++) {
+    uint64_t key = hj_keys[i];
+    uint64_t h = hash_key(key) & (HT_SLOTS - 1);
+
+    if (pf && i + PF_DIST < HJ_PROBES)
+      prefetch(&ht[hash_key(hj_keys[i + PF_DIST]) & (HT_SLOTS - 1)]);
+    if (ht[h].key == key)
+      sum += ht[h].payload + 1;
+    else if (ht[h].key)
+      sum += ht_walk(key, h);
+  }
+  return sum;
+}
+
+static void histogram(bool pf)
+{
+  long i;
+
+  for (i = 0; i < HI_BINS; i++)
+    hi_bins[i] = 0;
+  for (i = 0; i < HI_N; i++) {
+    if (pf && i + PF_DIST < HI_N)
+      prefetch(&hi_bins[hist_bin(hi_in[i + PF_DIST])]);
+    hi_bins[hist_bin(hi_in[i])]++;
+  }
+}
+
+/*
+ * Two-core slice variants: the consumers run on core 0, the producers
+ * on core 1
+ */
+
+static void spmv_produce(void)
+{
+  long k;
+
+  for (k = 0; k < SP_ROWS * SP_NNZ; k++)
+    queue_push_addr(&sp_x[sp_col[k]]);
+}
+
+static void spmv_consume(void)
+{
+  long r, k;
+
+  for (r = 0; r < SP_ROWS; r++) {
+    double sum = 0.0;
+
+    for (k = r * SP_NNZ; k < (r + 1) * SP_NNZ; k++)
+      sum += sp_val[k] * queue_pop_f64();
+    sp_y[r] = sum;
+  }
+}
+
+static void bfs_produce(void)
+{
+  long g = 0, n, i, e;
+
+  for (;;) {
+    while (gen == g)
+      /* wait for the next level */ ;
+    g = gen;
+    sync_cores();
+    n = frontier_n;
+    if (!n)
+      break;
+    for (i = 0; i < n; i++) {
+      uint32_t v = g_frontier[frontier_sel][i];
+
+      for (e = g_row[v]; e < g_row[v + 1]; e++)
+        queue_push_addr((const double *)&g_level[g_adj[e]]);
+    }
+  }
+}
+
+static void bfs_consume(void)
+{
+  long n = 1, m, i, e, sel = 0;
+  uint64_t d = 0;
+
+  for (i = 0; i < G_V; i++)
+    g_level[i] = UNVISITED;
+  g_level[0] = 0;
+  g_frontier[0][0] = 0;
+
+  while (n) {
+    uint32_t *cur = g_frontier[sel], *next = g_frontier[!sel];
+
+    frontier_sel = sel;
+    frontier_n = n;
+    sync_cores();
+    gen = gen + 1;
+
+    m = 0;
+    for (i = 0; i < n; i++) {
+      uint32_t v = cur[i];
+
+      for (e = g_row[v]; e < g_row[v + 1]; e++) {
+        uint32_t u = g_adj[e];
+
+        /* The queued value may predate our own update, so recheck */
+        if (queue_pop_u64() == UNVISITED && g_level[u] == UNVISITED) {
+          g_level[u] = d + 1;
+          next[m++] = u;
+        }
+      }
+    }
+    sel = !sel;
+    n = m;
+    d++;
+  }
+
+  /* Tell the producer we're done */
+  frontier_n = 0;
+  sync_cores();
+  gen = gen + 1;
+}
+
+static void pr_produce(void)
+{
+  long g = 0, it, e;
+
+  for (it = 0; it < PR_ITERS; it++) {
+    while (gen == g)
+      /* wait for the contributions */ ;
+    g = gen;
+    sync_cores();
+    for (e = 0; e < G_E; e++)
+      queue_push_addr(&pr_contrib[g_adj[e]]);
+  }
+}
+
+static void pr_consume(void)
+{
+  long it, v, e;
+
+  pr_init();
+  for (it = 0; it < PR_ITERS; it++) {
+    sync_cores();
+    gen = gen + 1;
+    for (v = 0; v < G_V; v++) {
+      double sum = 0.0;
+
+      for (e = g_row[v]; e < g_row[v + 1]; e++)
+        sum += queue_pop_f64();
+      pr_rank[v] = 0.15 / G_V + 0.85 * sum;
+    }
+    pr_update();
+  }
+}
+
+static void hash_produce(void)
+{
+  long i;
+
+  for (i = 0; i < HJ_PROBES; i++) {
+    struct ht_slot *s = &ht[hash_key(hj_keys[i]) & (HT_SLOTS - 1)];
+
+    queue_push_addr((const double *)&s->key);
+    queue_push_addr((const double *)&s->payload);
+  }
+}
+
+static uint64_t hash_consume(void)
+{
+  uint64_t sum = 0;
+  long i;
+
+  for (i = 0; i < HJ_PROBES; i++) {
+    uint64_t key = hj_keys[i];
+    uint64_t k = queue_pop_u64();
+    uint64_t payload = queue_pop_u64();
+
+    if (k == key)
+      sum += payload + 1;
+    else if (k)
+      sum += ht_walk(key, hash_key(key) & (HT_SLOTS - 1));
+  }
+  return sum;
+}
+
+static void hist_produce(void)
+{
+  long i;
+
+  for (i = 0; i < HI_N; i++)
+    queue_push_u64(hist_bin(hi_in[i]));
+}
+
+static void hist_consume(void)
+{
+  long i;
+
+  for (i = 0; i < HI_BINS; i++)
+    hi_bins[i] = 0;
+  for (i = 0; i < HI_N; i++)
+    hi_bins[queue_pop_u64()]++;
+}
+
+/*
+ * Measurement
+ */
+
+struct result {
+  uint64_t cycles;
+  uint64_t insns;
+  uint64_t check;
+};
+
+static void measure_start(void)
+{
+  pmu_start(PMU_MMCR1(PMU_EV1_CYCLES, 0, PMU_EV3_INSN_COMPLETE, 0));
+}
+
+static void measure_stop(struct result *r)
+{
+  pmu_stop();
+  r->cycles = pmu_read(1);
+  r->insns = pmu_read(3);
+}
+
+static uint64_t run_kernel(long kernel, int variant)
+{
+  bool pf = variant == 1;
+  uint64_t check = 0;
+
+  if (variant == 2) {
+    gen = 0;
+    sync_cores();
+    cmd = kernel;
+  }
+
+  switch (kernel) {
+  case CMD_SPMV:
+    if (variant == 2)
+      spmv_consume();
+    else
+      spmv(pf);
+    check = checksum(sp_y, sizeof(sp_y));
+    break;
+  case CMD_BFS:
+    if (variant == 2)
+      bfs_consume();
+    else
+      bfs(pf);
+    check = checksum(g_level, sizeof(g_level));
+    break;
+  case CMD_PR:
+    if (variant == 2)
+      pr_consume();
+    else
+      pagerank(pf);
+    check = checksum(pr_rank, sizeof(pr_rank));
+    break;
+  case CMD_HASH:
+    check = variant == 2 ? hash_consume() : hash_probe(pf);
+    break;
+  case CMD_HIST:
+    if (variant == 2)
+      hist_consume();
+    else
+      histogram(pf);
+    check = checksum(hi_bins, sizeof(hi_bins));
+    break;
+  }
+
+  if (variant == 2)
+    while (cmd != CMD_IDLE)
+      /* wait for the producer to finish */ ;
+  return check;
+}
+
+static const char *kernel_names[] = {
+  [CMD_SPMV] = "spmv ",
+  [CMD_BFS]  = "bfs  ",
+  [CMD_PR]   = "pr   ",
+  [CMD_HASH] = "hash ",
+  [CMD_HIST] = "hist ",
+};
+
+static const char *variant_names[] = {
+  "base  ",
+  "pf    ",
+  "slice ",
+};
+
+int main(void)
+{
+  struct result r, base = { 1, 1, 0 };
+  long kernel;
+  int variant;
+
+  console_init();
+  enable_fpu();
+
+  cmd = CMD_IDLE;
+  sync_cores();
+  enable_cpus(0x03);
+
+  init_data();
+
+  for (kernel = CMD_SPMV; kernel <= CMD_HIST; kernel++) {
+    for (variant = 0; variant < 3; variant++) {
+      measure_start();
+      r.check = run_kernel(kernel, variant);
+      measure_stop(&r);
+      if (variant == 0)
+        base = r;
+
+      puts(kernel_names[kernel]);
+      puts(variant_names[variant]);
+      puts("cycles ");
+      print_uint64(r.cycles);
+      puts(" insns ");
+      print_uint64(r.insns);
+      if (variant == 2) {
+        puts(" producer insns ");
+        print_uint64(prod_insns);
+      }
+      puts(" speedup x100 ");
+      print_uint64(base.cycles * 100 / r.cycles);
+      puts(r.check == base.check ? " ok\n" : " MISMATCH\n");
+    }
+  }
+
+  return 0;
+}
+
+void secondary_main(void)
+{
+  long c;
+
+  enable_fpu();
+
+  for (;;) {
+    while ((c = cmd) == CMD_IDLE)
+      /* wait for work */ ;
+
+    pmu_start(PMU_MMCR1(0, 0, PMU_EV3_INSN_COMPLETE, 0));
+    switch (c) {
+    case CMD_SPMV:
+      spmv_produce();
+      break;
+    case CMD_BFS:
+      bfs_produce();
+      break;
+    case CMD_PR:
+      pr_produce();
+      break;
+    case CMD_HASH:
+      hash_produce();
+      break;
+    case CMD_HIST:
+      hist_produce();
+      break;
+    }
+    pmu_stop();
+    prod_insns = pmu_read(3);
+
+    sync_cores();
+    cmd = CMD_IDLE;
+  }
+}
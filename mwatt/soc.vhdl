@@ -69,8 +69,24 @@ entity soc is
         SIM                  : boolean;
         NCPUS                : positive                      := 1;
         HAS_FPU              : boolean                       := true;
+        HAS_FPU_FAST_PATH    : boolean                       := false;
+        DIV_RADIX_BITS       : positive                      := 1;
+        MUL_PIPELINE_DEPTH   : positive                      := 3;
         HAS_BTC              : boolean                       := true;
+        BTC_ADDR_BITS        : positive                      := 10;
+        HAS_GSHARE           : boolean                       := false;
+        GSHARE_BITS          : positive                      := 10;
+        HAS_RAS              : boolean                       := false;
+        RAS_DEPTH            : positive                      := 8;
+        HAS_FUSION           : boolean                       := false;
+        DUAL_ISSUE           : boolean                       := false;
+        HAS_LOOP_BUFFER      : boolean                       := false;
+        LOOP_BUFFER_SIZE     : positive                      := 16;
         DISABLE_FLATTEN_CORE : boolean                       := false;
+        HAS_WB_CROSSBAR      : boolean                       := true;
+        HAS_SHARED_L2        : boolean                       := false;
+        L2_NUM_LINES         : positive                      := 256;
+        L2_NUM_WAYS          : positive                      := 4;
         ALT_RESET_ADDRESS    : std_logic_vector(63 downto 0) := (23 downto 0 => '0', others => '1');
         HAS_DRAM             : boolean                       := false;
         DRAM_SIZE            : integer                       := 0;
@@ -80,7 +96,9 @@ entity soc is
         SPI_FLASH_OFFSET     : integer                       := 0;
         SPI_FLASH_DEF_CKDV   : natural                       := 2;
         SPI_FLASH_DEF_QUAD   : boolean                       := false;
+        SPI_FLASH_READ_AHEAD : natural                       := 16;
         SPI_BOOT_CLOCKS      : boolean                       := true;
+        HAS_FLASH_DMA        : boolean                       := true;
         LOG_LENGTH           : natural                       := 512;
         HAS_LITEETH          : boolean                       := false;
         UART0_IS_16550       : boolean                       := true;
@@ -92,10 +110,21 @@ entity soc is
         DCACHE_NUM_WAYS      : natural                       := 2;
         DCACHE_TLB_SET_SIZE  : natural                       := 64;
         DCACHE_TLB_NUM_WAYS  : natural                       := 2;
+        MMU_L2TLB_SIZE       : natural                       := 64;
+        MMU_L2TLB_LARGE_SIZE : natural                       := 8;
+        MMU_PWC_SIZE         : natural                       := 4;
         HAS_SD_CARD          : boolean                       := false;
         HAS_GPIO             : boolean                       := false;
         NGPIO                : natural                       := 32;
-        QUEUE_DEPTH          : natural                       := 4
+        ICS_SRC_NUM          : positive                      := 16;
+        ICS_SPREAD_IRQS      : boolean                       := false;
+        HAS_FAST_IPI         : boolean                       := false;
+        QUEUE_DEPTH          : natural                       := 4;
+        STORE_BUFFER_DEPTH   : natural                       := 4;
+        -- Cores come out of reset stopped, to be started by the debugger
+        START_STOPPED        : boolean                       := false;
+        -- Check core 0 against the reference model in sim_cosim_c.c
+        COSIM                : boolean                       := false
     );
     port(
         rst        : in std_ulogic;
@@ -173,6 +202,46 @@ architecture behaviour of soc is
     signal wb_master_in  : wishbone_slave_out;
     signal wb_master_out : wishbone_master_out;
     signal wb_snoop      : wishbone_master_out;
+    signal wb_snoop_own  : std_ulogic_vector(NCPUS-1 downto 0);
+
+    -- Main bus slaves
+    constant WB_SLAVE_BRAM : wb_slave_idx_t := 0;
+    constant WB_SLAVE_DRAM : wb_slave_idx_t := 1;
+    constant WB_SLAVE_IO   : wb_slave_idx_t := 2;
+    constant NUM_WB_SLAVES : positive := 3;
+    signal wb_masters_slave : wb_slave_idx_vector(0 to NUM_WB_MASTERS-1);
+    signal wb_slaves_out    : wishbone_master_out_vector(0 to NUM_WB_SLAVES-1);
+    signal wb_slaves_in     : wishbone_slave_out_vector(0 to NUM_WB_SLAVES-1);
+    signal wb_slaves_master : wb_master_idx_vector(0 to NUM_WB_SLAVES-1);
+
+    -- Between the DRAM slave port (or shared L2) and DRAM
+    signal wb_mem_out : wishbone_master_out;
+    signal wb_mem_in  : wishbone_slave_out;
+
+    -- Shared L2 snoop filter and events
+    signal l2_sharers       : std_ulogic_vector(NCPUS-1 downto 0);
+    signal l2_inval         : wishbone_master_out;
+    signal l2_inval_sharers : std_ulogic_vector(NCPUS-1 downto 0);
+    signal l2_hit           : std_ulogic_vector(NCPUS-1 downto 0);
+    signal l2_miss          : std_ulogic_vector(NCPUS-1 downto 0);
+
+    -- Snoop bus as seen by each core
+    signal wb_snoop_core : wishbone_master_out_vector(0 to NCPUS-1);
+
+    function wb_slave_decode(adr : wishbone_addr_type; dram_at_0 : std_ulogic)
+        return wb_slave_idx_t is
+        variable top_decode : std_ulogic_vector(3 downto 0);
+    begin
+        top_decode := adr(28 downto 26) & dram_at_0;
+        if std_match(top_decode, "0001") then
+            return WB_SLAVE_DRAM;
+        elsif std_match(top_decode, "01--") then
+            return WB_SLAVE_DRAM;
+        elsif std_match(top_decode, "11--") then
+            return WB_SLAVE_IO;
+        end if;
+        return WB_SLAVE_BRAM;
+    end function;
 
     -- Main "IO" bus, from main slave decoder to the latch
     signal wb_io_in  : wishbone_master_out;
@@ -208,12 +277,19 @@ architecture behaviour of soc is
     signal wb_spiflash_is_reg : std_ulogic;
     signal wb_spiflash_is_map : std_ulogic;
 
+    -- Flash DMA signals:
+    signal wb_dma_regs_in  : wb_io_master_out;
+    signal wb_dma_regs_out : wb_io_slave_out;
+    signal wb_dma_out      : wishbone_master_out;
+    signal wb_dma_in       : wishbone_slave_out;
+
     -- XICS signals:
     signal wb_xics_icp_in  : wb_io_master_out;
     signal wb_xics_icp_out : wb_io_slave_out;
     signal wb_xics_ics_in  : wb_io_master_out;
     signal wb_xics_ics_out : wb_io_slave_out;
-    signal int_level_in    : std_ulogic_vector(15 downto 0);
+    signal int_level_in    : std_ulogic_vector(ICS_SRC_NUM - 1 downto 0);
+    signal icp_ipi         : icp_ipi_t;
     signal ics_to_icp      : ics_to_icp_t;
     signal core_ext_irq    : std_ulogic_vector(NCPUS-1 downto 0) := (others => '0');
 
@@ -248,6 +324,7 @@ architecture behaviour of soc is
     signal rst_xics    : std_ulogic;
     signal rst_spi     : std_ulogic;
     signal rst_gpio    : std_ulogic;
+    signal rst_dma     : std_ulogic;
     signal rst_bram    : std_ulogic;
     signal rst_dtm     : std_ulogic;
     signal rst_wbar    : std_ulogic;
@@ -262,6 +339,7 @@ architecture behaviour of soc is
                            SLAVE_IO_UART1,
                            SLAVE_IO_SPI_FLASH,
                            SLAVE_IO_GPIO,
+                           SLAVE_IO_DMA,
                            SLAVE_IO_EXTERNAL);
     signal current_io_decode : slave_io_type;
 
@@ -273,10 +351,18 @@ architecture behaviour of soc is
     signal io_cycle_ics       : std_ulogic;
     signal io_cycle_spi_flash : std_ulogic;
     signal io_cycle_gpio      : std_ulogic;
+    signal io_cycle_dma       : std_ulogic;
     signal io_cycle_external  : std_ulogic;
 
     signal core_run_out : std_ulogic_vector(NCPUS-1 downto 0);
 
+    -- Byte or word write to an ICP MFRR (offset 0xc of a presentation block)
+    function is_mfrr_write(wb : wishbone_master_out) return boolean is
+    begin
+        return wb.we = '1' and wb.adr(26 downto 9) = 18x"00004" and wb.adr(0) = '1' and
+            (wb.sel = x"10" or wb.sel = x"f0");
+    end function;
+
     -- type q_in_array is array(cpu_index_t) of Loadstore1ToQueueType;
     -- type q_out_array is array(cpu_index_t) of Loadstore1ToQueueType;
     -- signal q_in  : q_in_array;
@@ -289,10 +375,12 @@ architecture behaviour of soc is
     signal write_type_i   : bit_array;
     signal write_data_i   : vector_array;
     signal full_o         : bit_array;
+    signal write_wait_i   : bit_array;
     signal write_enable_o : bit_array;
     signal write_type_o   : bit_array;
     signal write_data_o   : vector_array;
     signal full_i         : bit_array;
+    signal write_wait_o   : bit_array;
 
     function wishbone_widen_data(wb : wb_io_master_out) return wishbone_master_out is
         variable wwb : wishbone_master_out;
@@ -366,6 +454,7 @@ begin
             rst_spi     <= soc_reset;
             rst_xics    <= soc_reset;
             rst_gpio    <= soc_reset;
+            rst_dma     <= soc_reset;
             rst_bram    <= soc_reset;
             rst_dtm     <= soc_reset;
             rst_wbar    <= soc_reset;
@@ -383,10 +472,12 @@ begin
     write_type_i(0)   <= write_type_o(1);
     write_data_i(0)   <= write_data_o(1);
     full_i(0)         <= full_o(1);
+    write_wait_i(0)   <= write_wait_o(1);
     write_enable_i(1) <= write_enable_o(0);
     write_type_i(1)   <= write_type_o(0);
     write_data_i(1)   <= write_data_o(0);
     full_i(1)         <= full_o(0);
+    write_wait_i(1)   <= write_wait_o(0);
 
     -- Processor cores
     processors : for i in 0 to NCPUS-1 generate
@@ -395,7 +486,19 @@ begin
                 SIM                 => SIM,
                 CPU_INDEX           => i,
                 HAS_FPU             => HAS_FPU,
+                HAS_FPU_FAST_PATH   => HAS_FPU_FAST_PATH,
+                DIV_RADIX_BITS      => DIV_RADIX_BITS,
+                MUL_PIPELINE_DEPTH  => MUL_PIPELINE_DEPTH,
                 HAS_BTC             => HAS_BTC,
+                BTC_ADDR_BITS       => BTC_ADDR_BITS,
+                HAS_GSHARE          => HAS_GSHARE,
+                GSHARE_BITS         => GSHARE_BITS,
+                HAS_RAS             => HAS_RAS,
+                RAS_DEPTH           => RAS_DEPTH,
+                HAS_FUSION          => HAS_FUSION,
+                DUAL_ISSUE          => DUAL_ISSUE,
+                HAS_LOOP_BUFFER     => HAS_LOOP_BUFFER,
+                LOOP_BUFFER_SIZE    => LOOP_BUFFER_SIZE,
                 DISABLE_FLATTEN     => DISABLE_FLATTEN_CORE,
                 ALT_RESET_ADDRESS   => ALT_RESET_ADDRESS,
                 LOG_LENGTH          => LOG_LENGTH,
@@ -405,7 +508,13 @@ begin
                 DCACHE_NUM_LINES    => DCACHE_NUM_LINES,
                 DCACHE_NUM_WAYS     => DCACHE_NUM_WAYS,
                 DCACHE_TLB_SET_SIZE => DCACHE_TLB_SET_SIZE,
-                DCACHE_TLB_NUM_WAYS => DCACHE_TLB_NUM_WAYS
+                DCACHE_TLB_NUM_WAYS => DCACHE_TLB_NUM_WAYS,
+                MMU_L2TLB_SIZE      => MMU_L2TLB_SIZE,
+                MMU_L2TLB_LARGE_SIZE => MMU_L2TLB_LARGE_SIZE,
+                MMU_PWC_SIZE        => MMU_PWC_SIZE,
+                STORE_BUFFER_DEPTH  => STORE_BUFFER_DEPTH,
+                START_STOPPED       => START_STOPPED,
+                COSIM               => COSIM and i = 0
             )
             port map(
                 clk               => system_clk,
@@ -417,7 +526,10 @@ begin
                 wishbone_insn_out => wb_masters_out(i + NCPUS),
                 wishbone_data_in  => wb_masters_in(i),
                 wishbone_data_out => wb_masters_out(i),
-                wb_snoop_in       => wb_snoop,
+                wb_snoop_in       => wb_snoop_core(i),
+                wb_snoop_own      => wb_snoop_own(i),
+                l2_events.hit     => l2_hit(i),
+                l2_events.miss    => l2_miss(i),
                 dmi_addr          => dmi_addr(3 downto 0),
                 dmi_dout          => dmi_core_dout(i),
                 dmi_din           => dmi_dout,
@@ -432,47 +544,53 @@ begin
                 write_type_i      => write_type_i(i),
                 write_data_i      => write_data_i(i),
                 full_o            => full_o(i),
+                write_wait_i      => write_wait_i(i),
                 -- This core loadstore to other core queue
                 write_enable_o    => write_enable_o(i),
                 write_type_o      => write_type_o(i),
                 write_data_o      => write_data_o(i),
-                full_i            => full_i(i)
+                full_i            => full_i(i),
+                write_wait_o      => write_wait_o(i)
             );
     end generate;
 
     run_out <= or (core_run_out);
 
     -- Wishbone bus master arbiter & mux
-    wb_masters_out(2*NCPUS)     <= wishbone_widen_data(wishbone_dma_out);
     wb_masters_out(2*NCPUS + 1) <= wishbone_debug_out;
-    wishbone_dma_in             <= wishbone_narrow_data(wb_masters_in(2*NCPUS), wishbone_dma_out.adr);
     wishbone_debug_in           <= wb_masters_in(2*NCPUS + 1);
-    wishbone_arbiter_0 : entity work.wishbone_arbiter
-        generic map(
-            NUM_MASTERS => NUM_WB_MASTERS
-        )
-        port map(
-            clk            => system_clk,
-            rst            => rst_wbar,
-            wb_masters_in  => wb_masters_out,
-            wb_masters_out => wb_masters_in,
-            wb_slave_out   => wb_master_out,
-            wb_slave_in    => wb_master_in
-        );
 
-    -- Snoop bus going to caches.
-    -- Gate stb with stall so the caches don't see the stalled strobes.
-    -- That way if the caches see a strobe when their wishbone is stalled,
-    -- they know it is an access by another master.
-    process(all)
+    -- The DMA master slot is shared between the external DMA port and
+    -- the flash DMA engine
+    dma_ext_only : if not (HAS_SPI_FLASH and HAS_FLASH_DMA) generate
+        wb_masters_out(2*NCPUS) <= wishbone_widen_data(wishbone_dma_out);
+        wishbone_dma_in         <= wishbone_narrow_data(wb_masters_in(2*NCPUS), wishbone_dma_out.adr);
+    end generate;
+
+    dma_shared : if HAS_SPI_FLASH and HAS_FLASH_DMA generate
+        signal dma_masters_out : wishbone_master_out_vector(0 to 1);
+        signal dma_masters_in  : wishbone_slave_out_vector(0 to 1);
     begin
-        wb_snoop <= wb_master_out;
-        if wb_master_in.stall = '1' then
-            wb_snoop.stb <= '0';
-        end if;
-    end process;
+        dma_masters_out(0) <= wishbone_widen_data(wishbone_dma_out);
+        dma_masters_out(1) <= wb_dma_out;
+        wishbone_dma_in    <= wishbone_narrow_data(dma_masters_in(0), wishbone_dma_out.adr);
+        wb_dma_in          <= dma_masters_in(1);
 
-    -- Top level Wishbone slaves address decoder & mux
+        dma_arbiter : entity work.wishbone_arbiter
+            generic map(
+                NUM_MASTERS => 2
+            )
+            port map(
+                clk            => system_clk,
+                rst            => rst_dma,
+                wb_masters_in  => dma_masters_out,
+                wb_masters_out => dma_masters_in,
+                wb_slave_out   => wb_masters_out(2*NCPUS),
+                wb_slave_in    => wb_masters_in(2*NCPUS)
+            );
+    end generate;
+
+    -- Top level Wishbone slaves address decoder
     --
     -- From CPU to BRAM, DRAM, IO, selected on top 3 bits and dram_at_0
     -- 0000  - BRAM
@@ -481,54 +599,174 @@ begin
     -- 10xx  - BRAM
     -- 11xx  - IO
     --
-    slave_top_intercon : process(wb_master_out, wb_bram_out, wb_dram_out, wb_io_out, dram_at_0)
-        type slave_top_type is (SLAVE_TOP_BRAM,
-                                SLAVE_TOP_DRAM,
-                                SLAVE_TOP_IO);
-        variable slave_top  : slave_top_type;
-        variable top_decode : std_ulogic_vector(3 downto 0);
+    slave_top_decode : process(wb_masters_out, dram_at_0)
     begin
-        -- Top-level address decoder
-        top_decode := wb_master_out.adr(28 downto 26) & dram_at_0;
-        slave_top  := SLAVE_TOP_BRAM;
-        if std_match(top_decode, "0000") then
-            slave_top := SLAVE_TOP_BRAM;
-        elsif std_match(top_decode, "0001") then
-            slave_top := SLAVE_TOP_DRAM;
-        elsif std_match(top_decode, "01--") then
-            slave_top := SLAVE_TOP_DRAM;
-        elsif std_match(top_decode, "10--") then
-            slave_top := SLAVE_TOP_BRAM;
-        elsif std_match(top_decode, "11--") then
-            slave_top := SLAVE_TOP_IO;
-        end if;
+        for i in 0 to NUM_WB_MASTERS-1 loop
+            wb_masters_slave(i) <= wb_slave_decode(wb_masters_out(i).adr, dram_at_0);
+        end loop;
+    end process slave_top_decode;
+
+    -- Every master gets its own path to each slave, so cores hitting
+    -- different slaves (or the IO bus) proceed in parallel.
+    wb_crossbar : if HAS_WB_CROSSBAR generate
+        signal wb_snoop_master : natural range 0 to NUM_WB_MASTERS-1;
+    begin
+        wishbone_crossbar_0 : entity work.wishbone_crossbar
+            generic map(
+                NUM_MASTERS  => NUM_WB_MASTERS,
+                NUM_SLAVES   => NUM_WB_SLAVES,
+                -- BRAM and DRAM are cacheable, IO isn't
+                SNOOP_SLAVES => (WB_SLAVE_BRAM => '1', WB_SLAVE_DRAM => '1', others => '0')
+            )
+            port map(
+                clk              => system_clk,
+                rst              => rst_wbar,
+                wb_masters_in    => wb_masters_out,
+                wb_masters_out   => wb_masters_in,
+                wb_masters_slave => wb_masters_slave,
+                wb_slaves_out    => wb_slaves_out,
+                wb_slaves_in     => wb_slaves_in,
+                wb_slaves_master => wb_slaves_master,
+                wb_snoop_out     => wb_snoop,
+                wb_snoop_master  => wb_snoop_master,
+                snoop_inject     => l2_inval.stb
+            );
 
-        -- Top level wishbone muxing.
-        wb_bram_in     <= wb_master_out;
-        wb_bram_in.cyc <= '0';
-        wb_dram_in     <= wb_master_out;
-        wb_dram_in.cyc <= '0';
-        wb_io_in       <= wb_master_out;
-        wb_io_in.cyc   <= '0';
-        case slave_top is
-            when SLAVE_TOP_BRAM =>
-                wb_bram_in.cyc <= wb_master_out.cyc;
-                wb_master_in   <= wb_bram_out;
-            when SLAVE_TOP_DRAM =>
-                if HAS_DRAM then
-                    wb_dram_in.cyc <= wb_master_out.cyc;
-                    wb_master_in   <= wb_dram_out;
-                else
-                    wb_master_in.ack   <= wb_master_out.cyc and wb_master_out.stb;
-                    wb_master_in.dat   <= (others => '1');
-                    wb_master_in.stall <= '0';
+        -- Tell each dcache which snooped writes are its own
+        snoop_own: for i in 0 to NCPUS-1 generate
+            wb_snoop_own(i) <= '1' when wb_snoop_master = i and l2_inval.stb = '0' else '0';
+        end generate;
+    end generate;
+
+    -- Single shared bus: one master at a time to any slave
+    wb_shared : if not HAS_WB_CROSSBAR generate
+        wb_slaves_master <= (others => 0);
+
+        wishbone_arbiter_0 : entity work.wishbone_arbiter
+            generic map(
+                NUM_MASTERS => NUM_WB_MASTERS
+            )
+            port map(
+                clk            => system_clk,
+                rst            => rst_wbar,
+                wb_masters_in  => wb_masters_out,
+                wb_masters_out => wb_masters_in,
+                wb_slave_out   => wb_master_out,
+                wb_slave_in    => wb_master_in
+            );
+
+        -- Snoop bus going to caches.
+        -- Gate stb with stall so the caches don't see the stalled strobes.
+        -- That way if a dcache sees a strobe when its own wishbone cycle
+        -- is active and not stalled, it knows it is its own access.
+        process(all)
+        begin
+            wb_snoop <= wb_master_out;
+            if wb_master_in.stall = '1' then
+                wb_snoop.stb <= '0';
+            end if;
+        end process;
+
+        snoop_own: for i in 0 to NCPUS-1 generate
+            wb_snoop_own(i) <= wb_masters_out(i).cyc and not wb_masters_in(i).stall;
+        end generate;
+
+        slave_top_intercon : process(wb_master_out, wb_slaves_in, dram_at_0)
+            variable slave_top : wb_slave_idx_t;
+        begin
+            slave_top := wb_slave_decode(wb_master_out.adr, dram_at_0);
+            for i in 0 to NUM_WB_SLAVES-1 loop
+                wb_slaves_out(i) <= wb_master_out;
+                if i /= slave_top then
+                    wb_slaves_out(i).cyc <= '0';
                 end if;
-            when SLAVE_TOP_IO =>
-                wb_io_in.cyc <= wb_master_out.cyc;
-                wb_master_in <= wb_io_out;
-        end case;
+            end loop;
+            wb_master_in <= wb_slaves_in(slave_top);
+        end process slave_top_intercon;
+    end generate;
+
+    -- Top level wishbone slaves
+    wb_bram_in                  <= wb_slaves_out(WB_SLAVE_BRAM);
+    wb_slaves_in(WB_SLAVE_BRAM) <= wb_bram_out;
+    wb_io_in                    <= wb_slaves_out(WB_SLAVE_IO);
+    wb_slaves_in(WB_SLAVE_IO)   <= wb_io_out;
+
+    -- Shared L2 in front of DRAM. It needs the crossbar to tell it which
+    -- master is making each request and to put its invalidations on the
+    -- snoop bus.
+    assert HAS_WB_CROSSBAR or not HAS_SHARED_L2
+        report "HAS_SHARED_L2 requires HAS_WB_CROSSBAR" severity failure;
+
+    l2cache : if HAS_SHARED_L2 generate
+        signal l2_req_cores : std_ulogic_vector(NCPUS-1 downto 0);
+    begin
+        -- Cores' dcaches and icaches are masters i and i + NCPUS
+        l2_cores: for i in 0 to NCPUS-1 generate
+            l2_req_cores(i) <= '1' when wb_slaves_master(WB_SLAVE_DRAM) = i or
+                                        wb_slaves_master(WB_SLAVE_DRAM) = i + NCPUS else '0';
+        end generate;
+
+        shared_l2_0 : entity work.shared_l2
+            generic map(
+                NCPUS     => NCPUS,
+                NUM_LINES => L2_NUM_LINES,
+                NUM_WAYS  => L2_NUM_WAYS
+            )
+            port map(
+                clk           => system_clk,
+                rst           => rst_wbar,
+                wb_in         => wb_slaves_out(WB_SLAVE_DRAM),
+                wb_out        => wb_slaves_in(WB_SLAVE_DRAM),
+                req_cores     => l2_req_cores,
+                mem_out       => wb_mem_out,
+                mem_in        => wb_mem_in,
+                sharers_out   => l2_sharers,
+                inval_out     => l2_inval,
+                inval_sharers => l2_inval_sharers,
+                hit_out       => l2_hit,
+                miss_out      => l2_miss
+            );
+    end generate;
+
+    no_l2cache : if not HAS_SHARED_L2 generate
+        wb_mem_out                  <= wb_slaves_out(WB_SLAVE_DRAM);
+        wb_slaves_in(WB_SLAVE_DRAM) <= wb_mem_in;
+        l2_sharers                  <= (others => '1');
+        l2_inval                    <= wishbone_master_out_init;
+        l2_inval_sharers            <= (others => '0');
+        l2_hit                      <= (others => '0');
+        l2_miss                     <= (others => '0');
+    end generate;
+
+    slave_dram : process(wb_mem_out, wb_dram_out)
+    begin
+        wb_dram_in <= wb_mem_out;
+        if HAS_DRAM then
+            wb_mem_in <= wb_dram_out;
+        else
+            wb_dram_in.cyc <= '0';
+            wb_mem_in.ack   <= wb_mem_out.cyc and wb_mem_out.stb;
+            wb_mem_in.dat   <= (others => '1');
+            wb_mem_in.stall <= '0';
+        end if;
+    end process slave_dram;
 
-    end process slave_top_intercon;
+    -- Snoop bus to each core. With the shared L2, writes to DRAM lines
+    -- that are in the L2 directory only go to the cores that may hold the
+    -- line; other writes, and the L2's invalidations of lines it is
+    -- installing, go to every core. L2 evictions go to the line's sharers.
+    snoop_filter : process(wb_snoop, l2_inval, l2_inval_sharers, l2_sharers, dram_at_0)
+    begin
+        for i in 0 to NCPUS-1 loop
+            wb_snoop_core(i) <= wb_snoop;
+            if l2_inval.stb = '1' then
+                wb_snoop_core(i)     <= l2_inval;
+                wb_snoop_core(i).stb <= l2_inval_sharers(i);
+            elsif wb_slave_decode(wb_snoop.adr, dram_at_0) = WB_SLAVE_DRAM then
+                wb_snoop_core(i).stb <= wb_snoop.stb and l2_sharers(i);
+            end if;
+        end loop;
+    end process snoop_filter;
 
     -- IO wishbone slave 64->32 bits converter
     --
@@ -561,6 +799,7 @@ begin
                 state           := IDLE;
                 wb_io_out.ack   <= '0';
                 wb_io_out.stall <= '0';
+                icp_ipi.valid   <= '0';
                 wb_sio_out.stb  <= '0';
                 end_cyc         := '1';
                 has_top         := false;
@@ -568,13 +807,22 @@ begin
                 dat_latch       := (others => '0');
                 sel_latch       := (others => '0');
             else
+                icp_ipi.valid <= '0';
                 case state is
                     when IDLE =>
                         -- Clear ACK in case it was set
                         wb_io_out.ack <= '0';
 
                         -- Do we have a cycle ?
-                        if wb_io_in.cyc = '1' and wb_io_in.stb = '1' then
+                        if wb_io_in.cyc = '1' and wb_io_in.stb = '1' and
+                            HAS_FAST_IPI and is_mfrr_write(wb_io_in) then
+                            -- IPI: post the MFRR write straight to the ICP
+                            -- and ack it without going down the IO bus.
+                            icp_ipi.valid <= '1';
+                            icp_ipi.cpu   <= wb_io_in.adr(4 downto 1);
+                            icp_ipi.mfrr  <= wb_io_in.dat(39 downto 32);
+                            wb_io_out.ack <= '1';
+                        elsif wb_io_in.cyc = '1' and wb_io_in.stb = '1' then
                             -- Stall master until we are done, we are't (yet) pipelining
                             -- this, it's all slow IOs. Note: The current cycle has
                             -- already been accepted as "stall" was 0, this only blocks
@@ -698,6 +946,7 @@ begin
                 io_cycle_ics        <= '0';
                 io_cycle_spi_flash  <= '0';
                 io_cycle_gpio       <= '0';
+                io_cycle_dma        <= '0';
                 io_cycle_external   <= '0';
                 wb_sio_out.cyc      <= '0';
                 wb_ext_is_dram_init <= '0';
@@ -760,6 +1009,9 @@ begin
                 elsif std_match(match, x"C0007") then
                     slave_io      := SLAVE_IO_GPIO;
                     io_cycle_gpio <= '1';
+                elsif std_match(match, x"C0008") and HAS_SPI_FLASH and HAS_FLASH_DMA then
+                    slave_io     := SLAVE_IO_DMA;
+                    io_cycle_dma <= '1';
                 else
                     io_cycle_none <= '1';
                 end if;
@@ -787,6 +1039,9 @@ begin
         wb_gpio_in     <= wb_sio_out;
         wb_gpio_in.cyc <= io_cycle_gpio;
 
+        wb_dma_regs_in     <= wb_sio_out;
+        wb_dma_regs_in.cyc <= io_cycle_dma;
+
         -- Only give xics 8 bits of wb addr (for now...)
         wb_xics_icp_in                 <= wb_sio_out;
         wb_xics_icp_in.adr             <= (others => '0');
@@ -820,6 +1075,8 @@ begin
                 wb_sio_in <= wb_spiflash_out;
             when SLAVE_IO_GPIO =>
                 wb_sio_in <= wb_gpio_out;
+            when SLAVE_IO_DMA =>
+                wb_sio_in <= wb_dma_regs_out;
         end case;
 
         -- Default response, ack & return all 1's
@@ -845,6 +1102,7 @@ begin
             SPI_FLASH_OFFSET => SPI_FLASH_OFFSET,
             HAS_LITEETH      => HAS_LITEETH,
             HAS_SD_CARD      => HAS_SD_CARD,
+            HAS_FLASH_DMA    => HAS_SPI_FLASH and HAS_FLASH_DMA,
             UART0_IS_16550   => UART0_IS_16550,
             HAS_UART1        => HAS_UART1
         )
@@ -977,7 +1235,8 @@ begin
                 DATA_LINES    => SPI_FLASH_DLINES,
                 DEF_CLK_DIV   => SPI_FLASH_DEF_CKDV,
                 DEF_QUAD_READ => SPI_FLASH_DEF_QUAD,
-                BOOT_CLOCKS   => SPI_BOOT_CLOCKS
+                BOOT_CLOCKS   => SPI_BOOT_CLOCKS,
+                READ_AHEAD    => SPI_FLASH_READ_AHEAD
             )
             port map(
                 rst        => rst_spi,
@@ -994,6 +1253,18 @@ begin
             );
     end generate;
 
+    flash_dma_gen : if HAS_SPI_FLASH and HAS_FLASH_DMA generate
+        flash_dma0 : entity work.flash_dma
+            port map(
+                clk        => system_clk,
+                rst        => rst_dma,
+                wb_in      => wb_dma_regs_in,
+                wb_out     => wb_dma_regs_out,
+                wb_dma_out => wb_dma_out,
+                wb_dma_in  => wb_dma_in
+            );
+    end generate;
+
     no_spi0_gen : if not HAS_SPI_FLASH generate
         wb_spiflash_out.dat   <= (others => '1');
         wb_spiflash_out.ack   <= wb_spiflash_in.cyc and wb_spiflash_in.stb;
@@ -1010,14 +1281,16 @@ begin
             wb_in        => wb_xics_icp_in,
             wb_out       => wb_xics_icp_out,
             ics_in       => ics_to_icp,
+            ipi_in       => icp_ipi,
             core_irq_out => core_ext_irq
         );
 
     xics_ics : entity work.xics_ics
         generic map(
-            NCPUS     => NCPUS,
-            SRC_NUM   => 16,
-            PRIO_BITS => 3
+            NCPUS       => NCPUS,
+            SRC_NUM     => ICS_SRC_NUM,
+            PRIO_BITS   => 3,
+            SPREAD_IRQS => ICS_SPREAD_IRQS
         )
         port map(
             clk          => system_clk,
@@ -1046,6 +1319,9 @@ begin
     end generate;
 
     -- Assign external interrupts
+    assert ICS_SRC_NUM >= 5
+        report "ICS_SRC_NUM must be at least 5 to cover the on-chip interrupt sources"
+        severity failure;
     interrupts : process(all)
     begin
         int_level_in    <= (others => '0');
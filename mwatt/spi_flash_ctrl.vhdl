@@ -14,6 +14,9 @@ entity spi_flash_ctrl is
         -- Dummy clocks after boot
         BOOT_CLOCKS     : boolean  := true;   -- Send 8 dummy clocks after boot
 
+        -- Auto-mode read-ahead buffer size in 32-bit words, 0 to disable
+        READ_AHEAD      : natural  := 0;
+
         -- Number of data lines (1=MISO/MOSI, otherwise 2 or 4)
         DATA_LINES      : positive := 1
         );
@@ -63,8 +66,8 @@ architecture rtl of spi_flash_ctrl is
     alias  auto_cfg_dummies : std_ulogic_vector(2 downto 0) is auto_cfg_reg(10 downto 8);
     alias  auto_cfg_mode    : std_ulogic_vector(1 downto 0) is auto_cfg_reg(12 downto 11);
     alias  auto_cfg_addr4   : std_ulogic                    is auto_cfg_reg(13);
-    alias  auto_cfg_rsrv1   : std_ulogic                    is auto_cfg_reg(14);
-    alias  auto_cfg_rsrv2   : std_ulogic                    is auto_cfg_reg(15);
+    alias  auto_cfg_wadr    : std_ulogic                    is auto_cfg_reg(14);
+    alias  auto_cfg_xip     : std_ulogic                    is auto_cfg_reg(15);
     alias  auto_cfg_div     : std_ulogic_vector(7 downto 0) is auto_cfg_reg(23 downto 16);
     alias  auto_cfg_cstout  : std_ulogic_vector(5 downto 0) is auto_cfg_reg(29 downto 24);
 
@@ -73,6 +76,12 @@ architecture rtl of spi_flash_ctrl is
     constant SPI_AUTO_CFG_MODE_DUAL   : std_ulogic_vector(1 downto 0) := "10";
     constant SPI_AUTO_CFG_MODE_QUAD   : std_ulogic_vector(1 downto 0) := "11";
 
+    -- Mode byte sent after the address when auto_cfg_wadr is set. The
+    -- first enters (or stays in) continuous read mode, which on most
+    -- parts is M5-4 = "10" or M7-4 /= M3-0, the second leaves it.
+    constant SPI_XIP_MODE_ENTER : std_ulogic_vector(7 downto 0) := x"a5";
+    constant SPI_XIP_MODE_EXIT  : std_ulogic_vector(7 downto 0) := x"ff";
+
     -- Signals to rxtx
     signal cmd_valid    : std_ulogic;
     signal cmd_clk_div  : natural range 0 to 255;
@@ -99,6 +108,9 @@ architecture rtl of spi_flash_ctrl is
     signal wb_map_valid : std_ulogic;
     signal wb_reg       : std_ulogic_vector(SPI_REG_BITS-1 downto 0);
 
+    -- Flash address of a map access
+    signal map_addr     : std_ulogic_vector(31 downto 0);
+
     -- Auto mode clock counts XXX FIXME: Look at reasonable values based
     -- on system clock maybe ? Or make them programmable.
     constant CS_DELAY_ASSERT    : integer := 1;   -- CS low to cmd
@@ -108,7 +120,7 @@ architecture rtl of spi_flash_ctrl is
     -- Automatic mode state
     type auto_state_t is (AUTO_BOOT, AUTO_IDLE, AUTO_CS_ON, AUTO_CMD,
                           AUTO_ADR0, AUTO_ADR1, AUTO_ADR2, AUTO_ADR3,
-                          AUTO_DUMMY,
+                          AUTO_MODE, AUTO_XIP_EXIT, AUTO_DUMMY,
                           AUTO_DAT0, AUTO_DAT1, AUTO_DAT2, AUTO_DAT3,
                           AUTO_DAT0_DATA, AUTO_DAT1_DATA, AUTO_DAT2_DATA, AUTO_DAT3_DATA,
                           AUTO_SEND_ACK, AUTO_WAIT_REQ, AUTO_RECOVERY);
@@ -124,12 +136,34 @@ architecture rtl of spi_flash_ctrl is
     signal auto_next      : auto_state_t;
     signal auto_lad_next  : std_ulogic_vector(31 downto 0);
     signal auto_latch_adr : std_ulogic;
+    signal auto_xip_next  : std_ulogic;
+    signal auto_exit_next : std_ulogic;
+    signal auto_reg_ok    : std_ulogic;
+    signal auto_rdata     : std_ulogic_vector(wb_out.dat'left downto 0);
 
     -- Automatic mode latches
     signal auto_data      : std_ulogic_vector(wb_out.dat'left downto 0);
     signal auto_cnt       : integer range 0 to 63;
     signal auto_state     : auto_state_t;
     signal auto_last_addr : std_ulogic_vector(31 downto 0);
+    signal auto_xip       : std_ulogic;   -- Flash is in continuous read mode
+    signal auto_exit      : std_ulogic;   -- Current sequence leaves it
+
+    -- Read-ahead buffer. With READ_AHEAD > 0 every word read in auto mode
+    -- goes through here, and the state machine keeps CS asserted and
+    -- streams the following words in for as long as there is room and
+    -- no non-sequential access comes in. Map reads of the word at
+    -- ra_addr are then answered from the buffer without an SPI command.
+    constant RA_ENABLED : boolean  := READ_AHEAD > 0;
+    constant RA_DEPTH   : positive := maximum(READ_AHEAD, 1);
+    type ra_buf_t is array(0 to RA_DEPTH-1) of std_ulogic_vector(31 downto 0);
+    signal ra_buf       : ra_buf_t;
+    signal ra_head      : integer range 0 to RA_DEPTH-1;  -- Oldest word
+    signal ra_count     : integer range 0 to RA_DEPTH;    -- Valid words
+    signal ra_addr      : std_ulogic_vector(31 downto 0); -- Address of oldest
+    signal ra_hit       : std_ulogic;
+    signal ra_push      : std_ulogic;
+    signal ra_flush     : std_ulogic;
 
 begin
 
@@ -167,6 +201,15 @@ begin
     -- Shortcut because we test that a lot: data register access
     wb_reg_dat_v <= '1' when wb_reg = SPI_REG_DATA else '0';
 
+    -- Convert wishbone address into a flash address. We mask
+    -- off the 4 top address bits to get rid of the "f" there.
+    map_addr     <= "00" & wb_req.adr(27 downto 0) & "00";
+
+    -- Register accesses wait for auto mode to be idle and out of
+    -- continuous read mode, so that manual commands reach the flash
+    auto_reg_ok  <= '1' when auto_state = AUTO_IDLE and auto_xip = '0' and
+                    bus_idle = '1' else '0';
+
     -- Wishbone request -> SPI request
     wb_request_sync: process(clk)
     begin
@@ -283,7 +326,7 @@ begin
             -- Memory map access
             wb_rsp.stall <= not auto_ack;  -- XXX FIXME: Allow pipelining
             wb_rsp.ack   <= auto_ack;
-            wb_rsp.dat   <= auto_data;
+            wb_rsp.dat   <= auto_rdata;
 
         elsif ctrl_cs = '1' and wb_reg = SPI_REG_DATA then
 
@@ -314,7 +357,7 @@ begin
             -- Normally single cycle but ensure any auto-mode or manual
             -- operation is complete first
             --
-            if auto_state = AUTO_IDLE and bus_idle = '1' then
+            if auto_reg_ok = '1' then
                 wb_rsp.ack   <= '1';
                 wb_rsp.stall <= '0';
 
@@ -353,10 +396,14 @@ begin
                 auto_state <= AUTO_BOOT;
                 auto_cnt <= 0;
                 auto_data  <= (others => '0');
+                auto_xip   <= '0';
+                auto_exit  <= '0';
             else
                 auto_state <= auto_next;
                 auto_cnt   <= auto_cnt_next;
                 auto_data  <= auto_data_next;
+                auto_xip   <= auto_xip_next;
+                auto_exit  <= auto_exit_next;
                 if auto_latch_adr = '1' then
                     auto_last_addr <= auto_lad_next;
                 end if;
@@ -364,9 +411,48 @@ begin
         end if;
     end process;
 
+    -- Read-ahead buffer
+    auto_rdata <= ra_buf(ra_head) when RA_ENABLED else auto_data;
+
+    ra_hit <= '1' when RA_ENABLED and wb_map_valid = '1' and wb_req.we = '0' and
+              ctrl_cs = '0' and ra_count /= 0 and map_addr = ra_addr else '0';
+
+    ra_sync: process(clk)
+    begin
+        if rising_edge(clk) then
+            if ra_push = '1' then
+                ra_buf((ra_head + ra_count) mod RA_DEPTH) <= d_rx & auto_data(23 downto 0);
+            end if;
+
+            -- Manual mode may reprogram the flash, so drop everything
+            if rst = '1' or ctrl_reset = '1' or ctrl_cs = '1' then
+                ra_head  <= 0;
+                ra_count <= 0;
+                ra_addr  <= (others => '0');
+            elsif ra_flush = '1' then
+                ra_count <= 0;
+                ra_addr  <= map_addr;
+            else
+                if ra_hit = '1' then
+                    ra_head <= (ra_head + 1) mod RA_DEPTH;
+                    ra_addr <= std_ulogic_vector(unsigned(ra_addr) + 4);
+                end if;
+                if ra_push = '1' and ra_hit = '0' then
+                    ra_count <= ra_count + 1;
+                elsif ra_push = '0' and ra_hit = '1' then
+                    ra_count <= ra_count - 1;
+                end if;
+            end if;
+        end if;
+    end process;
+
     auto_comb: process(all)
         variable addr : std_ulogic_vector(31 downto 0);
         variable req_is_next : boolean;
+        variable ra_miss : boolean;
+        variable ra_room : boolean;
+        variable adr_mode : std_ulogic_vector(2 downto 0);
+        variable adr_clks : std_ulogic_vector(2 downto 0);
 
         function mode_to_clks(mode: std_ulogic_vector(1 downto 0)) return std_ulogic_vector is
         begin
@@ -380,28 +466,51 @@ begin
         end function;
    begin
         -- Default outputs
-        auto_ack <= '0';
+        auto_ack <= ra_hit;
         auto_cs <= '0';
         auto_cmd_valid <= '0';
         auto_d_txd <= x"00";
         auto_cmd_mode <= "001";
         auto_d_clks <= "111";
         auto_latch_adr <= '0';
+        ra_push <= '0';
+        ra_flush <= '0';
 
         -- Default next state
         auto_next <= auto_state;
         auto_cnt_next <= auto_cnt;
         auto_data_next <= auto_data;
+        auto_xip_next <= auto_xip;
+        auto_exit_next <= auto_exit;
 
-        -- Convert wishbone address into a flash address. We mask
-        -- off the 4 top address bits to get rid of the "f" there.
-        addr := "00" & wb_req.adr(27 downto 0) & "00";
+        -- With the read-ahead buffer, the address being streamed is
+        -- auto_last_addr rather than that of the current request
+        if RA_ENABLED then
+            addr := auto_last_addr;
+        else
+            addr := map_addr;
+        end if;
 
         -- Calculate the next address for store & compare later
         auto_lad_next <= std_ulogic_vector(unsigned(addr) + 4);
 
         -- Match incoming request address with next address
-        req_is_next := addr = auto_last_addr;
+        req_is_next := map_addr = auto_last_addr;
+
+        -- Anything the buffer can't eventually answer. A read of ra_addr
+        -- with the buffer empty is waiting for the word being streamed.
+        ra_miss := wb_map_valid = '1' and (wb_req.we = '1' or map_addr /= ra_addr);
+        ra_room := ra_count /= RA_DEPTH or ra_hit = '1';
+
+        -- Address and mode byte go out in the data mode for the
+        -- dual/quad I/O read commands
+        if auto_cfg_wadr = '1' then
+            adr_mode := auto_cfg_mode & "1";
+            adr_clks := mode_to_clks(auto_cfg_mode);
+        else
+            adr_mode := "001";
+            adr_clks := "111";
+        end if;
 
         -- XXX TODO:
         --  - Support < 32-bit accesses
@@ -436,21 +545,43 @@ begin
                     auto_next <= AUTO_IDLE;
                 end if;
             when AUTO_IDLE =>
-                -- Access to the memory map only when manual CS isn't set
-                if wb_map_valid = '1' and ctrl_cs = '0' then
+                if ra_hit = '1' then
+                    -- Answered from the read-ahead buffer
+                    null;
+                elsif auto_xip = '1' and wb_reg_valid = '1' then
+                    -- Take the flash out of continuous read mode with
+                    -- a dummy read before any register access
+                    auto_exit_next <= '1';
+                    auto_next <= AUTO_CS_ON;
+                    auto_cnt_next <= CS_DELAY_ASSERT;
+                elsif wb_map_valid = '1' and ctrl_cs = '0' then
+                    -- Access to the memory map only when manual CS isn't set
                     -- Ignore writes, we don't support them yet
                     if wb_req.we = '1' then
                         auto_ack <= '1';
                     else
                         -- Start machine with CS assertion delay
+                        auto_exit_next <= '0';
                         auto_next <= AUTO_CS_ON;
                         auto_cnt_next <= CS_DELAY_ASSERT;
+                        if RA_ENABLED then
+                            ra_flush <= '1';
+                            auto_lad_next <= map_addr;
+                            auto_latch_adr <= '1';
+                        end if;
                     end if;
                 end if;
             when AUTO_CS_ON =>
                 if auto_cnt = 0 then
-                    -- CS asserted long enough, send command
-                    auto_next <= AUTO_CMD;
+                    -- CS asserted long enough, send command unless the
+                    -- flash is in continuous read mode and doesn't want one
+                    if auto_xip = '0' then
+                        auto_next <= AUTO_CMD;
+                    elsif auto_cfg_addr4 = '1' then
+                        auto_next <= AUTO_ADR3;
+                    else
+                        auto_next <= AUTO_ADR2;
+                    end if;
                 end if;
             when AUTO_CMD =>
                 auto_d_txd <= auto_cfg_cmd;
@@ -465,31 +596,67 @@ begin
             when AUTO_ADR3 =>
                 auto_d_txd <= addr(31 downto 24);
                 auto_cmd_valid <= '1';
+                auto_cmd_mode <= adr_mode;
+                auto_d_clks <= adr_clks;
                 if cmd_ready = '1' then
                     auto_next <= AUTO_ADR2;
                 end if;
             when AUTO_ADR2 =>
                 auto_d_txd <= addr(23 downto 16);
                 auto_cmd_valid <= '1';
+                auto_cmd_mode <= adr_mode;
+                auto_d_clks <= adr_clks;
                 if cmd_ready = '1' then
                     auto_next <= AUTO_ADR1;
                 end if;
             when AUTO_ADR1 =>
                 auto_d_txd <= addr(15 downto 8);
                 auto_cmd_valid <= '1';
+                auto_cmd_mode <= adr_mode;
+                auto_d_clks <= adr_clks;
                 if cmd_ready = '1' then
                     auto_next <= AUTO_ADR0;
                 end if;
             when AUTO_ADR0 =>
                 auto_d_txd <= addr(7 downto 0);
                 auto_cmd_valid <= '1';
+                auto_cmd_mode <= adr_mode;
+                auto_d_clks <= adr_clks;
+                if cmd_ready = '1' then
+                    if auto_cfg_wadr = '1' then
+                        auto_next <= AUTO_MODE;
+                    elsif auto_cfg_dummies = "000" then
+                        auto_next <= AUTO_DAT0;
+                    else
+                        auto_next <= AUTO_DUMMY;
+                    end if;
+                end if;
+            when AUTO_MODE =>
+                if auto_cfg_xip = '1' and auto_exit = '0' then
+                    auto_d_txd <= SPI_XIP_MODE_ENTER;
+                else
+                    auto_d_txd <= SPI_XIP_MODE_EXIT;
+                end if;
+                auto_cmd_valid <= '1';
+                auto_cmd_mode <= adr_mode;
+                auto_d_clks <= adr_clks;
                 if cmd_ready = '1' then
-                    if auto_cfg_dummies = "000" then
+                    auto_xip_next <= auto_cfg_xip and not auto_exit;
+                    if auto_exit = '1' then
+                        auto_next <= AUTO_XIP_EXIT;
+                    elsif auto_cfg_dummies = "000" then
                         auto_next <= AUTO_DAT0;
                     else
                         auto_next <= AUTO_DUMMY;
                     end if;
                 end if;
+            when AUTO_XIP_EXIT =>
+                -- The flash has seen the exit mode byte once it's
+                -- clocked out, CS can go
+                if bus_idle = '1' then
+                    auto_cnt_next <= CS_DELAY_RECOVERY;
+                    auto_next <= AUTO_RECOVERY;
+                end if;
             when AUTO_DUMMY =>
                 auto_cmd_valid <= '1';
                 auto_d_clks <= auto_cfg_dummies;
@@ -542,8 +709,14 @@ begin
             when AUTO_DAT3_DATA =>
                 if d_ack = '1' then
                     auto_data_next(31 downto 24) <= d_rx;
-                    auto_next <= AUTO_SEND_ACK;
                     auto_latch_adr <= '1';
+                    if RA_ENABLED then
+                        ra_push <= '1';
+                        auto_cnt_next <= to_integer(unsigned(auto_cfg_cstout));
+                        auto_next <= AUTO_WAIT_REQ;
+                    else
+                        auto_next <= AUTO_SEND_ACK;
+                    end if;
                 end if;
             when AUTO_SEND_ACK =>
                 auto_ack <= '1';
@@ -552,7 +725,20 @@ begin
             when AUTO_WAIT_REQ =>
                 -- Incoming bus request we can take ? Otherwise do we need
                 -- to cancel the wait ?
-                if wb_map_valid = '1' and req_is_next and wb_req.we = '0' then
+                if RA_ENABLED then
+                    -- Keep streaming while there is room. Once the buffer
+                    -- is full, hold CS for the timeout in case the reader
+                    -- catches up. The last word may still be clocking out
+                    -- when we get here, so wait for the bus before CS goes.
+                    if ra_miss or wb_reg_valid = '1' or auto_cnt = 0 then
+                        if bus_idle = '1' then
+                            auto_cnt_next <= CS_DELAY_RECOVERY;
+                            auto_next <= AUTO_RECOVERY;
+                        end if;
+                    elsif ra_room then
+                        auto_next <= AUTO_DAT0;
+                    end if;
+                elsif wb_map_valid = '1' and req_is_next and wb_req.we = '0' then
                     auto_next <= AUTO_DAT0;
                 elsif wb_map_valid = '1' or wb_reg_valid = '1' or auto_cnt = 0 then
                     -- This means we can drop the CS right on the next clock.
@@ -605,13 +791,13 @@ begin
                     auto_cfg_mode    <= SPI_AUTO_CFG_MODE_SINGLE;
                 end if;
                 auto_cfg_addr4   <= '0';
-                auto_cfg_rsrv1   <= '0';
-                auto_cfg_rsrv2   <= '0';
+                auto_cfg_wadr    <= '0';
+                auto_cfg_xip     <= '0';
                 auto_cfg_div     <= std_ulogic_vector(to_unsigned(DEF_CLK_DIV, 8));
                 auto_cfg_cstout  <= std_ulogic_vector(to_unsigned(DEFAULT_CS_TIMEOUT, 6));
             end if;
 
-            if wb_reg_valid = '1' and wb_req.we = '1' and auto_state = AUTO_IDLE and bus_idle = '1' then
+            if wb_reg_valid = '1' and wb_req.we = '1' and auto_reg_ok = '1' then
                 if wb_reg = SPI_REG_CTRL then
                     ctrl_reg     <= reg_wr(ctrl_reg, wb_req);
                 end if;
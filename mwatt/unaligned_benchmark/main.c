@@ -0,0 +1,169 @@
+#include "console.h"
+#include "io.h"
+#include "microwatt_soc.h"
+
+#include "pmu.h"
+#include "time.h"
+
+/*
+ * Unaligned load and store benchmark.
+ *
+ * Times runs of ld from a buffer that is already in the dcache, at an
+ * aligned offset, at an offset where every load crosses a doubleword
+ * but stays in its cache line (one dcache access with the dual-row
+ * read), and at an offset where every load crosses a cache line (two
+ * dcache accesses).  Prints the average number of PMU run cycles per
+ * access, in tenths.  The same is done for lwz, std and stw.  Packed
+ * structures and network headers give the middle case.
+ *
+ * Stores have no dual-row write: a store that crosses a doubleword
+ * takes two dcache accesses and bypasses the store buffer, whether or
+ * not it crosses a line, so the std and stw middle cases show the cost
+ * that is left.
+ */
+
+#define LINE      64
+#define LINES     64
+#define REPS      16
+#define ACCESSES  (LINES * REPS)
+
+static uint8_t buf[(LINES + 1) * LINE] __attribute__((aligned(LINE)));
+
+/*
+ * One load per line, in groups of four independent loads, so that the
+ * offset decides whether each load crosses a doubleword or a line.
+ */
+static uint64_t __attribute__((noinline)) ld_loop(const uint8_t *p)
+{
+  uint64_t a, b, c, d, sum = 0;
+  int i;
+
+  for (i = 0; i < LINES; i += 8, p += 8 * LINE) {
+    __asm__ volatile("ld %0,0(%4)\n\t"
+                     "ld %1,64(%4)\n\t"
+                     "ld %2,128(%4)\n\t"
+                     "ld %3,192(%4)"
+                     : "=&r"(a), "=&r"(b), "=&r"(c), "=&r"(d) : "b"(p));
+    sum += a + b + c + d;
+    __asm__ volatile("ld %0,256(%4)\n\t"
+                     "ld %1,320(%4)\n\t"
+                     "ld %2,384(%4)\n\t"
+                     "ld %3,448(%4)"
+                     : "=&r"(a), "=&r"(b), "=&r"(c), "=&r"(d) : "b"(p));
+    sum += a + b + c + d;
+  }
+  return sum;
+}
+
+static uint64_t __attribute__((noinline)) lwz_loop(const uint8_t *p)
+{
+  uint32_t a, b, c, d;
+  uint64_t sum = 0;
+  int i;
+
+  for (i = 0; i < LINES; i += 8, p += 8 * LINE) {
+    __asm__ volatile("lwz %0,0(%4)\n\t"
+                     "lwz %1,64(%4)\n\t"
+                     "lwz %2,128(%4)\n\t"
+                     "lwz %3,192(%4)"
+                     : "=&r"(a), "=&r"(b), "=&r"(c), "=&r"(d) : "b"(p));
+    sum += a + b + c + d;
+    __asm__ volatile("lwz %0,256(%4)\n\t"
+                     "lwz %1,320(%4)\n\t"
+                     "lwz %2,384(%4)\n\t"
+                     "lwz %3,448(%4)"
+                     : "=&r"(a), "=&r"(b), "=&r"(c), "=&r"(d) : "b"(p));
+    sum += a + b + c + d;
+  }
+  return sum;
+}
+
+static uint64_t __attribute__((noinline)) std_loop(const uint8_t *p)
+{
+  uint64_t a = 1, b = 2, c = 3, d = 4;
+  int i;
+
+  for (i = 0; i < LINES; i += 8, p += 8 * LINE) {
+    __asm__ volatile("std %0,0(%4)\n\t"
+                     "std %1,64(%4)\n\t"
+                     "std %2,128(%4)\n\t"
+                     "std %3,192(%4)\n\t"
+                     "std %0,256(%4)\n\t"
+                     "std %1,320(%4)\n\t"
+                     "std %2,384(%4)\n\t"
+                     "std %3,448(%4)"
+                     : : "r"(a), "r"(b), "r"(c), "r"(d), "b"(p) : "memory");
+  }
+  return 0;
+}
+
+static uint64_t __attribute__((noinline)) stw_loop(const uint8_t *p)
+{
+  uint32_t a = 1, b = 2, c = 3, d = 4;
+  int i;
+
+  for (i = 0; i < LINES; i += 8, p += 8 * LINE) {
+    __asm__ volatile("stw %0,0(%4)\n\t"
+                     "stw %1,64(%4)\n\t"
+                     "stw %2,128(%4)\n\t"
+                     "stw %3,192(%4)\n\t"
+                     "stw %0,256(%4)\n\t"
+                     "stw %1,320(%4)\n\t"
+                     "stw %2,384(%4)\n\t"
+                     "stw %3,448(%4)"
+                     : : "r"(a), "r"(b), "r"(c), "r"(d), "b"(p) : "memory");
+  }
+  return 0;
+}
+
+static void run(const char *name, uint64_t (*fn)(const uint8_t *), unsigned long off)
+{
+  volatile uint64_t sink;
+  uint64_t cycles;
+  int i;
+
+  /* Once to get the buffer into the dcache */
+  sink = fn(buf + off);
+  pmu_start(PMU_MMCR1(PMU_EV1_CYCLES, 0, 0, 0));
+  for (i = 0; i < REPS; i++)
+    sink = fn(buf + off);
+  pmu_stop();
+  (void)sink;
+
+  cycles = pmu_read(1) * 10 / ACCESSES;
+  puts(name);
+  puts(": cycles/access ");
+  print_uint64(cycles / 10);
+  puts(".");
+  print_uint64(cycles % 10);
+  puts("\n");
+}
+
+int main(void)
+{
+  unsigned long i;
+
+  console_init();
+
+  for (i = 0; i < sizeof(buf); i++)
+    buf[i] = i;
+
+  run("ld  aligned           ", ld_loop, 0);
+  run("ld  crossing dword    ", ld_loop, 3);
+  run("ld  crossing line     ", ld_loop, 59);
+  run("lwz aligned           ", lwz_loop, 0);
+  run("lwz crossing dword    ", lwz_loop, 6);
+  run("lwz crossing line     ", lwz_loop, 62);
+  run("std aligned           ", std_loop, 0);
+  run("std crossing dword    ", std_loop, 3);
+  run("std crossing line     ", std_loop, 59);
+  run("stw aligned           ", stw_loop, 0);
+  run("stw crossing dword    ", stw_loop, 6);
+  run("stw crossing line     ", stw_loop, 62);
+
+  return 0;
+}
+
+void secondary_main(void)
+{
+}
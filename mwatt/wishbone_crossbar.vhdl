@@ -0,0 +1,167 @@
+library ieee;
+use ieee.std_logic_1164.all;
+
+library work;
+use work.wishbone_types.all;
+
+-- Wishbone crossbar
+--
+-- Unlike wishbone_arbiter, which funnels every master into one bus, this
+-- gives each slave its own round-robin arbiter so that e.g. one core
+-- fetching from BRAM doesn't hold off another core's DRAM refill. The
+-- parent decodes which slave each master is addressing and passes that
+-- in via wb_masters_slave. A master is assumed to stay on the same slave
+-- for the whole of a cycle (cyc high).
+--
+-- Grants are pipelined: the next master for each slave is chosen a cycle
+-- ahead and held in a register, so when the current owner drops cyc the
+-- slave is handed over without a dead cycle and without a priority
+-- encoder on the handover path.
+--
+-- The caches rely on seeing every store to cacheable memory on a single
+-- snoop bus. Writes to the slaves flagged in SNOOP_SLAVES are therefore
+-- still serialised: if two of them see a write strobe in the same cycle,
+-- the lower numbered slave goes first and the other master is stalled.
+-- wb_snoop_master says which master issued the write on the snoop bus.
+-- A slave can put its own write (e.g. an invalidation) on the snoop bus
+-- by raising snoop_inject, which holds off all snooped writes that cycle.
+--
+entity wishbone_crossbar is
+    generic(
+        NUM_MASTERS  : positive := 4;
+        NUM_SLAVES   : positive := 3;
+        SNOOP_SLAVES : std_ulogic_vector(0 to 15) := (others => '1')
+        );
+    port (clk     : in std_ulogic;
+          rst     : in std_ulogic;
+
+          wb_masters_in    : in wishbone_master_out_vector(0 to NUM_MASTERS-1);
+          wb_masters_out   : out wishbone_slave_out_vector(0 to NUM_MASTERS-1);
+          wb_masters_slave : in wb_slave_idx_vector(0 to NUM_MASTERS-1);
+
+          wb_slaves_out    : out wishbone_master_out_vector(0 to NUM_SLAVES-1);
+          wb_slaves_in     : in wishbone_slave_out_vector(0 to NUM_SLAVES-1);
+          wb_slaves_master : out wb_master_idx_vector(0 to NUM_SLAVES-1);
+
+          wb_snoop_out    : out wishbone_master_out;
+          wb_snoop_master : out natural range 0 to NUM_MASTERS-1;
+          snoop_inject    : in std_ulogic := '0'
+          );
+end wishbone_crossbar;
+
+architecture behave of wishbone_crossbar is
+    subtype wb_xbar_master_t is integer range 0 to NUM_MASTERS-1;
+    type wb_xbar_grant_t is array(0 to NUM_SLAVES-1) of wb_xbar_master_t;
+
+    -- Master that held each slave last cycle
+    signal owner      : wb_xbar_grant_t;
+    -- Registered round-robin pick for when the owner lets go
+    signal next_owner : wb_xbar_grant_t;
+    -- Master driving each slave this cycle
+    signal grant      : wb_xbar_grant_t;
+    signal candidate  : wb_xbar_grant_t;
+    signal wr_block   : std_ulogic_vector(0 to NUM_SLAVES-1);
+
+    function wants(m : wishbone_master_out; sel : wb_slave_idx_t; s : natural) return boolean is
+    begin
+        return m.cyc = '1' and sel = s;
+    end;
+begin
+
+    wishbone_grant: process(all)
+    begin
+        for s in 0 to NUM_SLAVES-1 loop
+            if wants(wb_masters_in(owner(s)), wb_masters_slave(owner(s)), s) then
+                grant(s) <= owner(s);
+            else
+                grant(s) <= next_owner(s);
+            end if;
+        end loop;
+    end process;
+
+    -- Slave side muxes, write serialisation and snoop bus
+    wishbone_slave_muxes: process(all)
+        variable m       : wb_xbar_master_t;
+        variable req     : wishbone_master_out;
+        variable writing : boolean;
+    begin
+        writing := snoop_inject = '1';
+        wb_snoop_out <= wishbone_master_out_init;
+        wb_snoop_master <= 0;
+        for s in 0 to NUM_SLAVES-1 loop
+            m := grant(s);
+            req := wb_masters_in(m);
+            if wb_masters_slave(m) /= s then
+                req.cyc := '0';
+                req.stb := '0';
+            end if;
+            wr_block(s) <= '0';
+            if SNOOP_SLAVES(s) = '1' and req.cyc = '1' and req.stb = '1' and req.we = '1' then
+                if writing then
+                    wr_block(s) <= '1';
+                    req.stb := '0';
+                else
+                    writing := true;
+                    -- Gate stb with stall so the caches only see accepted writes
+                    wb_snoop_out <= req;
+                    wb_snoop_out.stb <= not wb_slaves_in(s).stall;
+                    wb_snoop_master <= m;
+                end if;
+            end if;
+            wb_slaves_out(s) <= req;
+            wb_slaves_master(s) <= m;
+        end loop;
+    end process;
+
+    wishbone_master_muxes: process(all)
+        variable s : wb_slave_idx_t;
+    begin
+        for i in 0 to NUM_MASTERS-1 loop
+            s := wb_masters_slave(i);
+            wb_masters_out(i).dat <= (others => '0');
+            wb_masters_out(i).ack <= '0';
+            wb_masters_out(i).stall <= '1';
+            if s < NUM_SLAVES then
+                wb_masters_out(i).dat <= wb_slaves_in(s).dat;
+                if grant(s) = i and wb_masters_in(i).cyc = '1' then
+                    wb_masters_out(i).ack <= wb_slaves_in(s).ack;
+                    wb_masters_out(i).stall <= wb_slaves_in(s).stall or wr_block(s);
+                end if;
+            end if;
+        end loop;
+    end process;
+
+    -- Round robin: the lowest numbered requester above the current grant,
+    -- else the lowest numbered one below it, else keep the current one.
+    wishbone_candidate: process(all)
+        variable cand : wb_xbar_master_t;
+    begin
+        for s in 0 to NUM_SLAVES-1 loop
+            cand := grant(s);
+            for i in NUM_MASTERS-1 downto 0 loop
+                if i < grant(s) and wants(wb_masters_in(i), wb_masters_slave(i), s) then
+                    cand := i;
+                end if;
+            end loop;
+            for i in NUM_MASTERS-1 downto 0 loop
+                if i > grant(s) and wants(wb_masters_in(i), wb_masters_slave(i), s) then
+                    cand := i;
+                end if;
+            end loop;
+            candidate(s) <= cand;
+        end loop;
+    end process;
+
+    wishbone_crossbar_process: process(clk)
+    begin
+        if rising_edge(clk) then
+            if rst = '1' then
+                owner <= (others => 0);
+                next_owner <= (others => 0);
+            else
+                owner <= grant;
+                next_owner <= candidate;
+            end if;
+        end if;
+    end process;
+end behave;
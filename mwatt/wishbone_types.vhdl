@@ -38,6 +38,13 @@ package wishbone_types is
     type wishbone_master_out_vector is array (natural range <>) of wishbone_master_out;
     type wishbone_slave_out_vector is array (natural range <>) of wishbone_slave_out;
 
+    -- Slave addressed by each master of a wishbone_crossbar
+    subtype wb_slave_idx_t is natural range 0 to 15;
+    type wb_slave_idx_vector is array (natural range <>) of wb_slave_idx_t;
+    -- Master granted each slave of a wishbone_crossbar
+    subtype wb_master_idx_t is natural range 0 to 63;
+    type wb_master_idx_vector is array (natural range <>) of wb_master_idx_t;
+
     --
     -- IO Bus to a device, 30-bit address, 32-bits data
     --
@@ -5,8 +5,14 @@ use ieee.numeric_std.all;
 library work;
 use work.common.all;
 use work.crhelpers.all;
+use work.sim_cosim.all;
 
 entity writeback is
+    generic (
+        CPU_INDEX : natural := 0;
+        -- Report register writes and completions to the co-simulation checker
+        COSIM     : boolean := false
+        );
     port (
         clk          : in std_ulogic;
         rst          : in std_ulogic;
@@ -83,10 +89,13 @@ begin
         hvi := '0';
 
         complete_out <= instr_tag_init;
+        events.instr_complete2 <= '0';
         if e_in.valid = '1' then
             complete_out <= e_in.instr_tag;
+            events.instr_complete2 <= (e_in.fused or e_in.dual) and not e_in.interrupt;
         elsif l_in.valid = '1' then
             complete_out <= l_in.instr_tag;
+            events.instr_complete2 <= l_in.fused and not l_in.interrupt;
         elsif fp_in.valid = '1' then
             complete_out <= fp_in.instr_tag;
         end if;
@@ -125,6 +134,13 @@ begin
                 w_out.write_enable <= '1';
             end if;
 
+            -- result of a dual-issued instruction
+            if e_in.write_enable2 = '1' then
+                w_out.write_reg2 <= e_in.write_reg2;
+                w_out.write_data2 <= e_in.write_data2;
+                w_out.write_enable2 <= '1';
+            end if;
+
             if e_in.write_cr_enable = '1' then
                 c_out.write_cr_enable <= '1';
                 c_out.write_cr_mask <= e_in.write_cr_mask;
@@ -193,6 +209,40 @@ begin
         wb_bypass.tag.tag <= complete_out.tag;
         wb_bypass.tag.valid <= complete_out.valid and w_out.write_enable;
         wb_bypass.data <= w_out.write_data;
+        wb_bypass.tag2.tag <= complete_out.tag;
+        wb_bypass.tag2.valid <= complete_out.valid and w_out.write_enable2;
+        wb_bypass.data2 <= w_out.write_data2;
 
     end process;
+
+    -- Retire trace for the co-simulation checker in sim_cosim_c.c: the
+    -- register, CR and XER writes made at each clock edge, and any
+    -- completion, interrupt (with what execute1 puts in SRR0/SRR1) and
+    -- flush.  Flag bits:
+    --   8 complete, 7 write, 6 write2, 5 CR, 4 XER,
+    --   3 interrupt, 2 HV interrupt, 1 scv, 0 flush
+    cosim_retire_trace: if COSIM generate
+        cosim_0: process(clk)
+            variable flags : std_ulogic_vector(8 downto 0);
+            variable xer   : std_ulogic_vector(4 downto 0);
+        begin
+            if rising_edge(clk) then
+                flags := complete_out.valid & w_out.write_enable & w_out.write_enable2 &
+                         c_out.write_cr_enable & c_out.write_xerc_enable &
+                         interrupt_out.intr & interrupt_out.hv_intr & interrupt_out.scv_int &
+                         flush_out;
+                xer := c_out.write_xerc_data.so & c_out.write_xerc_data.ov &
+                       c_out.write_xerc_data.ca & c_out.write_xerc_data.ov32 &
+                       c_out.write_xerc_data.ca32;
+                if rst = '0' and flags /= "000000000" then
+                    cosim_retire(CPU_INDEX, complete_out.tag, flags,
+                                 to_integer(unsigned(w_out.write_reg)), w_out.write_data,
+                                 to_integer(unsigned(w_out.write_reg2)), w_out.write_data2,
+                                 c_out.write_cr_mask, c_out.write_cr_data, xer,
+                                 to_integer(unsigned(f_out.intr_vec)), e_in.last_nia,
+                                 e_in.msr, interrupt_out.srr1);
+                end if;
+            end if;
+        end process;
+    end generate;
 end;
@@ -7,7 +7,8 @@
 -- registers in the source units.
 --
 -- The source ids start at 16 for int_level_in(0) and go up from
--- there (ie int_level_in(1) is source id 17). XXX Make a generic
+-- there (ie int_level_in(1) is source id 17), for SRC_NUM sources.
+-- Each source is routed to one CPU (server) by its XIVE.
 --
 -- The presentation layer will pick an interupt that is more
 -- favourable than the current CPPR and present it via the XISR and
@@ -15,6 +16,10 @@
 -- highest priority interrupt currently presented (which is allowed
 -- via XICS)
 --
+-- MFRR writes can also arrive on ipi_in, straight from the IO bus,
+-- which lets the SoC ack an IPI store without a trip through the
+-- 32-bit IO bus.
+--
 
 library ieee;
 use ieee.std_logic_1164.all;
@@ -36,6 +41,7 @@ entity xics_icp is
         wb_out       : out wb_io_slave_out;
 
         ics_in       : in ics_to_icp_t;
+        ipi_in       : in icp_ipi_t := icp_ipi_init;
         core_irq_out : out std_ulogic_vector(NCPUS-1 downto 0)
         );
 end xics_icp;
@@ -177,12 +183,17 @@ begin
                 end if;
             end if;
 
+            if ipi_in.valid = '1' and to_integer(unsigned(ipi_in.cpu)) = i then
+                v.icp(i).mfrr := ipi_in.mfrr;
+            end if;
+
             pending_priority := x"ff";
             v.icp(i).xisr := x"000000";
             v.icp(i).irq := '0';
 
             if ics_in.pri(8*i + 7 downto 8*i) /= x"ff" then
-                v.icp(i).xisr := x"00001" & ics_in.src(4*i + 3 downto 4*i);
+                v.icp(i).xisr := std_ulogic_vector(to_unsigned(16, 24) +
+                                                   unsigned(ics_in.src(8*i + 7 downto 8*i)));
                 pending_priority := ics_in.pri(8*i + 7 downto 8*i);
             end if;
 
@@ -235,9 +246,11 @@ use work.helpers.all;
 
 entity xics_ics is
     generic (
-        NCPUS      : natural := 1;
-        SRC_NUM    : integer range 1 to 256  := 16;
-        PRIO_BITS  : integer range 1 to 8    := 3
+        NCPUS       : natural := 1;
+        SRC_NUM     : integer range 2 to 256  := 16;
+        PRIO_BITS   : integer range 1 to 8    := 3;
+        -- Route source i to CPU i mod NCPUS at reset rather than all to CPU 0
+        SPREAD_IRQS : boolean := false
         );
     port (
         clk          : in std_logic;
@@ -253,8 +266,8 @@ end xics_ics;
 
 architecture rtl of xics_ics is
 
-    constant SRC_NUM_BITS : natural := log2(SRC_NUM);
-    constant SERVER_NUM_BITS : natural := 2;
+    constant SRC_NUM_BITS : natural := log2ceil(SRC_NUM - 1);
+    constant SERVER_NUM_BITS : natural := maximum(1, log2ceil(NCPUS - 1));
 
     subtype pri_t is std_ulogic_vector(PRIO_BITS-1 downto 0);
     subtype server_t is unsigned(SERVER_NUM_BITS-1 downto 0);
@@ -270,7 +283,7 @@ architecture rtl of xics_ics is
     signal xives : xive_array_t;
 
     signal wb_valid : std_ulogic;
-    signal reg_idx : integer range 0 to SRC_NUM - 1;
+    signal reg_idx : integer range 0 to 2**SRC_NUM_BITS - 1;
     signal icp_out_next : ics_to_icp_t;
     signal int_level_l : std_ulogic_vector(SRC_NUM - 1 downto 0);
 
@@ -325,16 +338,29 @@ architecture rtl of xics_ics is
         return v;
     end function;
 
-    -- Assumes nbits <= 6; v is 2^nbits wide
+    -- v is 2^nbits wide. Above 64 bits, find the first 64-bit chunk
+    -- with a bit set and count within that.
     function priority_encoder(v: std_ulogic_vector; nbits: natural) return std_ulogic_vector is
         variable h: std_ulogic_vector(2**nbits - 1 downto 0);
         variable p: std_ulogic_vector(5 downto 0);
+        variable r: std_ulogic_vector(nbits - 1 downto 0);
     begin
         -- Set the lowest-priority (highest-numbered) bit
         h := v;
         h(2**nbits - 1) := '1';
-        p := count_right_zeroes(h);
-        return p(nbits - 1 downto 0);
+        if nbits <= 6 then
+            p := count_right_zeroes(h);
+            r := p(nbits - 1 downto 0);
+        else
+            r := (others => '0');
+            for c in 2**(nbits - 6) - 1 downto 0 loop
+                if h(64*c + 63 downto 64*c) /= 64x"0" then
+                    p := count_right_zeroes(h(64*c + 63 downto 64*c));
+                    r := std_ulogic_vector(to_unsigned(c, nbits - 6)) & p;
+                end if;
+            end loop;
+        end if;
+        return r;
     end function;
 
     function server_check(serv_in: std_ulogic_vector(7 downto 0)) return unsigned is
@@ -355,7 +381,7 @@ architecture rtl of xics_ics is
     --
     -- Config register format:
     --
-    --  23..  0 : Interrupt base (hard wired to 16)
+    --  23..  0 : Number of sources (SRC_NUM)
     --  27.. 24 : #prio bits (1..8)
     --
     -- XIVE register format:
@@ -365,7 +391,7 @@ architecture rtl of xics_ics is
     --       29 : P (mirrors input for now)
     --       28 : Q (not implemented in this version)
     -- 30 ..    : reserved
-    -- 19 ..  8 : target (not implemented in this version)
+    -- 15 ..  8 : server (CPU number, must be < NCPUS)
     --  7 ..  0 : prio/mask
 
     signal reg_is_xive   : std_ulogic;
@@ -374,14 +400,14 @@ architecture rtl of xics_ics is
 
 begin
 
-    assert SRC_NUM = 16 report "Fixup address decode with log2";
+    assert NCPUS <= 4 report "ics_to_icp_t only has room for 4 cpus" severity failure;
 
-    reg_is_xive   <= wb_in.adr(9);
+    -- XIVEs beyond SRC_NUM read as zero and ignore writes
+    reg_is_xive   <= wb_in.adr(9) when reg_idx < SRC_NUM else '0';
     reg_is_config <= '1' when wb_in.adr(9 downto 0) = 10x"000" else '0';
     reg_is_debug  <= '1' when wb_in.adr(9 downto 0) = 10x"001" else '0';
 
-    -- Register index XX FIXME: figure out bits from SRC_NUM
-    reg_idx <= to_integer(unsigned(wb_in.adr(3 downto 0)));
+    reg_idx <= to_integer(unsigned(wb_in.adr(SRC_NUM_BITS - 1 downto 0)));
 
     -- Latch interrupt inputs for timing
     int_latch: process(clk)
@@ -412,7 +438,7 @@ begin
             elsif reg_is_config = '1' then
                 be_out := get_config;
             elsif reg_is_debug = '1' then
-                be_out := icp_out_next.src & icp_out_next.pri(15 downto 0);
+                be_out := icp_out_next.src(15 downto 0) & icp_out_next.pri(15 downto 0);
             end if;
             wb_out.dat <= bswap(be_out);
             wb_out.ack <= wb_valid;
@@ -427,6 +453,9 @@ begin
             if rst = '1' then
                 for i in 0 to SRC_NUM - 1 loop
                     xives(i) <= (pri => pri_masked, server => to_unsigned(0, SERVER_NUM_BITS));
+                    if SPREAD_IRQS then
+                        xives(i).server <= to_unsigned(i mod NCPUS, SERVER_NUM_BITS);
+                    end if;
                 end loop;
             elsif wb_valid = '1' and wb_in.we = '1' then
                 -- Byteswapped input
@@ -462,7 +491,7 @@ begin
         variable max_idx : std_ulogic_vector(SRC_NUM_BITS - 1 downto 0);
         variable max_pri : pri_t;
         variable pending_pri : pri_vector_t;
-        variable pending_at_pri : std_ulogic_vector(SRC_NUM - 1 downto 0);
+        variable pending_at_pri : std_ulogic_vector(2**SRC_NUM_BITS - 1 downto 0);
     begin
         icp_out_next.src <= (others => '0');
         icp_out_next.pri <= (others => '0');
@@ -491,7 +520,7 @@ begin
                 report "MFI: " & integer'image(to_integer(unsigned(max_idx))) & " pri=" & to_hstring(prio_unpack(max_pri)) &
                     " srv=" & integer'image(cpu);
             end if;
-            icp_out_next.src(4*cpu + 3 downto 4*cpu) <= max_idx;
+            icp_out_next.src(8*cpu + 7 downto 8*cpu) <= std_ulogic_vector(resize(unsigned(max_idx), 8));
             icp_out_next.pri(8*cpu + 7 downto 8*cpu) <= prio_unpack(max_pri);
         end loop;
     end process;
@@ -9,6 +9,10 @@ library unisim;
 use unisim.vcomponents.all;
 
 entity multiply is
+    generic (
+        -- Not used; the DSP48 pipeline has a fixed depth
+        PIPELINE_DEPTH : natural := 3
+        );
     port (
         clk   : in std_logic;
 